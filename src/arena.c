@@ -0,0 +1,264 @@
+/*******************************************************************************
+*
+* File:     arena.c
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Bump allocator for kell-shell. Memory is handed out from a list of
+*   chunks by advancing an offset; individual allocations are never freed.
+*   arenaReset() rewinds to the first chunk in O(1) and keeps every chunk
+*   for reuse, so after the first few commands the shell stops calling
+*   malloc altogether. A chunk's offset is cleared when allocation moves
+*   into it, not at reset time.
+*
+*   The most recent allocation can be grown in place while there is room
+*   in its chunk, which lets a line or argv array grow one element at a
+*   time without copying.
+*
+*   arenaMark() and arenaRewind() release everything allocated after a
+*   point, so a loop can run any number of times in a bounded amount of
+*   memory.
+*
+******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+#define ARENA_CHUNK_SIZE (64 * 1024)
+#define ARENA_ALIGN 16
+
+struct arenaChunk {
+    struct arenaChunk *next;
+    size_t size;
+    size_t used;
+    char data[];
+};
+
+/**
+*
+* static struct arenaChunk *arenaNewChunk(size_t minimum)
+*
+* Summary:
+*       Allocates a chunk with room for at least the requested size
+*
+* Parameters:   size_t for the minimum usable size
+*
+* Returns:      pointer to the new chunk
+*
+**/
+static struct arenaChunk *arenaNewChunk(size_t minimum)
+{
+    size_t size = (minimum > ARENA_CHUNK_SIZE) ? minimum : ARENA_CHUNK_SIZE;
+    struct arenaChunk *chunk = malloc(sizeof(struct arenaChunk) + size);
+    if (!chunk) {
+        abort();
+    }
+    chunk->next = NULL;
+    chunk->size = size;
+    chunk->used = 0;
+    return chunk;
+}
+
+/**
+*
+* void *arenaAlloc(struct arena *arena, size_t size)
+*
+* Summary:
+*       Allocates memory from the arena
+*
+* Parameters:   pointer to the arena
+*               size_t for the number of bytes
+*
+* Returns:      pointer to uninitialized memory, aligned to ARENA_ALIGN
+*
+* Description:
+*       When the current chunk is full, the next kept chunk is reused if it
+*       is big enough; otherwise a new chunk is linked in after the current
+*       one.
+*
+**/
+void *arenaAlloc(struct arena *arena, size_t size)
+{
+    size = (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+
+    if (!arena->head) {
+        arena->head = arenaNewChunk(size);
+        arena->current = arena->head;
+    }
+
+    struct arenaChunk *chunk = arena->current;
+    while (chunk->size - chunk->used < size) {
+        struct arenaChunk *next = chunk->next;
+        if (!next || next->size < size) {
+            // splice a fresh chunk in front of any smaller kept chunk
+            struct arenaChunk *fresh = arenaNewChunk(size);
+            fresh->next = next;
+            chunk->next = fresh;
+            next = fresh;
+        }
+        next->used = 0;
+        chunk = next;
+        arena->current = chunk;
+    }
+
+    void *ptr = chunk->data + chunk->used;
+    chunk->used += size;
+    arena->last = ptr;
+    return ptr;
+}
+
+/**
+*
+* void *arenaGrow(struct arena *arena, void *ptr, size_t oldSize,
+*                 size_t newSize)
+*
+* Summary:
+*       Resizes an allocation, in place when possible
+*
+* Parameters:   pointer to the arena
+*               pointer to the allocation, or NULL
+*               size_t for its current size
+*               size_t for the size wanted
+*
+* Returns:      pointer to the (possibly moved) allocation
+*
+* Description:
+*       Only the latest allocation can grow in place. Otherwise new memory
+*       is allocated and the contents copied; the old block is simply left
+*       behind until the next reset.
+*
+**/
+void *arenaGrow(struct arena *arena, void *ptr, size_t oldSize, size_t newSize)
+{
+    if (ptr && ptr == arena->last) {
+        struct arenaChunk *chunk = arena->current;
+        size_t offset = (char *)ptr - chunk->data;
+        size_t aligned = (newSize + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+        if (offset + aligned <= chunk->size) {
+            chunk->used = offset + aligned;
+            return ptr;
+        }
+    }
+
+    void *moved = arenaAlloc(arena, newSize);
+    if (ptr) {
+        memcpy(moved, ptr, oldSize);
+    }
+    return moved;
+}
+
+/**
+*
+* char *arenaStrndup(struct arena *arena, const char *str, size_t length)
+*
+* Summary:
+*       Copies a string of known length into the arena
+*
+* Parameters:   pointer to the arena
+*               char* for the string, need not be NUL terminated
+*               size_t for the number of bytes to copy
+*
+* Returns:      NUL terminated copy
+*
+**/
+char *arenaStrndup(struct arena *arena, const char *str, size_t length)
+{
+    char *copy = arenaAlloc(arena, length + 1);
+    memcpy(copy, str, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+/**
+*
+* struct arenaMark arenaMark(struct arena *arena)
+*
+* Summary:
+*       Records the current end of the arena
+*
+* Parameters:   pointer to the arena
+*
+* Returns:      the mark to pass to arenaRewind()
+*
+**/
+struct arenaMark arenaMark(struct arena *arena)
+{
+    struct arenaMark mark = { arena->current, arena->current ? arena->current->used : 0 };
+    return mark;
+}
+
+/**
+*
+* void arenaRewind(struct arena *arena, struct arenaMark mark)
+*
+* Summary:
+*       Releases every allocation made since a mark, keeping the chunks
+*
+* Parameters:   pointer to the arena
+*               struct arenaMark from arenaMark()
+*
+* Returns:      nothing.
+*
+* Description:
+*       The arena must not have been reset since the mark was taken.
+*
+**/
+void arenaRewind(struct arena *arena, struct arenaMark mark)
+{
+    if (!mark.chunk) {
+        arenaReset(arena);
+        return;
+    }
+    mark.chunk->used = mark.used;
+    arena->current = mark.chunk;
+    arena->last = NULL;
+}
+
+/**
+*
+* void arenaReset(struct arena *arena)
+*
+* Summary:
+*       Releases every allocation at once, keeping the chunks
+*
+* Parameters:   pointer to the arena
+*
+* Returns:      nothing.
+*
+**/
+void arenaReset(struct arena *arena)
+{
+    if (arena->head) {
+        arena->head->used = 0;
+    }
+    arena->current = arena->head;
+    arena->last = NULL;
+}
+
+/**
+*
+* void arenaFree(struct arena *arena)
+*
+* Summary:
+*       Frees every chunk of the arena
+*
+* Parameters:   pointer to the arena
+*
+* Returns:      nothing.
+*
+**/
+void arenaFree(struct arena *arena)
+{
+    struct arenaChunk *chunk = arena->head;
+    while (chunk) {
+        struct arenaChunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    arena->head = NULL;
+    arena->current = NULL;
+    arena->last = NULL;
+}
@@ -0,0 +1,40 @@
+/*******************************************************************************
+*
+* File:     arena.h
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Interface for the kell-shell bump allocator. Everything allocated for
+*   one command (input line, expanded line, argv) comes from an arena that
+*   is reset in O(1) once the command is done.
+*
+******************************************************************************/
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+struct arenaChunk;
+
+struct arena {
+    struct arenaChunk *head;    // first chunk, kept across resets
+    struct arenaChunk *current; // chunk allocations are served from
+    void *last;                 // most recent allocation, may grow in place
+};
+
+struct arenaMark {
+    struct arenaChunk *chunk;   // chunk that was current
+    size_t used;                // and how much of it was in use
+};
+
+void *arenaAlloc(struct arena *arena, size_t size);
+void *arenaGrow(struct arena *arena, void *ptr, size_t oldSize, size_t newSize);
+char *arenaStrndup(struct arena *arena, const char *str, size_t length);
+struct arenaMark arenaMark(struct arena *arena);
+void arenaRewind(struct arena *arena, struct arenaMark mark);
+void arenaReset(struct arena *arena);
+void arenaFree(struct arena *arena);
+
+#endif
@@ -0,0 +1,130 @@
+/*******************************************************************************
+*
+* File:     builtinbench.c
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Benchmark for kell-shell built-ins. Runs the shell on two generated
+*   scripts, one calling the `echo` built-in and one calling /bin/echo,
+*   and reports the average latency per command for each.
+*
+*   Usage: builtinbench [-n commands] [-s shell]
+*          -s path of the shell to run, ./kell-shell by default
+*
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+extern char **environ;
+
+/**
+*
+* static int writeScript(const char *path, const char *command, int count)
+*
+* Summary:
+*       Writes a script that runs the same command count times
+*
+* Returns:      0 on success, -1 if the file cannot be written
+*
+**/
+static int writeScript(const char *path, const char *command, int count)
+{
+    FILE *script = fopen(path, "w");
+    if (!script) {
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        fprintf(script, "%s %d\n", command, i);
+    }
+    return fclose(script);
+}
+
+/**
+*
+* static double runScript(const char *shell, const char *path)
+*
+* Summary:
+*       Runs the shell on a script with output going to /dev/null
+*
+* Returns:      elapsed time in microseconds, or -1 if the shell failed
+*
+**/
+static double runScript(const char *shell, const char *path)
+{
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+
+    char *argv[] = { (char *)shell, (char *)path, NULL };
+    struct timespec start, end;
+    pid_t pid;
+    int status;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (posix_spawn(&pid, shell, &actions, NULL, argv, environ) != 0) {
+        posix_spawn_file_actions_destroy(&actions);
+        return -1;
+    }
+    waitpid(pid, &status, 0);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    posix_spawn_file_actions_destroy(&actions);
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        return -1;
+    }
+    return (end.tv_sec - start.tv_sec) * 1e6 + (end.tv_nsec - start.tv_nsec) / 1e3;
+}
+
+int main(int argc, char *argv[])
+{
+    int count = 2000;
+    const char *shell = "./kell-shell";
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+        switch (opt) {
+            case 'n':
+                count = atoi(optarg);
+                break;
+            case 's':
+                shell = optarg;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n commands] [-s shell]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    char builtinPath[] = "/tmp/builtinbench_builtin.XXXXXX";
+    char externalPath[] = "/tmp/builtinbench_external.XXXXXX";
+    close(mkstemp(builtinPath));
+    close(mkstemp(externalPath));
+
+    if (writeScript(builtinPath, "echo", count) == -1
+            || writeScript(externalPath, "/bin/echo", count) == -1) {
+        perror("builtinbench: script");
+        return 1;
+    }
+
+    double builtinUs = runScript(shell, builtinPath);
+    double externalUs = runScript(shell, externalPath);
+    unlink(builtinPath);
+    unlink(externalPath);
+
+    if (builtinUs < 0 || externalUs < 0) {
+        fprintf(stderr, "builtinbench: %s failed\n", shell);
+        return 1;
+    }
+
+    printf("commands=%d builtin_us=%.2f external_us=%.2f speedup=%.1fx\n",
+            count, builtinUs / count, externalUs / count, externalUs / builtinUs);
+    return 0;
+}
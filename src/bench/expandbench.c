@@ -0,0 +1,168 @@
+/*******************************************************************************
+*
+* File:     expandbench.c
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Benchmark for kell-shell variable expansion. Compares the original
+*   strstr/calloc/strcat expandInput() with the single-pass expandLine()
+*   on lines made of many `$$`-tagged temp paths.
+*
+*   Usage: expandbench [-n iterations] [-l line_length]
+*
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../arena.h"
+#include "../expand.h"
+
+/**
+* 
+* static void expandInput(char *str, int pid) 
+* 
+* Summary: 
+*       Replaces all instances of $$ with process id
+* 
+* Parameters:   char* for the string to expand
+*               int for the process id
+* 				
+* Returns:      nothing. string is modified
+*
+* Description:
+*       This function takes advantage of a while loop and strstr to locate 
+*       all instancees of $$ in the string. It creates a new string to hold
+*       the expanded version and uses strcat to modify the new string.
+*       Finally, it copies the modified string back to the original to 
+*       be returned.
+*
+*       Note: It has been assumed that when instances of $$mare replaced by 
+*       process ID, the length of the command line will not go above 2048 char.
+*       (piazza post @240)
+*
+*       Note: Process ID must be 10 digits or fewer (I believe Linux limits
+*       processid to 2^22 on 64 bit systems but extra room doesn't hurt here).
+* 
+* ---
+*  
+* Elements of this code have been adapted from:
+*
+* - Title: C - how to convert a pointer in an array to an index?
+*   Author: AraK
+*   Date: 4/26/2010
+*   Availability: https://stackoverflow.com/questions/2711653
+*   Additional Info: First accessed 10/26/2020
+*
+**/
+static void expandInput(char *str, int pid) 
+{
+    // convert process id from int to string
+    char procId[11]; // 1 extra space for \0
+    sprintf(procId, "%d", pid);
+
+    // locate $$ substring if exists
+    // repeat until there are no substrings containing $$
+    char *loc;
+    while ((loc = strstr(str, "$$"))) {
+        // create copy of input with enough room for pid
+        char *expandedStr = calloc(strlen(str) + strlen(procId) + 1, sizeof(char));
+        strcpy(expandedStr, str);
+
+        // calculate index of initial $ and index after second $ for srtcat
+        size_t startIndex = loc - str;
+        size_t endIndex = startIndex + 2;
+
+        // replace the starting $ with \0 so we can cat and overwrite with pid
+        expandedStr[startIndex] = '\0';	
+        strcat(expandedStr, procId);
+        // sprintf has written trailing \0 to procId so we can 
+        // cat what's left after second $ in original string
+        strcat(expandedStr, str + endIndex);
+
+        // copy the expanded string to the original location and free memory
+        strcpy(str, expandedStr);
+        free(expandedStr);
+    }
+}
+
+static double elapsedUs(struct timespec *start, struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1e6 + (end->tv_nsec - start->tv_nsec) / 1e3;
+}
+
+int main(int argc, char *argv[])
+{
+    int iterations = 20000;
+    size_t lineLength = 2000;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:l:")) != -1) {
+        switch (opt) {
+            case 'n':
+                iterations = atoi(optarg);
+                break;
+            case 'l':
+                lineLength = atol(optarg);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n iterations] [-l line_length]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    // build a command line of $$-tagged temp paths
+    const char *word = " /tmp/job_$$.out";
+    size_t wordLength = strlen(word);
+    char *line = malloc(lineLength + wordLength + 4);
+    strcpy(line, "cat");
+    int occurrences = 0;
+    while (strlen(line) + wordLength <= lineLength) {
+        strcat(line, word);
+        occurrences++;
+    }
+
+    // the legacy function expands in place and needs room for the result
+    size_t room = strlen(line) * 4 + 64;
+    char *work = malloc(room);
+    char *out = NULL;
+    struct arena arena = { 0 };
+    struct expandVars vars = { 0, 0 };
+    struct timespec start, end;
+
+    expandInit(getpid());
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < iterations; i++) {
+        strcpy(work, line);
+        expandInput(work, getpid());
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double legacyUs = elapsedUs(&start, &end) / iterations;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < iterations; i++) {
+        // the shell resets its command arena after every line
+        arenaReset(&arena);
+        out = expandLine(&arena, line, NULL, &vars);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double singlePassUs = elapsedUs(&start, &end) / iterations;
+
+    if (strcmp(work, out) != 0) {
+        fprintf(stderr, "expansions differ\n");
+        return 1;
+    }
+
+    printf("line_bytes=%zu occurrences=%d legacy_us=%.2f single_pass_us=%.2f speedup=%.1fx\n",
+            strlen(line), occurrences, legacyUs, singlePassUs, legacyUs / singlePassUs);
+
+    free(line);
+    free(work);
+    arenaFree(&arena);
+    return 0;
+}
@@ -0,0 +1,201 @@
+/*******************************************************************************
+*
+* File:     globbench.c
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Benchmark for kell-shell pathname expansion. Fills a scratch directory
+*   with files (100000 by default, half of them *.log) and times matching
+*   `*.log` in it three ways: with globExpand() and a fresh cache, as the
+*   first pattern of a command; with the cache of an earlier pattern, as
+*   `*.log` following `*.txt` in the same command; and with the C
+*   library's glob(). A `**` pattern over a tree of directories is timed
+*   against it too. The scratch files are removed at the end.
+*
+*   Usage: globbench [-n files] [-r rounds]
+*
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <glob.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "../arena.h"
+#include "../glob.h"
+
+#define TREE_DIRS 100
+
+/**
+*
+* static double elapsedMs(struct timespec *start, struct timespec *end,
+*                         int rounds)
+*
+* Summary:
+*       Average time per round in milliseconds
+*
+**/
+static double elapsedMs(struct timespec *start, struct timespec *end, int rounds)
+{
+    return ((end->tv_sec - start->tv_sec) * 1e3 + (end->tv_nsec - start->tv_nsec) / 1e6)
+            / rounds;
+}
+
+/**
+*
+* static void makeFiles(const char *dir, int count)
+*
+* Summary:
+*       Creates count empty files in dir, every other one ending in .log
+*
+**/
+static void makeFiles(const char *dir, int count)
+{
+    char path[256];
+    for (int i = 0; i < count; i++) {
+        snprintf(path, sizeof(path), "%s/file%07d.%s", dir, i, (i % 2) ? "txt" : "log");
+        close(open(path, O_WRONLY | O_CREAT, 0644));
+    }
+}
+
+/**
+*
+* static void removeFiles(const char *dir, int count)
+*
+* Summary:
+*       Removes what makeFiles() created, and the directory
+*
+**/
+static void removeFiles(const char *dir, int count)
+{
+    char path[256];
+    for (int i = 0; i < count; i++) {
+        snprintf(path, sizeof(path), "%s/file%07d.%s", dir, i, (i % 2) ? "txt" : "log");
+        unlink(path);
+    }
+    rmdir(dir);
+}
+
+int main(int argc, char *argv[])
+{
+    int count = 100000;
+    int rounds = 10;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:r:")) != -1) {
+        switch (opt) {
+            case 'n':
+                count = atoi(optarg);
+                break;
+            case 'r':
+                rounds = atoi(optarg);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n files] [-r rounds]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (count <= 0 || rounds <= 0) {
+        fprintf(stderr, "globbench: files and rounds must be positive\n");
+        return 1;
+    }
+
+    char root[] = "/tmp/globbench.XXXXXX";
+    if (!mkdtemp(root)) {
+        perror("globbench: mkdtemp");
+        return 1;
+    }
+    char flat[64];
+    snprintf(flat, sizeof(flat), "%s/flat", root);
+    mkdir(flat, 0755);
+    makeFiles(flat, count);
+
+    // the same number of files spread over a tree
+    char tree[64], dir[128];
+    snprintf(tree, sizeof(tree), "%s/tree", root);
+    mkdir(tree, 0755);
+    for (int i = 0; i < TREE_DIRS; i++) {
+        snprintf(dir, sizeof(dir), "%s/d%03d", tree, i);
+        mkdir(dir, 0755);
+        makeFiles(dir, count / TREE_DIRS);
+    }
+
+    char pattern[128], other[128], deep[128];
+    snprintf(pattern, sizeof(pattern), "%s/*.log", flat);
+    snprintf(other, sizeof(other), "%s/*.txt", flat);
+    snprintf(deep, sizeof(deep), "%s/**/*.log", tree);
+    struct arena arena = { 0 };
+    struct timespec start, end;
+    char **matches;
+    int found = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < rounds; i++) {
+        arenaReset(&arena);
+        struct globCache cache = { .arena = &arena };
+        found = globExpand(pattern, strlen(pattern), &cache, 0, &matches);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double coldMs = elapsedMs(&start, &end, rounds);
+
+    struct globCache cache = { .arena = &arena };
+    arenaReset(&arena);
+    globExpand(other, strlen(other), &cache, 0, &matches);
+    struct arenaMark mark = arenaMark(&arena);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < rounds; i++) {
+        arenaRewind(&arena, mark);
+        globExpand(pattern, strlen(pattern), &cache, 0, &matches);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double cachedMs = elapsedMs(&start, &end, rounds);
+
+    int libcFound = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < rounds; i++) {
+        glob_t result;
+        glob(pattern, 0, NULL, &result);
+        libcFound = result.gl_pathc;
+        globfree(&result);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double libcMs = elapsedMs(&start, &end, rounds);
+
+    int deepFound = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < rounds; i++) {
+        arenaReset(&arena);
+        struct globCache fresh = { .arena = &arena };
+        deepFound = globExpand(deep, strlen(deep), &fresh, 0, &matches);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double deepMs = elapsedMs(&start, &end, rounds);
+
+    // a limit far below the matches stops the walk early
+    arenaReset(&arena);
+    struct globCache limited = { .arena = &arena };
+    int overflow = globExpand(pattern, strlen(pattern), &limited, 64 * 1024, &matches);
+
+    printf("files=%d matches=%d glob_ms=%.2f glob_cached_ms=%.2f libc_glob_ms=%.2f"
+            " speedup=%.1fx\n", count, found, coldMs, cachedMs, libcMs, libcMs / coldMs);
+    printf("files=%d recursive_matches=%d recursive_ms=%.2f limit_overflow=%d\n",
+            count, deepFound, deepMs, overflow == -1);
+    if (found != libcFound) {
+        fprintf(stderr, "globbench: %d matches, glob() found %d\n", found, libcFound);
+    }
+
+    arenaFree(&arena);
+    removeFiles(flat, count);
+    for (int i = 0; i < TREE_DIRS; i++) {
+        snprintf(dir, sizeof(dir), "%s/d%03d", tree, i);
+        removeFiles(dir, count / TREE_DIRS);
+    }
+    rmdir(tree);
+    rmdir(root);
+    return found == libcFound ? 0 : 1;
+}
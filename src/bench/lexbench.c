@@ -0,0 +1,153 @@
+/*******************************************************************************
+*
+* File:     lexbench.c
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Benchmark for the kell-shell lexer. Compares the original strtok_r()
+*   tokenizer, which needed an expanded copy of the line first, with
+*   lexLine(), which expands and tokenizes in the same pass, and reports
+*   tokens per second for both.
+*
+*   Usage: lexbench [-n iterations] [-l line_length] [-q]
+*          -q quotes every other word to exercise the slow path
+*
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../arena.h"
+#include "../expand.h"
+#include "../lex.h"
+
+/**
+*
+* static int legacyTokenize(char *str, char *args[], int maxArgs)
+*
+* Summary:
+*       The original tokenizer: splits on single spaces and compares every
+*       token against the redirection operators
+*
+* Parameters:   char* for the line, modified in place
+*               array of char* for the arguments
+*               int for the size of the array
+*
+* Returns:      number of tokens
+*
+**/
+static int legacyTokenize(char *str, char *args[], int maxArgs)
+{
+    int count = 0;
+    char *saveptr;
+    char *token = strtok_r(str, " ", &saveptr);
+    while (token != NULL && count < maxArgs - 1) {
+        if (strcmp(token, "<") == 0 || strcmp(token, ">") == 0) {
+            token = strtok_r(NULL, " ", &saveptr);
+        }
+        else {
+            args[count++] = token;
+        }
+        if (!token) {
+            break;
+        }
+        token = strtok_r(NULL, " ", &saveptr);
+    }
+    args[count] = NULL;
+    return count;
+}
+
+static double elapsedUs(struct timespec *start, struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1e6 + (end->tv_nsec - start->tv_nsec) / 1e3;
+}
+
+int main(int argc, char *argv[])
+{
+    int iterations = 20000;
+    size_t lineLength = 2000;
+    _Bool quoted = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:l:q")) != -1) {
+        switch (opt) {
+            case 'n':
+                iterations = atoi(optarg);
+                break;
+            case 'l':
+                lineLength = atol(optarg);
+                break;
+            case 'q':
+                quoted = 1;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n iterations] [-l line_length] [-q]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    // build a typical generated command line: a file list and a redirect
+    char *line = malloc(lineLength + 64);
+    strcpy(line, "cat");
+    int words = 0;
+    while (strlen(line) + 24 <= lineLength) {
+        char word[32];
+        if (quoted && words % 2) {
+            snprintf(word, sizeof(word), " 'src/file_%05d.c'", words);
+        }
+        else {
+            snprintf(word, sizeof(word), " src/file_%05d.c", words);
+        }
+        strcat(line, word);
+        words++;
+    }
+    strcat(line, " > out.txt");
+    size_t length = strlen(line);
+
+    char *work = malloc(length * 4 + 64);
+    char **args = malloc((length + 2) * sizeof(char *));
+    struct arena arena = { 0 };
+    struct expandVars vars = { 0, 0 };
+    struct token *tokens;
+    struct timespec start, end;
+    int legacyTokens = 0;
+    int lexTokens = 0;
+
+    expandInit(getpid());
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < iterations; i++) {
+        // the old path expanded into a copy before tokenizing it
+        arenaReset(&arena);
+        char *expanded = expandLine(&arena, line, NULL, &vars);
+        strcpy(work, expanded);
+        legacyTokens = legacyTokenize(work, args, length + 2);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double legacyUs = elapsedUs(&start, &end) / iterations;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < iterations; i++) {
+        // the lexer also works on its own copy, which it modifies
+        arenaReset(&arena);
+        char *copy = arenaStrndup(&arena, line, length);
+        lexTokens = lexLine(copy, length, &arena, &vars, &tokens);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double lexUs = elapsedUs(&start, &end) / iterations;
+
+    printf("line_bytes=%zu tokens=%d legacy_us=%.2f lex_us=%.2f "
+            "legacy_mtok_s=%.1f lex_mtok_s=%.1f\n",
+            length, lexTokens, legacyUs, lexUs,
+            legacyTokens / legacyUs, lexTokens / lexUs);
+
+    free(line);
+    free(work);
+    free(args);
+    arenaFree(&arena);
+    return 0;
+}
@@ -0,0 +1,386 @@
+/*******************************************************************************
+*
+* File:     lexfuzz.c
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Fuzz target for the kell-shell lexer. Every input line goes through
+*   lexLine(), and every word it keeps the source of goes through
+*   lexExpandWord() as it would when the command runs, with variables
+*   that split and hold wildcards and a $(...) that writes several words.
+*   Every byte of every token is read back, so AddressSanitizer sees any
+*   token that points outside its memory.
+*
+*   Built by `make bench/lexfuzz` with AddressSanitizer and
+*   UndefinedBehaviorSanitizer, it runs on its own: random lines and
+*   mutations of shell-like seed lines, each made from the seed and its
+*   iteration number, so a failure is reproduced with -s and -r. It also
+*   defines LLVMFuzzerTestOneInput() for libFuzzer:
+*
+*       clang -DKELL_LIBFUZZER -fsanitize=fuzzer,address,undefined \
+*           -D_GNU_SOURCE bench/lexfuzz.c lex.c expand.c vars.c arena.c
+*
+*   Usage: lexfuzz [-n iterations] [-s seed] [-r iteration]
+*          -r runs one iteration only and prints its line to stderr
+*
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "../arena.h"
+#include "../expand.h"
+#include "../lex.h"
+#include "../vars.h"
+
+#define FUZZ_LINE_MAX 512
+
+extern char **environ;
+
+static const char *seeds[] = {
+    "echo hello world",
+    "ls -l /tmp > out.txt 2>&1 < in.txt",
+    "cat <<EOF | wc -l && echo ok || echo failed &",
+    "x=\"a b\" y='c d' env | grep -v '^_' ; echo $x$y",
+    "echo ${HOME}/\"$USER\" '$HOME' \\$HOME $$ $? $! $# $@ $* $0 $1 ${9}",
+    "echo $(echo inner $(echo nested)) `date +%s` \"$(pwd)\"",
+    "for f in *.c src/**/*.h [a-c]?.txt; do echo \"$f\"; done",
+    "if [ -n \"$X\" ]; then (cd /; pwd) else { echo no; } fi",
+    "printf '%s\\n' a\\ b 'c\\'d' \"e\\\"f\" 3>&- 4<&0 &>> log <<< here",
+    "echo $SPLIT $GLOBS \"$SPLIT\" ${EMPTY} x${EMPTY}y $UNSET",
+    "a=1 b=$(cat) c=`x` cmd \"${a}\"* '*'$b [\"a\"]",
+    "echo \\*.c \"*\".c '['abc] [!x] [^y] [[:alpha:]]* \\\\ \"\\\\\"",
+};
+
+static const char interesting[] = "$'\"`\\(){}[]*?!<>|&;#=~ -\t/0123456789abcxyzHOME@";
+
+static uint64_t rngState;
+
+/**
+*
+* static uint64_t fuzzRandom(void)
+*
+* Summary:
+*       Next number from a splitmix64 generator
+*
+**/
+static uint64_t fuzzRandom(void)
+{
+    uint64_t z = (rngState += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/**
+*
+* static char fuzzByte(void)
+*
+* Summary:
+*       A byte for a line: mostly shell syntax, sometimes anything but a
+*       newline, which never reaches the lexer
+*
+**/
+static char fuzzByte(void)
+{
+    if (fuzzRandom() % 8 == 0) {
+        char c = fuzzRandom() % 256;
+        return (c == '\n') ? ' ' : c;
+    }
+    return interesting[fuzzRandom() % (sizeof(interesting) - 1)];
+}
+
+/**
+*
+* static size_t fuzzLine(char *line)
+*
+* Summary:
+*       Makes a random line, or a seed line with a few mutations
+*
+* Parameters:   char* with room for FUZZ_LINE_MAX bytes
+*
+* Returns:      length of the line
+*
+**/
+static size_t fuzzLine(char *line)
+{
+    size_t numSeeds = sizeof(seeds) / sizeof(seeds[0]);
+    size_t length;
+
+    if (fuzzRandom() % 4 == 0) {
+        length = fuzzRandom() % 64;
+        for (size_t i = 0; i < length; i++) {
+            line[i] = fuzzByte();
+        }
+        return length;
+    }
+
+    const char *seed = seeds[fuzzRandom() % numSeeds];
+    length = strlen(seed);
+    memcpy(line, seed, length);
+    int mutations = 1 + fuzzRandom() % 8;
+    for (int m = 0; m < mutations; m++) {
+        size_t at = length ? fuzzRandom() % (length + 1) : 0;
+        switch (fuzzRandom() % 5) {
+            case 0:     // replace a byte
+                if (at < length) {
+                    line[at] = fuzzByte();
+                }
+                break;
+            case 1:     // insert a byte
+                if (length < FUZZ_LINE_MAX - 1) {
+                    memmove(line + at + 1, line + at, length - at);
+                    line[at] = fuzzByte();
+                    length++;
+                }
+                break;
+            case 2:     // cut a run of bytes
+                if (at < length) {
+                    size_t cut = 1 + fuzzRandom() % (length - at);
+                    memmove(line + at, line + at + cut, length - at - cut);
+                    length -= cut;
+                }
+                break;
+            case 3:     // cut the line short
+                length = at;
+                break;
+            default: {  // splice in part of another seed
+                const char *other = seeds[fuzzRandom() % numSeeds];
+                size_t otherLength = strlen(other);
+                size_t from = fuzzRandom() % otherLength;
+                size_t count = 1 + fuzzRandom() % (otherLength - from);
+                if (length + count < FUZZ_LINE_MAX) {
+                    memmove(line + at + count, line + at, length - at);
+                    memcpy(line + at, other + from, count);
+                    length += count;
+                }
+                break;
+            }
+        }
+    }
+    return length;
+}
+
+/**
+*
+* static const char *fuzzSubstitute(const char *command, size_t length,
+*                                   size_t *outputLength, void *context)
+*
+* Summary:
+*       Stands in for running a $(...): output of several words with a
+*       wildcard and trailing newlines
+*
+**/
+static const char *fuzzSubstitute(const char *command, size_t length,
+        size_t *outputLength, void *context)
+{
+    static const char output[] = "sub  * [x]\tout\n\n";
+    *outputLength = sizeof(output) - 1;
+    return output;
+}
+
+/**
+*
+* static unsigned fuzzTouch(const struct token *tokens, int count)
+*
+* Summary:
+*       Reads every byte of every token
+*
+* Returns:      a sum of the bytes, so the reads are not optimized away
+*
+**/
+static unsigned fuzzTouch(const struct token *tokens, int count)
+{
+    unsigned sum = 0;
+    for (int i = 0; i < count; i++) {
+        for (size_t j = 0; j < tokens[i].length; j++) {
+            sum += (unsigned char)tokens[i].text[j];
+        }
+        for (size_t j = 0; tokens[i].source && j < tokens[i].sourceLength; j++) {
+            sum += (unsigned char)tokens[i].source[j];
+        }
+    }
+    return sum;
+}
+
+static struct arena fuzzArena;
+static struct expandVars fuzzVars;
+static long numTokens = 0;
+static long numWords = 0;
+
+/**
+*
+* static void fuzzSetUp(void)
+*
+* Summary:
+*       Sets up the variables, positional parameters and $(...) the lines
+*       expand with
+*
+**/
+static void fuzzSetUp(void)
+{
+    static char *args[] = { "one", "two words", "*", NULL };
+
+    expandInit(getpid());
+    varsInit(environ);
+    varsSet("SPLIT", "  a  b\tc ", 0);
+    varsSet("GLOBS", "*.c [ab] ?", 0);
+    varsSet("EMPTY", "", 0);
+    fuzzVars.name = "lexfuzz";
+    fuzzVars.args = args;
+    fuzzVars.numArgs = 3;
+    fuzzVars.substitute = fuzzSubstitute;
+}
+
+/**
+*
+* int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+*
+* Summary:
+*       Lexes one line and expands its words again, as a command would
+*
+* Returns:      0
+*
+**/
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    static _Bool ready = 0;
+    if (!ready) {
+        fuzzSetUp();
+        ready = 1;
+    }
+
+    // the lexer works on its own NUL terminated copy, which it modifies
+    arenaReset(&fuzzArena);
+    char *line = arenaStrndup(&fuzzArena, (const char *)data, size);
+    struct token *tokens;
+    int count = lexLine(line, size, &fuzzArena, &fuzzVars, &tokens);
+    if (count <= 0) {
+        return 0;
+    }
+    numTokens += count;
+    volatile unsigned sum = fuzzTouch(tokens, count);
+
+    for (int i = 0; i < count; i++) {
+        if (tokens[i].type != TOKEN_WORD || !tokens[i].source) {
+            continue;
+        }
+        struct token *words;
+        int numExpanded = lexExpandWord(&tokens[i], &fuzzArena, &fuzzVars, &words);
+        if (numExpanded > 0) {
+            numWords += numExpanded;
+            sum += fuzzTouch(words, numExpanded);
+        }
+    }
+    (void)sum;
+    return 0;
+}
+
+#ifndef KELL_LIBFUZZER
+
+static uint64_t fuzzSeed;
+static volatile long fuzzIteration = -1;
+
+/**
+*
+* const char *__asan_default_options(void)
+* const char *__ubsan_default_options(void)
+*
+* Summary:
+*       Have the sanitizers abort after a report instead of exiting, so
+*       fuzzDied() gets to run
+*
+**/
+const char *__asan_default_options(void)
+{
+    return "abort_on_error=1";
+}
+
+const char *__ubsan_default_options(void)
+{
+    return "abort_on_error=1:print_stacktrace=1";
+}
+
+/**
+*
+* static void fuzzDied(int signo)
+*
+* Summary:
+*       Tells how to run the failing line again, on SIGABRT from a
+*       sanitizer or a failed assertion
+*
+**/
+static void fuzzDied(int signo)
+{
+    char message[128];
+    int length = snprintf(message, sizeof(message),
+            "lexfuzz: failed at iteration %ld, rerun with -s %llu -r %ld\n",
+            fuzzIteration, (unsigned long long)fuzzSeed, fuzzIteration);
+    write(STDERR_FILENO, message, length);
+    signal(SIGABRT, SIG_DFL);
+    raise(SIGABRT);
+}
+
+int main(int argc, char *argv[])
+{
+    long iterations = 200000;
+    long replay = -1;
+    int opt;
+
+    fuzzSeed = time(NULL);
+    while ((opt = getopt(argc, argv, "n:s:r:")) != -1) {
+        switch (opt) {
+            case 'n':
+                iterations = atol(optarg);
+                break;
+            case 's':
+                fuzzSeed = strtoull(optarg, NULL, 10);
+                break;
+            case 'r':
+                replay = atol(optarg);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n iterations] [-s seed] [-r iteration]\n",
+                        argv[0]);
+                return 1;
+        }
+    }
+
+    signal(SIGABRT, fuzzDied);
+    // syntax errors are printed to stdout, and there are a lot of them
+    if (!freopen("/dev/null", "w", stdout)) {
+        perror("lexfuzz: /dev/null");
+        return 1;
+    }
+
+    char line[FUZZ_LINE_MAX];
+    struct timespec start, end;
+    long first = (replay >= 0) ? replay : 0;
+    long last = (replay >= 0) ? replay + 1 : iterations;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (fuzzIteration = first; fuzzIteration < last; fuzzIteration++) {
+        rngState = fuzzSeed ^ ((uint64_t)fuzzIteration * 0xd1b54a32d192ed03ULL);
+        size_t length = fuzzLine(line);
+        if (replay >= 0) {
+            fprintf(stderr, "%.*s\n", (int)length, line);
+        }
+        LLVMFuzzerTestOneInput((const uint8_t *)line, length);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    fprintf(stderr, "seed=%llu iterations=%ld tokens=%ld words=%ld seconds=%.2f\n",
+            (unsigned long long)fuzzSeed, last - first, numTokens, numWords,
+            (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9);
+    arenaFree(&fuzzArena);
+    varsFree();
+    return 0;
+}
+
+#endif
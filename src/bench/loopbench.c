@@ -0,0 +1,243 @@
+/*******************************************************************************
+*
+* File:     loopbench.c
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Benchmark for kell-shell control flow. Runs the shell on generated
+*   scripts that run the same `for` loop body the same number of times:
+*   written out one single-round loop per line, which reads, lexes and
+*   parses every round, and in nested `for` loops and a function called
+*   from them, which are parsed once. A sourced file is timed with its
+*   parsed commands cached and with KELL_SCRIPT_CACHE=0. Reports the
+*   average time per round, or per `source` for the last two.
+*
+*   Usage: loopbench [-n rounds] [-s shell]
+*          -s path of the shell to run, ./kell-shell by default
+*
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#define OUTER 100               // rounds of the outer loop
+#define SOURCED_LINES 20        // commands in the sourced file
+
+extern char **environ;
+
+/**
+*
+* static void writeWords(FILE *script, int count)
+*
+* Summary:
+*       Writes the word list of a `for` loop: 0 to count - 1
+*
+**/
+static void writeWords(FILE *script, int count)
+{
+    for (int i = 0; i < count; i++) {
+        fprintf(script, " %d", i);
+    }
+}
+
+/**
+*
+* static int writeScript(const char *path, const char *kind, int count,
+*                        const char *sourced)
+*
+* Summary:
+*       Writes a script that runs `: $b $?` count times in the given way,
+*       with b set by a `for` loop
+*
+* Parameters:   char* for the path to write
+*               char* for how: "lines", "loop", "function" or "source"
+*               int for the number of rounds, or of `source`s
+*               char* for the path of the file to source
+*
+* Returns:      0 on success, -1 if the file cannot be written
+*
+**/
+static int writeScript(const char *path, const char *kind, int count, const char *sourced)
+{
+    FILE *script = fopen(path, "w");
+    if (!script) {
+        return -1;
+    }
+
+    if (strcmp(kind, "lines") == 0) {
+        for (int i = 0; i < count; i++) {
+            fprintf(script, "for b in %d; do : $b $?; done\n", i);
+        }
+        return fclose(script);
+    }
+
+    if (strcmp(kind, "function") == 0) {
+        fprintf(script, "f() {\n    : $b $?\n}\n");
+    }
+    fprintf(script, "for a in");
+    writeWords(script, OUTER);
+    fprintf(script, "\ndo\n    for b in");
+    writeWords(script, count / OUTER);
+    if (strcmp(kind, "loop") == 0) {
+        fprintf(script, "\n    do\n        : $b $?\n    done\ndone\n");
+    }
+    else if (strcmp(kind, "function") == 0) {
+        fprintf(script, "\n    do\n        f\n    done\ndone\n");
+    }
+    else {
+        fprintf(script, "\n    do\n        . %s $a\n    done\ndone\n", sourced);
+    }
+    return fclose(script);
+}
+
+/**
+*
+* static int writeSourced(const char *path)
+*
+* Summary:
+*       Writes the file the "source" script sources, dated in the past so
+*       the shell may cache it
+*
+* Returns:      0 on success, -1 if the file cannot be written
+*
+**/
+static int writeSourced(const char *path)
+{
+    FILE *script = fopen(path, "w");
+    if (!script) {
+        return -1;
+    }
+    fprintf(script, "# sourced by loopbench\n");
+    for (int i = 0; i < SOURCED_LINES - 1; i++) {
+        fprintf(script, ": %d $1 \"$#\" && : ok\n", i);
+    }
+    fprintf(script, "if test $1 = 0; then return 0; fi\n");
+    if (fclose(script) == EOF) {
+        return -1;
+    }
+
+    struct timespec times[2];
+    clock_gettime(CLOCK_REALTIME, &times[0]);
+    times[0].tv_sec -= 60;
+    times[1] = times[0];
+    return utimensat(AT_FDCWD, path, times, 0);
+}
+
+/**
+*
+* static double runScript(const char *shell, const char *path)
+*
+* Summary:
+*       Runs the shell on a script with output going to /dev/null
+*
+* Returns:      elapsed time in microseconds, or -1 if the shell failed
+*
+**/
+static double runScript(const char *shell, const char *path)
+{
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+
+    char *argv[] = { (char *)shell, (char *)path, NULL };
+    struct timespec start, end;
+    pid_t pid;
+    int status;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (posix_spawn(&pid, shell, &actions, NULL, argv, environ) != 0) {
+        posix_spawn_file_actions_destroy(&actions);
+        return -1;
+    }
+    waitpid(pid, &status, 0);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    posix_spawn_file_actions_destroy(&actions);
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        return -1;
+    }
+    return (end.tv_sec - start.tv_sec) * 1e6 + (end.tv_nsec - start.tv_nsec) / 1e3;
+}
+
+int main(int argc, char *argv[])
+{
+    int count = 100000;
+    const char *shell = "./kell-shell";
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+        switch (opt) {
+            case 'n':
+                count = atoi(optarg);
+                break;
+            case 's':
+                shell = optarg;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n rounds] [-s shell]\n", argv[0]);
+                return 1;
+        }
+    }
+    count -= count % OUTER;
+    if (count <= 0) {
+        count = OUTER;
+    }
+    int sources = count / SOURCED_LINES;
+    sources -= sources % OUTER;
+    if (sources <= 0) {
+        sources = OUTER;
+    }
+
+    char linesPath[] = "/tmp/loopbench_lines.XXXXXX";
+    char loopPath[] = "/tmp/loopbench_loop.XXXXXX";
+    char functionPath[] = "/tmp/loopbench_function.XXXXXX";
+    char sourcePath[] = "/tmp/loopbench_source.XXXXXX";
+    char sourcedPath[] = "/tmp/loopbench_sourced.XXXXXX";
+    close(mkstemp(linesPath));
+    close(mkstemp(loopPath));
+    close(mkstemp(functionPath));
+    close(mkstemp(sourcePath));
+    close(mkstemp(sourcedPath));
+
+    if (writeScript(linesPath, "lines", count, NULL) == -1
+            || writeScript(loopPath, "loop", count, NULL) == -1
+            || writeScript(functionPath, "function", count, NULL) == -1
+            || writeScript(sourcePath, "source", sources, sourcedPath) == -1
+            || writeSourced(sourcedPath) == -1) {
+        perror("loopbench: script");
+        return 1;
+    }
+
+    double linesUs = runScript(shell, linesPath);
+    double loopUs = runScript(shell, loopPath);
+    double functionUs = runScript(shell, functionPath);
+    double cachedUs = runScript(shell, sourcePath);
+    setenv("KELL_SCRIPT_CACHE", "0", 1);
+    double uncachedUs = runScript(shell, sourcePath);
+    unsetenv("KELL_SCRIPT_CACHE");
+
+    unlink(linesPath);
+    unlink(loopPath);
+    unlink(functionPath);
+    unlink(sourcePath);
+    unlink(sourcedPath);
+
+    if (linesUs < 0 || loopUs < 0 || functionUs < 0 || cachedUs < 0 || uncachedUs < 0) {
+        fprintf(stderr, "loopbench: %s failed\n", shell);
+        return 1;
+    }
+
+    printf("rounds=%d lines_us=%.3f loop_us=%.3f function_us=%.3f speedup=%.1fx\n",
+            count, linesUs / count, loopUs / count, functionUs / count, linesUs / loopUs);
+    printf("sources=%d cached_us=%.2f uncached_us=%.2f speedup=%.1fx\n",
+            sources, cachedUs / sources, uncachedUs / sources, uncachedUs / cachedUs);
+    return 0;
+}
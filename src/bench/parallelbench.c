@@ -0,0 +1,119 @@
+/*******************************************************************************
+*
+* File:     parallelbench.c
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Benchmark for the kell-shell `parallel` built-in. Runs the same batch
+*   of CPU-bound jobs with -j 1, 2, ... up to the number of online CPUs
+*   and reports the wall time and speedup of each pool size.
+*
+*   Usage: parallelbench [-t tasks] [-w work] [-m max_jobs] [-s shell]
+*          -t number of jobs in the batch, 4 per CPU by default
+*          -w loop iterations each job spins for
+*          -m largest pool size to try, the CPU count by default
+*
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+extern char **environ;
+
+/**
+*
+* static double runParallel(const char *shell, int jobs, int tasks, int work)
+*
+* Summary:
+*       Runs one batch through `parallel -j jobs` in a fresh shell
+*
+* Returns:      elapsed time in seconds, or -1 if the shell failed
+*
+**/
+static double runParallel(const char *shell, int jobs, int tasks, int work)
+{
+    // every job spins in sh so the cost is CPU time, not process startup
+    size_t size = 128 + tasks * 8;
+    char *command = malloc(size);
+    int n = snprintf(command, size, "parallel -j %d sh -c "
+            "'i=0; while [ $i -lt %d ]; do i=$((i+1)); done' _ :::", jobs, work);
+    for (int i = 0; i < tasks; i++) {
+        n += snprintf(command + n, size - n, " %d", i);
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+
+    char *argv[] = { (char *)shell, "-c", command, NULL };
+    struct timespec start, end;
+    pid_t pid;
+    int status;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int error = posix_spawn(&pid, shell, &actions, NULL, argv, environ);
+    if (error == 0) {
+        waitpid(pid, &status, 0);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    posix_spawn_file_actions_destroy(&actions);
+    free(command);
+
+    if (error != 0 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        return -1;
+    }
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+int main(int argc, char *argv[])
+{
+    int cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int maxJobs = cpus;
+    int tasks = 4 * cpus;
+    int work = 20000;
+    const char *shell = "./kell-shell";
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:w:m:s:")) != -1) {
+        switch (opt) {
+            case 't':
+                tasks = atoi(optarg);
+                break;
+            case 'w':
+                work = atoi(optarg);
+                break;
+            case 'm':
+                maxJobs = atoi(optarg);
+                break;
+            case 's':
+                shell = optarg;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-t tasks] [-w work] [-m max_jobs] [-s shell]\n",
+                        argv[0]);
+                return 1;
+        }
+    }
+
+    double serial = 0;
+    for (int jobs = 1; jobs <= maxJobs; jobs++) {
+        double seconds = runParallel(shell, jobs, tasks, work);
+        if (seconds < 0) {
+            fprintf(stderr, "parallelbench: %s failed\n", shell);
+            return 1;
+        }
+        if (jobs == 1) {
+            serial = seconds;
+        }
+        printf("cpus=%d tasks=%d jobs=%d seconds=%.3f speedup=%.2fx\n",
+                cpus, tasks, jobs, seconds, serial / seconds);
+    }
+    return 0;
+}
@@ -0,0 +1,278 @@
+/*******************************************************************************
+*
+* File:     servebench.c
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Benchmark for kell-shell server mode. Runs the same command many times
+*   three ways: as `kell-shell -c command`, a new shell each time; over
+*   one connection to `kell-shell --serve`, a command at a time; and with
+*   a new connection, and so a new session, for each command. Then it
+*   runs the commands over several connections at once and reports how
+*   many the server finishes per second.
+*
+*   Usage: servebench [-n commands] [-j clients] [-e command] [-s shell]
+*          -e the command to run, `echo x` by default
+*          -s path of the shell to run, ./kell-shell by default
+*
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include "../serve.h"
+
+extern char **environ;
+
+/**
+*
+* static double elapsedUs(struct timespec *start)
+*
+* Summary:
+*       Microseconds since start
+*
+**/
+static double elapsedUs(struct timespec *start)
+{
+    struct timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return (end.tv_sec - start->tv_sec) * 1e6 + (end.tv_nsec - start->tv_nsec) / 1e3;
+}
+
+/**
+*
+* static int connectTo(const char *path)
+*
+* Summary:
+*       Connects to the server, waiting up to a second for it to listen
+*
+* Returns:      the connection, or -1
+*
+**/
+static int connectTo(const char *path)
+{
+    struct sockaddr_un address = { .sun_family = AF_UNIX };
+    snprintf(address.sun_path, sizeof(address.sun_path), "%s", path);
+    for (int tries = 0; tries < 100; tries++) {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (connect(fd, (struct sockaddr *)&address, sizeof(address)) == 0) {
+            return fd;
+        }
+        close(fd);
+        usleep(10000);
+    }
+    return -1;
+}
+
+/**
+*
+* static int runRemote(int fd, const char *command)
+*
+* Summary:
+*       Sends a command frame and reads frames until its status
+*
+* Returns:      the exit value of the command, or -1 if the connection
+*               failed
+*
+**/
+static int runRemote(int fd, const char *command)
+{
+    size_t length = strlen(command);
+    char request[SERVE_HEADER_SIZE + 4096];
+    uint32_t networkLength = htonl(length);
+    request[0] = SERVE_COMMAND;
+    memcpy(request + 1, &networkLength, sizeof(networkLength));
+    memcpy(request + SERVE_HEADER_SIZE, command, length);
+    if (write(fd, request, SERVE_HEADER_SIZE + length) != (ssize_t)(SERVE_HEADER_SIZE + length)) {
+        return -1;
+    }
+
+    // frames arrive whole or in pieces; only the last one matters
+    static char buffer[65536];
+    size_t have = 0;
+    for (;;) {
+        while (have >= SERVE_HEADER_SIZE) {
+            memcpy(&networkLength, buffer + 1, sizeof(networkLength));
+            size_t frame = SERVE_HEADER_SIZE + ntohl(networkLength);
+            if (frame > sizeof(buffer)) {
+                return -1;
+            }
+            if (have < frame) {
+                break;
+            }
+            if (buffer[0] == SERVE_STATUS) {
+                uint32_t value;
+                memcpy(&value, buffer + SERVE_HEADER_SIZE, sizeof(value));
+                return ntohl(value);
+            }
+            memmove(buffer, buffer + frame, have - frame);
+            have -= frame;
+        }
+        ssize_t n = read(fd, buffer + have, sizeof(buffer) - have);
+        if (n <= 0) {
+            return -1;
+        }
+        have += n;
+    }
+}
+
+/**
+*
+* static double runExec(const char *shell, const char *command, int count)
+*
+* Summary:
+*       Runs `shell -c command` count times, output to /dev/null
+*
+* Returns:      microseconds per command, or -1 if the shell failed
+*
+**/
+static double runExec(const char *shell, const char *command, int count)
+{
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    char *argv[] = { (char *)shell, "-c", (char *)command, NULL };
+    struct timespec start;
+    int failed = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < count && !failed; i++) {
+        pid_t pid;
+        int status;
+        if (posix_spawn(&pid, shell, &actions, NULL, argv, environ) != 0) {
+            failed = 1;
+            break;
+        }
+        waitpid(pid, &status, 0);
+        failed = !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+    }
+    double us = elapsedUs(&start) / count;
+    posix_spawn_file_actions_destroy(&actions);
+    return failed ? -1 : us;
+}
+
+/**
+*
+* static double runSessions(const char *path, const char *command, int count,
+*                           _Bool reconnect)
+*
+* Summary:
+*       Runs a command count times on the server, over one connection or
+*       over a new one each time
+*
+* Returns:      microseconds per command, or -1 if a command failed
+*
+**/
+static double runSessions(const char *path, const char *command, int count,
+        _Bool reconnect)
+{
+    struct timespec start;
+    int fd = -1;
+    int failed = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < count && !failed; i++) {
+        if (fd == -1) {
+            fd = connectTo(path);
+        }
+        failed = (fd == -1 || runRemote(fd, command) != 0);
+        if (reconnect && fd != -1) {
+            close(fd);
+            fd = -1;
+        }
+    }
+    double us = elapsedUs(&start) / count;
+    if (fd != -1) {
+        close(fd);
+    }
+    return failed ? -1 : us;
+}
+
+int main(int argc, char *argv[])
+{
+    int count = 1000;
+    int clients = 4;
+    const char *command = "echo x";
+    const char *shell = "./kell-shell";
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:j:e:s:")) != -1) {
+        switch (opt) {
+            case 'n':
+                count = atoi(optarg);
+                break;
+            case 'j':
+                clients = atoi(optarg);
+                break;
+            case 'e':
+                command = optarg;
+                break;
+            case 's':
+                shell = optarg;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n commands] [-j clients] [-e command]"
+                        " [-s shell]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (count <= 0 || clients <= 0 || strlen(command) > 4096) {
+        fprintf(stderr, "servebench: bad count, clients or command\n");
+        return 1;
+    }
+
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/servebench.%d.sock", (int)getpid());
+    char *serveArgv[] = { (char *)shell, "--serve", path, NULL };
+    pid_t server;
+    if (posix_spawn(&server, shell, NULL, NULL, serveArgv, environ) != 0) {
+        perror("servebench: server");
+        return 1;
+    }
+
+    double execUs = runExec(shell, command, count);
+    double serveUs = runSessions(path, command, count, 0);
+    double sessionUs = runSessions(path, command, count, 1);
+
+    // the same number of commands split over clients connections at once
+    struct timespec start;
+    int perClient = (count + clients - 1) / clients;
+    int failed = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < clients; i++) {
+        if (fork() == 0) {
+            _exit(runSessions(path, command, perClient, 0) < 0);
+        }
+    }
+    for (int i = 0; i < clients; i++) {
+        int status;
+        wait(&status);
+        failed |= !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+    }
+    double concurrentUs = elapsedUs(&start);
+
+    kill(server, SIGTERM);
+    waitpid(server, NULL, 0);
+
+    if (execUs < 0 || serveUs < 0 || sessionUs < 0 || failed) {
+        fprintf(stderr, "servebench: `%s` failed\n", command);
+        return 1;
+    }
+    printf("commands=%d exec_us=%.1f serve_us=%.1f session_us=%.1f speedup=%.1fx\n",
+            count, execUs, serveUs, sessionUs, execUs / serveUs);
+    printf("clients=%d commands=%d commands_per_s=%.0f\n",
+            clients, perClient * clients, perClient * clients / (concurrentUs / 1e6));
+    return 0;
+}
@@ -0,0 +1,632 @@
+/*******************************************************************************
+*
+* File:     shellbench.c
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Overhead and regression benchmark for kell-shell, run by `make bench`.
+*
+*   In pty mode the shell runs on a pseudo-terminal exactly as a user sees
+*   it, and each command is timed from writing its line to the next prompt
+*   appearing. In pipe mode a script of the same commands is piped to the
+*   shell's stdin and the time per command is the fastest of 5 runs, less
+*   the time of an empty run, divided by the number of commands. Two
+*   throughput scenarios only run piped: a large script and lines holding
+*   thousands of `$$` expansions.
+*
+*   Every result is one line of key=value pairs. Given a baseline file in
+*   the same format (-b), each result is compared with the baseline's
+*   mean and a mean that grew by more than the threshold is reported as a
+*   regression.
+*
+*   Usage: shellbench [-s shell] [-n pty_iterations] [-N pipe_commands]
+*                     [-b baseline] [-o results] [-t threshold_percent]
+*          -s path of the shell to run, ./kell-shell by default
+*          -o also writes the results to a file, for use as a baseline
+*
+*   Exit value: 0, 1 if the shell could not be run, 2 on a regression.
+*
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pty.h>
+#include <signal.h>
+#include <spawn.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/wait.h>
+
+#define PROMPT "k$: "
+#define PTY_TIMEOUT_MS 10000
+#define MAX_RESULTS 32
+#define PIPE_RUNS 5             // piped scripts report their fastest run
+
+extern char **environ;
+
+struct scenario {
+    const char *name;
+    const char *command;        // one line, without the newline
+};
+
+// prompt-to-prompt scenarios, run in both modes
+static const struct scenario scenarios[] = {
+    { "builtin",    "true" },
+    { "external",   "/bin/true" },
+    { "redirect",   "echo redirected > /tmp/shellbench.out" },
+    { "background", "/bin/true &" },
+};
+
+struct ptyShell {
+    pid_t pid;
+    int fd;                 // master side of the pty
+    char buffer[65536];     // output read but not yet consumed
+    size_t length;
+    _Bool sawDone;          // consumed output held a job completion
+};
+
+struct result {
+    char name[32];
+    char mode[8];
+    int count;
+    double meanUs;
+};
+
+static struct result results[MAX_RESULTS];
+static int numResults = 0;
+static FILE *resultsFile = NULL;
+
+static int compareDouble(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double elapsedUs(struct timespec *start, struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1e6 + (end->tv_nsec - start->tv_nsec) / 1e3;
+}
+
+/**
+*
+* static void report(const char *name, const char *mode, int count,
+*                    double meanUs, const char *extra)
+*
+* Summary:
+*       Prints one result line, and saves it for the baseline comparison
+*
+* Parameters:   char* for the scenario name
+*               char* for the mode, pty or pipe
+*               int for the number of commands measured
+*               double for the mean time per command in microseconds
+*               char* for any further key=value pairs, or ""
+*
+* Returns:      nothing.
+*
+**/
+static void report(const char *name, const char *mode, int count,
+        double meanUs, const char *extra)
+{
+    char line[256];
+    snprintf(line, sizeof(line), "scenario=%s mode=%s n=%d mean_us=%.2f%s%s\n",
+            name, mode, count, meanUs, extra[0] ? " " : "", extra);
+    fputs(line, stdout);
+    if (resultsFile) {
+        fputs(line, resultsFile);
+    }
+
+    if (numResults < MAX_RESULTS) {
+        struct result *r = &results[numResults++];
+        snprintf(r->name, sizeof(r->name), "%s", name);
+        snprintf(r->mode, sizeof(r->mode), "%s", mode);
+        r->count = count;
+        r->meanUs = meanUs;
+    }
+}
+
+/**
+*
+* static int ptyWaitFor(struct ptyShell *shell, const char *needle)
+*
+* Summary:
+*       Reads shell output until it contains a string, then consumes the
+*       output up to and including it
+*
+* Parameters:   pointer to the shell on the pty
+*               char* for the string to wait for
+*
+* Returns:      0 once found, -1 on timeout or if the shell went away
+*
+**/
+static int ptyWaitFor(struct ptyShell *shell, const char *needle)
+{
+    size_t needleLength = strlen(needle);
+
+    while (1) {
+        char *found = memmem(shell->buffer, shell->length, needle, needleLength);
+        if (found) {
+            size_t used = found - shell->buffer + needleLength;
+            if (memmem(shell->buffer, used, "is done", 7)) {
+                shell->sawDone = 1;
+            }
+            memmove(shell->buffer, shell->buffer + used, shell->length - used);
+            shell->length -= used;
+            return 0;
+        }
+        if (shell->length == sizeof(shell->buffer)) {
+            // keep the tail, which may hold the start of the needle
+            size_t keep = needleLength;
+            if (memmem(shell->buffer, shell->length, "is done", 7)) {
+                shell->sawDone = 1;
+            }
+            memmove(shell->buffer, shell->buffer + shell->length - keep, keep);
+            shell->length = keep;
+        }
+
+        struct pollfd pfd = { shell->fd, POLLIN, 0 };
+        if (poll(&pfd, 1, PTY_TIMEOUT_MS) <= 0) {
+            return -1;
+        }
+        ssize_t n = read(shell->fd, shell->buffer + shell->length,
+                sizeof(shell->buffer) - shell->length);
+        if (n <= 0) {
+            return -1;
+        }
+        shell->length += n;
+    }
+}
+
+/**
+*
+* static int ptyStart(struct ptyShell *shell, const char *path)
+*
+* Summary:
+*       Starts the shell on a new pty in raw mode and waits for its prompt
+*
+* Parameters:   pointer to the ptyShell to fill in
+*               char* for the path of the shell
+*
+* Returns:      0 on success, -1 on failure
+*
+* Description:
+*       Raw mode turns off echo, so everything read back is shell output,
+*       and lifts the canonical-mode limit on line length.
+*
+**/
+static int ptyStart(struct ptyShell *shell, const char *path)
+{
+    struct termios raw;
+    struct winsize size = { 24, 80, 0, 0 };
+    int slave;
+
+    memset(shell, 0, sizeof(*shell));
+    if (openpty(&shell->fd, &slave, NULL, NULL, &size) == -1) {
+        perror("openpty");
+        return -1;
+    }
+    tcgetattr(slave, &raw);
+    cfmakeraw(&raw);
+    tcsetattr(slave, TCSANOW, &raw);
+
+    shell->pid = fork();
+    if (shell->pid == 0) {
+        setsid();
+        ioctl(slave, TIOCSCTTY, 0);
+        dup2(slave, STDIN_FILENO);
+        dup2(slave, STDOUT_FILENO);
+        dup2(slave, STDERR_FILENO);
+        close(slave);
+        close(shell->fd);
+        execl(path, path, (char *)NULL);
+        _exit(127);
+    }
+    close(slave);
+    if (shell->pid == -1) {
+        perror("fork");
+        close(shell->fd);
+        return -1;
+    }
+    return ptyWaitFor(shell, PROMPT);
+}
+
+/**
+*
+* static void ptyStop(struct ptyShell *shell)
+*
+* Summary:
+*       Exits the shell on the pty and reaps it
+*
+**/
+static void ptyStop(struct ptyShell *shell)
+{
+    if (write(shell->fd, "exit\n", 5) != 5) {
+        kill(shell->pid, SIGKILL);
+    }
+    close(shell->fd);
+    waitpid(shell->pid, NULL, 0);
+}
+
+/**
+*
+* static int runPty(const char *path, const struct scenario *scenario,
+*                   int iterations)
+*
+* Summary:
+*       Times one scenario prompt-to-prompt on a pty
+*
+* Parameters:   char* for the path of the shell
+*               pointer to the scenario
+*               int for the number of commands to time
+*
+* Returns:      0 on success, -1 if the shell stopped responding
+*
+* Description:
+*       A background job also prints a completion message and a fresh
+*       prompt when it ends. That output is waited for outside the timed
+*       part so it cannot be mistaken for the next command's prompt.
+*
+**/
+static int runPty(const char *path, const struct scenario *scenario, int iterations)
+{
+    struct ptyShell shell;
+    if (ptyStart(&shell, path) == -1) {
+        return -1;
+    }
+
+    size_t length = strlen(scenario->command);
+    char *line = malloc(length + 2);
+    memcpy(line, scenario->command, length);
+    line[length] = '\n';
+
+    double *samples = malloc(iterations * sizeof(double));
+    _Bool background = strchr(scenario->command, '&') != NULL;
+    int status = 0;
+
+    for (int i = 0; i < iterations && status == 0; i++) {
+        struct timespec start, end;
+        shell.sawDone = 0;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        if (write(shell.fd, line, length + 1) != (ssize_t)length + 1
+                || ptyWaitFor(&shell, PROMPT) == -1) {
+            status = -1;
+            break;
+        }
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        samples[i] = elapsedUs(&start, &end);
+
+        if (background && !shell.sawDone) {
+            if (ptyWaitFor(&shell, "is done") == -1 || ptyWaitFor(&shell, PROMPT) == -1) {
+                status = -1;
+            }
+        }
+    }
+    ptyStop(&shell);
+
+    if (status == 0) {
+        double total = 0;
+        for (int i = 0; i < iterations; i++) {
+            total += samples[i];
+        }
+        qsort(samples, iterations, sizeof(double), compareDouble);
+
+        char extra[96];
+        snprintf(extra, sizeof(extra), "p50_us=%.2f p99_us=%.2f max_us=%.2f",
+                samples[iterations / 2], samples[(int)(iterations * 0.99)],
+                samples[iterations - 1]);
+        report(scenario->name, "pty", iterations, total / iterations, extra);
+    }
+    free(samples);
+    free(line);
+    return status;
+}
+
+/**
+*
+* static double runPipeOnce(const char *path, const char *script,
+*                           size_t length)
+*
+* Summary:
+*       Runs the shell with a script piped to its stdin
+*
+* Parameters:   char* for the path of the shell
+*               char* for the script
+*               size_t for the length of the script
+*
+* Returns:      elapsed time in microseconds, or -1 if the shell failed
+*
+**/
+static double runPipeOnce(const char *path, const char *script, size_t length)
+{
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) == -1) {
+        perror("pipe");
+        return -1;
+    }
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, fds[0], STDIN_FILENO);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+
+    char *argv[] = { (char *)path, NULL };
+    struct timespec start, end;
+    pid_t pid;
+    int status = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int error = posix_spawn(&pid, path, &actions, NULL, argv, environ);
+    close(fds[0]);
+    if (error == 0) {
+        size_t written = 0;
+        while (written < length) {
+            ssize_t n = write(fds[1], script + written, length - written);
+            if (n <= 0) {
+                break;
+            }
+            written += n;
+        }
+    }
+    close(fds[1]);
+    if (error == 0) {
+        waitpid(pid, &status, 0);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    posix_spawn_file_actions_destroy(&actions);
+
+    if (error != 0 || !WIFEXITED(status)) {
+        return -1;
+    }
+    return elapsedUs(&start, &end);
+}
+
+/**
+*
+* static double runPipe(const char *path, const char *script, size_t length)
+*
+* Summary:
+*       Runs a piped script PIPE_RUNS times
+*
+* Returns:      the fastest time in microseconds, or -1 if the shell failed
+*
+* Description:
+*       Taking the fastest run filters out scheduling noise, which would
+*       otherwise swamp the sub-microsecond cost of a built-in.
+*
+**/
+static double runPipe(const char *path, const char *script, size_t length)
+{
+    double best = -1;
+    for (int i = 0; i < PIPE_RUNS; i++) {
+        double us = runPipeOnce(path, script, length);
+        if (us < 0) {
+            return -1;
+        }
+        if (best < 0 || us < best) {
+            best = us;
+        }
+    }
+    return best;
+}
+
+/**
+*
+* static char *repeatLine(const char *line, int count, size_t *length)
+*
+* Summary:
+*       Builds a script that is the same line count times
+*
+* Returns:      newly allocated script, its length in *length
+*
+**/
+static char *repeatLine(const char *line, int count, size_t *length)
+{
+    size_t lineLength = strlen(line);
+    char *script = malloc((lineLength + 1) * count + 1);
+    char *out = script;
+    for (int i = 0; i < count; i++) {
+        memcpy(out, line, lineLength);
+        out += lineLength;
+        *out++ = '\n';
+    }
+    *out = '\0';
+    *length = out - script;
+    return script;
+}
+
+/**
+*
+* static int pipeScenario(const char *path, const char *name,
+*                         const char *line, int count, double emptyUs,
+*                         _Bool throughput)
+*
+* Summary:
+*       Times a piped script of one repeated line and reports it
+*
+* Parameters:   char* for the path of the shell
+*               char* for the scenario name
+*               char* for the line
+*               int for the number of lines
+*               double for the time of an empty run, subtracted out
+*               bool for also reporting lines and bytes per second
+*
+* Returns:      0 on success, -1 if the shell failed
+*
+**/
+static int pipeScenario(const char *path, const char *name, const char *line,
+        int count, double emptyUs, _Bool throughput)
+{
+    size_t length;
+    char *script = repeatLine(line, count, &length);
+    double us = runPipe(path, script, length);
+    free(script);
+    if (us < 0) {
+        return -1;
+    }
+
+    us -= emptyUs;
+    if (us < 0) {
+        us = 0;
+    }
+    char extra[96] = "";
+    if (throughput && us > 0) {
+        snprintf(extra, sizeof(extra), "lines_s=%.0f mb_s=%.1f",
+                count / (us / 1e6), length / us);
+    }
+    report(name, "pipe", count, us / count, extra);
+    return 0;
+}
+
+/**
+*
+* static int compareBaseline(const char *path, double threshold)
+*
+* Summary:
+*       Compares this run's results with a stored baseline
+*
+* Parameters:   char* for the baseline file, in shellbench's output format
+*               double for the allowed growth of a mean, in percent
+*
+* Returns:      number of regressions, or -1 if the baseline cannot be read
+*
+**/
+static int compareBaseline(const char *path, double threshold)
+{
+    FILE *baseline = fopen(path, "r");
+    if (!baseline) {
+        perror(path);
+        return -1;
+    }
+
+    char line[256];
+    int regressions = 0;
+    printf("baseline=%s threshold_pct=%.1f\n", path, threshold);
+    while (fgets(line, sizeof(line), baseline)) {
+        char name[32], mode[8];
+        int count;
+        double meanUs;
+        if (sscanf(line, "scenario=%31s mode=%7s n=%d mean_us=%lf",
+                    name, mode, &count, &meanUs) != 4) {
+            continue;
+        }
+        for (int i = 0; i < numResults; i++) {
+            struct result *r = &results[i];
+            if (strcmp(r->name, name) != 0 || strcmp(r->mode, mode) != 0) {
+                continue;
+            }
+            double change = meanUs > 0 ? (r->meanUs - meanUs) / meanUs * 100 : 0;
+            _Bool regressed = change > threshold;
+            printf("compare scenario=%s mode=%s baseline_us=%.2f mean_us=%.2f "
+                    "change_pct=%+.1f%s\n", name, mode, meanUs, r->meanUs,
+                    change, regressed ? " REGRESSION" : "");
+            regressions += regressed;
+        }
+    }
+    fclose(baseline);
+    return regressions;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *shell = "./kell-shell";
+    const char *baselinePath = NULL;
+    const char *resultsPath = NULL;
+    int ptyIterations = 300;
+    int pipeCommands = 2000;
+    double threshold = 10;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:n:N:b:o:t:")) != -1) {
+        switch (opt) {
+            case 's':
+                shell = optarg;
+                break;
+            case 'n':
+                ptyIterations = atoi(optarg);
+                break;
+            case 'N':
+                pipeCommands = atoi(optarg);
+                break;
+            case 'b':
+                baselinePath = optarg;
+                break;
+            case 'o':
+                resultsPath = optarg;
+                break;
+            case 't':
+                threshold = atof(optarg);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-s shell] [-n pty_iterations] "
+                        "[-N pipe_commands] [-b baseline] [-o results] "
+                        "[-t threshold_percent]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (ptyIterations < 1 || pipeCommands < 1) {
+        fprintf(stderr, "shellbench: iterations must be positive\n");
+        return 1;
+    }
+    if (resultsPath && !(resultsFile = fopen(resultsPath, "w"))) {
+        perror(resultsPath);
+        return 1;
+    }
+
+    int numScenarios = sizeof(scenarios) / sizeof(scenarios[0]);
+    for (int i = 0; i < numScenarios; i++) {
+        if (runPty(shell, &scenarios[i], ptyIterations) == -1) {
+            fprintf(stderr, "shellbench: %s stopped responding on the pty (%s)\n",
+                    shell, scenarios[i].name);
+            return 1;
+        }
+    }
+
+    // the cost of starting and stopping the shell is not per command
+    double emptyUs = runPipe(shell, "", 0);
+    int failed = emptyUs < 0;
+    for (int i = 0; i < numScenarios && !failed; i++) {
+        failed = pipeScenario(shell, scenarios[i].name, scenarios[i].command,
+                pipeCommands, emptyUs, 0) == -1;
+    }
+
+    // throughput: a long script of small commands, and $$-heavy lines
+    if (!failed) {
+        failed = pipeScenario(shell, "script", "echo line $$ $? word word word",
+                pipeCommands * 50, emptyUs, 1) == -1;
+    }
+    if (!failed) {
+        size_t size = 4 + 3 * 4096 + 1;
+        char *longLine = malloc(size);
+        char *out = stpcpy(longLine, "true");
+        for (int i = 0; i < 4096; i++) {
+            out = stpcpy(out, " $$");
+        }
+        failed = pipeScenario(shell, "longline", longLine,
+                pipeCommands / 4 + 1, emptyUs, 1) == -1;
+        free(longLine);
+    }
+    unlink("/tmp/shellbench.out");
+    if (resultsFile) {
+        fclose(resultsFile);
+    }
+    if (failed) {
+        fprintf(stderr, "shellbench: %s failed on piped input\n", shell);
+        return 1;
+    }
+
+    if (baselinePath) {
+        int regressions = compareBaseline(baselinePath, threshold);
+        if (regressions != 0) {
+            return regressions < 0 ? 1 : 2;
+        }
+    }
+    return 0;
+}
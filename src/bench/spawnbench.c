@@ -0,0 +1,112 @@
+/*******************************************************************************
+*
+* File:     spawnbench.c
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Micro-benchmark for the kell-shell spawn engine. Launches a command
+*   repeatedly through spawnCommand() in each spawn mode and reports the
+*   spawn + wait latency. The -m option grows the benchmark's resident set
+*   first, which shows how fork() cost scales with the size of the parent.
+*
+*   Usage: spawnbench [-n iterations] [-m rss_mb] [command [args...]]
+*
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "../spawn.h"
+
+extern char **environ;
+
+static int compareLong(const void *a, const void *b)
+{
+    long x = *(const long *)a;
+    long y = *(const long *)b;
+    return (x > y) - (x < y);
+}
+
+static long elapsedNs(struct timespec *start, struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1000000000L
+            + (end->tv_nsec - start->tv_nsec);
+}
+
+int main(int argc, char *argv[])
+{
+    int iterations = 2000;
+    long rssMb = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:m:")) != -1) {
+        switch (opt) {
+            case 'n':
+                iterations = atoi(optarg);
+                break;
+            case 'm':
+                rssMb = atol(optarg);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n iterations] [-m rss_mb] [command [args...]]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (iterations < 1) {
+        iterations = 1;
+    }
+
+    char *defaultCommand[] = { "/bin/true", NULL };
+    char **command = (optind < argc) ? argv + optind : defaultCommand;
+
+    // touch every page so the memory is really resident
+    char *ballast = NULL;
+    if (rssMb > 0) {
+        ballast = malloc(rssMb << 20);
+        memset(ballast, 1, rssMb << 20);
+    }
+
+    long *samples = malloc(iterations * sizeof(long));
+    enum spawnMode modes[] = { SPAWN_POSIX, SPAWN_FORK };
+
+    for (int m = 0; m < 2; m++) {
+        spawnMode = modes[m];
+        struct spawnRequest request = {
+            .argv = command, .envp = environ, .inputFd = -1, .outputFd = -1, .defaultSIGINT = 1
+        };
+        long total = 0;
+
+        for (int i = 0; i < iterations; i++) {
+            struct timespec start, end;
+            enum spawnFailure failure;
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            pid_t pid = spawnCommand(&request, &failure);
+            if (pid == -1) {
+                spawnPrintError(&request, failure);
+                return 1;
+            }
+            waitpid(pid, NULL, 0);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+
+            samples[i] = elapsedNs(&start, &end);
+            total += samples[i];
+        }
+
+        qsort(samples, iterations, sizeof(long), compareLong);
+        printf("mode=%s iterations=%d rss_mb=%ld mean_us=%.1f p50_us=%.1f p99_us=%.1f\n",
+                spawnModeName(spawnMode), iterations, rssMb,
+                total / 1000.0 / iterations,
+                samples[iterations / 2] / 1000.0,
+                samples[(iterations * 99) / 100] / 1000.0);
+    }
+
+    free(samples);
+    free(ballast);
+    return 0;
+}
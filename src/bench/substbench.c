@@ -0,0 +1,143 @@
+/*******************************************************************************
+*
+* File:     substbench.c
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Benchmark for kell-shell command substitution. Runs the shell on
+*   generated scripts that assign the same output to a variable the same
+*   number of times: from `$(echo x)`, which runs the built-in in the
+*   shell, from `$( (echo x) )`, which runs it in a forked subshell and
+*   reads it through a pipe, and from `$(/bin/echo x)`, which also execs
+*   a program. A script of plain `x=x` assignments is timed too and taken
+*   off the others, so the results are the cost of the substitution alone.
+*
+*   Usage: substbench [-n substitutions] [-s shell]
+*          -s path of the shell to run, ./kell-shell by default
+*
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+extern char **environ;
+
+/**
+*
+* static int writeScript(const char *path, const char *value, int count)
+*
+* Summary:
+*       Writes a script of count `x=value` lines, each followed by a use
+*       of x so the output is checked
+*
+* Returns:      0 on success, -1 if the file cannot be written
+*
+**/
+static int writeScript(const char *path, const char *value, int count)
+{
+    FILE *script = fopen(path, "w");
+    if (!script) {
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        fprintf(script, "x=%s\n: $x\n", value);
+    }
+    fprintf(script, "test \"$x\" = x\n");
+    return fclose(script);
+}
+
+/**
+*
+* static double runScript(const char *shell, const char *path)
+*
+* Summary:
+*       Runs the shell on a script with output going to /dev/null
+*
+* Returns:      elapsed time in microseconds, or -1 if the shell failed
+*
+**/
+static double runScript(const char *shell, const char *path)
+{
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+
+    char *argv[] = { (char *)shell, (char *)path, NULL };
+    struct timespec start, end;
+    pid_t pid;
+    int status;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (posix_spawn(&pid, shell, &actions, NULL, argv, environ) != 0) {
+        posix_spawn_file_actions_destroy(&actions);
+        return -1;
+    }
+    waitpid(pid, &status, 0);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    posix_spawn_file_actions_destroy(&actions);
+
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        return -1;
+    }
+    return (end.tv_sec - start.tv_sec) * 1e6 + (end.tv_nsec - start.tv_nsec) / 1e3;
+}
+
+int main(int argc, char *argv[])
+{
+    int count = 2000;
+    const char *shell = "./kell-shell";
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+        switch (opt) {
+            case 'n':
+                count = atoi(optarg);
+                break;
+            case 's':
+                shell = optarg;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n substitutions] [-s shell]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (count <= 0) {
+        count = 1;
+    }
+
+    const char *values[] = { "x", "$(echo x)", "$( (echo x) )", "$(/bin/echo x)" };
+    char paths[4][32];
+    double us[4];
+    for (int i = 0; i < 4; i++) {
+        strcpy(paths[i], "/tmp/substbench.XXXXXX");
+        close(mkstemp(paths[i]));
+        if (writeScript(paths[i], values[i], count) == -1) {
+            perror("substbench: script");
+            return 1;
+        }
+    }
+    for (int i = 0; i < 4; i++) {
+        us[i] = runScript(shell, paths[i]);
+        unlink(paths[i]);
+    }
+    for (int i = 0; i < 4; i++) {
+        if (us[i] < 0) {
+            fprintf(stderr, "substbench: %s failed on x=%s\n", shell, values[i]);
+            return 1;
+        }
+    }
+
+    double builtinUs = (us[1] - us[0]) / count;
+    double forkUs = (us[2] - us[0]) / count;
+    double execUs = (us[3] - us[0]) / count;
+    printf("substitutions=%d builtin_us=%.2f fork_us=%.2f exec_us=%.2f speedup=%.1fx\n",
+            count, builtinUs, forkUs, execUs, forkUs / builtinUs);
+    return 0;
+}
@@ -0,0 +1,186 @@
+/*******************************************************************************
+*
+* File:     varbench.c
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Benchmark for the kell-shell variable store, run in process with a
+*   large exported environment. Compares looking a variable up with
+*   varsGet() and with getenv(), and the cost of changing an exported
+*   variable and getting the environment for the next command three ways:
+*   with the store, which keeps its array current; with setenv(), as the
+*   shell used to; and by building a fresh array from every variable, as
+*   a shell that makes the environment on demand would before each exec.
+*   The last line times the copy a command with its own NAME=value gets.
+*
+*   Usage: varbench [-n iterations] [-v variables]
+*
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../arena.h"
+#include "../vars.h"
+
+extern char **environ;
+
+static volatile size_t sink;    // keeps results from being optimized out
+
+/**
+*
+* static double elapsedNs(struct timespec *start, struct timespec *end,
+*                         int iterations)
+*
+* Summary:
+*       Average time per iteration in nanoseconds
+*
+**/
+static double elapsedNs(struct timespec *start, struct timespec *end, int iterations)
+{
+    return ((end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec))
+            / iterations;
+}
+
+/**
+*
+* static char **rebuildEnviron(char **names, int count, struct arena *arena)
+*
+* Summary:
+*       Builds the environment from scratch: one "NAME=value" string per
+*       variable and the array of them
+*
+**/
+static char **rebuildEnviron(char **names, int count, struct arena *arena)
+{
+    char **env = arenaAlloc(arena, (count + 1) * sizeof(char *));
+    for (int i = 0; i < count; i++) {
+        const char *value = varsGet(names[i]);
+        size_t nameLength = strlen(names[i]);
+        size_t valueLength = strlen(value);
+        env[i] = arenaAlloc(arena, nameLength + valueLength + 2);
+        memcpy(env[i], names[i], nameLength);
+        env[i][nameLength] = '=';
+        memcpy(env[i] + nameLength + 1, value, valueLength + 1);
+    }
+    env[count] = NULL;
+    return env;
+}
+
+int main(int argc, char *argv[])
+{
+    int iterations = 200000;
+    int count = 1000;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:v:")) != -1) {
+        switch (opt) {
+            case 'n':
+                iterations = atoi(optarg);
+                break;
+            case 'v':
+                count = atoi(optarg);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n iterations] [-v variables]\n", argv[0]);
+                return 1;
+        }
+    }
+    if (iterations <= 0 || count <= 0) {
+        fprintf(stderr, "varbench: iterations and variables must be positive\n");
+        return 1;
+    }
+
+    // the exported variables, looked up in a scattered order
+    char **names = malloc(count * sizeof(char *));
+    int *order = malloc(iterations * sizeof(int));
+    char value[32];
+    for (int i = 0; i < count; i++) {
+        names[i] = malloc(32);
+        snprintf(names[i], 32, "VARBENCH_%d", i);
+        snprintf(value, sizeof(value), "value_%d", i);
+        setenv(names[i], value, 1);
+    }
+    srand(1);
+    for (int i = 0; i < iterations; i++) {
+        order[i] = rand() % count;
+    }
+    const char *changed = names[count / 2];
+    struct timespec start, end;
+
+    // the C library on its own
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < iterations; i++) {
+        sink += (size_t)getenv(names[order[i]]);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double getenvNs = elapsedNs(&start, &end, iterations);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < iterations; i++) {
+        snprintf(value, sizeof(value), "%d", i);
+        setenv(changed, value, 1);
+        sink += (size_t)environ;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double setenvNs = elapsedNs(&start, &end, iterations);
+
+    // the store, filled from that environment
+    varsInit(environ);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < iterations; i++) {
+        sink += (size_t)varsGet(names[order[i]]);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double getNs = elapsedNs(&start, &end, iterations);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < iterations; i++) {
+        snprintf(value, sizeof(value), "%d", i);
+        varsSet(changed, value, 0);
+        sink += (size_t)varsEnviron();
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double setNs = elapsedNs(&start, &end, iterations);
+
+    // a full rebuild is slow, a tenth of the rounds is plenty
+    struct arena arena = { 0 };
+    int rebuilds = iterations / 10 ? iterations / 10 : 1;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < rebuilds; i++) {
+        arenaReset(&arena);
+        snprintf(value, sizeof(value), "%d", i);
+        varsSet(changed, value, 0);
+        sink += (size_t)rebuildEnviron(names, count, &arena);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double rebuildNs = elapsedNs(&start, &end, rebuilds);
+
+    char *assignment[] = { "VARBENCH_ONE=1" };
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < iterations; i++) {
+        arenaReset(&arena);
+        sink += (size_t)varsEnvironWith(assignment, 1, &arena);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double withNs = elapsedNs(&start, &end, iterations);
+
+    printf("variables=%d lookup_vars_ns=%.1f lookup_getenv_ns=%.1f speedup=%.1fx\n",
+            count, getNs, getenvNs, getenvNs / getNs);
+    printf("variables=%d change_vars_ns=%.1f change_setenv_ns=%.1f change_rebuild_ns=%.1f"
+            " speedup=%.1fx\n", count, setNs, setenvNs, rebuildNs, rebuildNs / setNs);
+    printf("variables=%d command_assignment_ns=%.1f\n", count, withNs);
+
+    varsFree();
+    arenaFree(&arena);
+    for (int i = 0; i < count; i++) {
+        free(names[i]);
+    }
+    free(names);
+    free(order);
+    return 0;
+}
@@ -0,0 +1,1660 @@
+/*******************************************************************************
+*
+* File:     builtins.c
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Built-in commands for kell-shell. Built-ins run inside the shell, so
+*   the commands scripts call in tight loops (echo, test, printf, ...) cost
+*   a function call instead of a process.
+*
+*   Built-ins are registered in one table kept sorted by name and found
+*   with a binary search. Each handler gets the argument list and the shell
+*   state and returns an exit value. Redirections are honored by pointing
+*   stdin/stdout at the files for the duration of the call and restoring
+*   the shell's own descriptors afterwards.
+*
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include "builtins.h"
+#include "events.h"     // eventsWait()
+#include "exec.h"       // execUnsetFunction()
+#include "hash.h"
+#include "history.h"
+#include "jobs.h"
+#include "parallel.h"   // parallelRun()
+#include "parse.h"      // struct command
+#include "redirect.h"   // redirectApply()
+#include "script.h"     // scriptSource()
+#include "stats.h"      // statsPrint(), redirection timing
+#include "vars.h"
+
+/**
+*
+* void printStatus(int status)
+*
+* Summary:
+*       Prints an exit status
+*
+* Parameters:   an int for the exit status to print
+*
+* Returns:      nothing. prints exit status
+*
+* Description:
+*       This function prints the exit status of the int passed in. It determines
+*       whether termination was normal or by signal and prints the status.
+*
+* ---
+*
+* Elements of the following code have been adapted from:
+*
+* - Title: OSU CS344 archived lectures: 3.1 Processes
+*   Author: Benjamin Brewster
+*   Date: 4/10/2019
+*   Availability: https://www.youtube.com/channel/UCqiv0C67MA6NOiusl5NLXIQ
+*   Additional Info: first accessed 10/21/2020
+*
+**/
+void printStatus(int status) {
+    if (WIFEXITED(status)) {
+        //terminated normally
+        printf("exit value %d\n", WEXITSTATUS(status));
+        fflush(stdout);
+    }
+    else if (WIFSIGNALED(status)) {
+        // terminated by signal
+        printf("terminated by signal %d\n", WTERMSIG(status));
+        fflush(stdout);
+    }
+}
+
+/**
+*
+* void printUsage(FILE *out, const struct jobUsage *usage)
+*
+* Summary:
+*       Prints the wall, user and sys time, peak RSS and context switches
+*       of a job
+*
+* Parameters:   FILE* to print to
+*               pointer to the resource use to print
+*
+* Returns:      nothing.
+*
+* Description:
+*       The times use the same layout as the `time` keyword of bash.
+*
+**/
+void printUsage(FILE *out, const struct jobUsage *usage)
+{
+    const struct rusage *r = &usage->rusage;
+    double user = r->ru_utime.tv_sec + r->ru_utime.tv_usec / 1e6;
+    double sys = r->ru_stime.tv_sec + r->ru_stime.tv_usec / 1e6;
+
+    fprintf(out, "real\t%dm%.3fs\n", (int)(usage->wallSeconds / 60),
+            usage->wallSeconds - 60 * (int)(usage->wallSeconds / 60));
+    fprintf(out, "user\t%dm%.3fs\n", (int)(user / 60), user - 60 * (int)(user / 60));
+    fprintf(out, "sys\t%dm%.3fs\n", (int)(sys / 60), sys - 60 * (int)(sys / 60));
+    fprintf(out, "maxrss\t%ld KB\n", r->ru_maxrss);
+    fprintf(out, "csw\t%ld voluntary, %ld involuntary\n", r->ru_nvcsw, r->ru_nivcsw);
+    fflush(out);
+}
+
+/**
+*
+* int exitValue(int status)
+*
+* Summary:
+*       Converts a wait status to a shell exit value
+*
+* Parameters:   an int for the wait status
+*
+* Returns:      the exit value, or 128 + signal number if terminated by signal
+*
+**/
+int exitValue(int status) {
+    if (WIFSIGNALED(status)) {
+        return 128 + WTERMSIG(status);
+    }
+    return WEXITSTATUS(status);
+}
+
+/**
+*
+* static int loopCount(char *argv[], int argc, struct shellState *shell)
+*
+* Summary:
+*       Reads the loop count of `break [n]` and `continue [n]`
+*
+* Returns:      the number of loops to leave, at most the number running,
+*               or 0 after printing an error
+*
+**/
+static int loopCount(char *argv[], int argc, struct shellState *shell)
+{
+    if (shell->loopDepth == 0) {
+        printf("%s: only meaningful in a `for', `while', or `until' loop\n", argv[0]);
+        fflush(stdout);
+        return 0;
+    }
+    long count = 1;
+    if (argc > 1) {
+        char *end;
+        errno = 0;
+        count = strtol(argv[1], &end, 10);
+        if (end == argv[1] || *end != '\0' || errno == ERANGE || count < 1) {
+            printf("%s: %s: loop count out of range\n", argv[0], argv[1]);
+            fflush(stdout);
+            return 0;
+        }
+    }
+    return (count > shell->loopDepth) ? shell->loopDepth : (int)count;
+}
+
+/**
+*
+* static int builtinBreak(char *argv[], int argc, struct shellState *shell)
+*
+* Summary:
+*       `break [n]` leaves the innermost n loops
+*
+**/
+static int builtinBreak(char *argv[], int argc, struct shellState *shell)
+{
+    int count = loopCount(argv, argc, shell);
+    if (count == 0) {
+        return 1;
+    }
+    shell->breakLoops = count;
+    return 0;
+}
+
+/**
+*
+* static int builtinContinue(char *argv[], int argc, struct shellState *shell)
+*
+* Summary:
+*       `continue [n]` goes on with the next round of the nth loop out,
+*       leaving the loops inside it
+*
+**/
+static int builtinContinue(char *argv[], int argc, struct shellState *shell)
+{
+    int count = loopCount(argv, argc, shell);
+    if (count == 0) {
+        return 1;
+    }
+    shell->continueLoops = count;
+    return 0;
+}
+
+/**
+*
+* static int builtinCd(char *argv[], int argc, struct shellState *shell)
+*
+* Summary:
+*       `cd [dir]` changes the working directory, to HOME without dir
+*
+**/
+static int builtinCd(char *argv[], int argc, struct shellState *shell)
+{
+    int result = -1;
+    if (argc < 2) {
+        // cd is the only command, go to HOME
+        result = chdir(varsGet("HOME"));
+    }
+    else {
+        result = chdir(argv[1]);
+    }
+
+    if (result == -1) {
+        perror("cd error");
+        fflush(stdout);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+*
+* static const char *printEscape(FILE *out, const char *p)
+*
+* Summary:
+*       Prints the backslash escape at p for printf
+*
+* Parameters:   FILE* to print to
+*               char* pointing at the backslash
+*
+* Returns:      pointer to the last character of the escape
+*
+**/
+static const char *printEscape(FILE *out, const char *p)
+{
+    static const char plain[] = "\\\"abefnrtv";
+    static const char escaped[] = "\\\"\a\b\033\f\n\r\t\v";
+    const char *found;
+
+    if (p[1] >= '0' && p[1] <= '7') {
+        // up to three octal digits
+        int value = 0;
+        int i = 1;
+        for (; i <= 3 && p[i] >= '0' && p[i] <= '7'; i++) {
+            value = value * 8 + (p[i] - '0');
+        }
+        putc(value, out);
+        return p + i - 1;
+    }
+    if (p[1] && (found = strchr(plain, p[1]))) {
+        putc(escaped[found - plain], out);
+        return p + 1;
+    }
+    // unknown escape or trailing backslash: print it as is
+    putc('\\', out);
+    return p;
+}
+
+/**
+*
+* static _Bool echoEscapes(FILE *out, const char *text)
+*
+* Summary:
+*       Prints text with the escapes of `echo -e` and printf's %b
+*
+* Parameters:   FILE* to print to
+*               char* for the text
+*
+* Returns:      false if a \c asked for the output to stop there
+*
+* Description:
+*       The same escapes as printf, except that an octal value is written
+*       \0nnn, with up to three digits after the 0.
+*
+**/
+static _Bool echoEscapes(FILE *out, const char *text)
+{
+    for (const char *p = text; *p; p++) {
+        if (*p != '\\') {
+            putc(*p, out);
+        }
+        else if (p[1] == 'c') {
+            return 0;
+        }
+        else if (p[1] == '0') {
+            int value = 0;
+            p++;
+            for (int i = 0; i < 3 && p[1] >= '0' && p[1] <= '7'; i++) {
+                value = value * 8 + (*++p - '0');
+            }
+            putc(value, out);
+        }
+        else {
+            p = printEscape(out, p);
+        }
+    }
+    return 1;
+}
+
+/**
+*
+* static int builtinEcho(char *argv[], int argc, struct shellState *shell)
+*
+* Summary:
+*       `echo [-neE] [arg...]` prints its arguments separated by spaces,
+*       followed by a newline unless -n is given
+*
+* Description:
+*       -e turns on backslash escapes and -E turns them off again; the
+*       options may be combined, as in -ne. An argument with any other
+*       letter is printed, like the echo of bash.
+*
+**/
+static int builtinEcho(char *argv[], int argc, struct shellState *shell)
+{
+    int first = 1;
+    _Bool newline = 1;
+    _Bool escapes = 0;
+
+    for (; first < argc && argv[first][0] == '-' && argv[first][1]; first++) {
+        const char *option = argv[first] + 1;
+        if (option[strspn(option, "neE")] != '\0') {
+            break;
+        }
+        for (; *option; option++) {
+            if (*option == 'n') {
+                newline = 0;
+            }
+            else {
+                escapes = (*option == 'e');
+            }
+        }
+    }
+    for (int i = first; i < argc; i++) {
+        if (i > first) {
+            putchar(' ');
+        }
+        if (!escapes) {
+            fputs(argv[i], stdout);
+        }
+        else if (!echoEscapes(stdout, argv[i])) {
+            // \c: nothing more, not even the newline
+            return 0;
+        }
+    }
+    if (newline) {
+        putchar('\n');
+    }
+    return 0;
+}
+
+/**
+*
+* static int builtinExit(char *argv[], int argc, struct shellState *shell)
+*
+* Summary:
+*       `exit [n]` hangs up background jobs and ends the shell with n, or 0
+*
+* Description:
+*       With stopped jobs the first `exit` only warns; a second one hangs
+*       them up too, continuing them so they see the SIGHUP.
+*
+**/
+static int builtinExit(char *argv[], int argc, struct shellState *shell)
+{
+    static _Bool warned = 0;
+    _Bool stopped = 0;
+    for (struct job *job = jobsNext(NULL); job; job = jobsNext(job)) {
+        stopped |= job->stopped;
+    }
+    if (stopped && !warned) {
+        warned = 1;
+        printf("There are stopped jobs.\n");
+        fflush(stdout);
+        return 1;
+    }
+
+    // kill background processes and exit shell
+    jobsSignalAll(SIGHUP);
+    if (stopped) {
+        jobsSignalAll(SIGCONT);
+    }
+    shell->exitShell = 1;
+    shell->exitStatus = (argc > 1) ? (atoi(argv[1]) & 0xff) : 0;
+    return shell->exitStatus;
+}
+
+/**
+*
+* static _Bool validName(const char *name, size_t length)
+*
+* Summary:
+*       Checks that a string is a valid variable name: [A-Za-z_][A-Za-z0-9_]*
+*
+**/
+static _Bool validName(const char *name, size_t length)
+{
+    if (length == 0 || (name[0] >= '0' && name[0] <= '9')) {
+        return 0;
+    }
+    for (size_t i = 0; i < length; i++) {
+        char c = name[i];
+        if (!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')
+                || (c >= '0' && c <= '9') || c == '_')) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+*
+* static int builtinExport(char *argv[], int argc, struct shellState *shell)
+*
+* Summary:
+*       `export NAME[=value]...` puts variables in the environment of
+*       commands, setting those given a value; `export` alone lists them
+*
+**/
+static int builtinExport(char *argv[], int argc, struct shellState *shell)
+{
+    int result = 0;
+
+    if (argc < 2) {
+        for (char **env = varsEnviron(); *env; env++) {
+            printf("export %s\n", *env);
+        }
+        return 0;
+    }
+
+    for (int i = 1; i < argc; i++) {
+        char *equals = strchr(argv[i], '=');
+        size_t nameLength = equals ? (size_t)(equals - argv[i]) : strlen(argv[i]);
+        if (!validName(argv[i], nameLength)) {
+            printf("export: `%s': not a valid identifier\n", argv[i]);
+            result = 1;
+            continue;
+        }
+        if (equals) {
+            varsAssign(argv[i], VAR_EXPORT);
+        }
+        else {
+            varsExport(argv[i]);
+        }
+    }
+    return result;
+}
+
+/**
+*
+* static int builtinFalse(char *argv[], int argc, struct shellState *shell)
+*
+* Summary:
+*       `false` does nothing, unsuccessfully
+*
+**/
+static int builtinFalse(char *argv[], int argc, struct shellState *shell)
+{
+    return 1;
+}
+
+/**
+*
+* static int builtinHash(char *argv[], int argc, struct shellState *shell)
+*
+* Summary:
+*       Built-in `hash` command for the command path cache
+*
+* Description:
+*       `hash` lists remembered commands, `hash -r` forgets all of them,
+*       `hash -d name...` forgets the named commands and `hash name...`
+*       looks the named commands up in PATH and remembers them.
+*
+**/
+static int builtinHash(char *argv[], int argc, struct shellState *shell)
+{
+    int result = 0;
+
+    if (argc < 2) {
+        hashPrint();
+    }
+    else if (strcmp(argv[1], "-r") == 0) {
+        hashClear();
+    }
+    else if (strcmp(argv[1], "-d") == 0) {
+        for (int i = 2; i < argc; i++) {
+            hashRemove(argv[i]);
+        }
+    }
+    else {
+        for (int i = 1; i < argc; i++) {
+            if (hashAdd(argv[i]) == -1) {
+                printf("hash: %s: not found\n", argv[i]);
+                result = 1;
+            }
+        }
+    }
+    return result;
+}
+
+/**
+*
+* void printJob(const struct job *job)
+*
+* Summary:
+*       Prints a job's number, pid, state and command, as `jobs` lists it
+*
+* Parameters:   pointer to the job
+*
+* Returns:      nothing.
+*
+**/
+void printJob(const struct job *job)
+{
+    printf("[%d] %d %s  %s\n", job->id, job->jobPid,
+            job->stopped ? "stopped" : "running",
+            job->command ? job->command : "");
+    fflush(stdout);
+}
+
+/**
+*
+* static struct job *jobArgument(const char *name, const char *spec)
+*
+* Summary:
+*       Finds the job an argument of fg, bg, kill or wait names
+*
+* Parameters:   char* for the built-in, for the error message
+*               char* for %n, a pid, or NULL/%%/%+/% for the current job
+*
+* Returns:      the job, or NULL after printing an error
+*
+**/
+static struct job *jobArgument(const char *name, const char *spec)
+{
+    struct job *job = NULL;
+    if (!spec || strcmp(spec, "%") == 0 || strcmp(spec, "%%") == 0
+            || strcmp(spec, "%+") == 0) {
+        job = jobsCurrent();
+    }
+    else {
+        char *end;
+        long number = strtol(spec + (spec[0] == '%'), &end, 10);
+        if (*end == '\0' && number > 0 && number <= INT_MAX) {
+            job = (spec[0] == '%') ? jobFind(number) : jobFindPid(number);
+        }
+    }
+    if (!job || !job->background) {
+        printf("%s: %s: no such job\n", name, spec ? spec : "current");
+        fflush(stdout);
+        return NULL;
+    }
+    return job;
+}
+
+/**
+*
+* static int builtinBg(char *argv[], int argc, struct shellState *shell)
+*
+* Summary:
+*       `bg [%n]` continues a stopped job in the background
+*
+**/
+static int builtinBg(char *argv[], int argc, struct shellState *shell)
+{
+    struct job *job = jobArgument(argv[0], (argc > 1) ? argv[1] : NULL);
+    if (!job) {
+        return 1;
+    }
+    if (!job->stopped) {
+        printf("%s: job %d already in background\n", argv[0], job->id);
+        fflush(stdout);
+        return 0;
+    }
+    jobBackground(job);
+    printf("[%d] %s &\n", job->id, job->command ? job->command : "");
+    fflush(stdout);
+    return 0;
+}
+
+/**
+*
+* static int builtinFg(char *argv[], int argc, struct shellState *shell)
+*
+* Summary:
+*       `fg [%n]` brings a job to the foreground and waits for it
+*
+* Description:
+*       The job's status becomes the last foreground status, exactly as if
+*       it had been started in the foreground.
+*
+**/
+static int builtinFg(char *argv[], int argc, struct shellState *shell)
+{
+    struct job *job = jobArgument(argv[0], (argc > 1) ? argv[1] : NULL);
+    if (!job) {
+        return 1;
+    }
+    printf("%s\n", job->command ? job->command : "");
+    fflush(stdout);
+
+    jobForeground(job, job->stopped, shell->handleEvents);
+
+    if (job->stopped) {
+        shell->foregroundStatus = W_EXITCODE(128 + job->stopSignal, 0);
+        printf("\n");
+        printJob(job);
+        return 128 + job->stopSignal;
+    }
+    shell->foregroundStatus = job->status;
+    shell->lastUsage = job->usage;
+    jobDelete(job);
+    if (WIFSIGNALED(shell->foregroundStatus)) {
+        printStatus(shell->foregroundStatus);
+    }
+    return exitValue(shell->foregroundStatus);
+}
+
+// signals `kill` knows by name, without the SIG prefix
+static const struct {
+    const char *name;
+    int signo;
+} signalNames[] = {
+    { "HUP",  SIGHUP },  { "INT",  SIGINT },  { "QUIT", SIGQUIT },
+    { "ILL",  SIGILL },  { "TRAP", SIGTRAP }, { "ABRT", SIGABRT },
+    { "BUS",  SIGBUS },  { "FPE",  SIGFPE },  { "KILL", SIGKILL },
+    { "USR1", SIGUSR1 }, { "SEGV", SIGSEGV }, { "USR2", SIGUSR2 },
+    { "PIPE", SIGPIPE }, { "ALRM", SIGALRM }, { "TERM", SIGTERM },
+    { "CHLD", SIGCHLD }, { "CONT", SIGCONT }, { "STOP", SIGSTOP },
+    { "TSTP", SIGTSTP }, { "TTIN", SIGTTIN }, { "TTOU", SIGTTOU },
+    { "URG",  SIGURG },  { "XCPU", SIGXCPU }, { "XFSZ", SIGXFSZ },
+    { "VTALRM", SIGVTALRM }, { "PROF", SIGPROF }, { "WINCH", SIGWINCH },
+    { "SYS",  SIGSYS },
+};
+
+/**
+*
+* static int signalNumber(const char *name)
+*
+* Summary:
+*       Looks up a signal given as a number, a name or SIG and a name
+*
+* Returns:      the signal number, or -1 if it is unknown
+*
+**/
+static int signalNumber(const char *name)
+{
+    char *end;
+    long number = strtol(name, &end, 10);
+    if (*end == '\0' && end != name) {
+        return (number >= 0 && number < NSIG) ? number : -1;
+    }
+    if (strncasecmp(name, "SIG", 3) == 0) {
+        name += 3;
+    }
+    for (size_t i = 0; i < sizeof(signalNames) / sizeof(signalNames[0]); i++) {
+        if (strcasecmp(name, signalNames[i].name) == 0) {
+            return signalNames[i].signo;
+        }
+    }
+    return -1;
+}
+
+/**
+*
+* static int builtinKill(char *argv[], int argc, struct shellState *shell)
+*
+* Summary:
+*       `kill [-s SIG | -SIG] %n|pid...` signals jobs or processes,
+*       `kill -l` lists the signal names
+*
+* Description:
+*       A job is signalled as a whole. A stopped job is also continued
+*       after any signal but STOP and friends, so it can act on it.
+*
+**/
+static int builtinKill(char *argv[], int argc, struct shellState *shell)
+{
+    int signo = SIGTERM;
+    int i = 1;
+
+    if (argc > 1 && strcmp(argv[1], "-l") == 0) {
+        for (size_t n = 0; n < sizeof(signalNames) / sizeof(signalNames[0]); n++) {
+            printf("%2d) SIG%s\n", signalNames[n].signo, signalNames[n].name);
+        }
+        return 0;
+    }
+    if (argc > 2 && strcmp(argv[1], "-s") == 0) {
+        signo = signalNumber(argv[2]);
+        i = 3;
+    }
+    else if (argc > 1 && argv[1][0] == '-' && argv[1][1] != '\0') {
+        signo = signalNumber(argv[1] + 1);
+        i = 2;
+    }
+    if (signo == -1) {
+        printf("kill: %s: invalid signal\n", argv[i - 1]);
+        fflush(stdout);
+        return 1;
+    }
+    if (i >= argc) {
+        printf("kill: usage: kill [-s SIG | -SIG] %%n|pid...\n");
+        fflush(stdout);
+        return 1;
+    }
+
+    int result = 0;
+    for (; i < argc; i++) {
+        if (argv[i][0] == '%') {
+            struct job *job = jobArgument(argv[0], argv[i]);
+            if (!job) {
+                result = 1;
+                continue;
+            }
+            if (jobSignal(job, signo) == -1) {
+                perror("kill");
+                fflush(stdout);
+                result = 1;
+            }
+            else if (job->stopped && signo != SIGSTOP && signo != SIGTSTP
+                    && signo != SIGTTIN && signo != SIGTTOU && signo != 0) {
+                jobSignal(job, SIGCONT);
+            }
+            continue;
+        }
+        char *end;
+        long pid = strtol(argv[i], &end, 10);
+        if (*end != '\0' || end == argv[i] || pid > INT_MAX || pid < INT_MIN) {
+            printf("kill: %s: arguments must be process or job IDs\n", argv[i]);
+            fflush(stdout);
+            result = 1;
+        }
+        else if (kill(pid, signo) == -1) {
+            perror("kill");
+            fflush(stdout);
+            result = 1;
+        }
+    }
+    return result;
+}
+
+/**
+*
+* static int builtinJobs(char *argv[], int argc, struct shellState *shell)
+*
+* Summary:
+*       `jobs [-p]` lists the background jobs, running or stopped; -p
+*       prints only their pids
+*
+**/
+static int builtinJobs(char *argv[], int argc, struct shellState *shell)
+{
+    _Bool pidsOnly = (argc > 1 && strcmp(argv[1], "-p") == 0);
+    for (struct job *job = jobsNext(NULL); job; job = jobsNext(job)) {
+        if (!job->background) {
+            continue;
+        }
+        if (pidsOnly) {
+            printf("%d\n", job->jobPid);
+        }
+        else {
+            printJob(job);
+        }
+    }
+    return 0;
+}
+
+/**
+*
+* static int builtinPrintf(char *argv[], int argc, struct shellState *shell)
+*
+* Summary:
+*       `printf format [arg...]` prints its arguments under control of
+*       the format
+*
+* Description:
+*       Supports backslash escapes and %s %b %c %d %i %u %o %x %X %f %F
+*       %e %E %g %G %a %A %% with flags, width and precision. %b expands
+*       the escapes of `echo -e` in its argument, and a \c there ends all
+*       output. Missing arguments count as empty strings or zero, and the
+*       format is reused while arguments remain. Any other conversion is
+*       an error.
+*
+**/
+static int builtinPrintf(char *argv[], int argc, struct shellState *shell)
+{
+    int result = 0;
+    int next = 2;
+
+    if (argc < 2) {
+        printf("printf: usage: printf format [arguments]\n");
+        return 2;
+    }
+
+    do {
+        int firstArg = next;
+        for (const char *f = argv[1]; *f; f++) {
+            if (*f == '\\') {
+                f = printEscape(stdout, f);
+                continue;
+            }
+            if (*f != '%') {
+                putchar(*f);
+                continue;
+            }
+            if (f[1] == '%') {
+                putchar('%');
+                f++;
+                continue;
+            }
+
+            // copy %[flags][width][.precision] and add a length for numbers
+            char spec[32];
+            size_t n = 0;
+            const char *start = f++;
+            spec[n++] = '%';
+            while (*f && strchr("-+ #0", *f) && n < 8) {
+                spec[n++] = *f++;
+            }
+            while (*f >= '0' && *f <= '9' && n < 16) {
+                spec[n++] = *f++;
+            }
+            if (*f == '.') {
+                spec[n++] = *f++;
+                while (*f >= '0' && *f <= '9' && n < 24) {
+                    spec[n++] = *f++;
+                }
+            }
+
+            if (!*f || !strchr("sbcdiuoxXfFeEgGaA", *f)) {
+                printf("printf: %.*s: invalid conversion\n",
+                        (int)(f - start + (*f != '\0')), start);
+                return 1;
+            }
+
+            const char *arg = (next < argc) ? argv[next++] : "";
+            if (*f == 'b') {
+                // expanded into a string first, for the width and precision
+                char *text = NULL;
+                size_t length = 0;
+                FILE *out = open_memstream(&text, &length);
+                _Bool more = out && echoEscapes(out, arg);
+                if (out) {
+                    fclose(out);
+                }
+                spec[n++] = 's';
+                spec[n] = '\0';
+                printf(spec, text ? text : "");
+                free(text);
+                if (!more) {
+                    return result;
+                }
+            }
+            else if (strchr("fFeEgGaA", *f)) {
+                spec[n++] = *f;
+                spec[n] = '\0';
+                char *end;
+                errno = 0;
+                double value = strtod(arg, &end);
+                if (*arg && (*end || errno)) {
+                    printf("printf: %s: invalid number\n", arg);
+                    result = 1;
+                }
+                printf(spec, value);
+            }
+            else if (*f == 's' || *f == 'c') {
+                spec[n++] = *f;
+                spec[n] = '\0';
+                if (*f == 's') {
+                    printf(spec, arg);
+                }
+                else if (*arg) {
+                    printf(spec, *arg);
+                }
+            }
+            else {
+                spec[n++] = 'l';
+                spec[n++] = 'l';
+                spec[n++] = *f;
+                spec[n] = '\0';
+                char *end;
+                errno = 0;
+                long long value = strtoll(arg, &end, 0);
+                if (*arg && (*end || errno)) {
+                    printf("printf: %s: invalid number\n", arg);
+                    result = 1;
+                }
+                printf(spec, value);
+            }
+        }
+        if (next == firstArg) {
+            break;
+        }
+    } while (next < argc);
+
+    return result;
+}
+
+/**
+*
+* static int builtinHistory(char *argv[], int argc, struct shellState *shell)
+*
+* Summary:
+*       `history [n]` lists the last n history entries, all by default;
+*       `history -s text` lists the entries that contain text
+*
+**/
+static int builtinHistory(char *argv[], int argc, struct shellState *shell)
+{
+    size_t count = historyCount();
+    size_t length;
+
+    if (argc > 2 && strcmp(argv[1], "-s") == 0) {
+        // collect matches newest first, then list them oldest first
+        size_t *matches = NULL;
+        size_t numMatches = 0;
+        size_t capacity = 0;
+        size_t number = count + 1;
+        while ((number = historyFindSubstring(argv[2], strlen(argv[2]), number)) != 0) {
+            if (numMatches == capacity) {
+                capacity = capacity ? capacity * 2 : 64;
+                matches = realloc(matches, capacity * sizeof(size_t));
+            }
+            matches[numMatches++] = number;
+        }
+        while (numMatches > 0) {
+            number = matches[--numMatches];
+            const char *entry = historyGet(number, &length);
+            printf("%5zu  %.*s\n", number, (int)length, entry);
+        }
+        free(matches);
+        return 0;
+    }
+
+    size_t first = 1;
+    if (argc > 1) {
+        char *end;
+        long n = strtol(argv[1], &end, 10);
+        if (*argv[1] == '\0' || *end != '\0' || n < 0) {
+            printf("history: %s: numeric argument required\n", argv[1]);
+            return 2;
+        }
+        if ((size_t)n < count) {
+            first = count - n + 1;
+        }
+    }
+    for (size_t number = first; number <= count; number++) {
+        const char *entry = historyGet(number, &length);
+        printf("%5zu  %.*s\n", number, (int)length, entry);
+    }
+    return 0;
+}
+
+/**
+*
+* static int builtinPwd(char *argv[], int argc, struct shellState *shell)
+*
+* Summary:
+*       `pwd` prints the working directory
+*
+**/
+static int builtinPwd(char *argv[], int argc, struct shellState *shell)
+{
+    char cwd[PATH_MAX];
+    if (!getcwd(cwd, sizeof(cwd))) {
+        perror("pwd");
+        return 1;
+    }
+    puts(cwd);
+    return 0;
+}
+
+/**
+*
+* static int builtinReturn(char *argv[], int argc, struct shellState *shell)
+*
+* Summary:
+*       `return [n]` ends a function or sourced script with n, or with the
+*       status of the last command
+*
+**/
+static int builtinReturn(char *argv[], int argc, struct shellState *shell)
+{
+    if (shell->functionDepth == 0) {
+        printf("return: can only `return' from a function or sourced script\n");
+        fflush(stdout);
+        return 1;
+    }
+    int result = exitValue(shell->foregroundStatus);
+    if (argc > 1) {
+        char *end;
+        long value = strtol(argv[1], &end, 10);
+        if (end == argv[1] || *end != '\0') {
+            printf("return: %s: numeric argument required\n", argv[1]);
+            fflush(stdout);
+            result = 2;
+        }
+        else {
+            result = value & 0xff;
+        }
+    }
+    shell->returning = 1;
+    return result;
+}
+
+/**
+*
+* static int builtinShstats(char *argv[], int argc, struct shellState *shell)
+*
+* Summary:
+*       `shstats` prints the shell's per-phase latencies, `shstats -r`
+*       clears them
+*
+**/
+static int builtinShstats(char *argv[], int argc, struct shellState *shell)
+{
+    if (argc > 1 && strcmp(argv[1], "-r") == 0) {
+        statsReset();
+        return 0;
+    }
+    return statsPrint(stdout);
+}
+
+/**
+*
+* static int builtinSource(char *argv[], int argc, struct shellState *shell)
+*
+* Summary:
+*       `source file [arg...]` and `. file [arg...]` run the commands of a
+*       file in the shell
+*
+* Description:
+*       Arguments become the positional parameters while it runs. See
+*       scriptSource() for how the file's parsed commands are cached.
+*
+**/
+static int builtinSource(char *argv[], int argc, struct shellState *shell)
+{
+    if (argc < 2) {
+        printf("%s: filename argument required\n", argv[0]);
+        fflush(stdout);
+        return 2;
+    }
+    return scriptSource(argv[1], (argc > 2) ? argv + 2 : NULL, argc - 2, shell);
+}
+
+/**
+*
+* static int builtinStatus(char *argv[], int argc, struct shellState *shell)
+*
+* Summary:
+*       `status [-v]` prints the status of the last foreground command,
+*       and with -v the resources the last foreground job used
+*
+* Description:
+*       Built-ins and other commands run in the shell are not jobs and
+*       are not measured, so the usage is labeled: after one of them it
+*       is still that of the job before.
+*
+**/
+static int builtinStatus(char *argv[], int argc, struct shellState *shell)
+{
+    printStatus(shell->foregroundStatus);
+    if (argc > 1 && strcmp(argv[1], "-v") == 0) {
+        printf("last external job:\n");
+        printUsage(stdout, &shell->lastUsage);
+    }
+    return 0;
+}
+
+/**
+*
+* static int testNumber(const char *str, long *value)
+*
+* Summary:
+*       Parses an integer operand for test
+*
+* Returns:      0 on success, -1 after printing an error
+*
+**/
+static int testNumber(const char *str, long *value)
+{
+    char *end;
+    errno = 0;
+    *value = strtol(str, &end, 10);
+    if (!*str || *end || errno) {
+        printf("test: %s: integer expression expected\n", str);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+*
+* static int testUnary(const char *op, const char *operand)
+*
+* Summary:
+*       Evaluates a unary test: -n -z -e -f -d -p -S -b -c -r -w -x -s
+*       -L -h -t
+*
+* Returns:      0 for true, 1 for false, 2 for an unknown operator
+*
+**/
+static int testUnary(const char *op, const char *operand)
+{
+    struct stat info;
+
+    if (op[0] != '-' || !op[1] || op[2]) {
+        printf("test: %s: unary operator expected\n", op);
+        return 2;
+    }
+    switch (op[1]) {
+        case 'n':
+            return operand[0] == '\0';
+        case 'z':
+            return operand[0] != '\0';
+        case 'r':
+            return access(operand, R_OK) != 0;
+        case 'w':
+            return access(operand, W_OK) != 0;
+        case 'x':
+            return access(operand, X_OK) != 0;
+        case 'L':
+        case 'h':
+            return lstat(operand, &info) != 0 || !S_ISLNK(info.st_mode);
+        case 't':
+            return !isatty(atoi(operand));
+        case 'e':
+        case 'f':
+        case 'd':
+        case 'p':
+        case 'S':
+        case 'b':
+        case 'c':
+        case 's':
+            if (stat(operand, &info) != 0) {
+                return 1;
+            }
+            switch (op[1]) {
+                case 'f': return !S_ISREG(info.st_mode);
+                case 'd': return !S_ISDIR(info.st_mode);
+                case 'p': return !S_ISFIFO(info.st_mode);
+                case 'S': return !S_ISSOCK(info.st_mode);
+                case 'b': return !S_ISBLK(info.st_mode);
+                case 'c': return !S_ISCHR(info.st_mode);
+                case 's': return info.st_size == 0;
+                default: return 0;
+            }
+        default:
+            printf("test: %s: unary operator expected\n", op);
+            return 2;
+    }
+}
+
+/**
+*
+* static int testBinary(const char *left, const char *op, const char *right)
+*
+* Summary:
+*       Evaluates a binary test: = == != -eq -ne -lt -le -gt -ge
+*
+* Returns:      0 for true, 1 for false, 2 on error
+*
+**/
+static int testBinary(const char *left, const char *op, const char *right)
+{
+    static const char *numeric[] = { "-eq", "-ne", "-lt", "-le", "-gt", "-ge" };
+    long a, b;
+
+    if (strcmp(op, "=") == 0 || strcmp(op, "==") == 0) {
+        return strcmp(left, right) != 0;
+    }
+    if (strcmp(op, "!=") == 0) {
+        return strcmp(left, right) == 0;
+    }
+    for (int i = 0; i < 6; i++) {
+        if (strcmp(op, numeric[i]) != 0) {
+            continue;
+        }
+        if (testNumber(left, &a) == -1 || testNumber(right, &b) == -1) {
+            return 2;
+        }
+        switch (i) {
+            case 0: return !(a == b);
+            case 1: return !(a != b);
+            case 2: return !(a < b);
+            case 3: return !(a <= b);
+            case 4: return !(a > b);
+            default: return !(a >= b);
+        }
+    }
+    printf("test: %s: binary operator expected\n", op);
+    return 2;
+}
+
+/**
+*
+* static _Bool testIsBinary(const char *op)
+*
+* Summary:
+*       Checks if a word is an operator testBinary() knows
+*
+**/
+static _Bool testIsBinary(const char *op)
+{
+    static const char *binary[] = {
+        "=", "==", "!=", "-eq", "-ne", "-lt", "-le", "-gt", "-ge"
+    };
+    for (size_t i = 0; i < sizeof(binary) / sizeof(binary[0]); i++) {
+        if (strcmp(op, binary[i]) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+*
+* static _Bool testIsUnary(const char *op)
+*
+* Summary:
+*       Checks if a word is an operator testUnary() knows
+*
+**/
+static _Bool testIsUnary(const char *op)
+{
+    return op[0] == '-' && op[1] && !op[2] && strchr("nzrwxLhtefdpSbcs", op[1]);
+}
+
+// the operands of test and how far they have been read
+struct testParser {
+    char **argv;
+    int argc;
+    int pos;
+    _Bool error;    // a message was printed, the result is 2
+};
+
+static int testOr(struct testParser *t);
+
+/**
+*
+* static int testPrimary(struct testParser *t)
+*
+* Summary:
+*       Evaluates a binary test, a unary test, a ( expression ) or a
+*       string, in that order of preference
+*
+* Returns:      0 for true, 1 for false, 2 on error
+*
+**/
+static int testPrimary(struct testParser *t)
+{
+    char **argv = t->argv;
+    int left = t->argc - t->pos;
+    int result;
+
+    if (left == 0) {
+        printf("test: argument expected\n");
+        t->error = 1;
+        return 2;
+    }
+    if (left >= 3 && testIsBinary(argv[t->pos + 1])) {
+        result = testBinary(argv[t->pos], argv[t->pos + 1], argv[t->pos + 2]);
+        t->pos += 3;
+    }
+    else if (left >= 2 && strcmp(argv[t->pos], "(") == 0) {
+        t->pos++;
+        result = testOr(t);
+        if (t->error) {
+            return 2;
+        }
+        if (t->pos == t->argc || strcmp(argv[t->pos], ")") != 0) {
+            printf("test: `)' expected\n");
+            result = 2;
+        }
+        t->pos++;
+    }
+    else if (left >= 2 && testIsUnary(argv[t->pos])) {
+        result = testUnary(argv[t->pos], argv[t->pos + 1]);
+        t->pos += 2;
+    }
+    else {
+        // a string on its own is true when it is not empty
+        result = argv[t->pos++][0] == '\0';
+    }
+    t->error |= (result == 2);
+    return result;
+}
+
+/**
+*
+* static int testNot(struct testParser *t)
+*
+* Summary:
+*       Evaluates a primary with any number of `!` in front
+*
+**/
+static int testNot(struct testParser *t)
+{
+    // a last `!` is just a string, and so is one in front of a binary
+    // operator, as in `[ ! = x ]`
+    int left = t->argc - t->pos;
+    if (left >= 2 && strcmp(t->argv[t->pos], "!") == 0
+            && !(left >= 3 && testIsBinary(t->argv[t->pos + 1]))) {
+        t->pos++;
+        int result = testNot(t);
+        return t->error ? 2 : !result;
+    }
+    return testPrimary(t);
+}
+
+/**
+*
+* static int testAnd(struct testParser *t)
+*
+* Summary:
+*       Evaluates expressions joined by -a
+*
+**/
+static int testAnd(struct testParser *t)
+{
+    int result = testNot(t);
+    while (!t->error && t->pos < t->argc && strcmp(t->argv[t->pos], "-a") == 0) {
+        t->pos++;
+        int right = testNot(t);
+        result = (result != 0 || right != 0);
+    }
+    return t->error ? 2 : result;
+}
+
+/**
+*
+* static int testOr(struct testParser *t)
+*
+* Summary:
+*       Evaluates expressions joined by -o, which binds looser than -a
+*
+**/
+static int testOr(struct testParser *t)
+{
+    int result = testAnd(t);
+    while (!t->error && t->pos < t->argc && strcmp(t->argv[t->pos], "-o") == 0) {
+        t->pos++;
+        int right = testAnd(t);
+        result = (result != 0 && right != 0);
+    }
+    return t->error ? 2 : result;
+}
+
+/**
+*
+* static int builtinTest(char *argv[], int argc, struct shellState *shell)
+*
+* Summary:
+*       `test expr` and `[ expr ]` evaluate a condition
+*
+* Description:
+*       The POSIX grammar, read by recursive descent: -o joins -a, which
+*       joins `!` expressions, which are ( expression ), unary or binary
+*       tests or a string. A word is taken as an operator only when enough
+*       words follow it, so no operands is false, one is true when
+*       non-empty, and `[ ! ]` or `[ -n ]` test a string.
+*
+**/
+static int builtinTest(char *argv[], int argc, struct shellState *shell)
+{
+    if (strcmp(argv[0], "[") == 0) {
+        if (strcmp(argv[argc - 1], "]") != 0) {
+            printf("[: missing `]'\n");
+            return 2;
+        }
+        argc--;
+    }
+
+    struct testParser t = { .argv = argv + 1, .argc = argc - 1 };
+    if (t.argc == 0) {
+        return 1;
+    }
+    int result = testOr(&t);
+    if (!t.error && t.pos < t.argc) {
+        if (t.argc == 2) {
+            printf("test: %s: unary operator expected\n", t.argv[0]);
+        }
+        else if (t.argc == 3) {
+            printf("test: %s: binary operator expected\n", t.argv[1]);
+        }
+        else {
+            printf("test: too many arguments\n");
+        }
+        result = 2;
+    }
+    return result;
+}
+
+/**
+*
+* static int builtinColon(char *argv[], int argc, struct shellState *shell)
+*
+* Summary:
+*       `:` does nothing with its arguments, successfully
+*
+**/
+static int builtinColon(char *argv[], int argc, struct shellState *shell)
+{
+    return 0;
+}
+
+/**
+*
+* static int builtinTrue(char *argv[], int argc, struct shellState *shell)
+*
+* Summary:
+*       `true` does nothing, successfully
+*
+**/
+static int builtinTrue(char *argv[], int argc, struct shellState *shell)
+{
+    return 0;
+}
+
+/**
+*
+* static int builtinUnset(char *argv[], int argc, struct shellState *shell)
+*
+* Summary:
+*       `unset NAME...` removes variables, `unset -f NAME...`
+*       removes functions
+*
+**/
+static int builtinUnset(char *argv[], int argc, struct shellState *shell)
+{
+    int result = 0;
+    int first = 1;
+    _Bool functions = 0;
+    if (argc > 1 && (strcmp(argv[1], "-f") == 0 || strcmp(argv[1], "-v") == 0)) {
+        functions = (argv[1][1] == 'f');
+        first = 2;
+    }
+    for (int i = first; i < argc; i++) {
+        if (!validName(argv[i], strlen(argv[i]))) {
+            printf("unset: `%s': not a valid identifier\n", argv[i]);
+            result = 1;
+            continue;
+        }
+        if (functions) {
+            execUnsetFunction(argv[i]);
+        }
+        else {
+            varsUnset(argv[i]);
+        }
+    }
+    return result;
+}
+
+/**
+*
+* static int builtinWait(char *argv[], int argc, struct shellState *shell)
+*
+* Summary:
+*       `wait [%n|pid...]` waits for background jobs to finish
+*
+* Description:
+*       With no arguments it waits until no background job is running and
+*       returns 0; stopped jobs are not waited for. Otherwise it returns
+*       the exit value of the last job named. A job collected here is not
+*       reported as done at the next prompt.
+*
+**/
+static int builtinWait(char *argv[], int argc, struct shellState *shell)
+{
+    if (argc < 2) {
+        for (;;) {
+            _Bool running = 0;
+            for (struct job *job = jobsNext(NULL); job; job = jobsNext(job)) {
+                if (job->background && !job->stopped) {
+                    job->waited = 1;
+                    running |= !job->done;
+                }
+            }
+            if (!running) {
+                break;
+            }
+            shell->handleEvents(eventsWait(-1, 0));
+        }
+        struct job *next;
+        for (struct job *job = jobsNext(NULL); job; job = next) {
+            next = jobsNext(job);
+            if (job->waited && job->done) {
+                jobDelete(job);
+            }
+            else {
+                // stopped while waited for, report it as usual later
+                job->waited = 0;
+            }
+        }
+        return 0;
+    }
+
+    int result = 0;
+    for (int i = 1; i < argc; i++) {
+        struct job *job = jobArgument(argv[0], argv[i]);
+        if (!job) {
+            result = 127;
+            continue;
+        }
+        job->waited = 1;
+        while (!job->done && !job->stopped) {
+            shell->handleEvents(eventsWait(-1, 0));
+        }
+        if (job->stopped) {
+            job->waited = 0;
+            result = 128 + job->stopSignal;
+            continue;
+        }
+        result = exitValue(job->status);
+        jobDelete(job);
+    }
+    return result;
+}
+
+// sorted by name for bsearch()
+static const struct builtin builtins[] = {
+    { ".",      builtinSource,  0, 1 },
+    { ":",      builtinColon,   0, 0 },
+    { "[",      builtinTest,    0, 0 },
+    { "bg",     builtinBg,      0, 1 },
+    { "break",  builtinBreak,   0, 1 },
+    { "cd",     builtinCd,      0, 1 },
+    { "continue", builtinContinue, 0, 1 },
+    { "echo",   builtinEcho,    0, 0 },
+    { "exit",   builtinExit,    0, 1 },
+    { "export", builtinExport,  0, 1 },
+    { "false",  builtinFalse,   0, 0 },
+    { "fg",     builtinFg,      1, 1 },
+    { "hash",   builtinHash,    0, 1 },
+    { "history", builtinHistory, 0, 1 },
+    { "jobs",   builtinJobs,    0, 0 },
+    { "kill",   builtinKill,    0, 0 },
+    { "parallel", parallelRun,  0, 0 },
+    { "printf", builtinPrintf,  0, 0 },
+    { "pwd",    builtinPwd,     0, 0 },
+    { "return", builtinReturn,  0, 1 },
+    { "shstats", builtinShstats, 0, 0 },
+    { "source", builtinSource,  0, 1 },
+    { "status", builtinStatus,  1, 0 },
+    { "test",   builtinTest,    0, 0 },
+    { "true",   builtinTrue,    0, 0 },
+    { "unset",  builtinUnset,   0, 1 },
+    { "wait",   builtinWait,    0, 1 },
+};
+
+/**
+*
+* static int builtinCompare(const void *key, const void *entry)
+*
+* Summary:
+*       bsearch() comparison of a name against a table entry
+*
+**/
+static int builtinCompare(const void *key, const void *entry)
+{
+    return strcmp(key, ((const struct builtin *)entry)->name);
+}
+
+/**
+*
+* const struct builtin *builtinFind(const char *name)
+*
+* Summary:
+*       Looks up a built-in command by name
+*
+* Parameters:   char* for the command name
+*
+* Returns:      pointer to the table entry, or NULL if name is not built in
+*
+**/
+const struct builtin *builtinFind(const char *name)
+{
+    return bsearch(name, builtins, sizeof(builtins) / sizeof(builtins[0]),
+            sizeof(struct builtin), builtinCompare);
+}
+
+/**
+*
+* const char *builtinName(size_t index)
+*
+* Summary:
+*       Lists the built-in names, for completion
+*
+* Parameters:   size_t for the position in the table, from 0
+*
+* Returns:      the name, or NULL past the last built-in
+*
+**/
+const char *builtinName(size_t index)
+{
+    if (index >= sizeof(builtins) / sizeof(builtins[0])) {
+        return NULL;
+    }
+    return builtins[index].name;
+}
+
+/**
+*
+* int builtinRun(const struct builtin *builtin, struct command *cmd,
+*                struct shellState *shell)
+*
+* Summary:
+*       Runs a built-in with its redirections applied
+*
+* Parameters:   pointer to the built-in to run
+*               pointer to the parsed command
+*               pointer to the shell state
+*
+* Returns:      the exit value of the built-in
+*
+* Description:
+*       stdout is flushed before and after so buffered shell output never
+*       lands in a redirected file or the other way around. Unless the
+*       built-in is marked keepStatus, its exit value becomes the status of
+*       the last foreground command.
+*
+**/
+int builtinRun(const struct builtin *builtin, struct command *cmd,
+        struct shellState *shell)
+{
+    int numSteps = cmd->numRedirects;
+    struct redirect prepared[numSteps + 1];
+    struct redirectSaved saved[numSteps + 1];
+    int result = 1;
+
+    fflush(stdout);
+    STATS_TIMER(redirectStart);
+    STATS_START(redirectStart);
+    if (redirectPrepare(cmd->redirects, numSteps, prepared) == 0) {
+        redirectApply(prepared, numSteps, saved);
+        if (numSteps > 0) {
+            STATS_STOP(STATS_REDIRECT, redirectStart);
+        }
+        result = builtin->handler(cmd->argv, cmd->argc, shell);
+        fflush(stdout);
+        fflush(stderr);
+        redirectRestore(prepared, numSteps, saved);
+        redirectRelease(prepared, numSteps);
+    }
+
+    if (!builtin->keepStatus) {
+        shell->foregroundStatus = W_EXITCODE(result, 0);
+    }
+    return result;
+}
@@ -0,0 +1,63 @@
+/*******************************************************************************
+*
+* File:     builtins.h
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Interface for kell-shell built-in commands, which run inside the shell
+*   process instead of being spawned.
+*
+******************************************************************************/
+#ifndef BUILTINS_H
+#define BUILTINS_H
+
+#include <stdio.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "jobs.h"       // struct jobUsage
+
+struct command;
+
+struct shellState {
+    int foregroundStatus;   // wait status of the last foreground command
+    struct jobUsage lastUsage;  // resource use of the last foreground job
+    _Bool exitShell;        // set by `exit`
+    int exitStatus;         // value the shell exits with after `exit`
+    void (*handleEvents)(int events);   // for built-ins that wait on children
+    pid_t lastBackground;   // pid of the last background job, for $!
+    _Bool foregroundOnly;   // & is ignored, toggled by CTRL+Z
+    int pipeSize;           // F_SETPIPE_SZ for pipeline pipes, 0 for the default
+    const char *name;       // $0
+    char **args;            // $1 and on, of the shell, the sourced script
+    int numArgs;            // or the function running
+    int loopDepth;          // loops running, for break and continue
+    int breakLoops;         // loops `break` is leaving
+    int continueLoops;      // loops `continue` is leaving; the last of
+                            // them goes on with its next round
+    int functionDepth;      // functions and sourced scripts running
+    _Bool returning;        // set by `return`
+};
+
+typedef int (*builtinHandler)(char *argv[], int argc, struct shellState *shell);
+
+struct builtin {
+    const char *name;
+    builtinHandler handler;
+    _Bool keepStatus;       // does not replace the last foreground status
+    _Bool changesShell;     // changes the shell itself, so a subshell
+                            // running it must be a process of its own
+};
+
+const struct builtin *builtinFind(const char *name);
+const char *builtinName(size_t index);
+int builtinRun(const struct builtin *builtin, struct command *cmd,
+        struct shellState *shell);
+void printStatus(int status);
+void printJob(const struct job *job);
+void printUsage(FILE *out, const struct jobUsage *usage);
+int exitValue(int status);
+
+#endif
@@ -0,0 +1,479 @@
+/*******************************************************************************
+*
+* File:     complete.c
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Tab completion for kell-shell.
+*
+*   The first word of a command completes to built-in names and the
+*   commands in PATH; any other word, or one holding a `/`, completes to
+*   file names. Words are found and matched with their quotes and
+*   backslashes removed, as the lexer reads them, so `my\ fi` and `"my fi`
+*   complete `my fi`.
+*
+*   Command names come from an index of every PATH directory that is kept
+*   between key presses. Each directory's names are read once and kept
+*   sorted, so a lookup is a binary search per directory. The index is
+*   refreshed incrementally: at most once a second the directories are
+*   stat()ed and only those whose mtime changed are read again, and a new
+*   PATH rebuilds it. No key press ever reads every PATH directory, which
+*   keeps completion quick on large network-mounted bin directories.
+*
+******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "builtins.h"   // builtinName()
+#include "complete.h"
+#include "vars.h"       // varsGet()
+
+#define COMPLETE_RECHECK_NS 1000000000L     // stat PATH at most once a second
+
+struct pathDir {
+    char *path;
+    struct timespec mtime;  // of the directory when its names were read
+    _Bool read;
+    char **names;           // sorted
+    size_t count;
+};
+
+static char *indexedPath = NULL;    // PATH the index was built for
+static struct pathDir *dirs = NULL;
+static size_t numDirs = 0;
+static struct timespec lastCheck;
+
+static int compareNames(const void *a, const void *b)
+{
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+/**
+*
+* static void completionAdd(struct completion *result, const char *name,
+*                           size_t length, _Bool directory)
+*
+* Summary:
+*       Adds a match, with a trailing '/' for a directory
+*
+**/
+static void completionAdd(struct completion *result, const char *name,
+        size_t length, _Bool directory)
+{
+    if (result->count == result->capacity) {
+        result->capacity = result->capacity ? result->capacity * 2 : 32;
+        result->matches = realloc(result->matches, result->capacity * sizeof(char *));
+    }
+    char *match = malloc(length + 2);
+    memcpy(match, name, length);
+    if (directory) {
+        match[length++] = '/';
+    }
+    match[length] = '\0';
+    result->matches[result->count++] = match;
+}
+
+/**
+*
+* static void completionSort(struct completion *result)
+*
+* Summary:
+*       Sorts the matches and drops duplicates, such as a command found
+*       in two PATH directories
+*
+**/
+static void completionSort(struct completion *result)
+{
+    if (result->count < 2) {
+        return;
+    }
+    qsort(result->matches, result->count, sizeof(char *), compareNames);
+    size_t kept = 1;
+    for (size_t i = 1; i < result->count; i++) {
+        if (strcmp(result->matches[i], result->matches[kept - 1]) == 0) {
+            free(result->matches[i]);
+        }
+        else {
+            result->matches[kept++] = result->matches[i];
+        }
+    }
+    result->count = kept;
+}
+
+/**
+*
+* static void pathDirRead(struct pathDir *dir)
+*
+* Summary:
+*       Reads and sorts the names in one PATH directory
+*
+* Description:
+*       Subdirectories are skipped when the file system reports entry
+*       types; no entry is stat()ed, which would cost a round trip each on
+*       a network file system.
+*
+**/
+static void pathDirRead(struct pathDir *dir)
+{
+    for (size_t i = 0; i < dir->count; i++) {
+        free(dir->names[i]);
+    }
+    free(dir->names);
+    dir->names = NULL;
+    dir->count = 0;
+    dir->read = 1;
+
+    DIR *stream = opendir(dir->path);
+    if (!stream) {
+        return;
+    }
+    size_t capacity = 0;
+    struct dirent *entry;
+    while ((entry = readdir(stream)) != NULL) {
+        if (entry->d_name[0] == '.' || entry->d_type == DT_DIR) {
+            continue;
+        }
+        if (dir->count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            dir->names = realloc(dir->names, capacity * sizeof(char *));
+        }
+        dir->names[dir->count++] = strdup(entry->d_name);
+    }
+    closedir(stream);
+    if (dir->count > 1) {
+        qsort(dir->names, dir->count, sizeof(char *), compareNames);
+    }
+}
+
+/**
+*
+* static void pathIndexFree(void)
+*
+* Summary:
+*       Forgets every indexed PATH directory
+*
+**/
+static void pathIndexFree(void)
+{
+    for (size_t d = 0; d < numDirs; d++) {
+        for (size_t i = 0; i < dirs[d].count; i++) {
+            free(dirs[d].names[i]);
+        }
+        free(dirs[d].names);
+        free(dirs[d].path);
+    }
+    free(dirs);
+    free(indexedPath);
+    dirs = NULL;
+    numDirs = 0;
+    indexedPath = NULL;
+}
+
+/**
+*
+* static void pathIndexRefresh(void)
+*
+* Summary:
+*       Brings the PATH index up to date, see the top of the file
+*
+**/
+static void pathIndexRefresh(void)
+{
+    const char *path = varsGet("PATH");
+    if (!path) {
+        path = "";
+    }
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    if (!indexedPath || strcmp(indexedPath, path) != 0) {
+        pathIndexFree();
+        indexedPath = strdup(path);
+        for (const char *p = path; ; ) {
+            size_t length = strcspn(p, ":");
+            dirs = realloc(dirs, (numDirs + 1) * sizeof(struct pathDir));
+            memset(&dirs[numDirs], 0, sizeof(struct pathDir));
+            // an empty PATH entry means the current directory
+            dirs[numDirs].path = length ? strndup(p, length) : strdup(".");
+            numDirs++;
+            if (p[length] == '\0') {
+                break;
+            }
+            p += length + 1;
+        }
+    }
+    else if ((now.tv_sec - lastCheck.tv_sec) * 1000000000L
+            + (now.tv_nsec - lastCheck.tv_nsec) < COMPLETE_RECHECK_NS) {
+        return;
+    }
+    lastCheck = now;
+
+    for (size_t d = 0; d < numDirs; d++) {
+        struct stat info;
+        if (stat(dirs[d].path, &info) == -1) {
+            memset(&info, 0, sizeof(info));
+        }
+        if (!dirs[d].read || info.st_mtim.tv_sec != dirs[d].mtime.tv_sec
+                || info.st_mtim.tv_nsec != dirs[d].mtime.tv_nsec) {
+            dirs[d].mtime = info.st_mtim;
+            pathDirRead(&dirs[d]);
+        }
+    }
+}
+
+/**
+*
+* static void completeCommand(const char *word, size_t length,
+*                             struct completion *result)
+*
+* Summary:
+*       Collects the built-ins and PATH commands that start with word
+*
+**/
+static void completeCommand(const char *word, size_t length, struct completion *result)
+{
+    const char *name;
+    for (size_t i = 0; (name = builtinName(i)) != NULL; i++) {
+        if (strncmp(name, word, length) == 0) {
+            completionAdd(result, name, strlen(name), 0);
+        }
+    }
+
+    pathIndexRefresh();
+    for (size_t d = 0; d < numDirs; d++) {
+        // binary search for the first name >= word, then scan the run
+        size_t low = 0;
+        size_t high = dirs[d].count;
+        while (low < high) {
+            size_t middle = (low + high) / 2;
+            if (strncmp(dirs[d].names[middle], word, length) < 0) {
+                low = middle + 1;
+            }
+            else {
+                high = middle;
+            }
+        }
+        for (size_t i = low; i < dirs[d].count
+                && strncmp(dirs[d].names[i], word, length) == 0; i++) {
+            completionAdd(result, dirs[d].names[i], strlen(dirs[d].names[i]), 0);
+        }
+    }
+}
+
+/**
+*
+* static void completePath(const char *word, size_t length,
+*                          struct completion *result)
+*
+* Summary:
+*       Collects the file names that start with word
+*
+* Description:
+*       Matches are whole words, directory included, so they can replace
+*       the word as typed. Hidden files only match a name starting with '.'.
+*
+**/
+static void completePath(const char *word, size_t length, struct completion *result)
+{
+    const char *slash = memrchr(word, '/', length);
+    size_t dirLength = slash ? (size_t)(slash - word) + 1 : 0;
+    const char *base = word + dirLength;
+    size_t baseLength = length - dirLength;
+
+    char *dirPath = dirLength ? strndup(word, dirLength) : strdup(".");
+    DIR *stream = opendir(dirPath);
+    if (!stream) {
+        free(dirPath);
+        return;
+    }
+
+    char *match = NULL;
+    size_t matchCapacity = 0;
+    struct dirent *entry;
+    while ((entry = readdir(stream)) != NULL) {
+        const char *name = entry->d_name;
+        if (strncmp(name, base, baseLength) != 0
+                || (name[0] == '.' && (baseLength == 0 || base[0] != '.'))
+                || strcmp(name, ".") == 0 || strcmp(name, "..") == 0) {
+            continue;
+        }
+
+        size_t nameLength = strlen(name);
+        if (dirLength + nameLength + 1 > matchCapacity) {
+            matchCapacity = (dirLength + nameLength + 1) * 2;
+            match = realloc(match, matchCapacity);
+        }
+        memcpy(match, word, dirLength);
+        memcpy(match + dirLength, name, nameLength + 1);
+
+        _Bool directory = entry->d_type == DT_DIR;
+        if (entry->d_type == DT_UNKNOWN || entry->d_type == DT_LNK) {
+            struct stat info;
+            directory = stat(match, &info) == 0 && S_ISDIR(info.st_mode);
+        }
+        completionAdd(result, match, dirLength + nameLength, directory);
+    }
+    closedir(stream);
+    free(match);
+    free(dirPath);
+}
+
+/**
+*
+* void completeWord(const char *line, size_t cursor,
+*                   struct completion *result)
+*
+* Summary:
+*       Finds the completions of the word that ends at the cursor
+*
+* Parameters:   char* for the line being edited
+*               size_t for the cursor position
+*               pointer to an empty completion that receives the matches
+*
+* Returns:      nothing. result->wordStart is where the word begins,
+*               result->wordLength how long it is unquoted and
+*               result->quote the quote left open in it
+*
+* Description:
+*       The line is read from its start with the quoting rules of the
+*       lexer, since a blank or operator only ends a word when it is not
+*       quoted or escaped.
+*
+**/
+void completeWord(const char *line, size_t cursor, struct completion *result)
+{
+    char *word = malloc(cursor + 1);
+    size_t length = 0;
+    size_t start = cursor;
+    char quote = 0;
+    _Bool inWord = 0;
+    _Bool commandWord = 1;  // the first word of a command
+
+    for (size_t i = 0; i < cursor; i++) {
+        char c = line[i];
+        if (quote == '\'') {
+            if (c == '\'') {
+                quote = 0;
+            }
+            else {
+                word[length++] = c;
+            }
+            continue;
+        }
+        if (quote == '"') {
+            if (c == '"') {
+                quote = 0;
+            }
+            else if (c == '\\' && i + 1 < cursor && strchr("\"\\$`", line[i + 1])) {
+                word[length++] = line[++i];
+            }
+            else {
+                word[length++] = c;
+            }
+            continue;
+        }
+        if (c == ' ' || c == '\t' || strchr("|&;<>()", c)) {
+            if (inWord) {
+                inWord = 0;
+                commandWord = 0;
+            }
+            if (c != ' ' && c != '\t') {
+                // a redirection is followed by a file name
+                commandWord = (strchr("|&;(", c) != NULL);
+            }
+            continue;
+        }
+        if (!inWord) {
+            inWord = 1;
+            start = i;
+            length = 0;
+        }
+        if (c == '\\') {
+            if (i + 1 < cursor) {
+                word[length++] = line[++i];
+            }
+        }
+        else if (c == '\'' || c == '"') {
+            quote = c;
+        }
+        else {
+            word[length++] = c;
+        }
+    }
+    if (!inWord) {
+        length = 0;
+    }
+    word[length] = '\0';
+    result->wordStart = start;
+    result->wordLength = length;
+    result->quote = quote;
+
+    if (commandWord && !memchr(word, '/', length)) {
+        completeCommand(word, length, result);
+    }
+    else {
+        completePath(word, length, result);
+    }
+    completionSort(result);
+    free(word);
+}
+
+/**
+*
+* size_t completeCommonLength(const struct completion *result)
+*
+* Summary:
+*       Length of the prefix every match shares
+*
+**/
+size_t completeCommonLength(const struct completion *result)
+{
+    if (result->count == 0) {
+        return 0;
+    }
+    const char *first = result->matches[0];
+    size_t length = strlen(first);
+    for (size_t i = 1; i < result->count; i++) {
+        size_t n = 0;
+        while (n < length && first[n] == result->matches[i][n]) {
+            n++;
+        }
+        length = n;
+    }
+    return length;
+}
+
+/**
+*
+* void completionFree(struct completion *result)
+*
+* Summary:
+*       Frees the matches of one completion
+*
+**/
+void completionFree(struct completion *result)
+{
+    for (size_t i = 0; i < result->count; i++) {
+        free(result->matches[i]);
+    }
+    free(result->matches);
+    memset(result, 0, sizeof(*result));
+}
+
+/**
+*
+* void completeFree(void)
+*
+* Summary:
+*       Frees the PATH index
+*
+**/
+void completeFree(void)
+{
+    pathIndexFree();
+}
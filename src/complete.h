@@ -0,0 +1,31 @@
+/*******************************************************************************
+*
+* File:     complete.h
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Interface for kell-shell tab completion of command names and paths.
+*
+******************************************************************************/
+#ifndef COMPLETE_H
+#define COMPLETE_H
+
+#include <stddef.h>
+
+struct completion {
+    char **matches;     // sorted and unique; directories end in '/'
+    size_t count;
+    size_t capacity;
+    size_t wordStart;   // offset of the word being completed in the line
+    size_t wordLength;  // of the word once its quotes and escapes are gone
+    char quote;         // the quote still open at the cursor, or 0
+};
+
+void completeWord(const char *line, size_t cursor, struct completion *result);
+size_t completeCommonLength(const struct completion *result);
+void completionFree(struct completion *result);
+void completeFree(void);
+
+#endif
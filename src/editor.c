@@ -0,0 +1,822 @@
+/*******************************************************************************
+*
+* File:     editor.c
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Line editor for kell-shell. While a line is typed the terminal is in
+*   raw mode and every key is handled here:
+*
+*       Left/Right, CTRL+B/F    move the cursor
+*       Home/End, CTRL+A/E      jump to the start or end of the line
+*       Backspace, Delete       delete before or under the cursor
+*       CTRL+U/K/W              delete to the start, to the end, a word back
+*       Up/Down, CTRL+P/N       walk through the history
+*       CTRL+R                  incremental search back through the history
+*       Tab                     complete a command or path, list on a
+*                               second Tab
+*       CTRL+L                  clear the screen
+*       CTRL+D                  end of input on an empty line
+*
+*   Raw mode turns off the terminal's own signal keys, so CTRL+C is read
+*   as a key and abandons the line, and CTRL+Z is passed to the shell as
+*   the same EVENT_STOP a SIGTSTP produces, toggling foreground-only mode
+*   exactly as before. The terminal is put back in its normal mode before
+*   the line is returned, so commands run with the usual signal keys.
+*
+*   The editor waits in eventsWait() like the rest of the shell, so
+*   finished background jobs are still reported while a line is being
+*   typed; the line is cleared first and drawn again after.
+*
+*   Typing at the end of a line that fits only echoes the key. Anything
+*   else redraws the line with one write(), scrolled sideways when it is
+*   wider than the terminal.
+*
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+
+#include "complete.h"
+#include "editor.h"
+#include "events.h"     // eventsWait()
+#include "history.h"
+
+#define EDITOR_MIN_CAPACITY 256
+#define EDITOR_LIST_MAX 200     // matches a second Tab lists at most
+
+#define KEY_CTRL(key) ((key) & 0x1f)
+
+enum editorResult {
+    EDITOR_MORE,            // keep reading keys
+    EDITOR_DONE,            // the line is complete
+    EDITOR_EOF              // CTRL+D on an empty line
+};
+
+/**
+*
+* static void editorWrite(struct lineEditor *editor, const char *text,
+*                         size_t length)
+*
+* Summary:
+*       Writes to the terminal, retrying short writes
+*
+**/
+static void editorWrite(struct lineEditor *editor, const char *text, size_t length)
+{
+    while (length > 0) {
+        ssize_t n = write(editor->fd, text, length);
+        if (n <= 0) {
+            if (n == -1 && errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        text += n;
+        length -= n;
+    }
+}
+
+/**
+*
+* static int editorColumns(struct lineEditor *editor)
+*
+* Summary:
+*       Width of the terminal, 80 if it cannot be found
+*
+**/
+static int editorColumns(struct lineEditor *editor)
+{
+    struct winsize size;
+    if (ioctl(editor->fd, TIOCGWINSZ, &size) == -1 || size.ws_col == 0) {
+        return 80;
+    }
+    return size.ws_col;
+}
+
+/**
+*
+* static void editorRaw(struct lineEditor *editor)
+*
+* Summary:
+*       Puts the terminal in raw mode, saving its settings
+*
+* Description:
+*       Output processing stays on so the rest of the shell can keep
+*       printing "\n". TCSANOW keeps keys typed ahead of the prompt.
+*
+**/
+static void editorRaw(struct lineEditor *editor)
+{
+    struct termios raw;
+    tcgetattr(editor->fd, &editor->saved);
+    raw = editor->saved;
+    raw.c_iflag &= ~(BRKINT | ICRNL | INPCK | ISTRIP | IXON);
+    raw.c_cflag |= CS8;
+    raw.c_lflag &= ~(ECHO | ICANON | IEXTEN | ISIG);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    tcsetattr(editor->fd, TCSANOW, &raw);
+}
+
+static void editorRestore(struct lineEditor *editor)
+{
+    tcsetattr(editor->fd, TCSANOW, &editor->saved);
+}
+
+/**
+*
+* static void editorRefresh(struct lineEditor *editor)
+*
+* Summary:
+*       Draws the prompt and the line, or the search, over the current
+*       terminal line
+*
+**/
+static void editorRefresh(struct lineEditor *editor)
+{
+    size_t columns = editorColumns(editor);
+    size_t size = editor->promptLength + editor->length + EDITOR_QUERY_MAX + 64;
+    char *out = malloc(size);
+    size_t n = 0;
+
+    out[n++] = '\r';
+    if (editor->searching) {
+        size_t length = 0;
+        const char *match = editor->match ? historyGet(editor->match, &length) : "";
+        n += snprintf(out + n, size - n, "(%sreverse-i-search)`%.*s': ",
+                editor->searchFailed ? "failed " : "",
+                (int)editor->queryLength, editor->query);
+        // the match is clipped to the line rather than scrolled
+        size_t room = (columns > n) ? columns - n : 0;
+        if (length > room) {
+            length = room;
+        }
+        out = realloc(out, n + length + 8);
+        memcpy(out + n, match, length);
+        n += length;
+        memcpy(out + n, "\033[K", 3);
+        n += 3;
+    }
+    else {
+        // scroll sideways so the cursor stays on screen
+        size_t room = (columns > editor->promptLength + 1)
+                ? columns - editor->promptLength - 1 : 1;
+        size_t start = (editor->cursor > room) ? editor->cursor - room : 0;
+        size_t visible = editor->length - start;
+        if (visible > room) {
+            visible = room;
+        }
+
+        memcpy(out + n, editor->prompt, editor->promptLength);
+        n += editor->promptLength;
+        memcpy(out + n, editor->buffer + start, visible);
+        n += visible;
+        n += snprintf(out + n, size - n, "\033[K\r");
+        size_t column = editor->promptLength + editor->cursor - start;
+        if (column > 0) {
+            n += snprintf(out + n, size - n, "\033[%zuC", column);
+        }
+    }
+    editorWrite(editor, out, n);
+    free(out);
+}
+
+/**
+*
+* static void editorReserve(struct lineEditor *editor, size_t extra)
+*
+* Summary:
+*       Makes room for extra more bytes and the terminating NUL
+*
+**/
+static void editorReserve(struct lineEditor *editor, size_t extra)
+{
+    if (editor->length + extra + 1 > editor->capacity) {
+        while (editor->length + extra + 1 > editor->capacity) {
+            editor->capacity *= 2;
+        }
+        editor->buffer = realloc(editor->buffer, editor->capacity);
+    }
+}
+
+/**
+*
+* static void editorInsert(struct lineEditor *editor, const char *text,
+*                          size_t length)
+*
+* Summary:
+*       Inserts text at the cursor and moves the cursor past it
+*
+**/
+static void editorInsert(struct lineEditor *editor, const char *text, size_t length)
+{
+    editorReserve(editor, length);
+    memmove(editor->buffer + editor->cursor + length, editor->buffer + editor->cursor,
+            editor->length - editor->cursor + 1);
+    memcpy(editor->buffer + editor->cursor, text, length);
+    editor->length += length;
+    editor->cursor += length;
+}
+
+/**
+*
+* static void editorDelete(struct lineEditor *editor, size_t from,
+*                          size_t to)
+*
+* Summary:
+*       Deletes the bytes in [from, to) and leaves the cursor at from
+*
+**/
+static void editorDelete(struct lineEditor *editor, size_t from, size_t to)
+{
+    memmove(editor->buffer + from, editor->buffer + to, editor->length - to + 1);
+    editor->length -= to - from;
+    editor->cursor = from;
+}
+
+/**
+*
+* static void editorSetLine(struct lineEditor *editor, const char *text,
+*                           size_t length)
+*
+* Summary:
+*       Replaces the line, leaving the cursor at its end
+*
+**/
+static void editorSetLine(struct lineEditor *editor, const char *text, size_t length)
+{
+    editor->length = 0;
+    editor->cursor = 0;
+    editor->buffer[0] = '\0';
+    editorInsert(editor, text, length);
+}
+
+/**
+*
+* static void editorHistory(struct lineEditor *editor, int direction)
+*
+* Summary:
+*       Shows the previous (-1) or next (+1) history entry
+*
+* Description:
+*       The line being typed is kept as a draft and comes back after the
+*       newest entry.
+*
+**/
+static void editorHistory(struct lineEditor *editor, int direction)
+{
+    size_t count = historyCount();
+    size_t number = editor->historyNumber;
+
+    if (direction < 0 && number > 1) {
+        number--;
+    }
+    else if (direction > 0 && number <= count) {
+        number++;
+    }
+    if (number == editor->historyNumber) {
+        return;
+    }
+
+    if (editor->historyNumber == count + 1) {
+        free(editor->draft);
+        editor->draft = strndup(editor->buffer, editor->length);
+        editor->draftLength = editor->length;
+    }
+    editor->historyNumber = number;
+
+    if (number == count + 1) {
+        editorSetLine(editor, editor->draft, editor->draftLength);
+    }
+    else {
+        size_t length;
+        const char *entry = historyGet(number, &length);
+        editorSetLine(editor, entry, length);
+    }
+    editorRefresh(editor);
+}
+
+/**
+*
+* static void editorListMatches(struct lineEditor *editor,
+*                               const struct completion *result)
+*
+* Summary:
+*       Prints the matches in columns below the line, then redraws it
+*
+**/
+static void editorListMatches(struct lineEditor *editor, const struct completion *result)
+{
+    size_t columns = editorColumns(editor);
+    size_t width = 0;
+    size_t shown = result->count < EDITOR_LIST_MAX ? result->count : EDITOR_LIST_MAX;
+    for (size_t i = 0; i < shown; i++) {
+        size_t length = strlen(result->matches[i]);
+        if (length > width) {
+            width = length;
+        }
+    }
+    width += 2;
+    size_t perLine = (width < columns) ? columns / width : 1;
+
+    editorWrite(editor, "\r\n", 2);
+    for (size_t i = 0; i < shown; i++) {
+        char cell[512];
+        int n = snprintf(cell, sizeof(cell), "%-*s", (int)width, result->matches[i]);
+        editorWrite(editor, cell, n < (int)sizeof(cell) ? n : (int)sizeof(cell) - 1);
+        if ((i + 1) % perLine == 0 || i + 1 == shown) {
+            editorWrite(editor, "\r\n", 2);
+        }
+    }
+    if (shown < result->count) {
+        char more[64];
+        int n = snprintf(more, sizeof(more), "(%zu more)\r\n", result->count - shown);
+        editorWrite(editor, more, n);
+    }
+    editorRefresh(editor);
+}
+
+/**
+*
+* static void editorInsertQuoted(struct lineEditor *editor, const char *text,
+*                                size_t length, char quote)
+*
+* Summary:
+*       Inserts a completed name so that the lexer reads it back as it is
+*
+* Parameters:   pointer to the editor
+*               char* for the name
+*               size_t for its length
+*               char for the quote the word was opened with, or 0
+*
+* Returns:      nothing.
+*
+* Description:
+*       Without a quote, blanks and shell metacharacters get a backslash.
+*       In double quotes only " $ ` and \ do; a ' cannot be in single
+*       quotes, so it closes them, is escaped and opens them again.
+*
+**/
+static void editorInsertQuoted(struct lineEditor *editor, const char *text,
+        size_t length, char quote)
+{
+    const char *special = (quote == '"') ? "\"$`\\"
+            : (quote == '\'') ? "" : " \t\n|&;<>()$`\\\"'*?[]#!{}";
+    if (quote) {
+        editorInsert(editor, &quote, 1);
+    }
+    for (size_t i = 0; i < length; i++) {
+        if (quote == '\'' && text[i] == '\'') {
+            editorInsert(editor, "'\\''", 4);
+            continue;
+        }
+        if (text[i] != '\0' && strchr(special, text[i])) {
+            editorInsert(editor, "\\", 1);
+        }
+        editorInsert(editor, &text[i], 1);
+    }
+}
+
+/**
+*
+* static void editorComplete(struct lineEditor *editor)
+*
+* Summary:
+*       Completes the word before the cursor
+*
+* Description:
+*       A single match replaces the word and is followed by a space, or
+*       nothing for a directory; a quote the word opened is closed first.
+*       Several matches extend the word to their common prefix; if that
+*       adds nothing, a second Tab lists them. The word is written back
+*       quoted or escaped, since the names are matched unquoted.
+*
+**/
+static void editorComplete(struct lineEditor *editor)
+{
+    struct completion result = { 0 };
+    completeWord(editor->buffer, editor->cursor, &result);
+
+    size_t common = completeCommonLength(&result);
+
+    if (result.count == 0) {
+        editorWrite(editor, "\a", 1);
+    }
+    else if (common > result.wordLength || result.count == 1) {
+        const char *match = result.matches[0];
+        editorDelete(editor, result.wordStart, editor->cursor);
+        editorInsertQuoted(editor, match, common, result.quote);
+        if (result.count == 1 && match[common - 1] != '/') {
+            if (result.quote) {
+                editorInsert(editor, &result.quote, 1);
+            }
+            editorInsert(editor, " ", 1);
+        }
+        editorRefresh(editor);
+    }
+    else if (editor->lastWasTab) {
+        editorListMatches(editor, &result);
+    }
+    else {
+        editorWrite(editor, "\a", 1);
+    }
+    completionFree(&result);
+}
+
+/**
+*
+* static void editorSearch(struct lineEditor *editor, size_t before)
+*
+* Summary:
+*       Looks for the query in history entries older than `before`
+*
+**/
+static void editorSearch(struct lineEditor *editor, size_t before)
+{
+    size_t found = historyFindSubstring(editor->query, editor->queryLength, before);
+    editor->searchFailed = (found == 0 && editor->queryLength > 0);
+    if (found) {
+        editor->match = found;
+    }
+    editorRefresh(editor);
+}
+
+/**
+*
+* static void editorSearchEnd(struct lineEditor *editor, _Bool accept)
+*
+* Summary:
+*       Leaves CTRL+R search, keeping the match on the line or not
+*
+**/
+static void editorSearchEnd(struct lineEditor *editor, _Bool accept)
+{
+    editor->searching = 0;
+    if (accept && editor->match) {
+        size_t length;
+        const char *entry = historyGet(editor->match, &length);
+        editorSetLine(editor, entry, length);
+        editor->historyNumber = editor->match;
+    }
+    editorRefresh(editor);
+}
+
+/**
+*
+* static _Bool editorSearchKey(struct lineEditor *editor, unsigned char key)
+*
+* Summary:
+*       Handles a key during CTRL+R search
+*
+* Returns:      1 if the key was used by the search, 0 if it ended the
+*               search and should be handled as a normal key
+*
+**/
+static _Bool editorSearchKey(struct lineEditor *editor, unsigned char key)
+{
+    if (key == KEY_CTRL('r')) {
+        // the next older match
+        editorSearch(editor, editor->match ? editor->match : historyCount() + 1);
+    }
+    else if (key == KEY_CTRL('g') || key == KEY_CTRL('c')) {
+        editorSearchEnd(editor, 0);
+    }
+    else if (key == 0x7f || key == KEY_CTRL('h')) {
+        if (editor->queryLength > 0) {
+            editor->queryLength--;
+        }
+        editor->match = 0;
+        editorSearch(editor, historyCount() + 1);
+    }
+    else if (key >= 0x20 && key != 0x7f) {
+        if (editor->queryLength < EDITOR_QUERY_MAX) {
+            editor->query[editor->queryLength++] = key;
+        }
+        // the current match may still hold the longer query
+        editorSearch(editor, editor->match ? editor->match + 1 : historyCount() + 1);
+    }
+    else {
+        editorSearchEnd(editor, 1);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+*
+* static void editorEscape(struct lineEditor *editor)
+*
+* Summary:
+*       Acts on a complete escape sequence (arrow and editing keys)
+*
+**/
+static void editorEscape(struct lineEditor *editor)
+{
+    char final = editor->escape[editor->escapeLength - 1];
+    char number = (editor->escapeLength == 4) ? editor->escape[2] : 0;
+
+    if (editor->escape[1] != '[' && editor->escape[1] != 'O') {
+        return;     // ALT+key, unused
+    }
+    if (final == 'A') {
+        editorHistory(editor, -1);
+    }
+    else if (final == 'B') {
+        editorHistory(editor, 1);
+    }
+    else if (final == 'C' && editor->cursor < editor->length) {
+        editor->cursor++;
+        editorRefresh(editor);
+    }
+    else if (final == 'D' && editor->cursor > 0) {
+        editor->cursor--;
+        editorRefresh(editor);
+    }
+    else if (final == 'H' || (final == '~' && (number == '1' || number == '7'))) {
+        editor->cursor = 0;
+        editorRefresh(editor);
+    }
+    else if (final == 'F' || (final == '~' && (number == '4' || number == '8'))) {
+        editor->cursor = editor->length;
+        editorRefresh(editor);
+    }
+    else if (final == '~' && number == '3' && editor->cursor < editor->length) {
+        editorDelete(editor, editor->cursor, editor->cursor + 1);
+        editorRefresh(editor);
+    }
+}
+
+/**
+*
+* static enum editorResult editorKey(struct lineEditor *editor,
+*                                    unsigned char key,
+*                                    void (*handleEvents)(int events))
+*
+* Summary:
+*       Handles one byte of input, see the key list at the top of the file
+*
+**/
+static enum editorResult editorKey(struct lineEditor *editor, unsigned char key,
+        void (*handleEvents)(int events))
+{
+    // collect escape sequences until their final byte
+    if (editor->escapeLength > 0) {
+        editor->escape[editor->escapeLength++] = key;
+        _Bool complete = (editor->escapeLength == 2 && key != '[' && key != 'O')
+                || (editor->escapeLength >= 3 && (editor->escape[1] == 'O'
+                        || (key >= 0x40 && key <= 0x7e)))
+                || editor->escapeLength == sizeof(editor->escape);
+        if (complete) {
+            editorEscape(editor);
+            editor->escapeLength = 0;
+        }
+        return EDITOR_MORE;
+    }
+
+    if (editor->searching && editorSearchKey(editor, key)) {
+        return EDITOR_MORE;
+    }
+
+    _Bool tab = (key == '\t');
+    switch (key) {
+        case '\r':
+        case '\n':
+            if (editor->cursor != editor->length || editor->searching) {
+                editor->cursor = editor->length;
+                editorRefresh(editor);
+            }
+            editorWrite(editor, "\r\n", 2);
+            return EDITOR_DONE;
+        case '\t':
+            editorComplete(editor);
+            break;
+        case 0x1b:
+            editor->escape[0] = key;
+            editor->escapeLength = 1;
+            break;
+        case 0x7f:
+        case KEY_CTRL('h'):
+            if (editor->cursor > 0) {
+                editorDelete(editor, editor->cursor - 1, editor->cursor);
+                editorRefresh(editor);
+            }
+            break;
+        case KEY_CTRL('d'):
+            if (editor->length == 0) {
+                editorWrite(editor, "\r\n", 2);
+                return EDITOR_EOF;
+            }
+            if (editor->cursor < editor->length) {
+                editorDelete(editor, editor->cursor, editor->cursor + 1);
+                editorRefresh(editor);
+            }
+            break;
+        case KEY_CTRL('c'):
+            // abandon the line and start over on a fresh prompt
+            editorWrite(editor, "^C\r\n", 4);
+            editorSetLine(editor, "", 0);
+            editor->historyNumber = historyCount() + 1;
+            editorRefresh(editor);
+            break;
+        case KEY_CTRL('z'):
+            // what SIGTSTP does: toggle foreground-only mode
+            editorWrite(editor, "\r\033[K", 4);
+            handleEvents(EVENT_STOP);
+            editorRefresh(editor);
+            break;
+        case KEY_CTRL('a'):
+            editor->cursor = 0;
+            editorRefresh(editor);
+            break;
+        case KEY_CTRL('e'):
+            editor->cursor = editor->length;
+            editorRefresh(editor);
+            break;
+        case KEY_CTRL('b'):
+            if (editor->cursor > 0) {
+                editor->cursor--;
+                editorRefresh(editor);
+            }
+            break;
+        case KEY_CTRL('f'):
+            if (editor->cursor < editor->length) {
+                editor->cursor++;
+                editorRefresh(editor);
+            }
+            break;
+        case KEY_CTRL('u'):
+            editorDelete(editor, 0, editor->cursor);
+            editorRefresh(editor);
+            break;
+        case KEY_CTRL('k'):
+            editorDelete(editor, editor->cursor, editor->length);
+            editorRefresh(editor);
+            break;
+        case KEY_CTRL('w'): {
+            size_t start = editor->cursor;
+            while (start > 0 && editor->buffer[start - 1] == ' ') {
+                start--;
+            }
+            while (start > 0 && editor->buffer[start - 1] != ' ') {
+                start--;
+            }
+            editorDelete(editor, start, editor->cursor);
+            editorRefresh(editor);
+            break;
+        }
+        case KEY_CTRL('p'):
+            editorHistory(editor, -1);
+            break;
+        case KEY_CTRL('n'):
+            editorHistory(editor, 1);
+            break;
+        case KEY_CTRL('r'):
+            editor->searching = 1;
+            editor->searchFailed = 0;
+            editor->queryLength = 0;
+            editor->match = 0;
+            editorRefresh(editor);
+            break;
+        case KEY_CTRL('l'):
+            editorWrite(editor, "\033[H\033[2J", 7);
+            editorRefresh(editor);
+            break;
+        default:
+            if (key < 0x20) {
+                break;
+            }
+            if (editor->cursor == editor->length
+                    && editor->promptLength + editor->length + 1 < (size_t)editorColumns(editor)) {
+                // typing at the end of a line that fits: just echo the key
+                editorInsert(editor, (char *)&key, 1);
+                editorWrite(editor, (char *)&key, 1);
+            }
+            else {
+                editorInsert(editor, (char *)&key, 1);
+                editorRefresh(editor);
+            }
+            break;
+    }
+    editor->lastWasTab = tab;
+    return EDITOR_MORE;
+}
+
+/**
+*
+* void editorInit(struct lineEditor *editor, int fd)
+*
+* Summary:
+*       Sets up an editor on a terminal
+*
+* Parameters:   pointer to the editor
+*               int for the terminal descriptor, registered with
+*               eventsWatchInput()
+*
+* Returns:      nothing.
+*
+**/
+void editorInit(struct lineEditor *editor, int fd)
+{
+    memset(editor, 0, sizeof(struct lineEditor));
+    editor->fd = fd;
+    editor->capacity = EDITOR_MIN_CAPACITY;
+    editor->buffer = malloc(editor->capacity);
+    editor->buffer[0] = '\0';
+}
+
+/**
+*
+* const char *editorReadLine(struct lineEditor *editor, const char *prompt,
+*                            size_t *length,
+*                            void (*handleEvents)(int events))
+*
+* Summary:
+*       Prints the prompt and lets the user edit a line
+*
+* Parameters:   pointer to the editor
+*               char* for the prompt
+*               pointer to size_t for the length of the line
+*               function that handles EVENT_CHILD and EVENT_STOP; it may
+*               print, since the line is cleared before it is called
+*
+* Returns:      the NUL-terminated line, valid until the next call, or NULL
+*               at end of input
+*
+**/
+const char *editorReadLine(struct lineEditor *editor, const char *prompt,
+        size_t *length, void (*handleEvents)(int events))
+{
+    editor->prompt = prompt;
+    editor->promptLength = strlen(prompt);
+    editor->historyNumber = historyCount() + 1;
+    editor->searching = 0;
+    editor->escapeLength = 0;
+    editor->lastWasTab = 0;
+    editorSetLine(editor, "", 0);
+
+    fflush(stdout);
+    editorRaw(editor);
+    editorWrite(editor, prompt, editor->promptLength);
+
+    enum editorResult result = EDITOR_MORE;
+    while (result == EDITOR_MORE) {
+        // keys left over from the last line come first
+        if (editor->numPending == 0) {
+            int events = eventsWait(-1, 1);
+            if (events & (EVENT_CHILD | EVENT_STOP)) {
+                editorWrite(editor, "\r\033[K", 4);
+                handleEvents(events & (EVENT_CHILD | EVENT_STOP));
+                editorRefresh(editor);
+            }
+            if (!(events & EVENT_INPUT)) {
+                continue;
+            }
+            ssize_t n = read(editor->fd, editor->pending, sizeof(editor->pending));
+            if (n == -1 && (errno == EINTR || errno == EAGAIN)) {
+                continue;
+            }
+            if (n <= 0) {
+                result = EDITOR_EOF;
+                break;
+            }
+            editor->numPending = n;
+        }
+
+        size_t used = 0;
+        while (used < editor->numPending && result == EDITOR_MORE) {
+            result = editorKey(editor, editor->pending[used++], handleEvents);
+        }
+        memmove(editor->pending, editor->pending + used, editor->numPending - used);
+        editor->numPending -= used;
+    }
+
+    editorRestore(editor);
+    if (result == EDITOR_EOF) {
+        return NULL;
+    }
+    *length = editor->length;
+    return editor->buffer;
+}
+
+/**
+*
+* void editorFree(struct lineEditor *editor)
+*
+* Summary:
+*       Frees the editor's memory and the completion index
+*
+**/
+void editorFree(struct lineEditor *editor)
+{
+    free(editor->buffer);
+    free(editor->draft);
+    editor->buffer = NULL;
+    editor->draft = NULL;
+    completeFree();
+}
@@ -0,0 +1,54 @@
+/*******************************************************************************
+*
+* File:     editor.h
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Interface for the kell-shell line editor, used when the shell reads
+*   commands from a terminal.
+*
+******************************************************************************/
+#ifndef EDITOR_H
+#define EDITOR_H
+
+#include <stddef.h>
+#include <termios.h>
+
+#define EDITOR_QUERY_MAX 256
+
+struct lineEditor {
+    int fd;                 // the terminal
+    struct termios saved;   // terminal settings to restore after a line
+    const char *prompt;
+    size_t promptLength;
+
+    char *buffer;           // the line, NUL terminated
+    size_t length;
+    size_t cursor;
+    size_t capacity;
+
+    char pending[256];      // keys read after the end of the last line
+    size_t numPending;
+    char escape[8];         // escape sequence being read
+    size_t escapeLength;
+    _Bool lastWasTab;       // a second Tab lists the matches
+
+    size_t historyNumber;   // entry shown, historyCount() + 1 for the draft
+    char *draft;            // the line being typed, kept while browsing
+    size_t draftLength;
+
+    _Bool searching;        // in CTRL+R incremental search
+    _Bool searchFailed;
+    char query[EDITOR_QUERY_MAX];
+    size_t queryLength;
+    size_t match;           // entry found by the search, 0 for none
+};
+
+void editorInit(struct lineEditor *editor, int fd);
+const char *editorReadLine(struct lineEditor *editor, const char *prompt,
+        size_t *length, void (*handleEvents)(int events));
+void editorFree(struct lineEditor *editor);
+
+#endif
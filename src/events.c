@@ -0,0 +1,230 @@
+/*******************************************************************************
+*
+* File:     events.c
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Event loop for kell-shell, built on epoll and signalfd.
+*
+*   SIGCHLD and SIGTSTP are blocked and read from a signalfd instead of
+*   being handled asynchronously, so the shell can react to them with
+*   ordinary (non async-signal-safe) code such as printf. The signalfd and
+*   the input descriptor are watched by a single epoll instance: the shell
+*   sleeps until the user types, a child exits or CTRL+Z is pressed, and
+*   finished background jobs are reaped and reported right away instead of
+*   on the next Enter.
+*
+*   Input is registered one-shot. It is only re-armed when the caller asks
+*   for input, so a foreground child reading the terminal never causes the
+*   shell to spin while it waits for that child.
+*
+******************************************************************************/
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+
+#include "events.h"
+
+static int epollFd = -1;
+static int signalFd = -1;
+static int inputFd = -1;
+static _Bool inputArmed = 0;
+
+/**
+*
+* int eventsInit(void)
+*
+* Summary:
+*       Blocks SIGCHLD and SIGTSTP and starts watching them
+*
+* Parameters:   none
+*
+* Returns:      0 on success, -1 on failure with errno set
+*
+* Description:
+*       Children must not inherit the blocked mask; the spawn engine gives
+*       every child an empty signal mask.
+*
+**/
+int eventsInit(void)
+{
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    sigaddset(&mask, SIGTSTP);
+    sigprocmask(SIG_BLOCK, &mask, NULL);
+
+    signalFd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (signalFd == -1 || epollFd == -1) {
+        return -1;
+    }
+
+    struct epoll_event event = { 0 };
+    event.events = EPOLLIN;
+    event.data.fd = signalFd;
+    return epoll_ctl(epollFd, EPOLL_CTL_ADD, signalFd, &event);
+}
+
+/**
+*
+* int eventsWatchInput(int fd)
+*
+* Summary:
+*       Registers the descriptor the shell reads commands from
+*
+* Parameters:   int for the input descriptor
+*
+* Returns:      0 on success, -1 if the descriptor cannot be polled
+*
+* Description:
+*       Regular files cannot be added to epoll (they are always readable);
+*       the caller should then read without waiting.
+*
+**/
+int eventsWatchInput(int fd)
+{
+    struct epoll_event event = { 0 };
+    event.events = EPOLLIN | EPOLLONESHOT;
+    event.data.fd = fd;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) == -1) {
+        return -1;
+    }
+    inputFd = fd;
+    inputArmed = 1;
+    return 0;
+}
+
+/**
+*
+* static int eventsDrainSignals(void)
+*
+* Summary:
+*       Reads every pending signal from the signalfd
+*
+* Parameters:   none
+*
+* Returns:      mask of EVENT_CHILD and EVENT_STOP
+*
+* Description:
+*       Several SIGCHLDs may be merged into one; the caller reaps with a
+*       waitpid(-1, WNOHANG) loop so nothing is missed.
+*
+**/
+static int eventsDrainSignals(void)
+{
+    int events = 0;
+    struct signalfd_siginfo info;
+
+    while (read(signalFd, &info, sizeof(info)) == sizeof(info)) {
+        if (info.ssi_signo == SIGCHLD) {
+            events |= EVENT_CHILD;
+        }
+        else if (info.ssi_signo == SIGTSTP) {
+            events |= EVENT_STOP;
+        }
+    }
+    return events;
+}
+
+/**
+*
+* int eventsWait(int timeout, _Bool wantInput)
+*
+* Summary:
+*       Waits for input, child or SIGTSTP events
+*
+* Parameters:   int for the timeout in milliseconds, -1 to wait forever
+*                   and 0 to only collect what is already pending
+*               bool for whether input readiness should wake the caller
+*
+* Returns:      mask of EVENT_INPUT, EVENT_CHILD and EVENT_STOP, or 0 if
+*               the timeout passed or the wait was interrupted
+*
+**/
+int eventsWait(int timeout, _Bool wantInput)
+{
+    if (wantInput && inputFd != -1 && !inputArmed) {
+        struct epoll_event event = { 0 };
+        event.events = EPOLLIN | EPOLLONESHOT;
+        event.data.fd = inputFd;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, inputFd, &event);
+        inputArmed = 1;
+    }
+
+    struct epoll_event ready[2];
+    int n = epoll_wait(epollFd, ready, 2, timeout);
+    if (n == -1) {
+        // EINTR: nothing to report, the caller simply waits again
+        return 0;
+    }
+
+    int events = 0;
+    for (int i = 0; i < n; i++) {
+        if (ready[i].data.fd == signalFd) {
+            events |= eventsDrainSignals();
+        }
+        else {
+            // readable, hung up or in error: let the read report which
+            inputArmed = 0;
+            if (wantInput) {
+                events |= EVENT_INPUT;
+            }
+        }
+    }
+    return events;
+}
+
+/**
+*
+* void eventsFree(void)
+*
+* Summary:
+*       Closes the event loop descriptors
+*
+* Parameters:   none
+*
+* Returns:      nothing.
+*
+**/
+void eventsFree(void)
+{
+    if (epollFd != -1) {
+        close(epollFd);
+    }
+    if (signalFd != -1) {
+        close(signalFd);
+    }
+    epollFd = -1;
+    signalFd = -1;
+    inputFd = -1;
+}
+
+/**
+*
+* void eventsForget(void)
+*
+* Summary:
+*       Drops the event loop descriptors without closing them
+*
+* Parameters:   none
+*
+* Returns:      nothing.
+*
+* Description:
+*       For a forked subshell, which has closed them already along with
+*       the shell's other close-on-exec descriptors; their numbers may
+*       belong to a redirection by now. eventsInit() starts a new loop.
+*
+**/
+void eventsForget(void)
+{
+    epollFd = -1;
+    signalFd = -1;
+    inputFd = -1;
+    inputArmed = 0;
+}
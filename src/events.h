@@ -0,0 +1,26 @@
+/*******************************************************************************
+*
+* File:     events.h
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Interface for the kell-shell event loop. The shell waits in one place
+*   for input, finished children (SIGCHLD) and CTRL+Z (SIGTSTP).
+*
+******************************************************************************/
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#define EVENT_INPUT 1   // the input descriptor is readable
+#define EVENT_CHILD 2   // at least one child changed state
+#define EVENT_STOP  4   // SIGTSTP was received
+
+int eventsInit(void);
+int eventsWatchInput(int fd);
+int eventsWait(int timeout, _Bool wantInput);
+void eventsFree(void);
+void eventsForget(void);
+
+#endif
@@ -0,0 +1,1748 @@
+/*******************************************************************************
+*
+* File:     exec.c
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Executor for kell-shell. Runs the tree parseLine() builds for a line.
+*   `;`, `&&`, `||`, `if`, `while`, `until` and `for` are decided in the
+*   shell from the last foreground status, and `{ }` groups and function
+*   calls run in the shell with their redirections applied around them,
+*   so only the commands at the leaves are launched as processes.
+*
+*   A `( )` subshell runs in the shell as well unless its list could
+*   change the shell: a built-in such as cd, exit or export, a function,
+*   a loop variable or assignment, a background job, or a command whose
+*   name comes from an expansion or a wildcard. Then, and as a stage of a
+*   longer pipeline or in the background, it is a forked copy of the
+*   shell with an event loop and job table of its own.
+*
+*   The tree is never changed while it runs, so loop bodies, functions
+*   and cached scripts are parsed once and run any number of times. Words
+*   are expanded as a line is read; once a command of the line has run,
+*   $?, $! or a variable may have changed, so each later command expands
+*   copies of its words into the command arena before it runs. A loop
+*   rewinds the arena to where it stood before each round, so it runs in
+*   a fixed amount of memory however long it goes on. Wildcards are
+*   matched against the file system each time their command runs, with
+*   the directories listed kept until the command's words are done.
+*
+*   Assignments in front of a command go into the environment copy it is
+*   launched with, or, for a built-in or function, into the shell's
+*   variables until it returns. On their own they set shell variables.
+*
+*   A function keeps a copy of its body in an arena of its own, since the
+*   line that defined it is gone once the line is done. A command killed
+*   by CTRL+C, or CTRL+C at a terminal while a loop runs in the shell,
+*   ends the rest of the line.
+*
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>       // clock_gettime()
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>   // memfd_create()
+#include <sys/resource.h>   // getrusage()
+#include <sys/time.h>   // timersub()
+#include <sys/wait.h>
+
+#include "arena.h"
+#include "builtins.h"   // builtinRun(), printJob(), exitValue()
+#include "events.h"
+#include "exec.h"
+#include "expand.h"     // struct expandVars, expandLine()
+#include "fnv.h"
+#include "glob.h"
+#include "hash.h"       // hashSpawn()
+#include "jobs.h"
+#include "lex.h"        // lexLine(), lexExpandWord()
+#include "parse.h"
+#include "redirect.h"
+#include "spawn.h"
+#include "stats.h"
+#include "vars.h"
+
+#define FUNCTION_BUCKETS 64     // power of two
+#define FUNCTION_DEPTH_MAX 1000 // nested calls before giving up
+#define CAPTURE_DEPTH_MAX 8     // nested substitutions captured in the shell
+#define CAPTURE_READ_SIZE 65536 // room for each read of a substitution pipe
+
+// what a forked subshell runs, and how
+struct subshell {
+    struct command *cmd;
+    struct arena *arena;
+    struct shellState *shell;
+    _Bool stops;        // SIGTSTP stops it along with its job
+    _Bool background;   // a background job without job control
+};
+
+// where a command substitution runs, for execSubstitute()
+struct substitution {
+    struct arena *arena;
+    struct shellState *shell;
+    struct expandVars *vars;    // its $? follows each substitution
+};
+
+struct function {
+    char *name;
+    struct node *body;      // a copy of the compound command it runs
+    struct arena arena;     // holds the copy
+    struct function *next;  // in its bucket, or in the retired list
+};
+
+static _Bool fresh = 0;         // no command of the line has run yet
+static _Bool interrupted = 0;   // a command of the line died of SIGINT
+static _Bool subshellStops = 0; // in a subshell that SIGTSTP stops
+static _Bool subshellBackground = 0;    // in a background subshell
+static volatile sig_atomic_t sigintCaught = 0;  // CTRL+C reached the shell
+
+static struct function *functions[FUNCTION_BUCKETS];
+static int numFunctions = 0;
+static struct function *retired = NULL; // replaced, but maybe still running
+
+static int captureFds[CAPTURE_DEPTH_MAX];  // memfds for in-shell captures,
+static int numCaptureFds = 0;               // one per nesting level
+static int captureDepth = 0;
+
+static void execNode(struct node *node, struct arena *arena,
+        struct shellState *shell);
+static void execCompound(struct command *cmd, struct arena *arena,
+        struct shellState *shell);
+
+/**
+* 
+* static void timeBuiltin(struct timespec *start, struct rusage before[2],
+*                         struct jobUsage *usage)
+* 
+* Summary: 
+*       Measures a command run in the shell by the `time` keyword
+* 
+* Parameters:   pointer to the CLOCK_MONOTONIC time the built-in started
+*               array of the shell's own and its children's rusage from
+*               before the built-in started
+*               pointer to the jobUsage that receives the result
+* 				
+* Returns:      nothing.
+*
+* Description:
+*       Built-ins and groups have no job of their own, so their cost is
+*       the change in the shell's own usage plus that of any children
+*       reaped meanwhile (the jobs of `parallel`, for one). A peak RSS is
+*       not a sum that can be taken apart, so a built-in's own memory is
+*       not measured: the peak is the children's, and only when children
+*       were reaped while it ran, 0 otherwise. Even then it is the largest
+*       child the shell has ever reaped, which may be an earlier one.
+*
+**/
+static void timeBuiltin(struct timespec *start, struct rusage before[2],
+        struct jobUsage *usage) {
+    struct timespec now;
+    struct rusage after[2];
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    getrusage(RUSAGE_SELF, &after[0]);
+    getrusage(RUSAGE_CHILDREN, &after[1]);
+
+    memset(usage, 0, sizeof(*usage));
+    usage->wallSeconds = (now.tv_sec - start->tv_sec)
+            + (now.tv_nsec - start->tv_nsec) / 1e9;
+    for (int i = 0; i < 2; i++) {
+        struct rusage delta = after[i];
+        timersub(&after[i].ru_utime, &before[i].ru_utime, &delta.ru_utime);
+        timersub(&after[i].ru_stime, &before[i].ru_stime, &delta.ru_stime);
+        delta.ru_minflt -= before[i].ru_minflt;
+        delta.ru_majflt -= before[i].ru_majflt;
+        delta.ru_inblock -= before[i].ru_inblock;
+        delta.ru_oublock -= before[i].ru_oublock;
+        delta.ru_nvcsw -= before[i].ru_nvcsw;
+        delta.ru_nivcsw -= before[i].ru_nivcsw;
+        delta.ru_maxrss = 0;
+        jobUsageAdd(&usage->rusage, &delta);
+    }
+    _Bool reaped = timercmp(&after[1].ru_utime, &before[1].ru_utime, !=)
+            || timercmp(&after[1].ru_stime, &before[1].ru_stime, !=)
+            || after[1].ru_nvcsw != before[1].ru_nvcsw;
+    usage->rusage.ru_maxrss = reaped ? after[1].ru_maxrss : 0;
+}
+
+
+/**
+*
+* static void execSubshell(void *arg)
+*
+* Summary:
+*       Runs a compound command or function call in a forked child and
+*       exits
+*
+* Parameters:   pointer to the struct subshell to run
+*
+* Returns:      does not return
+*
+* Description:
+*       The event loop and job table came from the parent and describe its
+*       children, so the subshell starts its own. Its capture memfds were
+*       closed with the other close-on-exec descriptors and are made again
+*       on demand. SIGTSTP is unblocked: it either stops the subshell with
+*       its job or is ignored, it is never the CTRL+Z that toggles
+*       foreground-only mode. The redirections of the command were applied
+*       when the child was launched.
+*
+**/
+static void execSubshell(void *arg)
+{
+    struct subshell *subshell = arg;
+    struct shellState *shell = subshell->shell;
+
+    eventsForget();
+    jobsClear();
+    numCaptureFds = 0;
+    captureDepth = 0;
+    if (eventsInit() == -1) {
+        perror("subshell");
+        fflush(stdout);
+        _exit(1);
+    }
+    sigset_t tstpSet;
+    sigemptyset(&tstpSet);
+    sigaddset(&tstpSet, SIGTSTP);
+    sigprocmask(SIG_UNBLOCK, &tstpSet, NULL);
+    subshellStops = subshell->stops;
+    subshellBackground = subshell->background;
+
+    execCompound(subshell->cmd, subshell->arena, shell);
+    fflush(stdout);
+    _exit(shell->exitShell ? shell->exitStatus : exitValue(shell->foregroundStatus));
+}
+
+/**
+*
+* static unsigned execBucket(const char *name)
+*
+* Summary:
+*       Finds the bucket of a function name
+*
+**/
+static unsigned execBucket(const char *name)
+{
+    return fnvHash(name, strlen(name)) & (FUNCTION_BUCKETS - 1);
+}
+
+/**
+*
+* static struct function *execFindFunction(const char *name)
+*
+* Summary:
+*       Looks up a function by name
+*
+* Parameters:   char* for the command name
+*
+* Returns:      the function, or NULL if there is none by that name
+*
+* Description:
+*       Called for every command, so it costs nothing until a function
+*       has been defined.
+*
+**/
+static struct function *execFindFunction(const char *name)
+{
+    if (numFunctions == 0) {
+        return NULL;
+    }
+    for (struct function *function = functions[execBucket(name)]; function;
+            function = function->next) {
+        if (strcmp(function->name, name) == 0) {
+            return function;
+        }
+    }
+    return NULL;
+}
+
+/**
+*
+* int execUnsetFunction(const char *name)
+*
+* Summary:
+*       Removes a function
+*
+* Parameters:   char* for the function name
+*
+* Returns:      0 if it was removed, -1 if there was no such function
+*
+* Description:
+*       The function may be the one running (a function that redefines
+*       itself), so it is only freed once the line is done.
+*
+**/
+int execUnsetFunction(const char *name)
+{
+    struct function **link = &functions[execBucket(name)];
+    while (*link && strcmp((*link)->name, name) != 0) {
+        link = &(*link)->next;
+    }
+    if (!*link) {
+        return -1;
+    }
+    struct function *function = *link;
+    *link = function->next;
+    function->next = retired;
+    retired = function;
+    numFunctions--;
+    return 0;
+}
+
+/**
+*
+* static void execFreeRetired(void)
+*
+* Summary:
+*       Frees the functions removed or replaced while the line ran
+*
+**/
+static void execFreeRetired(void)
+{
+    while (retired) {
+        struct function *next = retired->next;
+        arenaFree(&retired->arena);
+        free(retired->name);
+        free(retired);
+        retired = next;
+    }
+}
+
+/**
+*
+* static void execDefine(struct command *cmd, struct shellState *shell)
+*
+* Summary:
+*       Defines a function, replacing one of the same name
+*
+* Parameters:   pointer to the COMMAND_FUNCTION command
+*               pointer to the shell state
+*
+* Returns:      nothing. the status is 0
+*
+**/
+static void execDefine(struct command *cmd, struct shellState *shell)
+{
+    execUnsetFunction(cmd->name);
+
+    struct function *function = calloc(1, sizeof(struct function));
+    function->name = strdup(cmd->name);
+    function->body = parseCopy(cmd->body, &function->arena);
+
+    unsigned bucket = execBucket(function->name);
+    function->next = functions[bucket];
+    functions[bucket] = function;
+    numFunctions++;
+    shell->foregroundStatus = W_EXITCODE(0, 0);
+}
+
+/**
+*
+* static _Bool execArgsTooLong(char **argv, char **envp)
+*
+* Summary:
+*       Checks an argument list against the system ARG_MAX limit
+*
+* Parameters:   NULL terminated argument list
+*               NULL terminated environment the command gets
+*
+* Returns:      true if exec would fail with E2BIG
+*
+* Description:
+*       Counts the strings and pointers of both, the way the kernel does.
+*       The environment is only walked when the arguments alone take up a
+*       good part of the limit.
+*
+**/
+static _Bool execArgsTooLong(char **argv, char **envp)
+{
+    static long argMax = 0;
+    if (argMax == 0) {
+        argMax = sysconf(_SC_ARG_MAX);
+    }
+    if (argMax <= 0) {
+        return 0;
+    }
+
+    size_t total = sizeof(char *);
+    for (char **arg = argv; *arg; arg++) {
+        total += strlen(*arg) + 1 + sizeof(char *);
+    }
+    if (total < (size_t)argMax / 2) {
+        return 0;
+    }
+
+    for (char **env = envp; *env; env++) {
+        total += strlen(*env) + 1 + sizeof(char *);
+    }
+    return total + sizeof(char *) > (size_t)argMax;
+}
+
+/**
+* 
+* static void runPipeline(struct pipeline *pipeline, struct arena *arena,
+*                         _Bool runInBackground, struct shellState *shell)
+* 
+* Summary: 
+*       Launches every command of a pipeline and waits for it unless it
+*       runs in the background
+* 
+* Parameters:   pointer to the pipeline to run
+*               pointer to the command arena, for per-stage bookkeeping
+*               bool for whether the pipeline runs in the background
+*               pointer to the shell state, for the last foreground status
+* 				
+* Returns:      nothing. status and resource use or job table is updated
+*
+* Description:
+*       Stages are connected with close-on-exec pipes so no child inherits
+*       pipe ends it does not use, and all stages run concurrently. The 
+*       parent closes each pipe end as soon as the stages using it exist, so
+*       readers see EOF when their writer exits. A stage that cannot be 
+*       launched is reported and counts as exiting with 1, as does an
+*       external command whose arguments and environment exceed ARG_MAX;
+*       built-ins and functions take arguments of any length.
+*
+*       Each stage's redirections are opened just before it is launched and
+*       closed in the shell right after. A stage whose redirection fails is
+*       not launched, like one whose command is missing.
+*
+*       A compound command or function call as a stage is a forked copy
+*       of the shell that runs it and exits with its status.
+*
+*       The status of the pipeline is the status of its last stage. In the
+*       background, every stage is tracked as one job reported under the 
+*       last stage's pid. With job control the stages share a process
+*       group led by the first; a foreground job that is stopped stays in
+*       the job table as a stopped background job.
+* 
+**/
+static void runPipeline(struct pipeline *pipeline, struct arena *arena,
+        _Bool runInBackground, struct shellState *shell) {
+    int last = pipeline->numCommands - 1;
+    pid_t *pids = arenaAlloc(arena, pipeline->numCommands * sizeof(pid_t));
+    int prevRead = -1;
+    int numStarted = 0;
+    _Bool jobControl = jobControlEnabled();
+
+    // the job exists before the first launch so its wall time covers them
+    struct job *job = jobCreate(runInBackground);
+    for (int i = 0; i <= last; i++) {
+        jobSetCommand(job, pipeline->commands[i].argv);
+    }
+
+    for (int i = 0; i <= last; i++) {
+        struct command *cmd = &pipeline->commands[i];
+        int pipeFds[2] = { -1, -1 };
+
+        if (i < last) {
+            if (pipe2(pipeFds, O_CLOEXEC) == -1) {
+                perror("pipe");
+                break;
+            }
+            if (shell->pipeSize > 0) {
+                fcntl(pipeFds[1], F_SETPIPE_SZ, shell->pipeSize);
+            }
+        }
+
+        struct redirect *plan = cmd->redirects;
+        int numSteps = cmd->numRedirects;
+        if (runInBackground) {
+            // input and output not redirected come from and go to /dev/null
+            struct redirect devNull[2] = {
+                { .action = REDIRECT_OPEN, .fd = 0, .text = "/dev/null",
+                    .flags = O_RDONLY },
+                { .action = REDIRECT_OPEN, .fd = 1, .text = "/dev/null",
+                    .flags = O_WRONLY }
+            };
+            _Bool nullInput = (i == 0 && !redirectTargets(plan, numSteps, 0));
+            _Bool nullOutput = (i == last && !redirectTargets(plan, numSteps, 1));
+            if (nullInput || nullOutput) {
+                struct redirect *extended = arenaAlloc(arena,
+                        (numSteps + 2) * sizeof(struct redirect));
+                int numExtra = 0;
+                if (nullInput) {
+                    extended[numExtra++] = devNull[0];
+                }
+                if (nullOutput) {
+                    extended[numExtra++] = devNull[1];
+                }
+                if (numSteps > 0) {
+                    memcpy(extended + numExtra, plan, numSteps * sizeof(struct redirect));
+                }
+                plan = extended;
+                numSteps += numExtra;
+            }
+        }
+
+        // files and here-documents are opened here, in the shell
+        struct redirect *prepared = arenaAlloc(arena,
+                numSteps * sizeof(struct redirect));
+        pids[i] = -1;
+        if (redirectPrepare(plan, numSteps, prepared) == 0) {
+            struct spawnRequest request = {
+                .argv = cmd->argv,
+                .envp = (cmd->numAssigns > 0)
+                        ? varsEnvironWith(cmd->assigns, cmd->numAssigns, arena)
+                        : varsEnviron(),
+                .inputFd = prevRead,
+                .outputFd = pipeFds[1],
+                .redirects = prepared,
+                .numRedirects = numSteps,
+                .defaultSIGINT = (!runInBackground && !subshellBackground) || jobControl,
+                .jobControl = jobControl,
+                .processGroup = job->pgid,
+                .defaultSIGTSTP = subshellStops
+            };
+            _Bool inChild = (cmd->type != COMMAND_SIMPLE || cmd->argc == 0
+                    || execFindFunction(cmd->argv[0]) || builtinFind(cmd->argv[0]));
+            if (inChild) {
+                struct subshell *subshell = arenaAlloc(arena, sizeof(struct subshell));
+                subshell->cmd = cmd;
+                subshell->arena = arena;
+                subshell->shell = shell;
+                subshell->stops = jobControl || subshellStops;
+                subshell->background = (runInBackground || subshellBackground) && !jobControl;
+                request.run = execSubshell;
+                request.runArg = subshell;
+                // the child must not write out the shell's buffered output
+                fflush(stdout);
+            }
+
+            // a PATH assigned in front of the command is the one searched
+            const char *search = NULL;
+            for (int a = 0; a < cmd->numAssigns; a++) {
+                if (strncmp(cmd->assigns[a], "PATH=", 5) == 0) {
+                    search = cmd->assigns[a] + 5;
+                }
+            }
+
+            // launch the command through the spawn engine
+            enum spawnFailure failure;
+            STATS_TIMER(spawnStart);
+            STATS_START(spawnStart);
+            _Bool tooLong = !inChild && execArgsTooLong(request.argv, request.envp);
+            if (!tooLong) {
+                pids[i] = inChild
+                        ? spawnCommand(&request, &failure) : hashSpawn(&request, search, &failure);
+            }
+            STATS_STOP(STATS_SPAWN, spawnStart);
+            if (tooLong) {
+                printf("%s: argument list too long\n", cmd->argv[0]);
+                fflush(stdout);
+            }
+            else if (pids[i] == -1) {
+                spawnPrintError(&request, failure);
+            }
+            else if (jobControl && job->pgid == 0) {
+                // the first stage leads the job's process group
+                job->pgid = pids[i];
+            }
+            redirectRelease(prepared, numSteps);
+        }
+        numStarted = i + 1;
+
+        // the children have their copies now
+        if (prevRead != -1) {
+            close(prevRead);
+        }
+        if (pipeFds[1] != -1) {
+            close(pipeFds[1]);
+        }
+        prevRead = pipeFds[0];
+    }
+    if (prevRead != -1) {
+        close(prevRead);
+    }
+
+    if (runInBackground) {
+        // report the job by its last stage, or the last stage that started
+        int jobPid = -1;
+        for (int i = 0; i < numStarted; i++) {
+            if (pids[i] != -1) {
+                jobPid = pids[i];
+            }
+        }
+        if (jobPid == -1) {
+            jobDelete(job);
+            return;
+        }
+
+        // add child processes to the job table as one background job
+        for (int i = 0; i < numStarted; i++) {
+            if (pids[i] != -1) {
+                jobAddProcess(job, pids[i], pids[i] == jobPid);
+            }
+        }
+
+        shell->lastBackground = jobPid;
+        printf("background pid is %d\n", jobPid);
+        fflush(stdout);
+    }
+    else {
+        // foreground: track the stages as a job and wait for all of them
+        // while still handling SIGTSTP and background completions
+        for (int i = 0; i < numStarted; i++) {
+            if (pids[i] != -1) {
+                jobAddProcess(job, pids[i], i == last);
+            }
+        }
+        STATS_TIMER(waitStart);
+        STATS_START(waitStart);
+        jobForeground(job, 0, shell->handleEvents);
+        STATS_STOP(STATS_WAIT, waitStart);
+
+        if (job->stopped) {
+            // CTRL+Z: the job waits in the table for fg or bg
+            shell->foregroundStatus = W_EXITCODE(128 + job->stopSignal, 0);
+            printf("\n");
+            printJob(job);
+            return;
+        }
+        if (job->jobPid != -1) {
+            shell->foregroundStatus = job->status;
+        }
+        else {
+            // nothing was run, report it like a child that exited 1
+            shell->foregroundStatus = W_EXITCODE(1, 0);
+        }
+        shell->lastUsage = job->usage;
+        jobDelete(job);
+
+        // if foreground child is terminated by signal, print status immediately
+        if (WIFSIGNALED(shell->foregroundStatus)) {
+            printStatus(shell->foregroundStatus);
+        }
+    }
+}
+
+/**
+*
+* static _Bool execNeedsFork(const struct node *node)
+*
+* Summary:
+*       Checks if a subshell's list must run in a process of its own
+*
+* Parameters:   pointer to the list, may be NULL
+*
+* Returns:      true if it could change the shell that runs it
+*
+**/
+static _Bool execNeedsFork(const struct node *node)
+{
+    if (!node) {
+        return 0;
+    }
+    if (node->type != NODE_PIPELINE) {
+        return execNeedsFork(node->left) || execNeedsFork(node->right);
+    }
+    const struct pipeline *pipeline = &node->pipeline;
+    if (pipeline->background) {
+        return 1;
+    }
+    for (int i = 0; i < pipeline->numCommands; i++) {
+        const struct command *cmd = &pipeline->commands[i];
+        if (cmd->type == COMMAND_FOR || cmd->type == COMMAND_FUNCTION) {
+            // sets a variable or defines a function
+            return 1;
+        }
+        if (cmd->type != COMMAND_SIMPLE) {
+            if (execNeedsFork(cmd->condition) || execNeedsFork(cmd->body)
+                    || execNeedsFork(cmd->orElse)) {
+                return 1;
+            }
+            continue;
+        }
+        if (cmd->argc == 0) {
+            if (cmd->numAssigns > 0) {
+                // sets a variable
+                return 1;
+            }
+            continue;
+        }
+        // a name from an expansion could turn out to be anything
+        for (int t = 0; t < cmd->numTokens; t++) {
+            if (cmd->tokens[t].text == cmd->argv[0]
+                    && (cmd->tokens[t].source || cmd->tokens[t].glob)) {
+                return 1;
+            }
+        }
+        if (execFindFunction(cmd->argv[0])) {
+            return 1;
+        }
+        const struct builtin *builtin = builtinFind(cmd->argv[0]);
+        if (builtin && builtin->changesShell) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+*
+* void execVars(const struct shellState *shell, struct expandVars *vars)
+*
+* Summary:
+*       Gathers the values $ words expand to
+*
+* Parameters:   pointer to the shell state
+*               pointer to the expandVars to fill in
+*
+* Returns:      nothing.
+*
+**/
+void execVars(const struct shellState *shell, struct expandVars *vars)
+{
+    vars->lastStatus = exitValue(shell->foregroundStatus);
+    vars->lastBackground = shell->lastBackground;
+    vars->name = shell->name;
+    vars->args = shell->args;
+    vars->numArgs = shell->numArgs;
+    vars->substitute = NULL;
+    vars->context = NULL;
+}
+
+/**
+*
+* static _Bool execOnlyBuiltins(const struct node *node)
+*
+* Summary:
+*       Checks if every command of a list is a lone built-in
+*
+**/
+static _Bool execOnlyBuiltins(const struct node *node)
+{
+    if (node->type != NODE_PIPELINE) {
+        return execOnlyBuiltins(node->left) && execOnlyBuiltins(node->right);
+    }
+    const struct pipeline *pipeline = &node->pipeline;
+    const struct command *cmd = &pipeline->commands[0];
+    return pipeline->numCommands == 1 && cmd->type == COMMAND_SIMPLE && cmd->argc > 0
+            && !execFindFunction(cmd->argv[0]) && builtinFind(cmd->argv[0]);
+}
+
+/**
+*
+* static char *execCaptureInShell(struct node *tree, struct arena *arena,
+*                                 struct shellState *shell, size_t *length)
+*
+* Summary:
+*       Runs a list of built-ins in the shell with their output captured
+*
+* Parameters:   pointer to the list
+*               pointer to the command arena, which receives the output
+*               pointer to the shell state
+*               pointer to the size_t that receives the output length
+*
+* Returns:      the output, or NULL if there is no buffer to capture it in
+*
+* Description:
+*       Nothing is forked. Standard output goes to a memfd for the time
+*       the list runs, which holds any amount of output without a reader,
+*       unlike a pipe, and is kept and emptied for the next substitution.
+*       Each nesting level has its own.
+*
+**/
+static char *execCaptureInShell(struct node *tree, struct arena *arena,
+        struct shellState *shell, size_t *length)
+{
+    if (captureDepth == CAPTURE_DEPTH_MAX) {
+        return NULL;
+    }
+    if (captureDepth == numCaptureFds) {
+        int fd = memfd_create("kell-capture", MFD_CLOEXEC);
+        if (fd == -1) {
+            return NULL;
+        }
+        // out of the way of the descriptors a command line names
+        captureFds[numCaptureFds] = fcntl(fd, F_DUPFD_CLOEXEC, REDIRECT_FD_BASE);
+        close(fd);
+        if (captureFds[numCaptureFds] == -1) {
+            return NULL;
+        }
+        numCaptureFds++;
+    }
+    int fd = captureFds[captureDepth++];
+    struct redirect step = { .action = REDIRECT_DUP, .fd = STDOUT_FILENO, .source = fd };
+    struct redirectSaved saved;
+
+    fflush(stdout);
+    redirectApply(&step, 1, &saved);
+    execNode(tree, arena, shell);
+    fflush(stdout);
+    redirectRestore(&step, 1, &saved);
+    captureDepth--;
+
+    off_t size = lseek(fd, 0, SEEK_CUR);
+    char *output = arenaAlloc(arena, (size > 0) ? size : 1);
+    ssize_t n = (size > 0) ? pread(fd, output, size, 0) : 0;
+    if (ftruncate(fd, 0) == -1 || lseek(fd, 0, SEEK_SET) == -1) {
+        perror("substitution");
+        fflush(stdout);
+    }
+    *length = (n > 0) ? n : 0;
+    return output;
+}
+
+/**
+*
+* static char *execCaptureForked(struct node *tree, struct arena *arena,
+*                                struct shellState *shell, size_t *length)
+*
+* Summary:
+*       Runs a list in a subshell and reads its output through a pipe
+*
+* Parameters:   pointer to the list
+*               pointer to the command arena, which receives the output
+*               pointer to the shell state
+*               pointer to the size_t that receives the output length
+*
+* Returns:      the output, or NULL if the subshell could not be started
+*
+* Description:
+*       The output is read straight into a buffer in the arena, which
+*       always keeps a full pipe's worth of room so each read takes all
+*       there is. It is done once everything that holds the pipe open has
+*       ended or closed it; then the subshell is reaped and its status
+*       becomes the last foreground status.
+*
+**/
+static char *execCaptureForked(struct node *tree, struct arena *arena,
+        struct shellState *shell, size_t *length)
+{
+    static char *argv[] = { "$(...)", NULL };
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) == -1) {
+        perror("substitution");
+        fflush(stdout);
+        return NULL;
+    }
+
+    struct command cmd = { .type = COMMAND_SUBSHELL, .argv = argv, .body = tree };
+    struct subshell subshell = { .cmd = &cmd, .arena = arena, .shell = shell };
+    struct spawnRequest request = {
+        .argv = argv,
+        .envp = varsEnviron(),
+        .inputFd = -1,
+        .outputFd = fds[1],
+        .defaultSIGINT = 1,
+        .run = execSubshell,
+        .runArg = &subshell
+    };
+    enum spawnFailure failure;
+    fflush(stdout);
+    pid_t pid = spawnCommand(&request, &failure);
+    close(fds[1]);
+    if (pid == -1) {
+        spawnPrintError(&request, failure);
+        close(fds[0]);
+        return NULL;
+    }
+
+    size_t size = CAPTURE_READ_SIZE;
+    size_t used = 0;
+    char *output = arenaAlloc(arena, size);
+    while (1) {
+        if (size - used < CAPTURE_READ_SIZE) {
+            output = arenaGrow(arena, output, used, size * 2);
+            size *= 2;
+        }
+        ssize_t n = read(fds[0], output + used, size - used);
+        if (n > 0) {
+            used += n;
+        }
+        else if (n == 0 || errno != EINTR) {
+            break;
+        }
+    }
+    close(fds[0]);
+
+    int status;
+    while (waitpid(pid, &status, 0) == -1 && errno == EINTR) {
+        continue;
+    }
+    shell->foregroundStatus = status;
+    if (WIFSIGNALED(status) && WTERMSIG(status) == SIGINT) {
+        interrupted = 1;
+    }
+    *length = used;
+    return output;
+}
+
+/**
+*
+* static const char *execSubstitute(const char *command, size_t length,
+*                                   size_t *outputLength, void *context)
+*
+* Summary:
+*       Runs the command of a $(...) or `...` and gives its output
+*
+* Parameters:   char* for the command text, not NUL terminated
+*               size_t for its length
+*               pointer to the size_t that receives the output length
+*               pointer to the struct substitution to run it with
+*
+* Returns:      the output, less its trailing newlines, in the command
+*               arena; NULL for none
+*
+* Description:
+*       The command is read and parsed like a line of its own. A list of
+*       built-ins that cannot change the shell runs in the shell itself
+*       (see execCaptureInShell()), anything else in a forked subshell.
+*       The status of the command becomes the last foreground status, for
+*       an assignment such as `x=$(false)` to return.
+*
+**/
+static const char *execSubstitute(const char *command, size_t length,
+        size_t *outputLength, void *context)
+{
+    struct substitution *substitution = context;
+    struct arena *arena = substitution->arena;
+    struct shellState *shell = substitution->shell;
+    *outputLength = 0;
+
+    // its own substitutions run as its commands do, not now
+    struct expandVars vars;
+    execVars(shell, &vars);
+    char *line = arenaStrndup(arena, command, length);
+    struct token *tokens;
+    struct node *tree = NULL;
+    int numTokens = lexLine(line, length, arena, &vars, &tokens);
+    int result = (numTokens > 0) ? parseLine(tokens, numTokens, arena, &tree) : numTokens;
+    if (result == LEX_INCOMPLETE) {
+        printf("syntax error: unterminated quote\n");
+        fflush(stdout);
+    }
+    if (result == PARSE_INCOMPLETE) {
+        printf("syntax error: unexpected end of file\n");
+        fflush(stdout);
+    }
+    if (result != 0) {
+        shell->foregroundStatus = W_EXITCODE(2, 0);
+        return NULL;
+    }
+    shell->foregroundStatus = W_EXITCODE(0, 0);
+    if (!tree) {
+        return NULL;
+    }
+
+    char *output = NULL;
+    if (!execNeedsFork(tree) && execOnlyBuiltins(tree)) {
+        output = execCaptureInShell(tree, arena, shell, outputLength);
+    }
+    if (!output) {
+        output = execCaptureForked(tree, arena, shell, outputLength);
+    }
+    while (*outputLength > 0 && output[*outputLength - 1] == '\n') {
+        (*outputLength)--;
+    }
+    substitution->vars->lastStatus = exitValue(shell->foregroundStatus);
+    return output;
+}
+
+/**
+*
+* static int execGlob(const struct token *word, struct globCache *cache,
+*                     size_t limit, struct token **words)
+*
+* Summary:
+*       Replaces a pattern with the paths it matches
+*
+* Parameters:   pointer to a word token that is a pattern
+*               pointer to the directory cache, whose arena the words are
+*                   allocated from
+*               size_t for the most bytes the matches may take, or 0
+*               pointer that receives the array of words
+*
+* Returns:      the number of words, or -1 if the matches would pass the
+*               limit. A pattern that matches nothing is one word, as
+*               written
+*
+**/
+static int execGlob(const struct token *word, struct globCache *cache, size_t limit,
+        struct token **words)
+{
+    char **paths;
+    int count = globExpand(word->text, word->length, cache, limit, &paths);
+    if (count == -1) {
+        return -1;
+    }
+    struct token *matches = arenaAlloc(cache->arena, (count ? count : 1) * sizeof(struct token));
+    if (count == 0) {
+        matches[0] = *word;
+        matches[0].text = globUnescape(cache->arena, word->text, word->length,
+                &matches[0].length);
+        matches[0].glob = 0;
+        *words = matches;
+        return 1;
+    }
+    for (int i = 0; i < count; i++) {
+        matches[i] = *word;
+        matches[i].text = paths[i];
+        matches[i].length = strlen(paths[i]);
+        matches[i].glob = 0;
+    }
+    *words = matches;
+    return count;
+}
+
+/**
+*
+* static _Bool execReexpands(const struct command *cmd)
+*
+* Summary:
+*       Checks if a command's words must be expanded again to run it
+*
+**/
+static _Bool execReexpands(const struct command *cmd)
+{
+    // before anything on the line ran, only substitutions, $@ and
+    // wildcards have something new to give
+    return (cmd->expands && (!fresh || cmd->substitutes || cmd->fields)) || cmd->globs;
+}
+
+/**
+*
+* static struct pipeline *execExpand(struct pipeline *pipeline,
+*                                    struct pipeline *expanded,
+*                                    struct arena *arena,
+*                                    struct shellState *shell)
+*
+* Summary:
+*       Expands the words of a pipeline's commands again
+*
+* Parameters:   pointer to the pipeline in the tree
+*               pointer to a pipeline to fill in with expanded copies
+*               pointer to the command arena
+*               pointer to the shell state, for the current values
+*
+* Returns:      the pipeline to run: the one in the tree if nothing in it
+*               expands, otherwise expanded. NULL after printing an error
+*
+* Description:
+*       Only the commands and tokens are copied; the words are expanded
+*       from their source text into the arena, patterns replaced by the
+*       paths they match, and the argument lists and redirection plans
+*       parsed anew from them. Before any command of the line has run,
+*       only commands with a command substitution, a $@ to split into
+*       words or a wildcard need it. A redirection target must stay one
+*       word.
+*
+*       Directory listings are shared by the patterns of the whole
+*       pipeline, unless a substitution runs in between. Each pattern may
+*       bring in up to ARG_MAX bytes of arguments.
+*
+**/
+static struct pipeline *execExpand(struct pipeline *pipeline,
+        struct pipeline *expanded, struct arena *arena, struct shellState *shell)
+{
+    int first = 0;
+    while (first < pipeline->numCommands && !execReexpands(&pipeline->commands[first])) {
+        first++;
+    }
+    if (first == pipeline->numCommands) {
+        return pipeline;
+    }
+
+    struct expandVars vars;
+    struct substitution substitution = { .arena = arena, .shell = shell, .vars = &vars };
+    struct globCache cache = { .arena = arena };
+    long argMax = sysconf(_SC_ARG_MAX);
+    execVars(shell, &vars);
+    vars.substitute = execSubstitute;
+    vars.context = &substitution;
+    *expanded = *pipeline;
+    expanded->commands = arenaAlloc(arena, pipeline->numCommands * sizeof(struct command));
+    memcpy(expanded->commands, pipeline->commands,
+            pipeline->numCommands * sizeof(struct command));
+
+    for (int i = first; i < pipeline->numCommands; i++) {
+        struct command *cmd = &expanded->commands[i];
+        if (!execReexpands(cmd)) {
+            continue;
+        }
+        struct token *words = cmd->tokens;
+        _Bool reexpand = cmd->expands && (!fresh || cmd->substitutes || cmd->fields);
+        int capacity = cmd->numTokens;
+        int numTokens = 0;
+        struct token *tokens = arenaAlloc(arena, capacity * sizeof(struct token));
+        for (int t = 0; t < cmd->numTokens; t++) {
+            struct token *split = &words[t];
+            int count = 1;
+            _Bool heredoc = (t > 0 && words[t - 1].type == TOKEN_HEREDOC);
+            _Bool target = (t > 0 && words[t - 1].type != TOKEN_WORD);
+            if (words[t].source && reexpand && heredoc) {
+                // a here-document body, as written
+                split = arenaAlloc(arena, sizeof(struct token));
+                *split = words[t];
+                split->length = split->sourceLength;
+                split->text = expandLine(arena, split->source, &split->length, &vars);
+            }
+            else if (words[t].source && reexpand) {
+                count = lexExpandWord(&words[t], arena, &vars, &split);
+                if (words[t].substitutes) {
+                    globCacheClear(&cache);
+                }
+            }
+
+            // output split into no word at all is no target either
+            _Bool ambiguous = target && count != 1;
+            for (int w = 0; w < count && !ambiguous; w++) {
+                struct token *matches = &split[w];
+                int numMatches = 1;
+                if (split[w].glob && !heredoc) {
+                    numMatches = execGlob(&split[w], &cache, argMax > 0 ? argMax : 0, &matches);
+                    if (numMatches == -1) {
+                        printf("%s: argument list too long\n",
+                                cmd->argc > 0 ? cmd->argv[0] : split[w].text);
+                        fflush(stdout);
+                        return NULL;
+                    }
+                }
+                if (target && numMatches != 1) {
+                    ambiguous = 1;
+                    break;
+                }
+                if (numTokens + numMatches > capacity) {
+                    tokens = arenaGrow(arena, tokens, numTokens * sizeof(struct token),
+                            (numTokens + numMatches) * 2 * sizeof(struct token));
+                    capacity = (numTokens + numMatches) * 2;
+                }
+                memcpy(tokens + numTokens, matches, numMatches * sizeof(struct token));
+                numTokens += numMatches;
+            }
+            if (ambiguous) {
+                printf("%.*s: ambiguous redirect\n",
+                        (int)(words[t].source ? words[t].sourceLength : words[t].length),
+                        words[t].source ? words[t].source : words[t].text);
+                fflush(stdout);
+                return NULL;
+            }
+        }
+        cmd->tokens = tokens;
+        cmd->numTokens = numTokens;
+        int result = (cmd->type == COMMAND_SIMPLE)
+                ? parseCommand(cmd, arena) : parseRedirects(cmd, arena);
+        if (result == -1) {
+            return NULL;
+        }
+    }
+    return expanded;
+}
+
+/**
+*
+* static void execInShell(struct command *cmd, struct arena *arena,
+*                         struct shellState *shell)
+*
+* Summary:
+*       Runs a compound command or function call in the shell with its
+*       redirections applied
+*
+* Parameters:   pointer to the command
+*               pointer to the command arena
+*               pointer to the shell state
+*
+* Returns:      nothing. the status of the last command it ran is kept
+*
+**/
+static void execInShell(struct command *cmd, struct arena *arena,
+        struct shellState *shell)
+{
+    int numSteps = cmd->numRedirects;
+    struct redirect prepared[numSteps + 1];
+    struct redirectSaved saved[numSteps + 1];
+
+    if (numSteps == 0) {
+        execCompound(cmd, arena, shell);
+        return;
+    }
+    fflush(stdout);
+    if (redirectPrepare(cmd->redirects, numSteps, prepared) == -1) {
+        shell->foregroundStatus = W_EXITCODE(1, 0);
+        return;
+    }
+    redirectApply(prepared, numSteps, saved);
+    execCompound(cmd, arena, shell);
+    fflush(stdout);
+    fflush(stderr);
+    redirectRestore(prepared, numSteps, saved);
+    redirectRelease(prepared, numSteps);
+}
+
+/**
+*
+* static _Bool execStopped(const struct shellState *shell)
+*
+* Summary:
+*       Checks if the rest of a list must be skipped: after `exit`,
+*       CTRL+C, `return`, `break` or `continue`
+*
+**/
+static _Bool execStopped(const struct shellState *shell)
+{
+    return shell->exitShell || interrupted || shell->returning
+            || shell->breakLoops || shell->continueLoops;
+}
+
+/**
+*
+* static _Bool execLoopDone(struct shellState *shell)
+*
+* Summary:
+*       Decides whether a loop ends after a round of its body
+*
+* Parameters:   pointer to the shell state
+*
+* Returns:      true if the loop must end
+*
+* Description:
+*       `break n` and `continue n` count down one loop at a time as they
+*       leave it; the loop that takes the last `continue` goes on.
+*
+**/
+static _Bool execLoopDone(struct shellState *shell)
+{
+    if (sigintCaught && !interrupted) {
+        // as if the loop itself had died of it
+        interrupted = 1;
+        shell->foregroundStatus = W_EXITCODE(0, SIGINT);
+    }
+    if (shell->breakLoops > 0) {
+        shell->breakLoops--;
+        return 1;
+    }
+    if (shell->continueLoops > 0) {
+        shell->continueLoops--;
+        return shell->continueLoops > 0;
+    }
+    return shell->exitShell || interrupted || shell->returning;
+}
+
+/**
+*
+* static void execIf(struct command *cmd, struct arena *arena,
+*                    struct shellState *shell)
+*
+* Summary:
+*       Runs the then part if the condition succeeds, else the else part
+*
+* Description:
+*       With no else part to run, the status is 0.
+*
+**/
+static void execIf(struct command *cmd, struct arena *arena, struct shellState *shell)
+{
+    execNode(cmd->condition, arena, shell);
+    if (execStopped(shell)) {
+        return;
+    }
+    if (exitValue(shell->foregroundStatus) == 0) {
+        execNode(cmd->body, arena, shell);
+    }
+    else if (cmd->orElse) {
+        execNode(cmd->orElse, arena, shell);
+    }
+    else {
+        shell->foregroundStatus = W_EXITCODE(0, 0);
+    }
+}
+
+/**
+*
+* static void execWhile(struct command *cmd, struct arena *arena,
+*                       struct shellState *shell)
+*
+* Summary:
+*       Runs the body of a `while` loop as long as its condition succeeds,
+*       or of an `until` loop as long as it fails
+*
+* Description:
+*       The status is that of the body's last command, or 0 if the body
+*       never ran.
+*
+**/
+static void execWhile(struct command *cmd, struct arena *arena, struct shellState *shell)
+{
+    int status = W_EXITCODE(0, 0);
+    struct arenaMark mark = arenaMark(arena);
+
+    shell->loopDepth++;
+    while (1) {
+        // nothing from the last round is needed any more
+        arenaRewind(arena, mark);
+        execNode(cmd->condition, arena, shell);
+        if (execLoopDone(shell)) {
+            break;
+        }
+        if ((exitValue(shell->foregroundStatus) == 0) != (cmd->type == COMMAND_WHILE)) {
+            shell->foregroundStatus = status;
+            break;
+        }
+        execNode(cmd->body, arena, shell);
+        status = shell->foregroundStatus;
+        if (execLoopDone(shell)) {
+            break;
+        }
+    }
+    shell->loopDepth--;
+}
+
+/**
+*
+* static void execFor(struct command *cmd, struct arena *arena,
+*                     struct shellState *shell)
+*
+* Summary:
+*       Runs the body of a `for` loop once for each word, with the
+*       variable set to it
+*
+* Description:
+*       The words are expanded once, before the first round, where
+*       command substitution output and $@ may split into several and a
+*       pattern becomes the paths it matches. Without
+*       `in`, the loop goes over the positional parameters. The variable
+*       is a shell variable, exported only if it already was.
+*
+**/
+static void execFor(struct command *cmd, struct arena *arena, struct shellState *shell)
+{
+    char **values = shell->args;
+    int numValues = shell->numArgs;
+    if (cmd->words) {
+        // the expanded words, before the mark so every round keeps them
+        struct expandVars vars;
+        struct substitution substitution = { .arena = arena, .shell = shell, .vars = &vars };
+        execVars(shell, &vars);
+        vars.substitute = execSubstitute;
+        vars.context = &substitution;
+        struct globCache cache = { .arena = arena };
+        int capacity = cmd->numWords + 1;
+        numValues = 0;
+        values = arenaAlloc(arena, capacity * sizeof(char *));
+        for (int i = 0; i < cmd->numWords; i++) {
+            struct token *word = &cmd->words[i];
+            int count = 1;
+            if (word->source && (!fresh || word->substitutes || word->fields)) {
+                count = lexExpandWord(&cmd->words[i], arena, &vars, &word);
+                if (cmd->words[i].substitutes) {
+                    globCacheClear(&cache);
+                }
+            }
+            for (int w = 0; w < count; w++) {
+                // the values are not exec() arguments: no limit
+                struct token *matches = &word[w];
+                int numMatches = word[w].glob ? execGlob(&word[w], &cache, 0, &matches) : 1;
+                if (numValues + numMatches >= capacity) {
+                    values = arenaGrow(arena, values, numValues * sizeof(char *),
+                            (numValues + numMatches) * 2 * sizeof(char *));
+                    capacity = (numValues + numMatches) * 2;
+                }
+                for (int m = 0; m < numMatches; m++) {
+                    values[numValues++] = matches[m].text;
+                }
+            }
+        }
+    }
+
+    struct arenaMark mark = arenaMark(arena);
+    shell->foregroundStatus = W_EXITCODE(0, 0);
+    shell->loopDepth++;
+    for (int i = 0; i < numValues; i++) {
+        arenaRewind(arena, mark);
+        varsSet(cmd->name, values[i], 0);
+        fresh = 0;
+        execNode(cmd->body, arena, shell);
+        if (execLoopDone(shell)) {
+            break;
+        }
+    }
+    shell->loopDepth--;
+}
+
+/**
+*
+* static void execCall(struct command *cmd, struct arena *arena,
+*                      struct shellState *shell)
+*
+* Summary:
+*       Calls a function with the command's arguments as its positional
+*       parameters, or runs a built-in that is a pipeline stage
+*
+* Parameters:   pointer to the simple command naming the function
+*               pointer to the command arena
+*               pointer to the shell state
+*
+* Returns:      nothing. the status is that of the function's last
+*               command, or the value given to `return`, or the exit
+*               value of the built-in
+*
+* Description:
+*       A built-in gets here only in the forked child of its stage, whose
+*       redirections the spawn engine has applied already.
+*
+**/
+static void execCall(struct command *cmd, struct arena *arena, struct shellState *shell)
+{
+    if (cmd->argc == 0) {
+        // a pipeline stage of only assignments, in its own process
+        for (int i = 0; i < cmd->numAssigns; i++) {
+            varsAssign(cmd->assigns[i], 0);
+        }
+        shell->foregroundStatus = W_EXITCODE(0, 0);
+        return;
+    }
+    struct function *function = execFindFunction(cmd->argv[0]);
+    const struct builtin *builtin = function ? NULL : builtinFind(cmd->argv[0]);
+    if (builtin) {
+        for (int i = 0; i < cmd->numAssigns; i++) {
+            varsPush(cmd->assigns[i]);
+        }
+        int result = builtin->handler(cmd->argv, cmd->argc, shell);
+        fflush(stdout);
+        fflush(stderr);
+        varsPop(cmd->numAssigns);
+        shell->foregroundStatus = W_EXITCODE(result, 0);
+        return;
+    }
+    if (!function) {
+        // unset by the time a forked stage got to it
+        shell->foregroundStatus = W_EXITCODE(127, 0);
+        return;
+    }
+    if (shell->functionDepth >= FUNCTION_DEPTH_MAX) {
+        printf("%s: maximum function nesting level exceeded (%d)\n",
+                cmd->argv[0], FUNCTION_DEPTH_MAX);
+        fflush(stdout);
+        shell->foregroundStatus = W_EXITCODE(1, 0);
+        return;
+    }
+
+    char **savedArgs = shell->args;
+    int savedNumArgs = shell->numArgs;
+    shell->args = cmd->argv + 1;
+    shell->numArgs = cmd->argc - 1;
+    shell->functionDepth++;
+    fresh = 0;
+    for (int i = 0; i < cmd->numAssigns; i++) {
+        varsPush(cmd->assigns[i]);
+    }
+
+    execNode(function->body, arena, shell);
+
+    varsPop(cmd->numAssigns);
+    shell->functionDepth--;
+    shell->returning = 0;
+    shell->args = savedArgs;
+    shell->numArgs = savedNumArgs;
+}
+
+/**
+*
+* static void execCompound(struct command *cmd, struct arena *arena,
+*                          struct shellState *shell)
+*
+* Summary:
+*       Runs a compound command, function definition or function call,
+*       leaving its redirections to the caller
+*
+**/
+static void execCompound(struct command *cmd, struct arena *arena,
+        struct shellState *shell)
+{
+    switch (cmd->type) {
+        case COMMAND_SIMPLE:
+            execCall(cmd, arena, shell);
+            break;
+        case COMMAND_SUBSHELL:
+        case COMMAND_GROUP:
+            execNode(cmd->body, arena, shell);
+            break;
+        case COMMAND_IF:
+            execIf(cmd, arena, shell);
+            break;
+        case COMMAND_WHILE:
+        case COMMAND_UNTIL:
+            execWhile(cmd, arena, shell);
+            break;
+        case COMMAND_FOR:
+            execFor(cmd, arena, shell);
+            break;
+        case COMMAND_FUNCTION:
+            execDefine(cmd, shell);
+            break;
+    }
+}
+
+/**
+*
+* static void execPipeline(struct pipeline *pipeline, struct arena *arena,
+*                          struct shellState *shell)
+*
+* Summary:
+*       Runs one pipeline of the tree
+*
+* Parameters:   pointer to the pipeline
+*               pointer to the command arena
+*               pointer to the shell state
+*
+* Returns:      nothing. the last foreground status is updated
+*
+* Description:
+*       A lone built-in, function call, compound command or function
+*       definition runs in the shell, unless it is sent to the background
+*       or is a subshell that needs a process. A lone command with only redirections
+*       creates its files and runs nothing. Everything else is launched
+*       by runPipeline().
+*
+**/
+static void execPipeline(struct pipeline *pipeline, struct arena *arena,
+        struct shellState *shell)
+{
+    // a command run before may have changed what $ words expand to, and
+    // command substitutions run now
+    struct pipeline expanded;
+    if (!(pipeline = execExpand(pipeline, &expanded, arena, shell))) {
+        shell->foregroundStatus = W_EXITCODE(1, 0);
+        return;
+    }
+    struct command *first = &pipeline->commands[0];
+    _Bool single = (pipeline->numCommands == 1);
+
+    // background processes are not allowed in foreground only mode
+    _Bool runInBackground = pipeline->background && !shell->foregroundOnly;
+
+    // `time` in front of a pipeline reports what it used
+    struct timespec timeStart;
+    struct rusage timeBefore[2];
+    if (pipeline->timed) {
+        clock_gettime(CLOCK_MONOTONIC, &timeStart);
+        getrusage(RUSAGE_SELF, &timeBefore[0]);
+        getrusage(RUSAGE_CHILDREN, &timeBefore[1]);
+    }
+
+    _Bool inShell;
+    const struct builtin *builtin = NULL;
+    if (!single) {
+        inShell = 0;
+    }
+    else if (first->type == COMMAND_SIMPLE && first->argc > 0
+            && execFindFunction(first->argv[0])) {
+        // functions come before built-ins of the same name
+        inShell = !runInBackground;
+    }
+    else if (first->type == COMMAND_SIMPLE) {
+        // a built-in on its own runs in the shell; in the background or as
+        // a pipeline stage it runs in the stage's child
+        builtin = (first->argc > 0) ? builtinFind(first->argv[0]) : NULL;
+        inShell = (first->argc == 0 || (builtin && !runInBackground));
+    }
+    else {
+        inShell = !runInBackground
+                && (first->type != COMMAND_SUBSHELL || !execNeedsFork(first->body));
+    }
+
+    if (!inShell) {
+        runPipeline(pipeline, arena, runInBackground, shell);
+
+        // CTRL+C ends the whole line, not just the command it killed
+        if (!runInBackground && WIFSIGNALED(shell->foregroundStatus)
+                && WTERMSIG(shell->foregroundStatus) == SIGINT) {
+            interrupted = 1;
+        }
+    }
+    else if (first->type == COMMAND_SIMPLE && first->argc == 0) {
+        // only redirections and assignments: files are created and
+        // variables set, nothing runs
+        struct redirect prepared[first->numRedirects + 1];
+        int result = redirectPrepare(first->redirects, first->numRedirects, prepared);
+        if (result == 0) {
+            redirectRelease(prepared, first->numRedirects);
+        }
+        for (int i = 0; result == 0 && i < first->numAssigns; i++) {
+            varsAssign(first->assigns[i], 0);
+        }
+        // x=$(cmd) returns the status of cmd
+        if (result != 0 || !first->substitutes) {
+            shell->foregroundStatus = W_EXITCODE((result == 0) ? 0 : 1, 0);
+        }
+    }
+    else if (builtin) {
+        // the command's own assignments last as long as the built-in
+        for (int i = 0; i < first->numAssigns; i++) {
+            varsPush(first->assigns[i]);
+        }
+        STATS_TIMER(builtinStart);
+        STATS_START(builtinStart);
+        builtinRun(builtin, first, shell);
+        STATS_STOP(STATS_BUILTIN, builtinStart);
+        varsPop(first->numAssigns);
+    }
+    else {
+        execInShell(first, arena, shell);
+    }
+
+    // report the time of the command, background jobs return at once
+    if (pipeline->timed && !runInBackground) {
+        struct jobUsage usage;
+        fflush(stdout);
+        if (inShell) {
+            timeBuiltin(&timeStart, timeBefore, &usage);
+            printUsage(stderr, &usage);
+        }
+        else {
+            printUsage(stderr, &shell->lastUsage);
+        }
+    }
+    fresh = 0;
+}
+
+/**
+*
+* static void execNode(struct node *node, struct arena *arena,
+*                      struct shellState *shell)
+*
+* Summary:
+*       Runs a list, deciding `&&` and `||` from the last foreground
+*       status
+*
+* Parameters:   pointer to the tree node
+*               pointer to the command arena
+*               pointer to the shell state
+*
+* Returns:      nothing.
+*
+**/
+static void execNode(struct node *node, struct arena *arena,
+        struct shellState *shell)
+{
+    if (execStopped(shell)) {
+        return;
+    }
+    switch (node->type) {
+        case NODE_PIPELINE:
+            execPipeline(&node->pipeline, arena, shell);
+            break;
+        case NODE_SEQUENCE:
+            execNode(node->left, arena, shell);
+            execNode(node->right, arena, shell);
+            break;
+        case NODE_AND:
+            execNode(node->left, arena, shell);
+            if (exitValue(shell->foregroundStatus) == 0) {
+                execNode(node->right, arena, shell);
+            }
+            break;
+        case NODE_OR:
+            execNode(node->left, arena, shell);
+            if (exitValue(shell->foregroundStatus) != 0) {
+                execNode(node->right, arena, shell);
+            }
+            break;
+    }
+}
+
+/**
+*
+* void execLine(struct node *root, struct arena *arena,
+*               struct shellState *shell)
+*
+* Summary:
+*       Runs the tree of a command line
+*
+* Parameters:   pointer to the root from parseLine()
+*               pointer to the command arena the tree lives in
+*               pointer to the shell state
+*
+* Returns:      nothing. status, job table and shell state are updated
+*
+* Description:
+*       The first command runs with the words as the line was expanded
+*       when it was read.
+*
+**/
+void execLine(struct node *root, struct arena *arena, struct shellState *shell)
+{
+    fresh = 1;
+    interrupted = 0;
+    sigintCaught = 0;
+    execNode(root, arena, shell);
+    execFreeRetired();
+}
+
+/**
+*
+* _Bool execTree(struct node *root, struct arena *arena,
+*                 struct shellState *shell)
+*
+* Summary:
+*       Runs a tree parsed some time before, such as a line of a cached
+*       script
+*
+* Parameters:   pointer to the tree
+*               pointer to the arena for what its commands need, which
+*                   need not be the one the tree lives in
+*               pointer to the shell state
+*
+* Returns:      true if the commands after it should not run: after
+*               `exit`, `return`, a `break` or `continue` out of it, or
+*               CTRL+C
+*
+* Description:
+*       Every word with a $ expansion is expanded again. A CTRL+C or
+*       `exit` before it was called skips it, as for the rest of a line.
+*
+**/
+_Bool execTree(struct node *root, struct arena *arena, struct shellState *shell)
+{
+    fresh = 0;
+    execNode(root, arena, shell);
+    return execStopped(shell);
+}
+
+/**
+*
+* static void execSigint(int signo)
+*
+* Summary:
+*       Notes a CTRL+C that reached the shell itself
+*
+**/
+static void execSigint(int signo)
+{
+    sigintCaught = 1;
+}
+
+/**
+*
+* void execCatchInterrupts(void)
+*
+* Summary:
+*       Lets CTRL+C end a loop running in the shell
+*
+* Parameters:   none
+*
+* Returns:      nothing.
+*
+* Description:
+*       Only for job control: commands then run in process groups of
+*       their own, so only a loop running in the shell itself is in the
+*       terminal's foreground to receive SIGINT. Without job control
+*       every child shares the shell's group and SIGINT stays ignored,
+*       which background commands inherit.
+*
+**/
+void execCatchInterrupts(void)
+{
+    struct sigaction action = {{0}};
+    action.sa_handler = execSigint;
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGINT, &action, NULL);
+}
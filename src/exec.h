@@ -0,0 +1,27 @@
+/*******************************************************************************
+*
+* File:     exec.h
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Interface for the kell-shell executor, which runs the tree a command
+*   line was parsed into, and keeps the shell's functions.
+*
+******************************************************************************/
+#ifndef EXEC_H
+#define EXEC_H
+
+struct arena;
+struct node;
+struct shellState;
+struct expandVars;
+
+void execLine(struct node *root, struct arena *arena, struct shellState *shell);
+_Bool execTree(struct node *root, struct arena *arena, struct shellState *shell);
+void execVars(const struct shellState *shell, struct expandVars *vars);
+int execUnsetFunction(const char *name);
+void execCatchInterrupts(void);
+
+#endif
@@ -0,0 +1,413 @@
+/*******************************************************************************
+*
+* File:     expand.c
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Variable expansion for kell-shell. The line is scanned once from left to
+*   right and written straight into the command arena: runs of plain text
+*   are copied with a single memcpy and each `$` is replaced as it is found,
+*   so there is no re-scanning and no heap allocation no matter how many
+*   variables a line contains. The output grows in place as needed, so an
+*   expanded line has no length limit.
+*
+*   Supported forms:
+*       $$          process id of the shell (formatted once at startup)
+*       $?          exit value of the last foreground command
+*       $!          process id of the last background job
+*       $NAME       value of shell variable NAME, empty if unset
+*       ${NAME}     same, for names followed by name characters
+*       $0 ... $9   the script or shell name and the positional parameters
+*                   of the running script or function, ${10} and on too
+*       $#          the number of positional parameters
+*       $@ $*       all of them, separated by spaces; the lexer makes them
+*                   one word each instead where it splits words
+*       $(command)  the output of command, less its trailing newlines
+*   Any other `$` is copied literally.
+*
+*   A command substitution is run through the substitute callback of the
+*   expandVars. While a line is only being read there is none and the
+*   substitution is empty; it runs once its command is about to.
+*
+*   Variables are looked up in the hashed store of vars.c straight from
+*   the name in the line, with no copy of the name.
+*
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "expand.h"
+#include "vars.h"
+
+static char pidString[16];
+static char *joinedArgs = NULL;     // storage for the last $@ or $*
+static size_t joinedSize = 0;
+static size_t pidLength = 0;
+
+/**
+*
+* void expandInit(pid_t shellPid)
+*
+* Summary:
+*       Formats the shell pid once for every later $$
+*
+* Parameters:   pid_t for the process id of the shell
+*
+* Returns:      nothing.
+*
+**/
+void expandInit(pid_t shellPid)
+{
+    pidLength = snprintf(pidString, sizeof(pidString), "%d", (int)shellPid);
+}
+
+/**
+*
+* static int isNameStart(char c)
+*
+* Summary:
+*       Checks if a character can start a variable name: [A-Za-z_]
+*
+* Parameters:   char to check
+*
+* Returns:      nonzero if it can
+*
+**/
+static int isNameStart(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+/**
+*
+* static int isNameChar(char c)
+*
+* Summary:
+*       Checks if a character can continue a variable name: [A-Za-z0-9_]
+*
+* Parameters:   char to check
+*
+* Returns:      nonzero if it can
+*
+**/
+static int isNameChar(char c)
+{
+    return isNameStart(c) || (c >= '0' && c <= '9');
+}
+
+/**
+*
+* static void expandArg(const struct expandVars *vars, int index,
+*                       struct expandValue *result)
+*
+* Summary:
+*       Looks up positional parameter index, $0 for 0
+*
+* Parameters:   pointer to the values for the parameters
+*               int for the parameter number
+*               pointer to the expandValue that receives the value
+*
+* Returns:      nothing. a parameter that is not set is empty
+*
+**/
+static void expandArg(const struct expandVars *vars, int index,
+        struct expandValue *result)
+{
+    const char *value = NULL;
+    if (index == 0) {
+        value = vars->name;
+    }
+    else if (index <= vars->numArgs) {
+        value = vars->args[index - 1];
+    }
+    result->value = value;
+    result->length = value ? strlen(value) : 0;
+}
+
+/**
+*
+* static void expandAllArgs(const struct expandVars *vars,
+*                           struct expandValue *result)
+*
+* Summary:
+*       Joins every positional parameter with spaces, for $@ and $*
+*
+* Parameters:   pointer to the values for the parameters
+*               pointer to the expandValue that receives the value
+*
+* Returns:      nothing.
+*
+* Description:
+*       The value lives in a buffer kept for the next call; every caller
+*       copies it out before expanding anything else.
+*
+**/
+static void expandAllArgs(const struct expandVars *vars, struct expandValue *result)
+{
+    size_t length = 0;
+    for (int i = 0; i < vars->numArgs; i++) {
+        length += strlen(vars->args[i]) + 1;
+    }
+    if (length > joinedSize) {
+        joinedSize = length * 2;
+        joinedArgs = realloc(joinedArgs, joinedSize);
+    }
+    char *out = joinedArgs;
+    for (int i = 0; i < vars->numArgs; i++) {
+        if (i > 0) {
+            *out++ = ' ';
+        }
+        out = stpcpy(out, vars->args[i]);
+    }
+    result->value = joinedArgs;
+    result->length = out - joinedArgs;
+}
+
+/**
+*
+* const char *expandCommandEnd(const char *p)
+*
+* Summary:
+*       Finds the `)` that closes a $( command substitution
+*
+* Parameters:   char* just past the $(
+*
+* Returns:      pointer to the closing `)`, or NULL if the line ends first
+*
+* Description:
+*       Parentheses nest; quoted text, escaped characters and backquoted
+*       commands are skipped, so a `)` in them does not count.
+*
+**/
+const char *expandCommandEnd(const char *p)
+{
+    int depth = 1;
+    for (; *p; p++) {
+        switch (*p) {
+            case '\\':
+                if (!p[1]) {
+                    return NULL;
+                }
+                p++;
+                break;
+            case '\'':
+            case '`':
+                for (char quote = *p++; *p != quote; p++) {
+                    if (!*p) {
+                        return NULL;
+                    }
+                    if (quote == '`' && *p == '\\' && p[1]) {
+                        p++;
+                    }
+                }
+                break;
+            case '"':
+                for (p++; *p != '"'; p++) {
+                    if (!*p) {
+                        return NULL;
+                    }
+                    if (*p == '\\' && p[1]) {
+                        p++;
+                    }
+                    else if (*p == '$' && p[1] == '(') {
+                        p = expandCommandEnd(p + 2);
+                        if (!p) {
+                            return NULL;
+                        }
+                    }
+                }
+                break;
+            case '(':
+                depth++;
+                break;
+            case ')':
+                if (--depth == 0) {
+                    return p;
+                }
+                break;
+        }
+    }
+    return NULL;
+}
+
+/**
+*
+* const char *expandVariable(const char *p, const struct expandVars *vars,
+*                            struct expandValue *result)
+*
+* Summary:
+*       Expands the single `$` form at the start of a string
+*
+* Parameters:   char* pointing at a `$`
+*               pointer to the values for $?, $! and the parameters
+*               pointer to the expandValue that receives the value
+*
+* Returns:      pointer just past the text that was consumed
+*
+* Description:
+*       A `$` that does not start a known form expands to itself, so the
+*       caller can always copy result->value and continue from the return
+*       value. Used by expandLine() and by the lexer, which expands words
+*       as it scans them.
+*
+**/
+const char *expandVariable(const char *p, const struct expandVars *vars,
+        struct expandValue *result)
+{
+    result->substituted = 0;
+    result->fields = 0;
+    if (p[1] == '(') {
+        const char *end = expandCommandEnd(p + 2);
+        if (end) {
+            result->substituted = 1;
+            result->value = NULL;
+            result->length = 0;
+            if (vars->substitute) {
+                result->value = vars->substitute(p + 2, end - (p + 2),
+                        &result->length, vars->context);
+            }
+            return end + 1;
+        }
+    }
+    if (p[1] == '$') {
+        result->value = pidString;
+        result->length = pidLength;
+        return p + 2;
+    }
+    if (p[1] == '?') {
+        result->length = snprintf(result->number, sizeof(result->number), "%d",
+                vars->lastStatus);
+        result->value = result->number;
+        return p + 2;
+    }
+    if (p[1] == '!') {
+        result->length = 0;
+        if (vars->lastBackground > 0) {
+            result->length = snprintf(result->number, sizeof(result->number), "%d",
+                    (int)vars->lastBackground);
+        }
+        result->value = result->number;
+        return p + 2;
+    }
+    if (p[1] >= '0' && p[1] <= '9') {
+        expandArg(vars, p[1] - '0', result);
+        return p + 2;
+    }
+    if (p[1] == '#') {
+        result->length = snprintf(result->number, sizeof(result->number), "%d",
+                vars->numArgs);
+        result->value = result->number;
+        return p + 2;
+    }
+    if (p[1] == '@' || p[1] == '*') {
+        expandAllArgs(vars, result);
+        result->fields = 1;
+        return p + 2;
+    }
+    if (isNameStart(p[1])) {
+        const char *name = p + 1;
+        const char *end = name;
+        while (isNameChar(*end)) {
+            end++;
+        }
+        result->value = varsLookup(name, end - name);
+        result->length = result->value ? strlen(result->value) : 0;
+        return end;
+    }
+    if (p[1] == '{' && isNameStart(p[2])) {
+        const char *name = p + 2;
+        const char *end = name;
+        while (isNameChar(*end)) {
+            end++;
+        }
+        if (*end == '}') {
+            result->value = varsLookup(name, end - name);
+            result->length = result->value ? strlen(result->value) : 0;
+            return end + 1;
+        }
+        // not a valid ${NAME}, keep the $ as text
+    }
+    if (p[1] == '{' && p[2] >= '0' && p[2] <= '9') {
+        const char *end = p + 2;
+        int index = 0;
+        while (*end >= '0' && *end <= '9' && index < 100000) {
+            index = index * 10 + (*end++ - '0');
+        }
+        if (*end == '}') {
+            expandArg(vars, index, result);
+            return end + 1;
+        }
+    }
+
+    // lone $ is just a character
+    result->value = p;
+    result->length = 1;
+    return p + 1;
+}
+
+/**
+*
+* char *expandLine(struct arena *arena, const char *src, size_t *length,
+*                  const struct expandVars *vars)
+*
+* Summary:
+*       Expands every variable in a line into arena memory
+*
+* Parameters:   pointer to the arena that owns the result
+*               char* for the line to expand
+*               pointer to size_t for the expanded length, may be NULL
+*               pointer to the values for $? and $!
+*
+* Returns:      the expanded, NUL terminated line
+*
+* Description:
+*       The output starts a little larger than the input and doubles when
+*       a value does not fit. It is the newest arena allocation while it is
+*       being written, so growing it rarely has to copy.
+*
+**/
+char *expandLine(struct arena *arena, const char *src, size_t *length,
+        const struct expandVars *vars)
+{
+    size_t n = 0;
+    size_t outSize = strlen(src) + 64;
+    char *out = arenaAlloc(arena, outSize);
+    const char *p = src;
+
+    while (*p) {
+        struct expandValue result;
+
+        if (*p != '$') {
+            // copy plain text up to the next $ in one go
+            result.value = p;
+            p = strchrnul(p, '$');
+            result.length = p - result.value;
+        }
+        else {
+            p = expandVariable(p, vars, &result);
+        }
+
+        if (n + result.length >= outSize) {
+            size_t newSize = outSize * 2;
+            while (n + result.length >= newSize) {
+                newSize *= 2;
+            }
+            out = arenaGrow(arena, out, n, newSize);
+            outSize = newSize;
+        }
+        if (result.length > 0) {
+            memcpy(out + n, result.value, result.length);
+            n += result.length;
+        }
+    }
+
+    out[n] = '\0';
+    if (length) {
+        *length = n;
+    }
+    return out;
+}
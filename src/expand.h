@@ -0,0 +1,51 @@
+/*******************************************************************************
+*
+* File:     expand.h
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Interface for kell-shell variable expansion: $$, $?, $!, $VAR,
+*   ${VAR}, the positional parameters and $(command).
+*
+******************************************************************************/
+#ifndef EXPAND_H
+#define EXPAND_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+struct arena;
+
+struct expandVars {
+    int lastStatus;         // exit value of the last foreground command
+    pid_t lastBackground;   // pid of the last background job, 0 if none
+    const char *name;       // $0, the shell or script name, may be NULL
+    char **args;            // $1 and on, the arguments of the running
+    int numArgs;            // script or function
+    // runs the command of a $(...) or `...` and returns its output, of
+    // *outputLength bytes; NULL while a line is read and nothing may run
+    // yet
+    const char *(*substitute)(const char *command, size_t length,
+            size_t *outputLength, void *context);
+    void *context;          // passed to substitute
+};
+
+struct expandValue {
+    const char *value;      // not NUL terminated, may point into number
+    size_t length;
+    char number[16];        // storage for $? and $!
+    _Bool substituted;      // the output of a $(...)
+    _Bool fields;           // $@ or $*: the parameters, which the lexer
+                            // may make one word each
+};
+
+void expandInit(pid_t shellPid);
+const char *expandCommandEnd(const char *p);
+const char *expandVariable(const char *p, const struct expandVars *vars,
+        struct expandValue *result);
+char *expandLine(struct arena *arena, const char *src, size_t *length,
+        const struct expandVars *vars);
+
+#endif
@@ -0,0 +1,41 @@
+/*******************************************************************************
+*
+* File:     fnv.h
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   FNV-1a string hash for kell-shell's hash tables: cached command paths,
+*   functions, variables and directory listings.
+*
+******************************************************************************/
+#ifndef FNV_H
+#define FNV_H
+
+#include <stddef.h>
+
+/**
+*
+* static inline unsigned fnvHash(const char *text, size_t length)
+*
+* Summary:
+*       FNV-1a hash of a string
+*
+* Parameters:   char* for the text, not NUL terminated
+*               size_t for its length
+*
+* Returns:      unsigned hash value
+*
+**/
+static inline unsigned fnvHash(const char *text, size_t length)
+{
+    unsigned hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= (unsigned char)text[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+#endif
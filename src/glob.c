@@ -0,0 +1,971 @@
+/*******************************************************************************
+*
+* File:     glob.c
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Pathname expansion for kell-shell. A pattern is split at `/` and each
+*   part compiled once: a part without wildcards is a plain name that is
+*   never looked up in its directory, `**` matches any number of
+*   directories, and any other part becomes a short list of literal runs,
+*   `?`, `[...]` sets (256-bit tables, with ranges, `!`/`^` and the POSIX
+*   `[:class:]` names worked out when compiled) and `*`. Matching walks
+*   that list with the classic backtrack-to-the-last-star loop, so no name
+*   costs more than its length times the pattern's, after checking the
+*   shortest length and the literal tail a name must have.
+*
+*   Directories are read with getdents64() into a 256 KB buffer, so even
+*   a directory of a hundred thousand entries takes a handful of system
+*   calls, and each listing is kept in a hash table by path for the rest
+*   of the command: `*.c *.h`, or `**` patterns that cover the same tree,
+*   read every directory once. Listings and matches live in the command
+*   arena, which drops them when the command is done.
+*
+*   Names starting with `.` only match a part that starts with a literal
+*   `.`, and `.` and `..` never match. `**` does not follow symbolic links.
+*   A pattern ending in `/` only matches directories. Matches are sorted
+*   byte by byte, with a multikey quicksort that starts past the prefix
+*   they all share. In a pattern, a backslash makes the next character
+*   literal; the lexer puts one in front of every quoted wildcard.
+*
+*   Matches are counted as exec() arguments as they are found, and the
+*   walk stops as soon as they would pass the limit given, so a pattern
+*   over a huge tree cannot build an argument list that could never run.
+*
+******************************************************************************/
+#include <ctype.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "arena.h"
+#include "fnv.h"
+#include "glob.h"
+
+#define GLOB_READ_SIZE (256 * 1024)     // getdents64() batch
+#define GLOB_MIN_CAPACITY 16            // cache slots
+#define GLOB_MIN_ENTRIES 64
+
+enum globOpType {
+    OP_LITERAL,     // a run of characters
+    OP_ANY,         // ?
+    OP_CLASS,       // [...]
+    OP_STAR         // *
+};
+
+struct globOp {
+    enum globOpType type;
+    const char *text;           // OP_LITERAL, unescaped
+    size_t length;
+    const unsigned char *set;   // OP_CLASS, one bit per byte value
+};
+
+enum globPartType {
+    PART_LITERAL,   // a plain name
+    PART_MATCH,     // a name with wildcards
+    PART_RECURSE    // **
+};
+
+struct globPart {
+    enum globPartType type;
+    const char *text;           // PART_LITERAL, unescaped
+    size_t length;
+    struct globOp *ops;         // PART_MATCH
+    int numOps;
+    size_t minLength;           // of a name that can match
+    const char *tail;           // literal a name must end with, or NULL
+    size_t tailLength;
+    _Bool dot;                  // starts with a literal `.`, may match
+                                // hidden names
+};
+
+struct globEntry {
+    const char *name;
+    size_t length;
+    unsigned char type;         // d_type, DT_UNKNOWN if not known
+};
+
+struct globDir {
+    const char *path;           // "" for the current directory
+    size_t pathLength;
+    unsigned hash;
+    struct globEntry *entries;  // without . and ..
+    int count;
+};
+
+struct globWalk {
+    struct globCache *cache;
+    struct globPart *parts;
+    int numParts;
+    _Bool dirsOnly;             // the pattern ended with `/`
+    _Bool descending;           // ** is going on into a directory it matched
+    char path[PATH_MAX];        // the path matched so far
+    size_t pathLength;
+    char **matches;
+    int numMatches;
+    int capacity;
+    size_t bytes;               // of the matches as exec() arguments
+    size_t limit;               // 0 for none
+    _Bool overflow;             // bytes went past limit
+};
+
+static union {
+    struct dirent64 entry;      // aligns the records
+    char bytes[GLOB_READ_SIZE];
+} readBuffer;
+
+static const struct {
+    const char *name;
+    int (*test)(int c);
+} posixClasses[] = {
+    { "alnum", isalnum }, { "alpha", isalpha }, { "blank", isblank },
+    { "cntrl", iscntrl }, { "digit", isdigit }, { "graph", isgraph },
+    { "lower", islower }, { "print", isprint }, { "punct", ispunct },
+    { "space", isspace }, { "upper", isupper }, { "xdigit", isxdigit }
+};
+
+/**
+*
+* static struct globDir *globRead(struct arena *arena, const char *path,
+*                                 size_t length)
+*
+* Summary:
+*       Lists a directory
+*
+* Parameters:   pointer to the arena the listing is allocated from
+*               char* for the NUL terminated path, "" for the current
+*                   directory
+*               size_t for its length
+*
+* Returns:      pointer to the listing, empty if the path is not a
+*               directory that can be read
+*
+* Description:
+*       Each getdents64() batch has its names copied into one block, which
+*       never needs more room than the records they came from.
+*
+**/
+static struct globDir *globRead(struct arena *arena, const char *path, size_t length)
+{
+    struct globDir *dir = arenaAlloc(arena, sizeof(struct globDir));
+    dir->path = arenaStrndup(arena, path, length);
+    dir->pathLength = length;
+    dir->entries = NULL;
+    dir->count = 0;
+
+    int fd = open(length ? path : ".", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd == -1) {
+        return dir;
+    }
+    int capacity = 0;
+    ssize_t n;
+    while ((n = getdents64(fd, readBuffer.bytes, GLOB_READ_SIZE)) > 0) {
+        char *names = arenaAlloc(arena, n);
+        size_t used = 0;
+        for (ssize_t offset = 0; offset < n; ) {
+            struct dirent64 *record = (struct dirent64 *)(readBuffer.bytes + offset);
+            offset += record->d_reclen;
+            const char *name = record->d_name;
+            if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+                continue;
+            }
+            if (dir->count == capacity) {
+                int newCapacity = capacity ? capacity * 2 : GLOB_MIN_ENTRIES;
+                dir->entries = arenaGrow(arena, dir->entries,
+                        capacity * sizeof(struct globEntry),
+                        newCapacity * sizeof(struct globEntry));
+                capacity = newCapacity;
+            }
+            size_t nameLength = strlen(name);
+            memcpy(names + used, name, nameLength + 1);
+            struct globEntry *entry = &dir->entries[dir->count++];
+            entry->name = names + used;
+            entry->length = nameLength;
+            entry->type = record->d_type;
+            used += nameLength + 1;
+        }
+    }
+    close(fd);
+    return dir;
+}
+
+/**
+*
+* static struct globDir *globList(struct globCache *cache, const char *path,
+*                                 size_t length)
+*
+* Summary:
+*       Gets the listing of a directory, reading it only the first time
+*
+* Parameters:   pointer to the cache
+*               char* for the NUL terminated path
+*               size_t for its length
+*
+* Returns:      pointer to the listing
+*
+**/
+static struct globDir *globList(struct globCache *cache, const char *path, size_t length)
+{
+    unsigned hash = fnvHash(path, length);
+    int mask = cache->capacity - 1;
+    if (cache->slots) {
+        for (int i = hash & mask; cache->slots[i]; i = (i + 1) & mask) {
+            struct globDir *dir = cache->slots[i];
+            if (dir->hash == hash && dir->pathLength == length
+                    && memcmp(dir->path, path, length) == 0) {
+                return dir;
+            }
+        }
+    }
+
+    if ((cache->numDirs + 1) * 10 > cache->capacity * 7) {
+        // keep the load under 70%
+        int capacity = cache->capacity ? cache->capacity * 2 : GLOB_MIN_CAPACITY;
+        struct globDir **slots = arenaAlloc(cache->arena, capacity * sizeof(struct globDir *));
+        memset(slots, 0, capacity * sizeof(struct globDir *));
+        mask = capacity - 1;
+        for (int i = 0; i < cache->capacity; i++) {
+            if (cache->slots[i]) {
+                int j = cache->slots[i]->hash & mask;
+                while (slots[j]) {
+                    j = (j + 1) & mask;
+                }
+                slots[j] = cache->slots[i];
+            }
+        }
+        cache->slots = slots;
+        cache->capacity = capacity;
+    }
+
+    struct globDir *dir = globRead(cache->arena, path, length);
+    dir->hash = hash;
+    int i = hash & mask;
+    while (cache->slots[i]) {
+        i = (i + 1) & mask;
+    }
+    cache->slots[i] = dir;
+    cache->numDirs++;
+    return dir;
+}
+
+/**
+*
+* static const char *globClass(struct arena *arena, const char *p,
+*                              const char *end, const unsigned char **set)
+*
+* Summary:
+*       Compiles a bracket expression into a table of the bytes it matches
+*
+* Parameters:   pointer to the arena the table is allocated from
+*               char* just past the `[`
+*               char* for the end of the pattern part
+*               pointer that receives the table
+*
+* Returns:      pointer just past the closing `]`, or NULL if there is
+*               none and the `[` is an ordinary character
+*
+**/
+static const char *globClass(struct arena *arena, const char *p, const char *end,
+        const unsigned char **set)
+{
+    unsigned char bits[32] = { 0 };
+    _Bool negate = 0;
+    if (p < end && (*p == '!' || *p == '^')) {
+        negate = 1;
+        p++;
+    }
+    const char *first = p;
+    while (p < end && (*p != ']' || p == first)) {
+        if (*p == '[' && p + 1 < end && p[1] == ':') {
+            const char *close = p + 2;
+            while (close + 1 < end && !(close[0] == ':' && close[1] == ']')) {
+                close++;
+            }
+            size_t length = close - (p + 2);
+            int found = -1;
+            for (size_t i = 0; close + 1 < end && i < sizeof(posixClasses) / sizeof(posixClasses[0]); i++) {
+                if (strlen(posixClasses[i].name) == length
+                        && memcmp(posixClasses[i].name, p + 2, length) == 0) {
+                    found = i;
+                }
+            }
+            if (found >= 0) {
+                for (int c = 0; c < 256; c++) {
+                    if (posixClasses[found].test(c)) {
+                        bits[c >> 3] |= 1 << (c & 7);
+                    }
+                }
+                p = close + 2;
+                continue;
+            }
+        }
+        if (*p == '\\' && p + 1 < end) {
+            p++;
+        }
+        unsigned char low = *p++;
+        unsigned char high = low;
+        if (p + 1 < end && *p == '-' && p[1] != ']') {
+            p++;
+            if (*p == '\\' && p + 1 < end) {
+                p++;
+            }
+            high = *p++;
+        }
+        for (int c = low; c <= high; c++) {
+            bits[c >> 3] |= 1 << (c & 7);
+        }
+    }
+    if (p == end) {
+        return NULL;
+    }
+
+    unsigned char *table = arenaAlloc(arena, sizeof(bits));
+    for (size_t i = 0; i < sizeof(bits); i++) {
+        table[i] = negate ? ~bits[i] : bits[i];
+    }
+    *set = table;
+    return p + 1;
+}
+
+/**
+*
+* static void globCompilePart(struct arena *arena, const char *p,
+*                             const char *end, struct globPart *part)
+*
+* Summary:
+*       Compiles one part of a pattern, between slashes
+*
+* Parameters:   pointer to the arena the part is allocated from
+*               char* for the start of the part
+*               char* for its end
+*               pointer to the part to fill in
+*
+* Returns:      nothing.
+*
+**/
+static void globCompilePart(struct arena *arena, const char *p, const char *end,
+        struct globPart *part)
+{
+    memset(part, 0, sizeof(struct globPart));
+    if (end - p == 2 && p[0] == '*' && p[1] == '*') {
+        part->type = PART_RECURSE;
+        return;
+    }
+
+    // literal runs are unescaped into one buffer the ops point into
+    char *text = arenaAlloc(arena, end - p + 1);
+    size_t textLength = 0;
+    struct globOp *ops = arenaAlloc(arena, (end - p) * sizeof(struct globOp));
+    int numOps = 0;
+    _Bool wild = 0;
+
+    while (p < end) {
+        struct globOp *op = &ops[numOps];
+        const unsigned char *set;
+        const char *next;
+        if (*p == '*') {
+            if (numOps == 0 || ops[numOps - 1].type != OP_STAR) {
+                op->type = OP_STAR;
+                numOps++;
+            }
+            wild = 1;
+            p++;
+            continue;
+        }
+        if (*p == '?') {
+            op->type = OP_ANY;
+            part->minLength++;
+            numOps++;
+            wild = 1;
+            p++;
+            continue;
+        }
+        if (*p == '[' && (next = globClass(arena, p + 1, end, &set))) {
+            op->type = OP_CLASS;
+            op->set = set;
+            part->minLength++;
+            numOps++;
+            wild = 1;
+            p = next;
+            continue;
+        }
+
+        if (*p == '\\' && p + 1 < end) {
+            p++;
+        }
+        if (numOps == 0 || ops[numOps - 1].type != OP_LITERAL) {
+            op->type = OP_LITERAL;
+            op->text = text + textLength;
+            op->length = 0;
+            numOps++;
+        }
+        text[textLength++] = *p++;
+        ops[numOps - 1].length++;
+        part->minLength++;
+    }
+    text[textLength] = '\0';
+
+    if (!wild) {
+        part->type = PART_LITERAL;
+        part->text = text;
+        part->length = textLength;
+        return;
+    }
+    part->type = PART_MATCH;
+    part->ops = ops;
+    part->numOps = numOps;
+    part->dot = (ops[0].type == OP_LITERAL && ops[0].text[0] == '.');
+    if (ops[numOps - 1].type == OP_LITERAL) {
+        part->tail = ops[numOps - 1].text;
+        part->tailLength = ops[numOps - 1].length;
+    }
+}
+
+/**
+*
+* static _Bool globCompile(struct arena *arena, const char *pattern,
+*                          size_t length, struct globWalk *walk)
+*
+* Summary:
+*       Splits a pattern at its slashes and compiles the parts
+*
+* Parameters:   pointer to the arena the parts are allocated from
+*               char* for the pattern
+*               size_t for its length
+*               pointer to the walk, which gets the parts and, for an
+*                   absolute pattern, the root as its starting path
+*
+* Returns:      true if some part has a wildcard, false if the pattern is
+*               only a name
+*
+**/
+static _Bool globCompile(struct arena *arena, const char *pattern, size_t length,
+        struct globWalk *walk)
+{
+    const char *p = pattern;
+    const char *end = pattern + length;
+    if (length >= PATH_MAX) {
+        return 0;
+    }
+    if (p < end && *p == '/') {
+        walk->path[walk->pathLength++] = '/';
+    }
+    walk->path[walk->pathLength] = '\0';
+    walk->dirsOnly = (length > 1 && end[-1] == '/');
+
+    int numParts = 1;
+    for (const char *c = p; c < end; c++) {
+        numParts += (*c == '/');
+    }
+    walk->parts = arenaAlloc(arena, numParts * sizeof(struct globPart));
+    walk->numParts = 0;
+    _Bool wild = 0;
+    while (p < end) {
+        const char *slash = memchr(p, '/', end - p);
+        if (!slash) {
+            slash = end;
+        }
+        if (slash > p) {
+            struct globPart *part = &walk->parts[walk->numParts++];
+            globCompilePart(arena, p, slash, part);
+            wild |= (part->type != PART_LITERAL);
+        }
+        p = slash + 1;
+    }
+    return wild;
+}
+
+/**
+*
+* static _Bool globMatch(const struct globPart *part, const char *name,
+*                        size_t length)
+*
+* Summary:
+*       Matches a name against a compiled part
+*
+* Parameters:   pointer to the part
+*               char* for the name
+*               size_t for its length
+*
+* Returns:      true if it matches
+*
+* Description:
+*       On a mismatch the last `*` takes one more character and matching
+*       goes on after it. Earlier stars never need to give anything back,
+*       since whatever follows the last one can still move right. A
+*       literal at the end can only match the end of the name, so it is
+*       compared first and the rest matched against what comes before it.
+*
+**/
+static _Bool globMatch(const struct globPart *part, const char *name, size_t length)
+{
+    if (length < part->minLength || (part->tail && memcmp(name + length - part->tailLength,
+            part->tail, part->tailLength) != 0)) {
+        return 0;
+    }
+    // the tail is matched already; what comes before it must match the rest
+    const struct globOp *ops = part->ops;
+    int numOps = part->numOps;
+    if (part->tail) {
+        numOps--;
+        length -= part->tailLength;
+    }
+    int op = 0;
+    size_t s = 0;
+    int starOp = -1;
+    size_t starS = 0;
+    while (op < numOps || s < length) {
+        if (op < numOps) {
+            const struct globOp *o = &ops[op];
+            unsigned char c = name[s];
+            switch (o->type) {
+                case OP_STAR:
+                    starOp = op++;
+                    starS = s;
+                    continue;
+                case OP_ANY:
+                    if (s < length) {
+                        op++;
+                        s++;
+                        continue;
+                    }
+                    break;
+                case OP_CLASS:
+                    if (s < length && (o->set[c >> 3] & (1 << (c & 7)))) {
+                        op++;
+                        s++;
+                        continue;
+                    }
+                    break;
+                case OP_LITERAL:
+                    if (length - s >= o->length && memcmp(name + s, o->text, o->length) == 0) {
+                        op++;
+                        s += o->length;
+                        continue;
+                    }
+                    break;
+            }
+        }
+        if (starOp >= 0 && starOp == numOps - 1) {
+            // a trailing star takes the rest of the name
+            return 1;
+        }
+        if (starOp >= 0 && starS < length) {
+            s = ++starS;
+            op = starOp + 1;
+            continue;
+        }
+        return 0;
+    }
+    return 1;
+}
+
+/**
+*
+* static _Bool globPush(struct globWalk *walk, const char *name, size_t length)
+*
+* Summary:
+*       Adds a name to the end of the path being walked
+*
+* Returns:      false if the path would be too long to use
+*
+**/
+static _Bool globPush(struct globWalk *walk, const char *name, size_t length)
+{
+    size_t slash = (walk->pathLength > 0 && walk->path[walk->pathLength - 1] != '/');
+    if (walk->pathLength + slash + length + 2 > PATH_MAX) {
+        return 0;
+    }
+    if (slash) {
+        walk->path[walk->pathLength++] = '/';
+    }
+    memcpy(walk->path + walk->pathLength, name, length);
+    walk->pathLength += length;
+    walk->path[walk->pathLength] = '\0';
+    return 1;
+}
+
+/**
+*
+* static void globPop(struct globWalk *walk, size_t length)
+*
+* Summary:
+*       Cuts the path being walked back to a length it had
+*
+**/
+static void globPop(struct globWalk *walk, size_t length)
+{
+    walk->pathLength = length;
+    walk->path[length] = '\0';
+}
+
+/**
+*
+* static _Bool globIsDir(const struct globWalk *walk, unsigned char type)
+*
+* Summary:
+*       Checks if the path being walked is a directory, not a link to one
+*
+* Parameters:   pointer to the walk
+*               unsigned char for the type of the path's last entry
+*
+* Returns:      true if it is a directory
+*
+**/
+static _Bool globIsDir(const struct globWalk *walk, unsigned char type)
+{
+    struct stat st;
+    if (type != DT_UNKNOWN) {
+        return type == DT_DIR;
+    }
+    return fstatat(AT_FDCWD, walk->path, &st, AT_SYMLINK_NOFOLLOW) == 0
+            && S_ISDIR(st.st_mode);
+}
+
+/**
+*
+* static void globAdd(struct globWalk *walk, unsigned char type, _Bool listed)
+*
+* Summary:
+*       Adds the path being walked to the matches
+*
+* Parameters:   pointer to the walk
+*               unsigned char for the type of the path's last entry
+*               bool for whether that entry came from a listing, so it
+*                   is known to exist
+*
+* Returns:      nothing. sets overflow instead if the matches would pass
+*               the limit
+*
+**/
+static void globAdd(struct globWalk *walk, unsigned char type, _Bool listed)
+{
+    if (!listed || (walk->dirsOnly && type != DT_DIR)) {
+        // a pattern that ends in `/` follows links to directories
+        struct stat st;
+        int flags = walk->dirsOnly ? 0 : AT_SYMLINK_NOFOLLOW;
+        if (fstatat(AT_FDCWD, walk->path, &st, flags) == -1
+                || (walk->dirsOnly && !S_ISDIR(st.st_mode))) {
+            return;
+        }
+    }
+
+    size_t length = walk->pathLength + walk->dirsOnly;
+    walk->bytes += length + 1 + sizeof(char *);
+    if (walk->limit && walk->bytes > walk->limit) {
+        walk->overflow = 1;
+        return;
+    }
+    struct arena *arena = walk->cache->arena;
+    if (walk->numMatches == walk->capacity) {
+        int capacity = walk->capacity ? walk->capacity * 2 : GLOB_MIN_ENTRIES;
+        walk->matches = arenaGrow(arena, walk->matches, walk->capacity * sizeof(char *),
+                capacity * sizeof(char *));
+        walk->capacity = capacity;
+    }
+    char *match = arenaAlloc(arena, length + 1);
+    memcpy(match, walk->path, walk->pathLength);
+    if (walk->dirsOnly) {
+        match[walk->pathLength] = '/';
+    }
+    match[length] = '\0';
+    walk->matches[walk->numMatches++] = match;
+}
+
+/**
+*
+* static void globAddBase(struct globWalk *walk, int index)
+*
+* Summary:
+*       Adds the directory a trailing ** starts from, as bash -O globstar
+*       does
+*
+* Parameters:   pointer to the walk
+*               int for the index of the ** part
+*
+* Returns:      nothing.
+*
+* Description:
+*       When only plain names lead to the directory it ends with a `/`,
+*       so `**` after `dir/` gives `dir/` first; after a wildcard it does not.
+*       The current directory, where `**` alone starts, is not added.
+*
+**/
+static void globAddBase(struct globWalk *walk, int index)
+{
+    size_t base = walk->pathLength;
+    struct stat st;
+    if (base == 0 || stat(walk->path, &st) == -1 || !S_ISDIR(st.st_mode)) {
+        return;
+    }
+
+    _Bool literal = 1;
+    for (int i = 0; i < index; i++) {
+        literal &= (walk->parts[i].type == PART_LITERAL);
+    }
+    _Bool dirsOnly = walk->dirsOnly;
+    if (literal && walk->path[base - 1] != '/') {
+        // globAdd() puts the `/` on the end, as for a pattern ending in one
+        walk->dirsOnly = 1;
+    }
+    globAdd(walk, DT_DIR, 1);
+    walk->dirsOnly = dirsOnly;
+}
+
+/**
+*
+* static void globStep(struct globWalk *walk, int index)
+*
+* Summary:
+*       Matches the parts of the pattern from one on, below the path
+*       walked so far
+*
+* Parameters:   pointer to the walk
+*               int for the index of the part to match
+*
+* Returns:      nothing. matches are added to the walk
+*
+**/
+static void globStep(struct globWalk *walk, int index)
+{
+    const struct globPart *part = &walk->parts[index];
+    _Bool last = (index + 1 == walk->numParts);
+    _Bool descending = walk->descending;
+    size_t base = walk->pathLength;
+
+    walk->descending = 0;
+
+    if (part->type == PART_LITERAL) {
+        // a plain name is not looked for; the final path is checked
+        if (globPush(walk, part->text, part->length)) {
+            if (last) {
+                globAdd(walk, DT_UNKNOWN, 0);
+            }
+            else {
+                globStep(walk, index + 1);
+            }
+            globPop(walk, base);
+        }
+        return;
+    }
+
+    if (part->type == PART_RECURSE && !last) {
+        // ** matching no directory at all
+        globStep(walk, index + 1);
+    }
+    else if (part->type == PART_RECURSE && !descending) {
+        globAddBase(walk, index);
+    }
+    const struct globDir *dir = globList(walk->cache, walk->path, walk->pathLength);
+    for (int i = 0; i < dir->count && !walk->overflow; i++) {
+        const struct globEntry *entry = &dir->entries[i];
+        if (entry->name[0] == '.' && !part->dot) {
+            continue;
+        }
+        if (part->type == PART_MATCH) {
+            if (!globMatch(part, entry->name, entry->length)
+                    || (!last && entry->type != DT_DIR && entry->type != DT_LNK
+                    && entry->type != DT_UNKNOWN)) {
+                continue;
+            }
+            if (globPush(walk, entry->name, entry->length)) {
+                if (last) {
+                    globAdd(walk, entry->type, 1);
+                }
+                else {
+                    globStep(walk, index + 1);
+                }
+            }
+        }
+        else if (globPush(walk, entry->name, entry->length)) {
+            if (last) {
+                globAdd(walk, entry->type, 1);
+            }
+            if (globIsDir(walk, entry->type)) {
+                walk->descending = 1;
+                globStep(walk, index);
+            }
+        }
+        globPop(walk, base);
+    }
+}
+
+/**
+*
+* static void globSort(char **matches, int count, size_t depth)
+*
+* Summary:
+*       Sorts matches that agree on their first depth bytes
+*
+* Parameters:   char** for the matches
+*               int for how many
+*               size_t for the number of leading bytes they share
+*
+* Returns:      nothing.
+*
+* Description:
+*       Multikey quicksort: the matches are split three ways on their byte
+*       at depth, and only those equal to the pivot go on to the next
+*       byte, so no comparison goes over bytes already known to be equal,
+*       as every strcmp() of a comparison sort would. Short runs use
+*       insertion sort.
+*
+**/
+static void globSort(char **matches, int count, size_t depth)
+{
+    while (count > 1) {
+        if (count < 16) {
+            for (int i = 1; i < count; i++) {
+                char *match = matches[i];
+                int j = i;
+                while (j > 0 && strcmp(matches[j - 1] + depth, match + depth) > 0) {
+                    matches[j] = matches[j - 1];
+                    j--;
+                }
+                matches[j] = match;
+            }
+            return;
+        }
+
+        char *swap = matches[0];
+        matches[0] = matches[count / 2];
+        matches[count / 2] = swap;
+        unsigned char pivot = matches[0][depth];
+        int less = 0, i = 1, more = count - 1;
+        while (i <= more) {
+            unsigned char c = matches[i][depth];
+            if (c < pivot) {
+                swap = matches[less];
+                matches[less++] = matches[i];
+                matches[i++] = swap;
+            }
+            else if (c > pivot) {
+                swap = matches[more];
+                matches[more--] = matches[i];
+                matches[i] = swap;
+            }
+            else {
+                i++;
+            }
+        }
+        globSort(matches, less, depth);
+        globSort(matches + more + 1, count - more - 1, depth);
+        if (pivot == '\0') {
+            // the equal ones are the same string
+            return;
+        }
+        matches += less;
+        count = more + 1 - less;
+        depth++;
+    }
+}
+
+/**
+*
+* int globExpand(const char *pattern, size_t length, struct globCache *cache,
+*                size_t limit, char ***matches)
+*
+* Summary:
+*       Finds the paths a pattern matches
+*
+* Parameters:   char* for the pattern, with quoted characters escaped
+*               size_t for its length
+*               pointer to the cache of directory listings, whose arena
+*                   the matches are allocated from
+*               size_t for the most bytes the matches may take as exec()
+*                   arguments, strings and pointers, or 0 for no limit
+*               pointer that receives the sorted array of matches
+*
+* Returns:      the number of matches, 0 if there are none or the pattern
+*               has no wildcard, or -1 if they would pass the limit
+*
+**/
+int globExpand(const char *pattern, size_t length, struct globCache *cache,
+        size_t limit, char ***matches)
+{
+    struct globWalk walk = { .cache = cache, .limit = limit };
+    if (!globCompile(cache->arena, pattern, length, &walk)) {
+        return 0;
+    }
+    globStep(&walk, 0);
+    if (walk.overflow) {
+        return -1;
+    }
+
+    // sorting starts after whatever every match begins with, such as
+    // their directory
+    size_t prefix = 0;
+    if (walk.numMatches > 1) {
+        const char *first = walk.matches[0];
+        prefix = strlen(first);
+        for (int i = 1; i < walk.numMatches && prefix > 0; i++) {
+            size_t same = 0;
+            while (same < prefix && walk.matches[i][same] == first[same]) {
+                same++;
+            }
+            prefix = same;
+        }
+    }
+    globSort(walk.matches, walk.numMatches, prefix);
+    *matches = walk.matches;
+    return walk.numMatches;
+}
+
+/**
+*
+* char *globUnescape(struct arena *arena, const char *pattern, size_t length,
+*                    size_t *outLength)
+*
+* Summary:
+*       Gives a pattern that matched nothing as the word it was written as
+*
+* Parameters:   pointer to the arena a copy is allocated from
+*               char* for the NUL terminated pattern
+*               size_t for its length
+*               pointer to the size_t that receives the new length
+*
+* Returns:      the pattern without its escaping backslashes; the pattern
+*               itself if it has none
+*
+**/
+char *globUnescape(struct arena *arena, const char *pattern, size_t length,
+        size_t *outLength)
+{
+    *outLength = length;
+    if (!memchr(pattern, '\\', length)) {
+        return (char *)pattern;
+    }
+    char *text = arenaAlloc(arena, length + 1);
+    size_t n = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (pattern[i] == '\\' && i + 1 < length) {
+            i++;
+        }
+        text[n++] = pattern[i];
+    }
+    text[n] = '\0';
+    *outLength = n;
+    return text;
+}
+
+/**
+*
+* void globCacheClear(struct globCache *cache)
+*
+* Summary:
+*       Forgets every listing, after something ran that may have changed
+*       the directories
+*
+**/
+void globCacheClear(struct globCache *cache)
+{
+    cache->slots = NULL;
+    cache->numDirs = 0;
+    cache->capacity = 0;
+}
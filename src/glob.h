@@ -0,0 +1,37 @@
+/*******************************************************************************
+*
+* File:     glob.h
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Interface for kell-shell pathname expansion: `*`, `?`, `[...]` and a
+*   `**` that spans directories, matched against directory listings that
+*   are kept for the rest of the command.
+*
+******************************************************************************/
+#ifndef GLOB_H
+#define GLOB_H
+
+#include <stddef.h>
+
+struct arena;
+struct globDir;
+
+// directories listed while expanding one command, kept in its arena;
+// zero it with the arena set to start empty
+struct globCache {
+    struct arena *arena;
+    struct globDir **slots;     // open addressing by path
+    int numDirs;
+    int capacity;
+};
+
+int globExpand(const char *pattern, size_t length, struct globCache *cache,
+        size_t limit, char ***matches);
+char *globUnescape(struct arena *arena, const char *pattern, size_t length,
+        size_t *outLength);
+void globCacheClear(struct globCache *cache);
+
+#endif
@@ -0,0 +1,488 @@
+/*******************************************************************************
+*
+* File:     hash.c
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Command hash for kell-shell. execvp walks every $PATH directory and
+*   makes a failed execve for each miss on every command. Instead, the first
+*   time a command is run its absolute path is resolved once and stored in
+*   an open-addressing hash table (linear probing, power of two capacity),
+*   and later runs exec the stored path directly.
+*
+*   The table remembers the value of PATH it was filled against and is
+*   cleared when PATH changes. Entries are dropped when exec reports the
+*   stored path no longer works (see hashRemove()).
+*
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "fnv.h"
+#include "hash.h"
+#include "spawn.h"
+#include "vars.h"       // varsGet()
+
+#define HASH_MIN_CAPACITY 64
+#define HASH_DEFAULT_PATH "/bin:/usr/bin"   // what execvp uses without PATH
+
+struct hashEntry {
+    char *name;         // NULL for an empty slot, deletedName once removed
+    char *path;
+    unsigned hash;
+    unsigned hits;
+};
+
+static struct hashEntry *table = NULL;
+static size_t capacity = 0;
+static size_t used = 0;         // live entries plus deleted slots
+static size_t count = 0;        // live entries
+static char *cachedPath = NULL; // value of PATH the table was filled against
+static char *uncached = NULL;   // last result kept out of the table
+
+static char deletedName[] = "";
+
+/**
+*
+* static struct hashEntry *hashFind(const char *name, unsigned hash)
+*
+* Summary:
+*       Locates the live entry for a command name
+*
+* Parameters:   char* for the command name
+*               unsigned for the hash of the name
+*
+* Returns:      pointer to the entry, or NULL if not present
+*
+**/
+static struct hashEntry *hashFind(const char *name, unsigned hash)
+{
+    if (!table) {
+        return NULL;
+    }
+    size_t mask = capacity - 1;
+    for (size_t i = hash & mask; table[i].name; i = (i + 1) & mask) {
+        if (table[i].name != deletedName && table[i].hash == hash
+                && strcmp(table[i].name, name) == 0) {
+            return &table[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+*
+* static void hashGrow(void)
+*
+* Summary:
+*       Doubles the table and rehashes live entries, dropping deleted slots
+*
+* Parameters:   none
+*
+* Returns:      nothing. table is replaced
+*
+**/
+static void hashGrow(void)
+{
+    size_t newCapacity = capacity ? capacity * 2 : HASH_MIN_CAPACITY;
+    struct hashEntry *newTable = calloc(newCapacity, sizeof(struct hashEntry));
+    size_t mask = newCapacity - 1;
+
+    for (size_t i = 0; i < capacity; i++) {
+        if (table[i].name && table[i].name != deletedName) {
+            size_t j = table[i].hash & mask;
+            while (newTable[j].name) {
+                j = (j + 1) & mask;
+            }
+            newTable[j] = table[i];
+        }
+    }
+
+    free(table);
+    table = newTable;
+    capacity = newCapacity;
+    used = count;
+}
+
+/**
+*
+* static void hashCheckPath(void)
+*
+* Summary:
+*       Clears the table if PATH has changed since it was filled
+*
+* Parameters:   none
+*
+* Returns:      nothing.
+*
+**/
+static void hashCheckPath(void)
+{
+    const char *path = varsGet("PATH");
+    if (!path) {
+        path = HASH_DEFAULT_PATH;
+    }
+    if (cachedPath && strcmp(cachedPath, path) == 0) {
+        return;
+    }
+
+    hashClear();
+    free(cachedPath);
+    cachedPath = strdup(path);
+}
+
+/**
+*
+* static char *hashResolve(const char *name, const char *search)
+*
+* Summary:
+*       Walks a PATH value to find an executable regular file for a
+*       command name
+*
+* Parameters:   char* for the command name
+*               char* for the colon separated directories to search
+*
+* Returns:      malloc'd path of the command, or NULL if not found
+*
+* Description:
+*       An empty PATH component means the current directory, as with execvp.
+*
+**/
+static char *hashResolve(const char *name, const char *search)
+{
+    size_t nameLen = strlen(name);
+    char *candidate = malloc(strlen(search) + nameLen + 3);
+    const char *dir = search;
+
+    while (1) {
+        const char *end = strchrnul(dir, ':');
+        size_t dirLen = end - dir;
+
+        if (dirLen == 0) {
+            candidate[0] = '.';
+            dirLen = 1;
+        }
+        else {
+            memcpy(candidate, dir, dirLen);
+        }
+        candidate[dirLen] = '/';
+        memcpy(candidate + dirLen + 1, name, nameLen + 1);
+
+        struct stat info;
+        if (stat(candidate, &info) == 0 && S_ISREG(info.st_mode)
+                && access(candidate, X_OK) == 0) {
+            return candidate;
+        }
+
+        if (*end == '\0') {
+            break;
+        }
+        dir = end + 1;
+    }
+
+    free(candidate);
+    return NULL;
+}
+
+/**
+*
+* static struct hashEntry *hashInsert(const char *name, unsigned hash,
+*                                     char *path)
+*
+* Summary:
+*       Stores a resolved path for a command name
+*
+* Parameters:   char* for the command name
+*               unsigned for the hash of the name
+*               char* for the malloc'd path, owned by the table afterwards
+*
+* Returns:      pointer to the new entry
+*
+**/
+static struct hashEntry *hashInsert(const char *name, unsigned hash, char *path)
+{
+    // keep load (including deleted slots) under 70%
+    if ((used + 1) * 10 > capacity * 7) {
+        hashGrow();
+    }
+
+    size_t mask = capacity - 1;
+    size_t i = hash & mask;
+    while (table[i].name && table[i].name != deletedName) {
+        i = (i + 1) & mask;
+    }
+    if (!table[i].name) {
+        used++;
+    }
+
+    table[i].name = strdup(name);
+    table[i].path = path;
+    table[i].hash = hash;
+    table[i].hits = 0;
+    count++;
+    return &table[i];
+}
+
+/**
+*
+* const char *hashLookup(const char *name)
+*
+* Summary:
+*       Resolves a command name to the path that should be exec'd
+*
+* Parameters:   char* for the command name
+*
+* Returns:      the path to exec, or NULL if the command was not found
+*
+* Description:
+*       Names containing a slash are returned unchanged. Results found
+*       through a relative PATH entry are not stored since they depend on
+*       the current directory. The returned string is owned by the table
+*       and stays valid until the next call into this module.
+*
+**/
+const char *hashLookup(const char *name)
+{
+    if (strchr(name, '/')) {
+        return name;
+    }
+
+    hashCheckPath();
+    unsigned hash = fnvHash(name, strlen(name));
+    struct hashEntry *entry = hashFind(name, hash);
+
+    if (!entry) {
+        char *path = hashResolve(name, cachedPath);
+        if (!path) {
+            return NULL;
+        }
+        if (path[0] != '/') {
+            free(uncached);
+            uncached = path;
+            return path;
+        }
+        entry = hashInsert(name, hash, path);
+    }
+
+    entry->hits++;
+    return entry->path;
+}
+
+/**
+*
+* pid_t hashSpawn(struct spawnRequest *request, const char *search,
+*                 enum spawnFailure *failure)
+*
+* Summary:
+*       Resolves a command through the command hash and spawns it
+*
+* Parameters:   pointer to the spawn request, path is filled in
+*               char* for a PATH of the command's own, NULL for the shell's
+*               pointer to enum spawnFailure set on error
+*
+* Returns:      child pid, or -1 on failure
+*
+* Description:
+*       Commands missing from PATH fail without creating a process. If a
+*       remembered path no longer exists (ENOENT, ENOTDIR) or has lost its
+*       execute permission (EACCES), the entry is forgotten and PATH is
+*       searched once more before giving up. Other failures say nothing
+*       about the path; scripts without `#!` never fail, the spawn engine
+*       runs them with /bin/sh.
+*
+*       A command run with a PATH assignment in front of it is searched
+*       for in that PATH, and the table is neither used nor filled.
+*
+**/
+pid_t hashSpawn(struct spawnRequest *request, const char *search,
+        enum spawnFailure *failure)
+{
+    char *name = request->argv[0];
+
+    if (search && !strchr(name, '/')) {
+        free(uncached);
+        uncached = hashResolve(name, search);
+        request->path = uncached;
+        if (!request->path) {
+            *failure = SPAWN_FAIL_EXEC;
+            errno = ENOENT;
+            return -1;
+        }
+        return spawnCommand(request, failure);
+    }
+
+    request->path = hashLookup(name);
+    if (!request->path) {
+        *failure = SPAWN_FAIL_EXEC;
+        errno = ENOENT;
+        return -1;
+    }
+
+    pid_t spawnPid = spawnCommand(request, failure);
+
+    if (spawnPid == -1 && *failure == SPAWN_FAIL_EXEC && request->path != name
+            && (errno == ENOENT || errno == ENOTDIR || errno == EACCES)) {
+        // stale entry: search PATH again
+        hashRemove(name);
+        request->path = hashLookup(name);
+        if (!request->path) {
+            errno = ENOENT;
+            return -1;
+        }
+        spawnPid = spawnCommand(request, failure);
+    }
+    return spawnPid;
+}
+
+/**
+*
+* int hashAdd(const char *name)
+*
+* Summary:
+*       Resolves a command and stores it without counting a hit
+*
+* Parameters:   char* for the command name
+*
+* Returns:      0 on success, -1 if the command was not found
+*
+**/
+int hashAdd(const char *name)
+{
+    if (strchr(name, '/')) {
+        return 0;
+    }
+
+    hashCheckPath();
+    unsigned hash = fnvHash(name, strlen(name));
+    struct hashEntry *entry = hashFind(name, hash);
+    char *path = hashResolve(name, cachedPath);
+
+    if (!path) {
+        if (entry) {
+            hashRemove(name);
+        }
+        return -1;
+    }
+
+    if (entry) {
+        // refresh an existing entry in place
+        free(entry->path);
+        entry->path = path;
+        entry->hits = 0;
+    }
+    else if (path[0] == '/') {
+        hashInsert(name, hash, path);
+    }
+    else {
+        free(path);
+    }
+    return 0;
+}
+
+/**
+*
+* void hashRemove(const char *name)
+*
+* Summary:
+*       Forgets the stored path for a command, if any
+*
+* Parameters:   char* for the command name
+*
+* Returns:      nothing.
+*
+**/
+void hashRemove(const char *name)
+{
+    struct hashEntry *entry = hashFind(name, fnvHash(name, strlen(name)));
+    if (entry) {
+        free(entry->name);
+        free(entry->path);
+        entry->name = deletedName;
+        entry->path = NULL;
+        count--;
+    }
+}
+
+/**
+*
+* void hashClear(void)
+*
+* Summary:
+*       Removes every stored command
+*
+* Parameters:   none
+*
+* Returns:      nothing.
+*
+**/
+void hashClear(void)
+{
+    for (size_t i = 0; i < capacity; i++) {
+        if (table[i].name && table[i].name != deletedName) {
+            free(table[i].name);
+            free(table[i].path);
+        }
+        table[i].name = NULL;
+        table[i].path = NULL;
+    }
+    used = 0;
+    count = 0;
+}
+
+/**
+*
+* void hashPrint(void)
+*
+* Summary:
+*       Prints the stored commands with their hit counts, like bash `hash`
+*
+* Parameters:   none
+*
+* Returns:      nothing. prints table
+*
+**/
+void hashPrint(void)
+{
+    if (count == 0) {
+        printf("hash: hash table empty\n");
+    }
+    else {
+        printf("hits\tcommand\n");
+        for (size_t i = 0; i < capacity; i++) {
+            if (table[i].name && table[i].name != deletedName) {
+                printf("%4u\t%s\n", table[i].hits, table[i].path);
+            }
+        }
+    }
+    fflush(stdout);
+}
+
+/**
+*
+* void hashFree(void)
+*
+* Summary:
+*       Frees all memory held by the command hash
+*
+* Parameters:   none
+*
+* Returns:      nothing.
+*
+**/
+void hashFree(void)
+{
+    hashClear();
+    free(table);
+    free(cachedPath);
+    free(uncached);
+    table = NULL;
+    cachedPath = NULL;
+    uncached = NULL;
+    capacity = 0;
+}
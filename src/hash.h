@@ -0,0 +1,29 @@
+/*******************************************************************************
+*
+* File:     hash.h
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Interface for the kell-shell command hash, a cache of command names
+*   resolved to absolute paths through $PATH.
+*
+******************************************************************************/
+#ifndef HASH_H
+#define HASH_H
+
+#include <sys/types.h>
+
+#include "spawn.h"
+
+const char *hashLookup(const char *name);
+pid_t hashSpawn(struct spawnRequest *request, const char *search,
+        enum spawnFailure *failure);
+int hashAdd(const char *name);
+void hashRemove(const char *name);
+void hashClear(void);
+void hashPrint(void);
+void hashFree(void);
+
+#endif
@@ -0,0 +1,515 @@
+/*******************************************************************************
+*
+* File:     history.c
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Command history for kell-shell.
+*
+*   History lives in an append-only file, ~/.kell_history or KELL_HISTFILE,
+*   one entry per line. Each new entry is appended with a single write()
+*   on a descriptor opened with O_APPEND, so any number of shells can share
+*   one file without their lines interleaving.
+*
+*   At startup the file is only mmap'd. Nothing is parsed until history is
+*   first used; then one memchr() pass records where every entry starts,
+*   and that offset index serves lookups by number, newest-first prefix
+*   search (one memcmp per entry) and substring search (memmem over blocks
+*   of entries, mapping a hit back to its entry by binary search). Lines
+*   entered during the session are kept in memory after the mapped ones.
+*
+*   Lines are expanded before they are lexed:
+*
+*       !!          the previous entry
+*       !n  !-n     entry n, or the n-th entry back
+*       !prefix     the newest entry that starts with prefix
+*
+*   A `!` inside single quotes, after a backslash or `$`, or followed by a
+*   blank, `=` or `(` is left alone.
+*
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#include "arena.h"
+#include "history.h"
+
+#define HISTORY_SEARCH_BLOCK 4096   // entries searched per memmem() sweep
+
+struct historyEntry {
+    char *text;
+    size_t length;
+};
+
+static int historyFd = -1;
+
+static const char *map = NULL;      // the file as it was at startup
+static size_t mapLength = 0;
+static size_t *offsets = NULL;      // start of each mapped entry
+static size_t numMapped = 0;
+static _Bool indexed = 0;
+
+static struct historyEntry *session = NULL;    // entries added since startup
+static size_t numSession = 0;
+static size_t sessionCapacity = 0;
+
+/**
+*
+* int historyOpen(const char *path)
+*
+* Summary:
+*       Opens the history file for appending and maps what it holds
+*
+* Parameters:   char* for the path of the history file
+*
+* Returns:      0 on success, -1 with errno set if the file cannot be opened
+*
+**/
+int historyOpen(const char *path)
+{
+    int fd = open(path, O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0600);
+    if (fd == -1) {
+        return -1;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) == 0 && info.st_size > 0) {
+        void *data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            map = data;
+            mapLength = info.st_size;
+        }
+    }
+    historyFd = fd;
+    return 0;
+}
+
+/**
+*
+* _Bool historyEnabled(void)
+*
+* Summary:
+*       Tells whether a history file is open
+*
+**/
+_Bool historyEnabled(void)
+{
+    return historyFd != -1;
+}
+
+/**
+*
+* static void historyIndex(void)
+*
+* Summary:
+*       Builds the offset index of the mapped entries, once
+*
+* Description:
+*       A last line without a newline, such as one cut short by a crash,
+*       still counts as an entry.
+*
+**/
+static void historyIndex(void)
+{
+    if (indexed) {
+        return;
+    }
+    indexed = 1;
+
+    size_t capacity = 0;
+    size_t position = 0;
+    while (position < mapLength) {
+        if (numMapped == capacity) {
+            capacity = capacity ? capacity * 2 : 1024;
+            offsets = realloc(offsets, capacity * sizeof(size_t));
+        }
+        offsets[numMapped++] = position;
+
+        const char *newline = memchr(map + position, '\n', mapLength - position);
+        position = newline ? (size_t)(newline - map) + 1 : mapLength;
+    }
+}
+
+/**
+*
+* static size_t mappedEnd(size_t index)
+*
+* Summary:
+*       Offset just past the text of a mapped entry, before its newline
+*
+* Parameters:   size_t for the 0-based index of the entry
+*
+* Returns:      offset into the mapping
+*
+**/
+static size_t mappedEnd(size_t index)
+{
+    size_t end = (index + 1 < numMapped) ? offsets[index + 1] : mapLength;
+    if (end > offsets[index] && map[end - 1] == '\n') {
+        end--;
+    }
+    return end;
+}
+
+/**
+*
+* void historyAdd(const char *line, size_t length)
+*
+* Summary:
+*       Adds a line to the history and appends it to the history file
+*
+* Parameters:   char* for the line, without its newline
+*               size_t for the length of the line
+*
+* Returns:      nothing.
+*
+**/
+void historyAdd(const char *line, size_t length)
+{
+    if (historyFd == -1 || length == 0) {
+        return;
+    }
+
+    // line and newline in one write so concurrent shells never interleave
+    struct iovec parts[2] = {
+        { (void *)line, length },
+        { "\n", 1 }
+    };
+    if (writev(historyFd, parts, 2) != (ssize_t)length + 1) {
+        // a full disk should not stop the shell, keep it in memory only
+    }
+
+    if (numSession == sessionCapacity) {
+        sessionCapacity = sessionCapacity ? sessionCapacity * 2 : 64;
+        session = realloc(session, sessionCapacity * sizeof(struct historyEntry));
+    }
+    session[numSession].text = strndup(line, length);
+    session[numSession].length = length;
+    numSession++;
+}
+
+/**
+*
+* size_t historyCount(void)
+*
+* Summary:
+*       Number of history entries, which is also the newest entry's number
+*
+**/
+size_t historyCount(void)
+{
+    historyIndex();
+    return numMapped + numSession;
+}
+
+/**
+*
+* const char *historyGet(size_t number, size_t *length)
+*
+* Summary:
+*       Looks up a history entry by number
+*
+* Parameters:   size_t for the entry number, 1 for the oldest
+*               pointer to size_t for the length of the entry
+*
+* Returns:      pointer to the entry, which is not NUL terminated, or NULL
+*               if there is no such entry
+*
+**/
+const char *historyGet(size_t number, size_t *length)
+{
+    historyIndex();
+    if (number < 1 || number > numMapped + numSession) {
+        return NULL;
+    }
+    if (number > numMapped) {
+        struct historyEntry *entry = &session[number - numMapped - 1];
+        *length = entry->length;
+        return entry->text;
+    }
+    size_t index = number - 1;
+    *length = mappedEnd(index) - offsets[index];
+    return map + offsets[index];
+}
+
+/**
+*
+* size_t historyFindPrefix(const char *prefix, size_t length, size_t before)
+*
+* Summary:
+*       Finds the newest entry older than `before` that starts with prefix
+*
+* Parameters:   char* for the prefix
+*               size_t for the length of the prefix
+*               size_t for the entry number to search below, or
+*               historyCount() + 1 to search everything
+*
+* Returns:      the entry number, or 0 if no entry matches
+*
+**/
+size_t historyFindPrefix(const char *prefix, size_t length, size_t before)
+{
+    size_t count = historyCount();
+    if (before > count + 1) {
+        before = count + 1;
+    }
+    if (before == 0) {
+        return 0;
+    }
+    for (size_t number = before - 1; number >= 1; number--) {
+        size_t entryLength;
+        const char *entry = historyGet(number, &entryLength);
+        if (entryLength >= length && memcmp(entry, prefix, length) == 0) {
+            return number;
+        }
+    }
+    return 0;
+}
+
+/**
+*
+* size_t historyFindSubstring(const char *text, size_t length,
+*                             size_t before)
+*
+* Summary:
+*       Finds the newest entry older than `before` that contains text
+*
+* Parameters:   char* for the text, which holds no newline
+*               size_t for the length of the text
+*               size_t for the entry number to search below, or
+*               historyCount() + 1 to search everything
+*
+* Returns:      the entry number, or 0 if no entry matches
+*
+* Description:
+*       Mapped entries are searched a block at a time: one memmem() sweep
+*       over the block's bytes finds its last hit, which cannot span two
+*       entries because the text has no newline, and a binary search over
+*       the offsets turns the hit into an entry number.
+*
+**/
+size_t historyFindSubstring(const char *text, size_t length, size_t before)
+{
+    size_t count = historyCount();
+    if (before > count + 1) {
+        before = count + 1;
+    }
+    if (before == 0) {
+        return 0;
+    }
+    size_t number = before - 1;
+    if (length == 0) {
+        return number;
+    }
+
+    for (; number > numMapped; number--) {
+        struct historyEntry *entry = &session[number - numMapped - 1];
+        if (memmem(entry->text, entry->length, text, length)) {
+            return number;
+        }
+    }
+
+    while (number >= 1) {
+        size_t first = (number > HISTORY_SEARCH_BLOCK) ? number - HISTORY_SEARCH_BLOCK + 1 : 1;
+        const char *start = map + offsets[first - 1];
+        const char *end = map + mappedEnd(number - 1);
+        const char *hit = NULL;
+
+        for (const char *p = start; p < end; p++) {
+            p = memmem(p, end - p, text, length);
+            if (!p) {
+                break;
+            }
+            hit = p;
+        }
+        if (hit) {
+            size_t low = first - 1;
+            size_t high = number - 1;
+            size_t position = hit - map;
+            while (low < high) {
+                size_t middle = (low + high + 1) / 2;
+                if (offsets[middle] <= position) {
+                    low = middle;
+                }
+                else {
+                    high = middle - 1;
+                }
+            }
+            return low + 1;
+        }
+        number = first - 1;
+    }
+    return 0;
+}
+
+/**
+*
+* static size_t historyEvent(const char *p, const char *end, size_t *number)
+*
+* Summary:
+*       Resolves the event after a `!`
+*
+* Parameters:   char* for the character after the `!`
+*               char* for the end of the line
+*               pointer to size_t that receives the entry number, 0 if the
+*               event names no entry
+*
+* Returns:      number of characters that make up the event
+*
+**/
+static size_t historyEvent(const char *p, const char *end, size_t *number)
+{
+    size_t count = historyCount();
+
+    if (*p == '!') {
+        *number = count;
+        return 1;
+    }
+    if (isdigit((unsigned char)*p) || (*p == '-' && p + 1 < end
+                && isdigit((unsigned char)p[1]))) {
+        const char *digits = (*p == '-') ? p + 1 : p;
+        const char *q = digits;
+        size_t n = 0;
+        while (q < end && isdigit((unsigned char)*q)) {
+            n = n * 10 + (*q - '0');
+            q++;
+        }
+        if (*p == '-') {
+            n = (n >= 1 && n <= count) ? count + 1 - n : 0;
+        }
+        *number = (n <= count) ? n : 0;
+        return q - p;
+    }
+
+    // !prefix runs to the end of the word
+    size_t length = strcspn(p, " \t;&|<>()'\"`");
+    if (p + length > end) {
+        length = end - p;
+    }
+    *number = historyFindPrefix(p, length, count + 1);
+    return length;
+}
+
+/**
+*
+* int historyExpand(struct arena *arena, char **line, size_t *length)
+*
+* Summary:
+*       Expands history references in a line
+*
+* Parameters:   pointer to the arena the expanded line is allocated from
+*               pointer to char* for the NUL-terminated line, replaced by
+*               the expanded line
+*               pointer to size_t for the length of the line, updated
+*
+* Returns:      1 if the line was expanded, 0 if it had nothing to expand,
+*               -1 if an event was not found (the error has been printed)
+*
+**/
+int historyExpand(struct arena *arena, char **line, size_t *length)
+{
+    const char *src = *line;
+    const char *end = src + *length;
+    if (!memchr(src, '!', *length)) {
+        return 0;
+    }
+
+    size_t capacity = *length * 2 + 64;
+    size_t used = 0;
+    char *out = arenaAlloc(arena, capacity);
+    _Bool inSingle = 0;
+    _Bool inDouble = 0;
+    _Bool expanded = 0;
+
+    for (const char *p = src; p < end; p++) {
+        const char *copy = p;
+        size_t copyLength = 1;
+
+        if (*p == '\\' && !inSingle && p + 1 < end) {
+            copyLength = 2;
+            p++;
+        }
+        else if (*p == '\'' && !inDouble) {
+            inSingle = !inSingle;
+        }
+        else if (*p == '"' && !inSingle) {
+            inDouble = !inDouble;
+        }
+        else if (*p == '!' && !inSingle && p + 1 < end
+                && !(p > src && p[-1] == '$')
+                && !strchr(" \t=(\"", p[1])) {
+            size_t number;
+            size_t eventLength = historyEvent(p + 1, end, &number);
+            if (eventLength == 0) {
+                // a `!` before an operator is just a character
+            }
+            else if (number == 0) {
+                printf("%.*s: event not found\n", (int)(eventLength + 1), p);
+                fflush(stdout);
+                return -1;
+            }
+            else {
+                copy = historyGet(number, &copyLength);
+                p += eventLength;
+                expanded = 1;
+            }
+        }
+
+        if (used + copyLength + 1 > capacity) {
+            size_t newCapacity = (used + copyLength + 1) * 2;
+            out = arenaGrow(arena, out, capacity, newCapacity);
+            capacity = newCapacity;
+        }
+        memcpy(out + used, copy, copyLength);
+        used += copyLength;
+    }
+
+    if (!expanded) {
+        return 0;
+    }
+    out[used] = '\0';
+    *line = out;
+    *length = used;
+    return 1;
+}
+
+/**
+*
+* void historyClose(void)
+*
+* Summary:
+*       Unmaps and closes the history file and frees the session entries
+*
+**/
+void historyClose(void)
+{
+    if (map) {
+        munmap((void *)map, mapLength);
+    }
+    if (historyFd != -1) {
+        close(historyFd);
+    }
+    for (size_t i = 0; i < numSession; i++) {
+        free(session[i].text);
+    }
+    free(session);
+    free(offsets);
+    historyFd = -1;
+    map = NULL;
+    mapLength = 0;
+    offsets = NULL;
+    numMapped = 0;
+    indexed = 0;
+    session = NULL;
+    numSession = 0;
+    sessionCapacity = 0;
+}
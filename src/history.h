@@ -0,0 +1,31 @@
+/*******************************************************************************
+*
+* File:     history.h
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Interface for the kell-shell command history. Entries are numbered
+*   from 1, oldest first: the entries already in the history file when
+*   the shell started, then the lines entered since.
+*
+******************************************************************************/
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <stddef.h>
+
+struct arena;
+
+int historyOpen(const char *path);
+_Bool historyEnabled(void);
+void historyAdd(const char *line, size_t length);
+size_t historyCount(void);
+const char *historyGet(size_t number, size_t *length);
+size_t historyFindPrefix(const char *prefix, size_t length, size_t before);
+size_t historyFindSubstring(const char *text, size_t length, size_t before);
+int historyExpand(struct arena *arena, char **line, size_t *length);
+void historyClose(void);
+
+#endif
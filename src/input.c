@@ -0,0 +1,287 @@
+/*******************************************************************************
+*
+* File:     input.c
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Input reader for kell-shell. Instead of one fgets() per line, input is
+*   pulled in large blocks (or mapped whole, for script files) and split
+*   into lines here. Lines are returned as pointers into the reader's
+*   memory with a length; they are not NUL terminated and stay valid only
+*   until the next call.
+*
+******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "input.h"
+
+#define INPUT_BLOCK (64 * 1024)
+
+/**
+*
+* void inputOpenFd(struct inputReader *reader, int fd)
+*
+* Summary:
+*       Sets up a reader that reads lines from a file descriptor
+*
+* Parameters:   pointer to the reader to set up
+*               int for the descriptor, usually stdin
+*
+* Returns:      nothing.
+*
+* Description:
+*       A tty hands back one line per read() anyway; anything else is read
+*       INPUT_BLOCK bytes at a time.
+*
+**/
+void inputOpenFd(struct inputReader *reader, int fd)
+{
+    memset(reader, 0, sizeof(struct inputReader));
+    reader->fd = fd;
+    reader->capacity = INPUT_BLOCK;
+    reader->buffer = malloc(reader->capacity);
+}
+
+/**
+*
+* int inputOpenFile(struct inputReader *reader, const char *path)
+*
+* Summary:
+*       Sets up a reader over a memory-mapped script file
+*
+* Parameters:   pointer to the reader to set up
+*               char* for the path of the script
+*
+* Returns:      0 on success, -1 with errno set if the file cannot be read
+*
+* Description:
+*       A directory is refused with EISDIR: reading it would fail, which
+*       looks like an empty script.
+*
+**/
+int inputOpenFile(struct inputReader *reader, const char *path)
+{
+    memset(reader, 0, sizeof(struct inputReader));
+    reader->fd = -1;
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return -1;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) == -1) {
+        close(fd);
+        return -1;
+    }
+    if (S_ISDIR(info.st_mode)) {
+        close(fd);
+        errno = EISDIR;
+        return -1;
+    }
+    if (!S_ISREG(info.st_mode)) {
+        // pipes and devices cannot be mapped, read them in blocks instead
+        inputOpenFd(reader, fd);
+        return 0;
+    }
+
+    if (info.st_size > 0) {
+        void *map = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            int error = errno;
+            close(fd);
+            errno = error;
+            return -1;
+        }
+        madvise(map, info.st_size, MADV_SEQUENTIAL);
+        reader->data = map;
+        reader->length = info.st_size;
+        reader->mapLength = info.st_size;
+    }
+
+    close(fd);
+    return 0;
+}
+
+/**
+*
+* void inputOpenString(struct inputReader *reader, const char *str)
+*
+* Summary:
+*       Sets up a reader over a string, for -c
+*
+* Parameters:   pointer to the reader to set up
+*               char* for the commands, which must outlive the reader
+*
+* Returns:      nothing.
+*
+**/
+void inputOpenString(struct inputReader *reader, const char *str)
+{
+    memset(reader, 0, sizeof(struct inputReader));
+    reader->fd = -1;
+    reader->data = str;
+    reader->length = strlen(str);
+}
+
+/**
+*
+* static const char *inputNextFromMemory(struct inputReader *reader,
+*                                        size_t *length)
+*
+* Summary:
+*       Returns the next line of a mapped file or string
+*
+* Parameters:   pointer to the reader
+*               pointer to size_t for the line length
+*
+* Returns:      pointer to the line, or NULL at the end
+*
+**/
+static const char *inputNextFromMemory(struct inputReader *reader, size_t *length)
+{
+    if (reader->start >= reader->length) {
+        reader->eof = 1;
+        return NULL;
+    }
+
+    const char *line = reader->data + reader->start;
+    size_t remaining = reader->length - reader->start;
+    const char *newline = memchr(line, '\n', remaining);
+
+    if (newline) {
+        *length = newline - line;
+        reader->start += *length + 1;
+    }
+    else {
+        *length = remaining;
+        reader->start = reader->length;
+    }
+    return line;
+}
+
+/**
+*
+* const char *inputReadLine(struct inputReader *reader, size_t *length)
+*
+* Summary:
+*       Returns the next line of input without its newline
+*
+* Parameters:   pointer to the reader
+*               pointer to size_t for the line length
+*
+* Returns:      pointer to the line, or NULL when no line is available
+*
+* Description:
+*       NULL is returned at the end of input, with reader->eof set, and when
+*       a read is interrupted by a signal, with reader->eof clear. A last
+*       line without a trailing newline is still returned. The buffer grows
+*       to hold lines longer than a block.
+*
+**/
+const char *inputReadLine(struct inputReader *reader, size_t *length)
+{
+    if (reader->fd == -1) {
+        return inputNextFromMemory(reader, length);
+    }
+
+    size_t scanned = reader->start;
+    while (1) {
+        char *newline = memchr(reader->buffer + scanned, '\n', reader->end - scanned);
+        if (newline) {
+            char *line = reader->buffer + reader->start;
+            *length = newline - line;
+            reader->start += *length + 1;
+            return line;
+        }
+        scanned = reader->end;
+
+        // make room: drop consumed bytes first, grow only for long lines
+        if (reader->end == reader->capacity) {
+            if (reader->start > 0) {
+                memmove(reader->buffer, reader->buffer + reader->start,
+                        reader->end - reader->start);
+                reader->end -= reader->start;
+                scanned -= reader->start;
+                reader->start = 0;
+            }
+            else {
+                reader->capacity *= 2;
+                reader->buffer = realloc(reader->buffer, reader->capacity);
+            }
+        }
+
+        ssize_t n = read(reader->fd, reader->buffer + reader->end,
+                reader->capacity - reader->end);
+        if (n > 0) {
+            reader->end += n;
+        }
+        else if (n == -1 && errno == EINTR) {
+            return NULL;
+        }
+        else {
+            // end of input: hand back a final unterminated line if any
+            reader->eof = 1;
+            if (reader->start < reader->end) {
+                char *line = reader->buffer + reader->start;
+                *length = reader->end - reader->start;
+                reader->start = reader->end;
+                return line;
+            }
+            return NULL;
+        }
+    }
+}
+
+/**
+*
+* _Bool inputHasLine(struct inputReader *reader)
+*
+* Summary:
+*       Checks whether inputReadLine() can return without reading
+*
+* Parameters:   pointer to the reader
+*
+* Returns:      true if a full line is buffered, or input is in memory
+*
+**/
+_Bool inputHasLine(struct inputReader *reader)
+{
+    if (reader->fd == -1) {
+        return 1;
+    }
+    return memchr(reader->buffer + reader->start, '\n', reader->end - reader->start) != NULL;
+}
+
+/**
+*
+* void inputClose(struct inputReader *reader)
+*
+* Summary:
+*       Releases the memory and descriptors held by a reader
+*
+* Parameters:   pointer to the reader
+*
+* Returns:      nothing.
+*
+**/
+void inputClose(struct inputReader *reader)
+{
+    if (reader->mapLength) {
+        munmap((void *)reader->data, reader->mapLength);
+    }
+    if (reader->fd > STDIN_FILENO) {
+        close(reader->fd);
+    }
+    free(reader->buffer);
+    memset(reader, 0, sizeof(struct inputReader));
+    reader->fd = -1;
+}
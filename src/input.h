@@ -0,0 +1,39 @@
+/*******************************************************************************
+*
+* File:     input.h
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Interface for the kell-shell input reader. Lines come from a file
+*   descriptor read in large blocks, from a memory-mapped script file, or
+*   from a string given with -c.
+*
+******************************************************************************/
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <stddef.h>
+
+struct inputReader {
+    int fd;             // descriptor to read from, -1 for mapped files/strings
+    const char *data;   // mapped script or -c string
+    size_t length;      // bytes in data
+    size_t mapLength;   // nonzero when data must be munmap'd
+    char *buffer;       // block buffer for fd input
+    size_t capacity;
+    size_t start;       // first unconsumed byte in buffer or data
+    size_t end;         // end of valid bytes in buffer
+    _Bool interactive;  // print a prompt before every line
+    _Bool eof;          // no more input will arrive
+};
+
+void inputOpenFd(struct inputReader *reader, int fd);
+int inputOpenFile(struct inputReader *reader, const char *path);
+void inputOpenString(struct inputReader *reader, const char *str);
+const char *inputReadLine(struct inputReader *reader, size_t *length);
+_Bool inputHasLine(struct inputReader *reader);
+void inputClose(struct inputReader *reader);
+
+#endif
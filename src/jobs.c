@@ -0,0 +1,976 @@
+/*******************************************************************************
+*
+* File:     jobs.c
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Job table for kell-shell jobs.
+*
+*   Jobs live in fixed-size slabs that are never moved or freed while the
+*   shell runs, so a job keeps its address and its id (slot number + 1) for
+*   its whole life. Finished jobs go on a free list and are handed out
+*   again before a new slab is allocated, which keeps job ids small.
+*
+*   Every tracked process is in an open-addressing pid -> job table, so
+*   reaping is one wait4(-1, WNOHANG) loop that costs O(finished
+*   processes) instead of one waitpid call per tracked process.
+*
+*   wait4() also returns the resource use of each child, which is summed
+*   into its job. With KELL_JOB_LOG set, every finished job is appended to
+*   that file as one line of JSON holding its command, status, wall, user
+*   and sys time, peak RSS, page faults and context switches.
+*
+*   Job control is on when an interactive shell reads a terminal. The
+*   shell then leads its own process group and owns the terminal; each job
+*   gets a process group of its own, led by its first stage, and the
+*   terminal is handed to the group while the job runs in the foreground.
+*   CTRL+C and CTRL+Z reach only that group. Children are reaped with
+*   WUNTRACED and WCONTINUED so the table knows which processes are
+*   stopped; a job whose every remaining process is stopped is stopped,
+*   and a stopped foreground job becomes a background job that `fg` and
+*   `bg` can continue.
+*
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+#include "events.h"     // eventsWait()
+#include "jobs.h"
+
+#define JOB_SLAB_SIZE 64
+#define PID_MIN_CAPACITY 64
+
+struct pidEntry {
+    pid_t pid;          // 0 for an empty slot
+    struct job *job;
+    _Bool stopped;      // last reported stopped, not continued or gone
+};
+
+static struct job **slabs = NULL;
+static int numSlabs = 0;
+static struct job *freeList = NULL;
+static int numJobs = 0;
+
+static struct pidEntry *pidTable = NULL;
+static size_t pidCapacity = 0;
+static size_t pidCount = 0;
+
+static int logFd = -1;      // KELL_JOB_LOG, -1 when not logging
+static unsigned long activity = 0;  // counts job starts and stops
+
+static int terminalFd = -1;         // controlling terminal, -1 without job control
+static pid_t shellPgid = 0;
+static pid_t originalPgid = 0;      // group that had the terminal at startup
+static struct termios shellModes;   // terminal modes of the shell itself
+
+/**
+*
+* static size_t pidSlot(pid_t pid)
+*
+* Summary:
+*       Home slot of a pid in the pid table (Fibonacci hashing)
+*
+* Parameters:   pid_t for the process id
+*
+* Returns:      index into pidTable
+*
+**/
+static size_t pidSlot(pid_t pid)
+{
+    return ((unsigned)pid * 2654435761u) & (pidCapacity - 1);
+}
+
+/**
+*
+* static struct pidEntry *pidInsert(pid_t pid, struct job *job)
+*
+* Summary:
+*       Maps a process id to its job, growing the table at half full
+*
+* Parameters:   pid_t for the process id
+*               pointer to the job that owns it
+*
+* Returns:      pointer to the new entry
+*
+**/
+static struct pidEntry *pidInsert(pid_t pid, struct job *job)
+{
+    if ((pidCount + 1) * 2 > pidCapacity) {
+        struct pidEntry *oldTable = pidTable;
+        size_t oldCapacity = pidCapacity;
+
+        pidCapacity = oldCapacity ? oldCapacity * 2 : PID_MIN_CAPACITY;
+        pidTable = calloc(pidCapacity, sizeof(struct pidEntry));
+        pidCount = 0;
+        for (size_t i = 0; i < oldCapacity; i++) {
+            if (oldTable[i].pid) {
+                pidInsert(oldTable[i].pid, oldTable[i].job)->stopped = oldTable[i].stopped;
+            }
+        }
+        free(oldTable);
+    }
+
+    size_t mask = pidCapacity - 1;
+    size_t i = pidSlot(pid);
+    while (pidTable[i].pid) {
+        i = (i + 1) & mask;
+    }
+    pidTable[i].pid = pid;
+    pidTable[i].job = job;
+    pidTable[i].stopped = 0;
+    pidCount++;
+    return &pidTable[i];
+}
+
+/**
+*
+* static struct pidEntry *pidFind(pid_t pid)
+*
+* Summary:
+*       Looks up a process id in the pid table
+*
+* Parameters:   pid_t for the process id
+*
+* Returns:      pointer to its entry, or NULL if not tracked
+*
+**/
+static struct pidEntry *pidFind(pid_t pid)
+{
+    if (!pidTable) {
+        return NULL;
+    }
+    size_t mask = pidCapacity - 1;
+    size_t i = pidSlot(pid);
+    while (pidTable[i].pid && pidTable[i].pid != pid) {
+        i = (i + 1) & mask;
+    }
+    return pidTable[i].pid ? &pidTable[i] : NULL;
+}
+
+/**
+*
+* static struct job *pidRemove(pid_t pid)
+*
+* Summary:
+*       Removes a process id from the pid table
+*
+* Parameters:   pid_t for the process id
+*
+* Returns:      the job that owned the process, or NULL if not tracked
+*
+* Description:
+*       Uses backward-shift deletion: entries after the hole that would
+*       probe through it are moved up, so no tombstones are needed and
+*       lookups never slow down as jobs come and go.
+*
+**/
+static struct job *pidRemove(pid_t pid)
+{
+    if (!pidTable) {
+        return NULL;
+    }
+
+    size_t mask = pidCapacity - 1;
+    size_t i = pidSlot(pid);
+    while (pidTable[i].pid && pidTable[i].pid != pid) {
+        i = (i + 1) & mask;
+    }
+    if (!pidTable[i].pid) {
+        return NULL;
+    }
+
+    struct job *job = pidTable[i].job;
+    size_t j = i;
+    while (1) {
+        j = (j + 1) & mask;
+        if (!pidTable[j].pid) {
+            break;
+        }
+        // move entry j into the hole unless its home slot lies in (i, j]
+        size_t home = pidSlot(pidTable[j].pid);
+        _Bool between = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+        if (!between) {
+            pidTable[i] = pidTable[j];
+            i = j;
+        }
+    }
+    pidTable[i].pid = 0;
+    pidTable[i].job = NULL;
+    pidTable[i].stopped = 0;
+    pidCount--;
+    return job;
+}
+
+/**
+*
+* struct job *jobCreate(_Bool background)
+*
+* Summary:
+*       Takes an unused job from the free list, adding a slab if empty
+*
+* Parameters:   bool for whether the job runs in the background
+*
+* Returns:      pointer to a cleared job with its id set
+*
+**/
+struct job *jobCreate(_Bool background)
+{
+    if (!freeList) {
+        slabs = realloc(slabs, (numSlabs + 1) * sizeof(struct job *));
+        struct job *slab = calloc(JOB_SLAB_SIZE, sizeof(struct job));
+        slabs[numSlabs] = slab;
+
+        // push in reverse so the lowest id is handed out first
+        for (int i = JOB_SLAB_SIZE - 1; i >= 0; i--) {
+            slab[i].id = numSlabs * JOB_SLAB_SIZE + i + 1;
+            slab[i].nextFree = freeList;
+            freeList = &slab[i];
+        }
+        numSlabs++;
+    }
+
+    struct job *job = freeList;
+    freeList = job->nextFree;
+
+    job->jobPid = -1;
+    job->pgid = 0;
+    job->remaining = 0;
+    job->numStopped = 0;
+    job->status = 0;
+    job->stopSignal = 0;
+    job->background = background;
+    job->done = 0;
+    job->stopped = 0;
+    job->waited = 0;
+    job->inUse = 1;
+    job->lastActive = ++activity;
+    job->hasModes = 0;
+    job->nextFree = NULL;
+    memset(&job->usage, 0, sizeof(job->usage));
+    job->command = NULL;
+    clock_gettime(CLOCK_MONOTONIC, &job->started);
+    numJobs++;
+    return job;
+}
+
+/**
+*
+* void jobDelete(struct job *job)
+*
+* Summary:
+*       Returns a finished job to the free list
+*
+* Parameters:   pointer to the job
+*
+* Returns:      nothing.
+*
+**/
+void jobDelete(struct job *job)
+{
+    free(job->command);
+    job->command = NULL;
+    job->inUse = 0;
+    job->nextFree = freeList;
+    freeList = job;
+    numJobs--;
+}
+
+/**
+*
+* void jobAddProcess(struct job *job, pid_t pid, _Bool isLast)
+*
+* Summary:
+*       Tracks a process as part of a job
+*
+* Parameters:   pointer to the job
+*               pid_t for the process id
+*               bool for whether this is the last stage of the pipeline
+*
+* Returns:      nothing.
+*
+**/
+void jobAddProcess(struct job *job, pid_t pid, _Bool isLast)
+{
+    pidInsert(pid, job);
+    job->remaining++;
+    if (isLast) {
+        job->jobPid = pid;
+    }
+}
+
+/**
+*
+* void jobSetCommand(struct job *job, char *argv[])
+*
+* Summary:
+*       Records the words of a pipeline stage as part of the job's command
+*
+* Parameters:   pointer to the job
+*               NULL-terminated array of char* for the stage's arguments
+*
+* Returns:      nothing.
+*
+* Description:
+*       Stages are joined with " | ". The text is what `jobs` lists and
+*       the job log records.
+*
+**/
+void jobSetCommand(struct job *job, char *argv[])
+{
+    size_t oldLength = job->command ? strlen(job->command) : 0;
+    size_t length = oldLength + 3;
+    for (int i = 0; argv[i]; i++) {
+        length += strlen(argv[i]) + 1;
+    }
+
+    char *command = realloc(job->command, length + 1);
+    char *out = command + oldLength;
+    if (oldLength > 0) {
+        out = stpcpy(out, " | ");
+    }
+    for (int i = 0; argv[i]; i++) {
+        if (i > 0) {
+            *out++ = ' ';
+        }
+        out = stpcpy(out, argv[i]);
+    }
+    *out = '\0';
+    job->command = command;
+}
+
+/**
+*
+* void jobUsageAdd(struct rusage *total, const struct rusage *usage)
+*
+* Summary:
+*       Adds the resource use of one process to a running total
+*
+* Parameters:   pointer to the rusage receiving the sum
+*               pointer to the rusage to add
+*
+* Returns:      nothing.
+*
+* Description:
+*       Times and counters are summed; the peak RSS is the largest peak of
+*       any process, since the processes do not share memory.
+*
+**/
+void jobUsageAdd(struct rusage *total, const struct rusage *usage)
+{
+    timeradd(&total->ru_utime, &usage->ru_utime, &total->ru_utime);
+    timeradd(&total->ru_stime, &usage->ru_stime, &total->ru_stime);
+    if (usage->ru_maxrss > total->ru_maxrss) {
+        total->ru_maxrss = usage->ru_maxrss;
+    }
+    total->ru_minflt += usage->ru_minflt;
+    total->ru_majflt += usage->ru_majflt;
+    total->ru_inblock += usage->ru_inblock;
+    total->ru_oublock += usage->ru_oublock;
+    total->ru_nvcsw += usage->ru_nvcsw;
+    total->ru_nivcsw += usage->ru_nivcsw;
+}
+
+/**
+*
+* int jobsOpenLog(const char *path)
+*
+* Summary:
+*       Starts appending a JSON line for every finished job to a file
+*
+* Parameters:   char* for the path of the log
+*
+* Returns:      0 on success, -1 if the file cannot be opened
+*
+**/
+int jobsOpenLog(const char *path)
+{
+    int fd = open(path, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        return -1;
+    }
+    if (logFd != -1) {
+        close(logFd);
+    }
+    logFd = fd;
+    return 0;
+}
+
+/**
+*
+* static void jobLogWrite(struct job *job)
+*
+* Summary:
+*       Appends one JSON line describing a finished job to the job log
+*
+* Parameters:   pointer to the finished job
+*
+* Returns:      nothing.
+*
+* Description:
+*       The line is built in memory and written with a single write() to
+*       a file opened with O_APPEND, so lines from several shells logging
+*       to the same file do not interleave.
+*
+**/
+static void jobLogWrite(struct job *job)
+{
+    const struct rusage *usage = &job->usage.rusage;
+    const char *command = job->command ? job->command : "";
+    size_t size = 512 + strlen(command) * 6;
+    char *line = malloc(size);
+    struct timespec now;
+    int n;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    n = snprintf(line, size, "{\"time\":%lld.%03ld,\"job\":%d,\"pid\":%d,"
+            "\"background\":%s,\"command\":\"",
+            (long long)now.tv_sec, now.tv_nsec / 1000000, job->id,
+            (int)job->jobPid, job->background ? "true" : "false");
+
+    // escape the command as a JSON string
+    for (const unsigned char *p = (const unsigned char *)command; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            line[n++] = '\\';
+            line[n++] = *p;
+        }
+        else if (*p < 0x20) {
+            n += sprintf(line + n, "\\u%04x", *p);
+        }
+        else {
+            line[n++] = *p;
+        }
+    }
+
+    n += snprintf(line + n, size - n, "\",\"%s\":%d,\"real\":%.6f,"
+            "\"user\":%.6f,\"sys\":%.6f,\"maxrss_kb\":%ld,\"minflt\":%ld,"
+            "\"majflt\":%ld,\"inblock\":%ld,\"oublock\":%ld,\"nvcsw\":%ld,"
+            "\"nivcsw\":%ld}\n",
+            WIFSIGNALED(job->status) ? "signal" : "exit",
+            WIFSIGNALED(job->status) ? WTERMSIG(job->status) : WEXITSTATUS(job->status),
+            job->usage.wallSeconds,
+            usage->ru_utime.tv_sec + usage->ru_utime.tv_usec / 1e6,
+            usage->ru_stime.tv_sec + usage->ru_stime.tv_usec / 1e6,
+            usage->ru_maxrss, usage->ru_minflt, usage->ru_majflt,
+            usage->ru_inblock, usage->ru_oublock,
+            usage->ru_nvcsw, usage->ru_nivcsw);
+
+    if (write(logFd, line, n) != n) {
+        // a full disk should not stop the shell, the line is lost
+    }
+    free(line);
+}
+
+/**
+*
+* struct job *jobFind(int id)
+*
+* Summary:
+*       Looks up a job by its id
+*
+* Parameters:   int for the job id
+*
+* Returns:      pointer to the job, or NULL if no such job exists
+*
+**/
+struct job *jobFind(int id)
+{
+    if (id < 1 || id > numSlabs * JOB_SLAB_SIZE) {
+        return NULL;
+    }
+    struct job *job = &slabs[(id - 1) / JOB_SLAB_SIZE][(id - 1) % JOB_SLAB_SIZE];
+    return job->inUse ? job : NULL;
+}
+
+/**
+*
+* struct job *jobsNext(struct job *job)
+*
+* Summary:
+*       Iterates over the jobs that exist, in order of job id
+*
+* Parameters:   pointer to the previous job, or NULL to start
+*
+* Returns:      pointer to the next job, or NULL after the last one
+*
+**/
+struct job *jobsNext(struct job *job)
+{
+    int total = numSlabs * JOB_SLAB_SIZE;
+    for (int id = job ? job->id + 1 : 1; id <= total && numJobs > 0; id++) {
+        struct job *next = &slabs[(id - 1) / JOB_SLAB_SIZE][(id - 1) % JOB_SLAB_SIZE];
+        if (next->inUse) {
+            return next;
+        }
+    }
+    return NULL;
+}
+
+/**
+*
+* struct job *jobFindPid(pid_t pid)
+*
+* Summary:
+*       Looks up the job a process belongs to
+*
+* Parameters:   pid_t for the process id
+*
+* Returns:      pointer to the job, or NULL if the process is not tracked
+*
+**/
+struct job *jobFindPid(pid_t pid)
+{
+    struct pidEntry *entry = pidFind(pid);
+    return entry ? entry->job : NULL;
+}
+
+/**
+*
+* struct job *jobsCurrent(void)
+*
+* Summary:
+*       Finds the current job, the one `fg` and `bg` use by default
+*
+* Parameters:   none
+*
+* Returns:      the background job started or stopped most recently, or
+*               NULL if there is none
+*
+**/
+struct job *jobsCurrent(void)
+{
+    struct job *current = NULL;
+    for (struct job *job = jobsNext(NULL); job; job = jobsNext(job)) {
+        if (job->background && (!current || job->lastActive > current->lastActive)) {
+            current = job;
+        }
+    }
+    return current;
+}
+
+/**
+*
+* static _Bool jobUpdateStopped(struct job *job)
+*
+* Summary:
+*       Works out if a job is stopped after one of its processes changed
+*
+* Parameters:   pointer to the job
+*
+* Returns:      true if the job has just become stopped
+*
+**/
+static _Bool jobUpdateStopped(struct job *job)
+{
+    _Bool stopped = (job->remaining > 0 && job->numStopped == job->remaining);
+    _Bool newly = stopped && !job->stopped;
+    job->stopped = stopped;
+    if (newly) {
+        job->lastActive = ++activity;
+    }
+    return newly;
+}
+
+/**
+*
+* static void jobSetRunning(struct job *job)
+*
+* Summary:
+*       Marks every process of a job as running after SIGCONT
+*
+* Parameters:   pointer to the job
+*
+* Returns:      nothing.
+*
+* Description:
+*       Done when the signal is sent rather than when WCONTINUED is
+*       reaped, so a job resumed with `fg` is not still seen as stopped.
+*
+**/
+static void jobSetRunning(struct job *job)
+{
+    for (size_t i = 0; i < pidCapacity; i++) {
+        if (pidTable[i].pid && pidTable[i].job == job) {
+            pidTable[i].stopped = 0;
+        }
+    }
+    job->numStopped = 0;
+    job->stopped = 0;
+}
+
+/**
+*
+* int jobsReap(void (*onChange)(struct job *job))
+*
+* Summary:
+*       Reaps every finished child and reports jobs with no processes left
+*
+* Parameters:   function called for each background job that finishes,
+*               before it is freed, or stops
+*
+* Returns:      the number of jobs that finished
+*
+* Description:
+*       A job is done once all of its processes have been reaped; its
+*       status is the status of the last stage. Finished foreground jobs,
+*       and background jobs `wait` is collecting, are only marked done;
+*       whoever is waiting on them reads the status and deletes them.
+*       Children that are not in the table are ignored.
+*
+*       Stopped and continued children only update which processes are
+*       stopped; a foreground job that stops is left for its waiter.
+*
+*       The resource use wait4() reports for each child is added to its
+*       job, and the wall time is taken when the last process is reaped.
+*
+* ---
+*
+* Elements of the following code have been adapted from:
+*
+* - Title: The Linux Programming Interface pg. 557-558
+*   Author: Michael Kerrisk
+*
+**/
+int jobsReap(void (*onChange)(struct job *job))
+{
+    int finished = 0;
+    int status;
+    struct rusage usage;
+    pid_t pid;
+
+    while ((pid = wait4(-1, &status, WNOHANG | WUNTRACED | WCONTINUED, &usage)) > 0) {
+        struct pidEntry *entry = pidFind(pid);
+        if (!entry) {
+            continue;
+        }
+        struct job *job = entry->job;
+
+        if (WIFSTOPPED(status) || WIFCONTINUED(status)) {
+            _Bool stopped = WIFSTOPPED(status);
+            if (stopped != entry->stopped) {
+                entry->stopped = stopped;
+                job->numStopped += stopped ? 1 : -1;
+            }
+            if (stopped) {
+                job->stopSignal = WSTOPSIG(status);
+            }
+            if (jobUpdateStopped(job) && job->background) {
+                onChange(job);
+            }
+            continue;
+        }
+
+        if (entry->stopped) {
+            job->numStopped--;
+        }
+        pidRemove(pid);
+
+        if (pid == job->jobPid) {
+            job->status = status;
+        }
+        jobUsageAdd(&job->usage.rusage, &usage);
+        if (--job->remaining == 0) {
+            job->stopped = 0;
+            struct timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            job->usage.wallSeconds = (now.tv_sec - job->started.tv_sec)
+                    + (now.tv_nsec - job->started.tv_nsec) / 1e9;
+            if (logFd != -1) {
+                jobLogWrite(job);
+            }
+
+            if (job->background && !job->waited) {
+                onChange(job);
+                jobDelete(job);
+            }
+            else {
+                job->done = 1;
+            }
+            finished++;
+        }
+        else if (jobUpdateStopped(job) && job->background) {
+            onChange(job);
+        }
+    }
+    return finished;
+}
+
+/**
+*
+* int jobSignal(struct job *job, int signo)
+*
+* Summary:
+*       Sends a signal to every process of a job
+*
+* Parameters:   pointer to the job
+*               int for the signal number
+*
+* Returns:      0 if the signal was sent, -1 with errno set otherwise
+*
+* Description:
+*       A job with a process group is signalled with one kill(); without
+*       job control each of its processes is.
+*
+**/
+int jobSignal(struct job *job, int signo)
+{
+    if (job->pgid > 0) {
+        return kill(-job->pgid, signo);
+    }
+    int result = -1;
+    for (size_t i = 0; i < pidCapacity; i++) {
+        if (pidTable[i].pid && pidTable[i].job == job
+                && kill(pidTable[i].pid, signo) == 0) {
+            result = 0;
+        }
+    }
+    return result;
+}
+
+/**
+*
+* void jobsSignalAll(int signo)
+*
+* Summary:
+*       Sends a signal to every tracked process
+*
+* Parameters:   int for the signal number
+*
+* Returns:      nothing.
+*
+**/
+void jobsSignalAll(int signo)
+{
+    for (size_t i = 0; i < pidCapacity; i++) {
+        if (pidTable[i].pid) {
+            kill(pidTable[i].pid, signo);
+        }
+    }
+}
+
+/**
+*
+* int jobControlInit(int fd)
+*
+* Summary:
+*       Turns on job control for a shell reading a terminal
+*
+* Parameters:   int for the terminal descriptor
+*
+* Returns:      0 on success, -1 if the terminal cannot be taken over
+*
+* Description:
+*       A shell started in the background stops itself with SIGTTIN until
+*       it is brought to the foreground, as any job would. It then leads a
+*       process group of its own and takes the terminal. SIGTTIN and
+*       SIGTTOU are ignored so the shell can take the terminal back from a
+*       job; the spawn engine restores them in children.
+*
+* ---
+*
+* Elements of the following code have been adapted from:
+*
+* - Title: GNU C Library manual, 28.6.2 Initializing the Shell
+*   Author: Free Software Foundation
+*
+**/
+int jobControlInit(int fd)
+{
+    pid_t pgid;
+    while ((pgid = getpgrp()) != tcgetpgrp(fd)) {
+        if (tcgetpgrp(fd) == -1) {
+            return -1;
+        }
+        kill(-pgid, SIGTTIN);
+    }
+
+    struct sigaction ignore = {{0}};
+    ignore.sa_handler = SIG_IGN;
+    sigaction(SIGTTIN, &ignore, NULL);
+    sigaction(SIGTTOU, &ignore, NULL);
+
+    // a session leader already leads its group and cannot start another
+    originalPgid = pgid;
+    if (pgid != getpid() && setpgid(0, 0) == -1) {
+        return -1;
+    }
+    shellPgid = getpid();
+    if (tcsetpgrp(fd, shellPgid) == -1) {
+        return -1;
+    }
+    tcgetattr(fd, &shellModes);
+    terminalFd = fd;
+    return 0;
+}
+
+/**
+*
+* _Bool jobControlEnabled(void)
+*
+* Summary:
+*       Reports whether jobs get process groups and the terminal
+*
+**/
+_Bool jobControlEnabled(void)
+{
+    return terminalFd != -1;
+}
+
+/**
+*
+* void jobForeground(struct job *job, _Bool resume,
+*                    void (*handleEvents)(int events))
+*
+* Summary:
+*       Runs a job in the foreground until it finishes or stops
+*
+* Parameters:   pointer to the job
+*               bool for whether the job was stopped and must be continued
+*               function that handles the events of the wait
+*
+* Returns:      nothing. job->done or job->stopped is set
+*
+* Description:
+*       With job control the job's group gets the terminal first, with its
+*       own terminal modes if it stopped before, and always gets a SIGCONT:
+*       a stage that touched the terminal before it was handed over was
+*       stopped by SIGTTIN, and is woken by it. Afterwards the shell takes
+*       the terminal back; when the job stopped or was killed its modes are
+*       saved and the shell's restored.
+*
+*       A job that stops becomes a background job.
+*
+**/
+void jobForeground(struct job *job, _Bool resume, void (*handleEvents)(int events))
+{
+    _Bool control = (terminalFd != -1 && job->pgid > 0);
+
+    job->background = 0;
+    if (control) {
+        if (resume && job->hasModes) {
+            tcsetattr(terminalFd, TCSADRAIN, &job->modes);
+        }
+        tcsetpgrp(terminalFd, job->pgid);
+    }
+    if (control || resume) {
+        jobSignal(job, SIGCONT);
+        jobSetRunning(job);
+    }
+
+    while (job->remaining > 0 && !job->done && !job->stopped) {
+        handleEvents(eventsWait(-1, 0));
+    }
+
+    if (control) {
+        tcsetpgrp(terminalFd, shellPgid);
+        if (job->stopped) {
+            tcgetattr(terminalFd, &job->modes);
+            job->hasModes = 1;
+        }
+        if (job->stopped || (job->done && WIFSIGNALED(job->status))) {
+            tcsetattr(terminalFd, TCSADRAIN, &shellModes);
+        }
+    }
+    if (job->stopped) {
+        job->background = 1;
+    }
+}
+
+/**
+*
+* void jobBackground(struct job *job)
+*
+* Summary:
+*       Continues a stopped job in the background
+*
+* Parameters:   pointer to the job
+*
+* Returns:      nothing.
+*
+**/
+void jobBackground(struct job *job)
+{
+    jobSignal(job, SIGCONT);
+    jobSetRunning(job);
+    job->background = 1;
+    job->lastActive = ++activity;
+}
+
+/**
+*
+* void jobsClear(void)
+*
+* Summary:
+*       Forgets every job and turns job control off, in a subshell
+*
+* Parameters:   none
+*
+* Returns:      nothing.
+*
+* Description:
+*       A forked subshell inherits the shell's table, but the processes in
+*       it are not its children. Its own jobs are not logged, the job
+*       that runs the subshell already is.
+*
+**/
+void jobsClear(void)
+{
+    struct job *next;
+    for (struct job *job = jobsNext(NULL); job; job = next) {
+        next = jobsNext(job);
+        jobDelete(job);
+    }
+    if (pidTable) {
+        memset(pidTable, 0, pidCapacity * sizeof(struct pidEntry));
+    }
+    pidCount = 0;
+    logFd = -1;
+    terminalFd = -1;
+}
+
+/**
+*
+* void jobsFree(void)
+*
+* Summary:
+*       Frees all memory held by the job table
+*
+* Parameters:   none
+*
+* Returns:      nothing.
+*
+**/
+void jobsFree(void)
+{
+    for (int i = 0; i < numSlabs; i++) {
+        for (int j = 0; j < JOB_SLAB_SIZE; j++) {
+            free(slabs[i][j].command);
+        }
+        free(slabs[i]);
+    }
+    free(slabs);
+    free(pidTable);
+    if (logFd != -1) {
+        close(logFd);
+        logFd = -1;
+    }
+    // hand the terminal back to whoever started the shell
+    if (terminalFd != -1 && originalPgid != shellPgid) {
+        tcsetpgrp(terminalFd, originalPgid);
+    }
+    terminalFd = -1;
+    slabs = NULL;
+    numSlabs = 0;
+    freeList = NULL;
+    numJobs = 0;
+    pidTable = NULL;
+    pidCapacity = 0;
+    pidCount = 0;
+}
@@ -0,0 +1,71 @@
+/*******************************************************************************
+*
+* File:     jobs.h
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Interface for the kell-shell job table. A job is a command or pipeline
+*   started by one input line; it owns one process per pipeline stage.
+*   Foreground jobs are tracked too, so one reaper sees every child. With
+*   job control on, every job is also a process group that can be stopped,
+*   continued and given the terminal.
+*
+******************************************************************************/
+#ifndef JOBS_H
+#define JOBS_H
+
+#include <time.h>
+#include <termios.h>
+#include <sys/resource.h>
+#include <sys/types.h>
+
+struct jobUsage {
+    double wallSeconds;     // from creation until the last process was reaped
+    struct rusage rusage;   // summed over every process of the job
+};
+
+struct job {
+    int id;             // stable job number, valid while the job exists
+    pid_t jobPid;       // pid reported for the job: its last stage
+    pid_t pgid;         // process group with job control on, else 0
+    int remaining;      // processes not yet reaped
+    int numStopped;     // of those, how many are stopped
+    int status;         // wait status of the last stage once reaped
+    int stopSignal;     // signal that last stopped a process of the job
+    _Bool background;   // not waited for; stopped jobs are background too
+    _Bool done;         // foreground job finished, status is final
+    _Bool stopped;      // every remaining process is stopped
+    _Bool waited;       // `wait` collects it, do not report it when done
+    _Bool inUse;
+    unsigned long lastActive;   // when it was started or stopped, for %%
+    struct termios modes;       // terminal modes when it was stopped
+    _Bool hasModes;
+    struct timespec started;    // CLOCK_MONOTONIC time the job was created
+    struct jobUsage usage;      // final once the job is done
+    char *command;      // command text for `jobs` and the job log
+    struct job *nextFree;
+};
+
+struct job *jobCreate(_Bool background);
+void jobDelete(struct job *job);
+void jobAddProcess(struct job *job, pid_t pid, _Bool isLast);
+void jobSetCommand(struct job *job, char *argv[]);
+struct job *jobFind(int id);
+struct job *jobFindPid(pid_t pid);
+struct job *jobsNext(struct job *job);
+struct job *jobsCurrent(void);
+int jobsReap(void (*onChange)(struct job *job));
+int jobSignal(struct job *job, int signo);
+void jobsSignalAll(int signo);
+int jobControlInit(int fd);
+_Bool jobControlEnabled(void);
+void jobForeground(struct job *job, _Bool resume, void (*handleEvents)(int events));
+void jobBackground(struct job *job);
+int jobsOpenLog(const char *path);
+void jobUsageAdd(struct rusage *total, const struct rusage *usage);
+void jobsClear(void);
+void jobsFree(void);
+
+#endif
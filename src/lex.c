@@ -0,0 +1,1015 @@
+/*******************************************************************************
+*
+* File:     lex.c
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Lexer for kell-shell. A command line is read exactly once, from left to
+*   right, and expanded as it is read. The character at each decision point
+*   is classified through a 256-entry table; runs of ordinary word
+*   characters are skipped with strcspn(), which glibc vectorizes, so only
+*   quotes, backslashes, `$` and operators take a slower path.
+*
+*   Plain words are used in place: the blank after them is overwritten
+*   with a NUL. Any other word is written unquoted and expanded into an
+*   output buffer in the command arena. Word syntax:
+*       'text'      literal, nothing inside is special
+*       "text"      $ expansions and \$ \" \\ \` escapes still apply
+*       \c          c taken literally; a backslash and newline are
+*                   dropped, so a word goes on past the end of the line
+*       $...        any form understood by expandVariable()
+*       `command`   the output of command, like $(command)
+*       #...        at the start of a word, a comment to the end of line
+*   Variables are not split into several words, except for $@ and $*,
+*   which become a word per positional parameter wherever substitution
+*   output is split; "$@" does too, "$*" stays one word. A word that had
+*   expansions also keeps its text as written, so the executor can expand
+*   it again with lexExpandWord() when a command earlier on the line has
+*   changed $? or $!.
+*
+*   Command substitutions only run in lexExpandWord(), when their command
+*   is about to run; as a line is read they are empty and their word is
+*   marked to be expanded again. There the output of an unquoted one is
+*   split at blanks and newlines into separate words, except in a NAME=
+*   assignment.
+*
+*   A word with an unquoted `*`, `?` or `[...]` is marked as a pattern
+*   for the executor to match against file names. Its text then has a
+*   backslash in front of each wildcard or backslash that was quoted,
+*   escaped or expanded, which only match themselves. The quoted parts of
+*   each word are noted as it is read, so only a pattern pays for that.
+*
+*   A word that starts with an unquoted NAME= is marked as an assignment,
+*   for the parser to tell `NAME=value cmd` from an argument.
+*
+*   Operators: < > >> >& <& << <<- <<< &> &>> | & ; && || ( ). A word of
+*   plain digits directly in front of a redirection (2> or 2>&1) names the
+*   descriptor it applies to.
+*
+*   A line that ends inside quotes or with a backslash is not complete:
+*   the caller joins the next line to it with a newline and lexes the
+*   two again.
+*
+******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+
+#include "arena.h"
+#include "expand.h"
+#include "lex.h"
+
+enum charClass {
+    CC_WORD = 0,    // anything not listed below
+    CC_BLANK,       // space and tab end a word
+    CC_OPERATOR,    // < > | & ; ( )
+    CC_SQUOTE,
+    CC_DQUOTE,
+    CC_BACKSLASH,
+    CC_DOLLAR,
+    CC_BACKQUOTE,
+    CC_GLOB,        // * ? [
+    CC_END          // NUL and newline
+};
+
+static const unsigned char charClasses[256] = {
+    ['\0'] = CC_END,
+    ['\n'] = CC_END,
+    [' '] = CC_BLANK,
+    ['\t'] = CC_BLANK,
+    ['<'] = CC_OPERATOR,
+    ['>'] = CC_OPERATOR,
+    ['|'] = CC_OPERATOR,
+    ['&'] = CC_OPERATOR,
+    [';'] = CC_OPERATOR,
+    ['('] = CC_OPERATOR,
+    [')'] = CC_OPERATOR,
+    ['\''] = CC_SQUOTE,
+    ['"'] = CC_DQUOTE,
+    ['\\'] = CC_BACKSLASH,
+    ['$'] = CC_DOLLAR,
+    ['`'] = CC_BACKQUOTE,
+    ['*'] = CC_GLOB,
+    ['?'] = CC_GLOB,
+    ['['] = CC_GLOB,
+};
+
+#define CLASS(c) (charClasses[(unsigned char)(c)])
+
+// every character that is not CC_WORD or CC_GLOB, for strcspn(); glibc
+// only vectorizes a set of up to 16, so wildcards are looked for apart
+#define WORD_STOP " \t\n<>|&;()'\"\\$`"
+#define GLOB_CHARS "*?["
+
+// quoted or expanded text in the output buffer, as offsets
+struct lexRange {
+    size_t from;
+    size_t to;
+};
+
+struct lexer {
+    struct arena *arena;
+    const struct expandVars *vars;
+    char *out;              // unquoted word text, NUL separated
+    size_t outLength;
+    size_t outSize;
+    struct token *tokens;
+    int numTokens;
+    int tokenCapacity;
+    _Bool expanded;         // the current word had a $ expansion
+    _Bool substituted;      // the current word had a command substitution
+    _Bool fields;           // the current word had a $@ or $* to split
+    _Bool splitting;        // unquoted substitutions and $@ are split into
+                            // words
+    _Bool wild;             // the line has a * ? or [ somewhere
+    _Bool globbing;         // the current word has an unquoted wildcard
+    _Bool open;             // the line ended inside quotes or on a backslash
+    struct lexRange *quotedRanges;  // the parts of the current word that
+    int numRanges;                  // are not, for a pattern to escape
+    int rangeCapacity;
+};
+
+/**
+*
+* static void lexAppend(struct lexer *lexer, const char *text, size_t length)
+*
+* Summary:
+*       Appends text to the word being built, growing the output buffer
+*
+* Parameters:   pointer to the lexer
+*               char* for the text, not NUL terminated
+*               size_t for its length
+*
+* Returns:      nothing.
+*
+**/
+static void lexAppend(struct lexer *lexer, const char *text, size_t length)
+{
+    if (length == 0) {
+        // an empty expansion may have no text at all
+        return;
+    }
+    if (lexer->outLength + length >= lexer->outSize) {
+        size_t newSize = lexer->outSize * 2;
+        while (lexer->outLength + length >= newSize) {
+            newSize *= 2;
+        }
+        lexer->out = arenaGrow(lexer->arena, lexer->out, lexer->outLength, newSize);
+        lexer->outSize = newSize;
+    }
+    memcpy(lexer->out + lexer->outLength, text, length);
+    lexer->outLength += length;
+}
+
+/**
+*
+* static void lexAppendQuoted(struct lexer *lexer, const char *text,
+*                             size_t length)
+*
+* Summary:
+*       Appends quoted or expanded text to the word being built
+*
+* Parameters:   pointer to the lexer
+*               char* for the text, not NUL terminated
+*               size_t for its length
+*
+* Returns:      nothing.
+*
+* Description:
+*       Wildcards in the text only match themselves, but whether the word
+*       is a pattern at all is only known at its end. The text is copied
+*       as it is and its place noted, for lexEndWord() to escape if so.
+*
+**/
+static void lexAppendQuoted(struct lexer *lexer, const char *text, size_t length)
+{
+    lexAppend(lexer, text, length);
+    if (!lexer->wild || length == 0) {
+        // no word of the line can be a pattern
+        return;
+    }
+    size_t from = lexer->outLength - length;
+    if (lexer->numRanges > 0 && lexer->quotedRanges[lexer->numRanges - 1].to == from) {
+        lexer->quotedRanges[lexer->numRanges - 1].to = lexer->outLength;
+        return;
+    }
+    if (lexer->numRanges == lexer->rangeCapacity) {
+        int capacity = lexer->rangeCapacity ? lexer->rangeCapacity * 2 : 8;
+        lexer->quotedRanges = arenaGrow(lexer->arena, lexer->quotedRanges,
+                lexer->rangeCapacity * sizeof(struct lexRange),
+                capacity * sizeof(struct lexRange));
+        lexer->rangeCapacity = capacity;
+    }
+    lexer->quotedRanges[lexer->numRanges].from = from;
+    lexer->quotedRanges[lexer->numRanges].to = lexer->outLength;
+    lexer->numRanges++;
+}
+
+/**
+*
+* static void lexEscapeQuoted(struct lexer *lexer, size_t start)
+*
+* Summary:
+*       Puts a backslash in front of each * ? [ and \ in the quoted parts
+*       of a pattern
+*
+* Parameters:   pointer to the lexer
+*               size_t for the start of the word in the output buffer
+*
+* Returns:      nothing.
+*
+**/
+static void lexEscapeQuoted(struct lexer *lexer, size_t start)
+{
+    char *word = arenaStrndup(lexer->arena, lexer->out + start, lexer->outLength - start);
+    size_t length = lexer->outLength - start;
+    size_t at = 0;
+    lexer->outLength = start;
+    for (int i = 0; i <= lexer->numRanges; i++) {
+        size_t from = (i < lexer->numRanges) ? lexer->quotedRanges[i].from - start : length;
+        size_t to = (i < lexer->numRanges) ? lexer->quotedRanges[i].to - start : length;
+        lexAppend(lexer, word + at, from - at);
+        for (at = from; at < to; at++) {
+            if (CLASS(word[at]) == CC_GLOB || word[at] == '\\') {
+                lexAppend(lexer, "\\", 1);
+            }
+            lexAppend(lexer, word + at, 1);
+        }
+    }
+}
+
+/**
+*
+* static void lexEndWord(struct lexer *lexer, struct token *token,
+*                        size_t start)
+*
+* Summary:
+*       Ends a word built in the output buffer
+*
+* Parameters:   pointer to the lexer
+*               pointer to the word's token
+*               size_t for the start of the word in the output buffer
+*
+* Returns:      nothing.
+*
+**/
+static void lexEndWord(struct lexer *lexer, struct token *token, size_t start)
+{
+    if (lexer->globbing && lexer->numRanges > 0) {
+        lexEscapeQuoted(lexer, start);
+    }
+    token->length = lexer->outLength - start;
+    token->glob = lexer->globbing;
+    lexer->globbing = 0;
+    lexer->numRanges = 0;
+}
+
+/**
+*
+* static struct token *lexPush(struct lexer *lexer, enum tokenType type,
+*                              int fd, const char *text)
+*
+* Summary:
+*       Adds a token to the token array, growing it as needed
+*
+* Parameters:   pointer to the lexer
+*               enum tokenType for the token type
+*               int for the descriptor a redirection applies to
+*               char* for the operator text, NULL for a word
+*
+* Returns:      pointer to the new token
+*
+**/
+static struct token *lexPush(struct lexer *lexer, enum tokenType type, int fd,
+        const char *text)
+{
+    if (lexer->numTokens == lexer->tokenCapacity) {
+        lexer->tokens = arenaGrow(lexer->arena, lexer->tokens,
+                lexer->tokenCapacity * sizeof(struct token),
+                lexer->tokenCapacity * 2 * sizeof(struct token));
+        lexer->tokenCapacity *= 2;
+    }
+    struct token *token = &lexer->tokens[lexer->numTokens++];
+    token->type = type;
+    token->fd = fd;
+    token->text = (char *)text;
+    token->length = text ? strlen(text) : 0;
+    token->quoted = 0;
+    token->source = NULL;
+    token->sourceLength = 0;
+    token->assignment = 0;
+    token->substitutes = 0;
+    token->fields = 0;
+    token->glob = 0;
+    return token;
+}
+
+/**
+*
+* static char *lexOperator(struct lexer *lexer, char *p, int fd)
+*
+* Summary:
+*       Reads one operator
+*
+* Parameters:   pointer to the lexer
+*               char* pointing at the operator
+*               int for a descriptor given in front of a redirection, or -1
+*
+* Returns:      pointer just past the operator
+*
+**/
+static char *lexOperator(struct lexer *lexer, char *p, int fd)
+{
+    switch (*p) {
+        case '<':
+            if (p[1] == '<' && p[2] == '<') {
+                lexPush(lexer, TOKEN_HERESTRING, (fd == -1) ? 0 : fd, "<<<");
+                return p + 3;
+            }
+            if (p[1] == '<' && p[2] == '-') {
+                lexPush(lexer, TOKEN_HEREDOC, (fd == -1) ? 0 : fd, "<<-");
+                return p + 3;
+            }
+            if (p[1] == '<') {
+                lexPush(lexer, TOKEN_HEREDOC, (fd == -1) ? 0 : fd, "<<");
+                return p + 2;
+            }
+            if (p[1] == '&') {
+                lexPush(lexer, TOKEN_DUP, (fd == -1) ? 0 : fd, "<&");
+                return p + 2;
+            }
+            lexPush(lexer, TOKEN_REDIRECT_IN, (fd == -1) ? 0 : fd, "<");
+            return p + 1;
+        case '>':
+            if (p[1] == '>') {
+                lexPush(lexer, TOKEN_APPEND, (fd == -1) ? 1 : fd, ">>");
+                return p + 2;
+            }
+            if (p[1] == '&') {
+                lexPush(lexer, TOKEN_DUP, (fd == -1) ? 1 : fd, ">&");
+                return p + 2;
+            }
+            lexPush(lexer, TOKEN_REDIRECT_OUT, (fd == -1) ? 1 : fd, ">");
+            return p + 1;
+        case '|':
+            if (p[1] == '|') {
+                lexPush(lexer, TOKEN_OR, -1, "||");
+                return p + 2;
+            }
+            lexPush(lexer, TOKEN_PIPE, -1, "|");
+            return p + 1;
+        case '&':
+            if (p[1] == '>' && p[2] == '>') {
+                lexPush(lexer, TOKEN_OUTPUT_ALL, 1, "&>>");
+                return p + 3;
+            }
+            if (p[1] == '>') {
+                lexPush(lexer, TOKEN_OUTPUT_ALL, 1, "&>");
+                return p + 2;
+            }
+            if (p[1] == '&') {
+                lexPush(lexer, TOKEN_AND, -1, "&&");
+                return p + 2;
+            }
+            lexPush(lexer, TOKEN_BACKGROUND, -1, "&");
+            return p + 1;
+        case '(':
+            lexPush(lexer, TOKEN_OPEN, -1, "(");
+            return p + 1;
+        case ')':
+            lexPush(lexer, TOKEN_CLOSE, -1, ")");
+            return p + 1;
+        default:
+            lexPush(lexer, TOKEN_SEMICOLON, -1, ";");
+            return p + 1;
+    }
+}
+
+/**
+*
+* static char *lexBackquoted(struct lexer *lexer, char *p,
+*                            struct expandValue *result)
+*
+* Summary:
+*       Reads a `command` substitution and runs it if running is allowed
+*
+* Parameters:   pointer to the lexer
+*               char* for the opening backquote
+*               pointer to the expandValue that receives the output
+*
+* Returns:      pointer just past the closing backquote, or NULL if
+*               unterminated
+*
+* Description:
+*       Inside the backquotes \`, \\ and \$ stand for the character
+*       itself; the command is run without those backslashes.
+*
+**/
+static char *lexBackquoted(struct lexer *lexer, char *p, struct expandValue *result)
+{
+    char *end = p + 1;
+    while (*end != '`') {
+        if (CLASS(*end) == CC_END) {
+            return NULL;
+        }
+        if (*end == '\\' && CLASS(end[1]) != CC_END) {
+            end++;
+        }
+        end++;
+    }
+
+    result->substituted = 1;
+    result->fields = 0;
+    result->value = NULL;
+    result->length = 0;
+    if (lexer->vars->substitute) {
+        char *command = arenaAlloc(lexer->arena, end - p);
+        size_t length = 0;
+        for (char *c = p + 1; c < end; c++) {
+            if (*c == '\\' && (c[1] == '`' || c[1] == '\\' || c[1] == '$')) {
+                c++;
+            }
+            command[length++] = *c;
+        }
+        result->value = lexer->vars->substitute(command, length, &result->length,
+                lexer->vars->context);
+    }
+    return end + 1;
+}
+
+/**
+*
+* static void lexBreakWord(struct lexer *lexer, size_t *start, _Bool *quoted)
+*
+* Summary:
+*       Ends the word being built where expanded text is split and starts
+*       the next one
+*
+* Parameters:   pointer to the lexer
+*               pointer to the start of the current word in the output
+*                   buffer, moved to the new word
+*               pointer to whether the current word was quoted, cleared
+*                   for the new word
+*
+* Returns:      nothing.
+*
+* Description:
+*       An empty word that was not quoted is not a word: it is left to be
+*       continued instead.
+*
+**/
+static void lexBreakWord(struct lexer *lexer, size_t *start, _Bool *quoted)
+{
+    if (lexer->outLength > *start || *quoted) {
+        struct token *token = lexPush(lexer, TOKEN_WORD, -1, NULL);
+        lexEndWord(lexer, token, *start);
+        token->quoted = *quoted;
+        lexAppend(lexer, "", 1);
+        *start = lexer->outLength;
+        *quoted = 0;
+    }
+}
+
+/**
+*
+* static void lexFields(struct lexer *lexer, size_t *start, _Bool *quoted,
+*                       _Bool inQuotes)
+*
+* Summary:
+*       Appends the positional parameters for a $@ or $*, each in a word
+*       of its own
+*
+* Parameters:   pointer to the lexer
+*               pointer to the start of the current word in the output
+*                   buffer, moved to each new word
+*               pointer to whether the current word was quoted
+*               bool for whether it is a "$@", whose words are all quoted
+*
+* Returns:      nothing.
+*
+* Description:
+*       The first parameter continues the current word and the last one
+*       is continued by what follows. An empty parameter is dropped
+*       unless it is quoted.
+*
+**/
+static void lexFields(struct lexer *lexer, size_t *start, _Bool *quoted, _Bool inQuotes)
+{
+    for (int i = 0; i < lexer->vars->numArgs; i++) {
+        if (i > 0) {
+            lexBreakWord(lexer, start, quoted);
+            *quoted = inQuotes;
+        }
+        lexAppendQuoted(lexer, lexer->vars->args[i], strlen(lexer->vars->args[i]));
+    }
+}
+
+/**
+*
+* static void lexSplit(struct lexer *lexer, const char *value, size_t length,
+*                      size_t *start, _Bool *quoted)
+*
+* Summary:
+*       Appends the output of an unquoted command substitution, ending the
+*       word being built at each run of blanks and newlines in it
+*
+* Parameters:   pointer to the lexer
+*               char* for the output, not NUL terminated
+*               size_t for its length
+*               pointer to the start of the current word in the output
+*                   buffer, moved to each new word
+*               pointer to whether the current word was quoted, cleared
+*                   for each new word
+*
+* Returns:      nothing.
+*
+**/
+static void lexSplit(struct lexer *lexer, const char *value, size_t length,
+        size_t *start, _Bool *quoted)
+{
+    const char *end = value + length;
+    while (value < end) {
+        const char *run = value;
+        while (value < end && *value != ' ' && *value != '\t' && *value != '\n') {
+            value++;
+        }
+        lexAppendQuoted(lexer, run, value - run);
+        if (value == end) {
+            break;
+        }
+        lexBreakWord(lexer, start, quoted);
+        while (value < end && (*value == ' ' || *value == '\t' || *value == '\n')) {
+            value++;
+        }
+    }
+}
+
+/**
+*
+* static char *lexDoubleQuoted(struct lexer *lexer, char *p, size_t *start,
+*                              _Bool *quoted)
+*
+* Summary:
+*       Reads the inside of a double quoted string
+*
+* Parameters:   pointer to the lexer
+*               char* just past the opening quote
+*               pointer to the start of the current word in the output
+*                   buffer, moved to each new word of a "$@"
+*               pointer to whether the current word was quoted
+*
+* Returns:      pointer just past the closing quote, or NULL if unterminated
+*
+**/
+static char *lexDoubleQuoted(struct lexer *lexer, char *p, size_t *start, _Bool *quoted)
+{
+    while (1) {
+        const char *run = p;
+        while (*p && *p != '"' && *p != '\\' && *p != '$' && *p != '`') {
+            p++;
+        }
+        lexAppendQuoted(lexer, run, p - run);
+
+        if (*p == '"') {
+            return p + 1;
+        }
+        else if (*p == '$' || *p == '`') {
+            // quoted output is never split, only "$@" is a word each
+            struct expandValue result;
+            _Bool all = (p[1] == '@');
+            if (*p == '`') {
+                p = lexBackquoted(lexer, p, &result);
+            }
+            else if (p[1] == '(' && !expandCommandEnd(p + 2)) {
+                p = NULL;
+            }
+            else {
+                p = (char *)expandVariable(p, lexer->vars, &result);
+            }
+            if (!p) {
+                return NULL;
+            }
+            if (result.fields && all && lexer->splitting) {
+                lexFields(lexer, start, quoted, 1);
+            }
+            else {
+                lexAppendQuoted(lexer, result.value, result.length);
+            }
+            lexer->expanded = 1;
+            lexer->substituted |= result.substituted;
+            lexer->fields |= result.fields && all;
+        }
+        else if (*p == '\\' && p[1] == '\n') {
+            p += 2;
+        }
+        else if (*p == '\\') {
+            // only these escapes are special inside double quotes
+            if (p[1] == '$' || p[1] == '"' || p[1] == '\\' || p[1] == '`') {
+                p++;
+            }
+            lexAppendQuoted(lexer, p, 1);
+            p++;
+        }
+        else {
+            lexer->open = 1;
+            return NULL;
+        }
+    }
+}
+
+/**
+*
+* static _Bool lexIsNumber(const char *text, size_t length)
+*
+* Summary:
+*       Checks if text is a small descriptor number like the 2 in 2>
+*
+* Parameters:   char* for the text
+*               size_t for its length
+*
+* Returns:      true if it is 1 to 4 digits
+*
+**/
+static _Bool lexIsNumber(const char *text, size_t length)
+{
+    if (length == 0 || length > 4) {
+        return 0;
+    }
+    for (size_t i = 0; i < length; i++) {
+        if (text[i] < '0' || text[i] > '9') {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+*
+* static _Bool lexIsAssignment(const char *p)
+*
+* Summary:
+*       Checks if a word as written starts with an unquoted NAME=
+*
+* Parameters:   char* for the first character of the word
+*
+* Returns:      true if it does
+*
+**/
+static _Bool lexIsAssignment(const char *p)
+{
+    if (!((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') || *p == '_')) {
+        return 0;
+    }
+    do {
+        p++;
+    } while ((*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') || *p == '_'
+            || (*p >= '0' && *p <= '9'));
+    return *p == '=';
+}
+
+/**
+*
+* static void lexFindGlob(struct lexer *lexer, const char *run,
+*                         const char *end, _Bool assignment)
+*
+* Summary:
+*       Marks the word being built as a pattern if an unquoted run of it
+*       has a wildcard
+*
+* Parameters:   pointer to the lexer
+*               char* for the start of the run
+*               char* for its end
+*               bool for whether the word is an assignment, which is never
+*                   a pattern
+*
+* Returns:      nothing.
+*
+**/
+static void lexFindGlob(struct lexer *lexer, const char *run, const char *end,
+        _Bool assignment)
+{
+    if (!lexer->wild || assignment || lexer->globbing) {
+        return;
+    }
+    for (; run < end; run++) {
+        // a [ is only a wildcard if a ] follows in the word
+        if (*run == '*' || *run == '?'
+                || (*run == '[' && run[1 + strcspn(run + 1, "] \t\n<>|&;()")] == ']')) {
+            lexer->globbing = 1;
+            return;
+        }
+    }
+}
+
+/**
+*
+* static char *lexWord(struct lexer *lexer, char *p)
+*
+* Summary:
+*       Reads one word, which may mix plain, quoted and escaped parts
+*
+* Parameters:   pointer to the lexer
+*               char* for the first character of the word
+*
+* Returns:      pointer just past the word, or NULL on an unterminated quote
+*
+* Description:
+*       Most words are plain text ending at a blank or the end of the line.
+*       Those are not copied: the blank is overwritten with a NUL and the
+*       token points into the line itself.
+*
+*       A word of unquoted digits followed directly by `<` or `>` is not
+*       a word at all but the descriptor of the redirection; the operator
+*       is read here so it gets that descriptor.
+*
+**/
+static char *lexWord(struct lexer *lexer, char *p)
+{
+    const char *begin = p;
+    size_t start = lexer->outLength;
+    _Bool quoted = 0;
+    _Bool plain = 1;
+    _Bool assignment = lexIsAssignment(p);
+    _Bool split = 0;        // some output was split off into words
+    lexer->expanded = 0;
+    lexer->substituted = 0;
+    lexer->fields = 0;
+    lexer->globbing = 0;
+    lexer->numRanges = 0;
+
+    if (CLASS(*p) == CC_WORD || CLASS(*p) == CC_GLOB) {
+        char *end = p + strcspn(p, WORD_STOP);
+        char stop = *end;
+        if (CLASS(stop) == CC_BLANK || CLASS(stop) == CC_END) {
+            *end = '\0';
+            if (!lexer->wild || !strpbrk(p, GLOB_CHARS)) {
+                struct token *token = lexPush(lexer, TOKEN_WORD, -1, NULL);
+                token->text = p;
+                token->length = end - p;
+                token->assignment = assignment;
+                return (CLASS(stop) == CC_BLANK) ? end + 1 : end;
+            }
+            *end = stop;
+        }
+        lexFindGlob(lexer, p, end, assignment);
+        lexAppend(lexer, p, end - p);
+        p = end;
+    }
+
+    while (1) {
+        const char *run = p;
+        switch (CLASS(*p)) {
+            case CC_WORD:
+            case CC_GLOB:
+                p += strcspn(p, WORD_STOP);
+                lexFindGlob(lexer, run, p, assignment);
+                lexAppend(lexer, run, p - run);
+                break;
+            case CC_SQUOTE:
+                run = p + 1;
+                p = strchr(run, '\'');
+                if (!p) {
+                    lexer->open = 1;
+                    return NULL;
+                }
+                lexAppendQuoted(lexer, run, p - run);
+                p++;
+                quoted = 1;
+                break;
+            case CC_DQUOTE:
+                quoted = 1;
+                p = lexDoubleQuoted(lexer, p + 1, &start, &quoted);
+                if (!p) {
+                    return NULL;
+                }
+                split |= lexer->fields && lexer->splitting;
+                break;
+            case CC_BACKSLASH:
+                if (p[1] == '\n') {
+                    // a line continuation is no part of the word
+                    p += 2;
+                }
+                else if (p[1] != '\0') {
+                    lexAppendQuoted(lexer, p + 1, 1);
+                    p += 2;
+                    quoted = 1;
+                }
+                else {
+                    // trailing backslash: the word goes on on the next line
+                    lexer->open = 1;
+                    p++;
+                    quoted = 1;
+                }
+                break;
+            case CC_DOLLAR:
+            case CC_BACKQUOTE: {
+                struct expandValue result;
+                if (*p == '`') {
+                    p = lexBackquoted(lexer, p, &result);
+                }
+                else if (p[1] == '(' && !expandCommandEnd(p + 2)) {
+                    p = NULL;
+                }
+                else {
+                    p = (char *)expandVariable(p, lexer->vars, &result);
+                }
+                if (!p) {
+                    return NULL;
+                }
+                if (result.substituted && lexer->splitting && !assignment) {
+                    lexSplit(lexer, result.value, result.length, &start, &quoted);
+                    split = 1;
+                }
+                else if (result.fields && lexer->splitting && !assignment) {
+                    lexFields(lexer, &start, &quoted, 0);
+                    split = 1;
+                }
+                else {
+                    lexAppendQuoted(lexer, result.value, result.length);
+                }
+                lexer->expanded = 1;
+                lexer->substituted |= result.substituted;
+                lexer->fields |= result.fields;
+                plain = 0;
+                break;
+            }
+            default:
+                goto done;
+        }
+    }
+
+done:
+    if (plain && !quoted && (*p == '<' || *p == '>')
+            && lexIsNumber(lexer->out + start, lexer->outLength - start)) {
+        // 2> style redirection: the digits are the descriptor
+        int fd = 0;
+        for (size_t i = start; i < lexer->outLength; i++) {
+            fd = fd * 10 + (lexer->out[i] - '0');
+        }
+        lexer->outLength = start;
+        return lexOperator(lexer, p, fd);
+    }
+
+    if (split && lexer->outLength == start && !quoted) {
+        // output that ended in blanks leaves no word behind
+        return p;
+    }
+    if (split && lexer->vars->numArgs == 0 && p - begin == 4 && memcmp(begin, "\"$@\"", 4) == 0) {
+        // nor does "$@" without parameters
+        return p;
+    }
+
+    // text is set once the word buffer stops moving
+    struct token *token = lexPush(lexer, TOKEN_WORD, -1, NULL);
+    lexEndWord(lexer, token, start);
+    token->quoted = quoted;
+    token->assignment = assignment;
+    token->substitutes = lexer->substituted;
+    token->fields = lexer->fields && !assignment;
+    if (lexer->expanded) {
+        token->source = begin;
+        token->sourceLength = p - begin;
+    }
+    lexAppend(lexer, "", 1);
+    return p;
+}
+
+/**
+*
+* int lexLine(char *line, size_t length, struct arena *arena,
+*             const struct expandVars *vars, struct token **tokens)
+*
+* Summary:
+*       Splits a command line into tokens
+*
+* Parameters:   char* for the NUL terminated line, which is modified
+*               size_t for the length of the line
+*               pointer to the arena tokens and word text are allocated from
+*               pointer to the values for $? and $!
+*               pointer to the token array to set
+*
+* Returns:      number of tokens, LEX_INCOMPLETE when the line ends inside
+*               quotes or with a backslash, or -1 after printing a syntax
+*               error
+*
+* Description:
+*       Plain words point into the line. Other words are built in one
+*       buffer that may move while it grows, so they only record their
+*       lengths while lexing and are pointed at their text once the whole
+*       line has been read.
+*
+**/
+int lexLine(char *line, size_t length, struct arena *arena,
+        const struct expandVars *vars, struct token **tokens)
+{
+    struct lexer lexer = {
+        .arena = arena,
+        .vars = vars,
+        .outSize = length + 64,
+        .tokenCapacity = 16,
+        .wild = (strpbrk(line, GLOB_CHARS) != NULL)
+    };
+    lexer.tokens = arenaAlloc(arena, lexer.tokenCapacity * sizeof(struct token));
+    lexer.out = arenaAlloc(arena, lexer.outSize);
+
+    char *p = line;
+    while (1) {
+        switch (CLASS(*p)) {
+            case CC_BLANK:
+                p++;
+                continue;
+            case CC_OPERATOR:
+                p = lexOperator(&lexer, p, -1);
+                continue;
+            case CC_END:
+                break;
+            default:
+                if (*p == '#') {
+                    // comment: ignore the rest of the line
+                    break;
+                }
+                if (p[0] == '\\' && p[1] == '\n') {
+                    // a line continuation between words
+                    p += 2;
+                    continue;
+                }
+                p = lexWord(&lexer, p);
+                if (!p && !lexer.open) {
+                    printf("syntax error: unterminated quote\n");
+                    fflush(stdout);
+                    return -1;
+                }
+                if (!p) {
+                    break;
+                }
+                continue;
+        }
+        break;
+    }
+    if (lexer.open) {
+        return LEX_INCOMPLETE;
+    }
+
+    // the word buffer is final now: point each word at its text
+    size_t offset = 0;
+    for (int i = 0; i < lexer.numTokens; i++) {
+        struct token *token = &lexer.tokens[i];
+        if (token->type == TOKEN_WORD && !token->text) {
+            token->text = lexer.out + offset;
+            offset += token->length + 1;
+        }
+    }
+
+    *tokens = lexer.tokens;
+    return lexer.numTokens;
+}
+
+/**
+*
+* int lexExpandWord(const struct token *token, struct arena *arena,
+*                   const struct expandVars *vars, struct token **words)
+*
+* Summary:
+*       Expands a word again from the text it was written as
+*
+* Parameters:   pointer to a word token with a source
+*               pointer to the arena the new words are allocated from
+*               pointer to the current values for $? and $!, and the
+*                   callback that runs command substitutions
+*               pointer that receives the array of words
+*
+* Returns:      the number of words: one, unless command substitution
+*               output was split into several or into none
+*
+* Description:
+*       Words are expanded as the line is read. A command that runs after
+*       another one on the same line (a; b, a && b) calls this for its
+*       words that had expansions, so they see the values as they are
+*       when it runs, as does every command with a substitution to run.
+*
+**/
+int lexExpandWord(const struct token *token, struct arena *arena,
+        const struct expandVars *vars, struct token **words)
+{
+    struct lexer lexer = {
+        .arena = arena,
+        .vars = vars,
+        .outSize = token->sourceLength + 64,
+        .tokenCapacity = 1,
+        .splitting = (vars->substitute != NULL),
+        .wild = 1
+    };
+    lexer.tokens = arenaAlloc(arena, sizeof(struct token));
+    lexer.out = arenaAlloc(arena, lexer.outSize);
+
+    // the copy ends where the word does, whatever followed it on the line
+    lexWord(&lexer, arenaStrndup(arena, token->source, token->sourceLength));
+    size_t offset = 0;
+    for (int i = 0; i < lexer.numTokens; i++) {
+        lexer.tokens[i].text = lexer.out + offset;
+        offset += lexer.tokens[i].length + 1;
+    }
+    *words = lexer.tokens;
+    return lexer.numTokens;
+}
@@ -0,0 +1,69 @@
+/*******************************************************************************
+*
+* File:     lex.h
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Interface for the kell-shell lexer, which turns a command line into a
+*   stream of typed tokens with quoting, escaping and variable expansion
+*   already applied.
+*
+******************************************************************************/
+#ifndef LEX_H
+#define LEX_H
+
+#include <stddef.h>
+
+struct arena;
+struct expandVars;
+
+enum tokenType {
+    TOKEN_WORD,
+    TOKEN_REDIRECT_IN,  // [n]<
+    TOKEN_REDIRECT_OUT, // [n]>
+    TOKEN_APPEND,       // [n]>>
+    TOKEN_DUP,          // [n]>& or [n]<&, the target is the next word
+    TOKEN_HEREDOC,      // [n]<< or [n]<<-, the next word is the delimiter
+    TOKEN_HERESTRING,   // [n]<<<
+    TOKEN_OUTPUT_ALL,   // &> or &>>, stdout and stderr together
+    TOKEN_PIPE,         // |
+    TOKEN_BACKGROUND,   // &
+    TOKEN_SEMICOLON,    // ;
+    TOKEN_AND,          // &&
+    TOKEN_OR,           // ||
+    TOKEN_OPEN,         // (
+    TOKEN_CLOSE,        // )
+    TOKEN_NEWLINE       // the end of a line, when a command goes on to
+                        // the next; added by the caller, not lexLine()
+};
+
+struct token {
+    enum tokenType type;
+    int fd;             // descriptor a redirection applies to
+    char *text;         // unquoted, expanded text of a word, or the
+                        // operator itself for every other type
+    size_t length;      // length of text
+    _Bool quoted;       // some part of the word was quoted or escaped
+    const char *source; // a word with $ expansions: its text as written,
+    size_t sourceLength;    // to expand again when it runs; else NULL
+    _Bool assignment;   // a word starting with an unquoted NAME=
+    _Bool substitutes;  // has a $(...) or `...` to run each time it is
+                        // expanded
+    _Bool fields;       // has a $@ or $* that becomes one word per
+                        // positional parameter when expanded again
+    _Bool glob;         // has an unquoted * ? or [...]: text is a pattern,
+                        // in which a backslash escapes each quoted
+                        // wildcard or backslash
+};
+
+// lexLine() result for a line that ends inside quotes or with a backslash
+#define LEX_INCOMPLETE -2
+
+int lexLine(char *line, size_t length, struct arena *arena,
+        const struct expandVars *vars, struct token **tokens);
+int lexExpandWord(const struct token *token, struct arena *arena,
+        const struct expandVars *vars, struct token **words);
+
+#endif
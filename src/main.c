@@ -10,12 +10,34 @@
 *   such as bash. It:
 *       1. Has a prompt `k$: `
 *       2. Can handle comment lines that begin with `#`
-*       3. Expands the variable `$$` to PID
-*       4. Contains 3 built-in commands: `exit`, `cd`, and `status`
-*       5. Can execute non-built-in commands as new processes
-*       6. Works with input `<` and output `>` redirection
-*       7. Supports running background processes with a last argument `&`
-*       8. Uses custom signal handlers for `SIGINT` and `SIGTSTP`
+*       3. Expands `$$` to PID, `$?`, `$!`, shell variables, set with
+*          NAME=value and passed to commands with `export` (see vars.c),
+*          and `$(command)` to the output of the command (see exec.c)
+*       4. Runs built-in commands such as `exit`, `cd`, `status`, `echo`
+*          and `test` inside the shell (see builtins.c)
+*       5. Can execute non-built-in commands as new processes using
+*          posix_spawn, or fork() when KELL_SPAWN=fork
+*       6. Works with `<`, `>`, `>>`, `2>&1`, `&>`, `<<` and `<<<`
+*          redirection and understands quoting and escaping
+*       7. Connects commands into pipelines with `|` and lists with `;`,
+*          `&&` and `||`, and groups them with `( )` and `{ }` (see
+*          exec.c)
+*       8. Runs `if`, `while`, `until` and `for`, defines functions and
+*          sources scripts, keeping the parsed commands of a sourced
+*          file to run again (see script.c)
+*       9. Supports running background processes with `&`
+*      10. Uses custom signal handlers for `SIGINT` and `SIGTSTP`
+*      11. Reports the time and resources a command used with `time`,
+*          `status -v` and the KELL_JOB_LOG job log
+*      12. Edits lines typed at a terminal, with history search and tab
+*          completion (see editor.c)
+*      13. Controls jobs on a terminal: CTRL+Z stops the foreground job,
+*          and `jobs`, `fg`, `bg`, `kill` and `wait` manage them (see
+*          jobs.c)
+*      14. Expands `*`, `?`, `[...]` and `**` wildcards to sorted paths
+*          (see glob.c)
+*      15. Serves commands to clients of a Unix domain socket, each in a
+*          shell of its own (see serve.c)
 * 
 ******************************************************************************/
 #include <stdio.h>
@@ -26,31 +48,48 @@
 #include <unistd.h>     // system calls
 #include <fcntl.h>      // files
 #include <signal.h>     // signal handlers
-
-#define MAX_CHAR 2048 
-#define MAX_ARG 512 
-
-struct process {
-    int processId;
-    struct process *next;
-};
-
-_Bool foregroundOnly = 0;
+#include <limits.h>     // PATH_MAX
+#include <getopt.h>     // getopt_long()
+
+#include <errno.h>
+
+#include "arena.h"      // per-command bump allocator
+#include "builtins.h"   // built-in commands, printStatus()
+#include "input.h"      // inputReadLine()
+#include "jobs.h"       // job table
+#include "events.h"     // epoll/signalfd event loop
+#include "expand.h"     // $ expansion values
+#include "parse.h"      // struct node
+#include "exec.h"       // execLine()
+#include "script.h"     // scriptParse()
+#include "spawn.h"      // spawnSetMode()
+#include "hash.h"       // command path cache
+#include "history.h"    // command history, ! expansion
+#include "editor.h"     // line editor for terminals
+#include "stats.h"      // per-phase latency histograms
+#include "vars.h"       // shell variables and the environment
+#include "serve.h"      // --serve and --connect
+
+struct shellState shell = { 0 };
+_Bool promptShown = 0;  // a prompt is on screen waiting for input
 
 /**
 * 
-* void catchSIGTSTP(int signo) 
+* void toggleForegroundOnly(void) 
 * 
 * Summary: 
-*       Custom ignal handler for SIGTSTP
+*       Toggles foreground only mode when SIGTSTP is received
 * 
-* Parameters:   int for signal number
+* Parameters:   none
 * 				
 * Returns:      nothing.
 *
 * Description:
-*       This signal handler toggles foreground only mode when user enters CTRL+Z
-*       and sends SIGTSTP. Foreground only mode will disable background procs.
+*       Called from the event loop when the user enters CTRL+Z and sends
+*       SIGTSTP. SIGTSTP is read from a signalfd rather than caught by a
+*       handler, so it is safe to use stdio here. Foreground only mode will 
+*       disable background procs. With job control, CTRL+Z only reaches
+*       the shell at the prompt; while a job runs it stops the job.
 * 
 * ---
 *
@@ -69,320 +108,197 @@ _Bool foregroundOnly = 0;
 *   Additional Info: first accessed 9/24/2020
 *
 **/
-void catchSIGTSTP(int signo) 
+void toggleForegroundOnly(void) 
 {
-    if (foregroundOnly) {
-        char *message = "\nExiting foreground-only mode\n";
-        write(STDOUT_FILENO, message, 30);
-        fflush(stdout);
-        foregroundOnly = 0;
+    if (shell.foregroundOnly) {
+        printf("\nExiting foreground-only mode\n");
+        shell.foregroundOnly = 0;
     }
     else {
-        char *message = "\nEntering foreground-only mode (& is now ignored)\n";
-        write(STDOUT_FILENO, message, 50);
-        fflush(stdout);
-        foregroundOnly = 1;
+        printf("\nEntering foreground-only mode (& is now ignored)\n");
+        shell.foregroundOnly = 1;
     }
+    fflush(stdout);
 }
 
 /**
 * 
-* void expandInput(char *str, int pid) 
+* void reportJob(struct job *job)
 * 
 * Summary: 
-*       Replaces all instances of $$ with process id
+*       Prints that a background job is done along with its status, or
+*       that it stopped
 * 
-* Parameters:   char* for the string to expand
-*               int for the process id
+* Parameters:   pointer to the finished or stopped job
 * 				
-* Returns:      nothing. string is modified
-*
-* Description:
-*       This function takes advantage of a while loop and strstr to locate 
-*       all instancees of $$ in the string. It creates a new string to hold
-*       the expanded version and uses strcat to modify the new string.
-*       Finally, it copies the modified string back to the original to 
-*       be returned.
-*
-*       Note: It has been assumed that when instances of $$mare replaced by 
-*       process ID, the length of the command line will not go above 2048 char.
-*       (piazza post @240)
-*
-*       Note: Process ID must be 10 digits or fewer (I believe Linux limits
-*       processid to 2^22 on 64 bit systems but extra room doesn't hurt here).
-* 
-* ---
-*  
-* Elements of this code have been adapted from:
-*
-* - Title: C - how to convert a pointer in an array to an index?
-*   Author: AraK
-*   Date: 4/26/2010
-*   Availability: https://stackoverflow.com/questions/2711653
-*   Additional Info: First accessed 10/26/2020
+* Returns:      nothing. prints message
 *
 **/
-void expandInput(char *str, int pid) 
-{
-    // convert process id from int to string
-    char procId[11]; // 1 extra space for \0
-    sprintf(procId, "%d", pid);
-
-    // locate $$ substring if exists
-    // repeat until there are no substrings containing $$
-    char *loc;
-    while ((loc = strstr(str, "$$"))) {
-        // create copy of input with enough room for pid
-        char *expandedStr = calloc(strlen(str) + strlen(procId) + 1, sizeof(char));
-        strcpy(expandedStr, str);
-
-        // calculate index of initial $ and index after second $ for srtcat
-        size_t startIndex = loc - str;
-        size_t endIndex = startIndex + 2;
-
-        // replace the starting $ with \0 so we can cat and overwrite with pid
-        expandedStr[startIndex] = '\0';	
-        strcat(expandedStr, procId);
-        // sprintf has written trailing \0 to procId so we can 
-        // cat what's left after second $ in original string
-        strcat(expandedStr, str + endIndex);
-
-        // copy the expanded string to the original location and free memory
-        strcpy(str, expandedStr);
-        free(expandedStr);
+void reportJob(struct job *job) {
+    if (promptShown) {
+        // move off the prompt line, handleEvents() prints a new prompt
+        printf("\n");
+        promptShown = 0;
     }
-}
-
-/**
-* 
-* int tokenize(char *str, char *args[], char *io[]) 
-* 
-* Summary: 
-*       Tokenizes user input and locates locations of all user arguments.
-*       Marks end of list with NULL arg.
-* 
-* Parameters:   char* for the user input string
-*               array of char* to hold pointers to individual arguments
-*               array of char* to hold pointers to io files
-* 				
-* Returns:      an int for the number of arguments found
-*
-* Description:
-*       For simplicity, this function does not allocate new memory for tokens, 
-*       rather it simply points to their location in the original string. 
-*       If the original string is altered after this function is called, 
-*       the argument and io arrays will no longer be accurate which could 
-*       lead to invalid memory reads or unexpected behavior. 
-* 
-* ---
-*
-* Elements of the following code have been adapted from:
-*
-* - Title: OSU CS344 course materials including studentsc & sample repl
-*   Author: Unknown
-*   Date: Unknown
-*   Availability: canvas.oregonstate.edu
-*   Additional Info: first accessed 9/24/2020
-*
-* - Kelley Neubauer CS344 Assignment1 & Assignment2
-* 
-**/
-int tokenize(char *str, char *args[], char *io[]) 
-{
-    int count = 0;
-    char *saveptr;
-    char *token = strtok_r(str, " ", &saveptr);
-    while (token != NULL) {
-        if (strcmp(token, "<") == 0) {
-            // redirect input: save name of next token, add neither to arg list
-            token = strtok_r(NULL, " ", &saveptr);
-            io[0] = token;
-        }
-        else if (strcmp(token, ">") == 0) {
-            // redirect output: save name of next token, add neither to arg list
-            token = strtok_r(NULL, " ", &saveptr);
-            io[1] = token;
-        }
-        else {
-            // save token to arg list
-            args[count] = token;
-            count++;
-        }
-        // get next token
-        token = strtok_r(NULL, " ", &saveptr);
+    if (job->stopped) {
+        printJob(job);
+        return;
     }
-    // add NULL terminator so we can find end of list
-    args[count] = NULL;
-
-    return count;
+    printf("background pid %d is done: ", job->jobPid);
+    fflush(stdout);
+    printStatus(job->status);
 }
 
 /**
 * 
-* void printStatus(int status)
+* void printPrompt(void)
 * 
 * Summary: 
-*       Prints an exit status
+*       Prints the shell prompt
 * 
-* Parameters:   an int for the exit status to print
+* Parameters:   none
 * 				
-* Returns:      nothing. prints exit status
-*
-* Description:
-*       This function prints the exit status of the int passed in. It determines
-*       whether termination was normal or by signal and prints the status.
-* 
-* ---
-*
-* Elements of the following code have been adapted from:
-*
-* - Title: OSU CS344 archived lectures: 3.1 Processes
-*   Author: Benjamin Brewster
-*   Date: 4/10/2019
-*   Availability: https://www.youtube.com/channel/UCqiv0C67MA6NOiusl5NLXIQ
-*   Additional Info: first accessed 10/21/2020
+* Returns:      nothing. prints prompt
 *
 **/
-void printStatus(int status) {
-    if (WIFEXITED(status)) {
-        //terminated normally
-        printf("exit value %d\n", WEXITSTATUS(status));
-        fflush(stdout);
-    }
-    else if (WIFSIGNALED(status)) {
-        // terminated by signal
-        printf("terminated by signal %d\n", WTERMSIG(status));
-        fflush(stdout);
-    } 
+void printPrompt(void) {
+    printf("k$: ");
+    fflush(stdout);
+    promptShown = 1;
 }
 
 /**
 * 
-* _Bool backgroundCheck(char *args[], int *numArgs)
+* void handleEvents(int events)
 * 
 * Summary: 
-*       Checks is the last argument in a command is &
+*       Acts on events returned by eventsWait()
 * 
-* Parameters:   array of pointer to char for the argument list
-*               a pointer to int for the number of args in the list
+* Parameters:   int mask of EVENT_CHILD and EVENT_STOP
 * 				
-* Returns:      a bool. 
-*               true if process should run in background
-*               false if process should not run in background
+* Returns:      nothing.
 *
 * Description:
-*       Checks if the last argument is & in a list that has more than one 
-*       argument. If an & is found in the last position, it will be replaced
-*       by NULL and the arg count value will be reduced by one.
+*       SIGTSTP toggles foreground only mode and SIGCHLD reaps finished 
+*       children, reporting background jobs as soon as they are done. If a 
+*       message interrupted the prompt, the prompt is printed again.
 *
 **/
-_Bool backgroundCheck(char *args[], int *numArgs) {
-    if ((*numArgs > 1) && (strcmp(args[*numArgs - 1], "&") == 0)) {
-        // set list end indicator in place of & and reduce count by 1
-        args[*numArgs - 1] = NULL;
-        *numArgs = *numArgs - 1;
+void handleEvents(int events) {
+    _Bool hadPrompt = promptShown;
 
-        return 1;
+    if (events & EVENT_STOP) {
+        toggleForegroundOnly();
+        promptShown = 0;
+    }
+    if (events & EVENT_CHILD) {
+        STATS_TIMER(reapStart);
+        STATS_START(reapStart);
+        jobsReap(reportJob);
+        STATS_STOP(STATS_REAP, reapStart);
     }
-    return 0;
-}
 
-/**
-* 
-* void addProcess(struct process **list, int procId)
-* 
-* Summary: 
-*       Adds a process to a linked list. New process will be added to front.
-* 
-* Parameters:   pointer to pointer to process struct
-*               int for the process id to add
-* 				
-* Returns:      nothing. list is modified
-*
-* ---
-*
-* Elements of the following code have been adapted from:
-*
-* - Title: Linked List | Set 3 (Deleting a node)
-*   Author: Geeks for Geeks
-*   Date: 10/26/2020
-*   Availability: https://www.geeksforgeeks.org/linked-list-set-3-deleting-node/
-*   Additional Info: first accessed 11/2/2020
-*
-**/
-void addProcess(struct process **list, int procId) {
-    struct process *newProcess = malloc(sizeof(struct process));
-    newProcess->processId = procId;
-    newProcess->next = *list;  
-    *list = newProcess;
+    if (hadPrompt && !promptShown) {
+        printPrompt();
+    }
 }
 
+// where scriptParse() gets the lines typed or piped to the shell
+struct commandInput {
+    struct inputReader *reader;
+    struct lineEditor *editor;  // NULL when lines are not edited
+    _Bool pollable;             // wait for input in the event loop
+    struct arena *arena;        // for ! history expansion
+};
+
 /**
 * 
-* void removeProcess(struct process **list, int procId)
+* const char *readCommandLine(struct scriptInput *input,
+*                             enum scriptLine kind, size_t *length)
 * 
 * Summary: 
-*       Removes a specified process id from a linked list, if exists
+*       Reads the next line of input for scriptParse()
 * 
-* Parameters:   pointer to pointer to process struct
-*               int for the process id to remove
+* Parameters:   pointer to the script input, whose context is the
+*                   struct commandInput
+*               enum for what the line is for: a new command, the rest of
+*                   one, or a here-document
+*               pointer to the length to set
 * 				
-* Returns:      nothing.
-*
-* ---
-*
-* Elements of the following code have been adapted from:
-*
-* - Title: Linked List | Set 3 (Deleting a node)
-*   Author: Geeks for Geeks
-*   Date: 10/26/2020
-*   Availability: https://www.geeksforgeeks.org/linked-list-set-3-deleting-node/
-*   Additional Info: first accessed 11/2/2020
+* Returns:      the line, without its newline, or NULL if there is none:
+*               at the end of input, or when a wait for the first line of
+*               a command was interrupted
 *
+* Description:
+*       The first line of a command gets the `k$: ` prompt and waits in
+*       the event loop, reporting finished jobs and SIGTSTP as they
+*       happen; the rest of a command and here-documents get `> `. Lines
+*       that are not part of a here-document go through ! expansion and
+*       into the history.
+* 
 **/
-void removeProcess(struct process **list, int procId) {
-    struct process *prev = NULL;
-    struct process *temp = *list;
-
-    if (temp && temp->processId == procId) {
-        // special case: first item is one to be removed (prev does not exist)
-        *list = temp->next;
-        free(temp);
+const char *readCommandLine(struct scriptInput *input, enum scriptLine kind,
+        size_t *length) {
+    struct commandInput *command = input->context;
+    struct inputReader *reader = command->reader;
+    const char *prompt = (kind == SCRIPT_COMMAND) ? "k$: " : "> ";
+    const char *line;
+    STATS_TIMER(phaseStart);
+
+    if (command->editor) {
+        // the editor prints the prompt and handles events itself
+        STATS_START(phaseStart);
+        line = editorReadLine(command->editor, prompt, length, handleEvents);
+        STATS_STOP(STATS_READ, phaseStart);
+        input->eof = !line;     // CTRL+D
     }
     else {
-        // locate the link if exists
-        while (temp && temp->processId != procId) {
-            prev = temp;
-            temp = temp->next;
+        // print prompt, then sleep until input arrives while reporting 
+        // finished jobs and SIGTSTP as they happen
+        if (reader->interactive) {
+            if (kind == SCRIPT_COMMAND) {
+                printPrompt();
+            }
+            else {
+                printf("%s", prompt);
+                fflush(stdout);
+            }
         }
-
-        if (temp != NULL) {
-            // process id was found, remove the link
-            prev->next = temp->next;
-            free(temp);
+        while (kind == SCRIPT_COMMAND && command->pollable && !inputHasLine(reader)) {
+            int events = eventsWait(-1, 1);
+            handleEvents(events);
+            if (events & EVENT_INPUT) {
+                break;
+            }
         }
+        STATS_START(phaseStart);
+        do {
+            line = inputReadLine(reader, length); // newline is not included
+        } while (!line && kind != SCRIPT_COMMAND && !reader->eof);
+        STATS_STOP(STATS_READ, phaseStart);
+        input->eof = reader->eof;
     }
-}
+    promptShown = 0;
 
-/**
-* 
-* void freeMemory(struct process **list)
-* 
-* Summary: 
-*       Frees all dynamically allocated memory for a linked list of process
-* 
-* Parameters:   pointer to pointer to process struct
-* 				
-* Returns:      nothing.
-*
-**/
-void freeMemory(struct process **list) {
-    struct process *temp = *list;
-    while (temp) {
-        struct process *garbage = temp;
-        temp = temp->next;
-        free(garbage);
+    if (!line || kind == SCRIPT_DOCUMENT || *length == 0 || line[0] == '#'
+            || !historyEnabled()) {
+        return line;
     }
+
+    // show what a ! reference turned into, then remember the line
+    char *text = arenaStrndup(command->arena, line, *length);
+    int historyExpanded = historyExpand(command->arena, &text, length);
+    if (historyExpanded == -1) {
+        // a ! reference to an entry that does not exist, run nothing
+        *length = 0;
+        return "";
+    }
+    if (historyExpanded) {
+        printf("%s\n", text);
+        fflush(stdout);
+    }
+    historyAdd(text, *length);
+    return text;
 }
 
 /**
@@ -392,18 +308,147 @@ void freeMemory(struct process **list) {
 * Summary: 
 *       Program driver. See description at top of file.
 * 
-* Parameters:   none
+* Parameters:   kell-shell [-i] [-c commands | script]
+*               kell-shell --serve socket
+*               kell-shell --connect socket [-c commands]
+*               -c runs the given commands instead of reading stdin
+*               -i prompts for input even if stdin is not a terminal
+*               script runs the commands in the named file
+*               --serve runs the commands of clients of a Unix domain
+*                   socket, each client in a shell of its own
+*               --connect runs commands, or the lines of stdin, in a
+*                   new session of the server at socket
 * 				
-* Returns:      nothing
+* Returns:      the value given to `exit` (0 by default), otherwise the
+*               exit value of the last foreground command when input runs out
+*
+* Description:
+*       The prompt is only printed when reading from a terminal (or with
+*       -i). Scripts, -c strings and piped input are read in large blocks
+*       and split into lines without a prompt or flush per line.
+*
+*       Everything a command needs (its line, the expanded line, argv and
+*       the pipeline) is allocated from one arena that is reset after the
+*       command, so lines and argument lists have no fixed size limit.
+*
+*       A server is set up like any other shell, up to the event loop, so
+*       the sessions it forks start with that done (see serve.c).
 * 
 **/
 int main (int argc, char* argv[])
 {
-    _Bool exitShell = 0;
-    int foregroundStatus = 0;
-    int backgroundStatus = 0;
+    shell.handleEvents = handleEvents;
+
+    struct inputReader reader;
+    _Bool forceInteractive = 0;
+    char *commandString = NULL;
+    char *servePath = NULL;
+    char *connectPath = NULL;
+    static const struct option longOptions[] = {
+        { "serve", required_argument, NULL, 'S' },
+        { "connect", required_argument, NULL, 'C' },
+        { NULL, 0, NULL, 0 }
+    };
+    int opt;
+
+    // stop at the first non-option so script arguments are left alone
+    while ((opt = getopt_long(argc, argv, "+ic:", longOptions, NULL)) != -1) {
+        switch (opt) {
+            case 'i':
+                forceInteractive = 1;
+                break;
+            case 'c':
+                commandString = optarg;
+                break;
+            case 'S':
+                servePath = optarg;
+                break;
+            case 'C':
+                connectPath = optarg;
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-i] [-c commands | script]\n"
+                        "       %s --serve socket\n"
+                        "       %s --connect socket [-c commands]\n",
+                        argv[0], argv[0], argv[0]);
+                return 2;
+        }
+    }
+
+    // a client only passes the command on
+    if (connectPath) {
+        return serveConnect(connectPath, commandString);
+    }
+
+    // $0 and the positional parameters: the script and its arguments,
+    // or what follows -c commands
+    shell.name = argv[0];
+    if (optind < argc) {
+        shell.name = argv[optind];
+        shell.args = argv + optind + 1;
+        shell.numArgs = argc - optind - 1;
+    }
+
+    if (servePath) {
+        // commands come from the clients, not stdin
+        inputOpenString(&reader, "");
+    }
+    else if (commandString) {
+        inputOpenString(&reader, commandString);
+    }
+    else if (optind < argc) {
+        if (inputOpenFile(&reader, argv[optind]) == -1) {
+            int error = errno;
+            fprintf(stderr, "kell-shell: %s: %s\n", argv[optind], strerror(error));
+            // like other shells: 127 if it is not there, 126 if it cannot run
+            return (error == ENOENT) ? 127 : 126;
+        }
+    }
+    else {
+        inputOpenFd(&reader, STDIN_FILENO);
+        reader.interactive = isatty(STDIN_FILENO);
+    }
+    if (forceInteractive) {
+        reader.interactive = 1;
+    }
 
-    struct process *backgroundProcsList = NULL;
+    // the variables start out as the exported environment
+    varsInit(environ);
+
+    // $$ never changes, format it once
+    expandInit(getpid());
+
+    // select posix_spawn or fork() for launching commands
+    char *modeName = getenv("KELL_SPAWN");
+    if (modeName && spawnSetMode(modeName) == -1) {
+        fprintf(stderr, "KELL_SPAWN: unknown mode %s, using %s\n",
+                modeName, spawnModeName(spawnMode));
+    }
+
+    // interactive shells keep a history, KELL_HISTFILE= turns it off
+    if (reader.interactive) {
+        char *historyFile = getenv("KELL_HISTFILE");
+        char defaultFile[PATH_MAX];
+        if (!historyFile && getenv("HOME")) {
+            snprintf(defaultFile, sizeof(defaultFile), "%s/.kell_history", getenv("HOME"));
+            historyFile = defaultFile;
+        }
+        if (historyFile && historyFile[0] && historyOpen(historyFile) == -1) {
+            fprintf(stderr, "kell-shell: history: %s: %s\n", historyFile, strerror(errno));
+        }
+    }
+
+    // optional log of every finished job, one JSON line each
+    char *jobLog = getenv("KELL_JOB_LOG");
+    if (jobLog && jobLog[0] && jobsOpenLog(jobLog) == -1) {
+        fprintf(stderr, "KELL_JOB_LOG: %s: %s\n", jobLog, strerror(errno));
+    }
+
+    // optional pipe buffer size for pipelines
+    char *pipeSizeValue = getenv("KELL_PIPE_SIZE");
+    if (pipeSizeValue) {
+        shell.pipeSize = atoi(pipeSizeValue);
+    }
 
     // register action for parent process to ignore SIGINT
     // source: OSU CS344 course materials: 5_3_siguser.c
@@ -411,210 +456,110 @@ int main (int argc, char* argv[])
     SIGINT_action.sa_handler = SIG_IGN;
     sigaction(SIGINT, &SIGINT_action, NULL);
 
-    // register custom handler for SIGTSTP
-    // source: OSU CS344 course materials: 5_3_siguser.c
-    struct sigaction SIGTSTP_action = {{0}};
-    SIGTSTP_action.sa_handler = catchSIGTSTP;
-    SIGTSTP_action.sa_flags = SA_RESTART;   // auto restart interrupted things
-    sigfillset(&SIGTSTP_action.sa_mask);    // block all catchable while running
-    SIGTSTP_action.sa_flags = 0;            // no flags
-    sigaction(SIGTSTP, &SIGTSTP_action, NULL);
+    // a server runs until it is stopped; each session starts its own
+    // event loop
+    if (servePath) {
+        int serveStatus = serveRun(servePath, &shell);
+        jobsFree();
+        inputClose(&reader);
+        varsFree();
+        return serveStatus;
+    }
 
+    // SIGTSTP and SIGCHLD are delivered through the event loop
+    if (eventsInit() == -1) {
+        perror("kell-shell: event loop");
+        return 1;
+    }
+    // interactive shells on a terminal get job control; KELL_JOB_CONTROL=0
+    // keeps every job in the shell's process group, as before
+    char *jobControlValue = getenv("KELL_JOB_CONTROL");
+    if (reader.interactive && reader.fd != -1 && isatty(reader.fd)
+            && !(jobControlValue && strcmp(jobControlValue, "0") == 0)
+            && jobControlInit(reader.fd) == -1) {
+        fprintf(stderr, "kell-shell: no job control: %s\n", strerror(errno));
+    }
+    // with job control CTRL+C reaches the shell only while a loop runs in
+    // it, and ends the loop
+    if (jobControlEnabled()) {
+        execCatchInterrupts();
+    }
 
-    // repeat shell prompt until exit command is received
-    while (!exitShell) {
-        char buffer[MAX_CHAR + 2]; // 2 extra: one for \n and one for \0
-        char *userInput;
-        char *userArgs[MAX_ARG + 1]; // 1 extra: space for null arg at end
-        int numArgs = 0;
-        char *ioFiles[2] = { NULL };
+    // regular files (script < file) are always readable and cannot be polled
+    _Bool inputPollable = (reader.fd != -1 && eventsWatchInput(reader.fd) == 0);
 
-        _Bool runInBackground = 0;
 
+    // lines typed at a terminal are edited in raw mode, TERM=dumb opts out
+    struct lineEditor editor;
+    char *term = getenv("TERM");
+    _Bool useEditor = inputPollable && reader.interactive && isatty(reader.fd)
+            && !(term && strcmp(term, "dumb") == 0);
+    if (useEditor) {
+        editorInit(&editor, reader.fd);
+    }
 
-        // print prompt and get user input
-        printf("k$: ");
-        fflush(stdout);
-        userInput = fgets(buffer, sizeof(buffer), stdin); // fgets reads \n
+    // memory for one command at a time, reused after the first few lines
+    struct arena commandArena = { 0 };
 
-        if (!userInput) {
-            // if there was an error with fgets, clear it and move on
-            clearerr(stdin);
-        }
-        else if (userInput[0] == '#' || userInput[0] == '\n') {
-            // skip comments and lines with no input
+    // commands are read through scriptParse(), which asks for more lines
+    // until a command is complete
+    struct commandInput command = {
+        &reader, useEditor ? &editor : NULL, inputPollable, &commandArena
+    };
+    struct scriptInput input = { .readLine = readCommandLine, .context = &command };
+
+    // repeat shell prompt until exit command is received
+    while (!shell.exitShell) {
+        // $ words are expanded as they are read, with the current values
+        struct expandVars vars;
+        execVars(&shell, &vars);
+
+        // read, split into tokens and build the tree of the command:
+        // lists, pipelines, compound commands and commands
+        struct node *root;
+        int result = scriptParse(&input, &commandArena, &vars, &root);
+        if (result == 0 && reader.eof && !isatty(reader.fd)) {
+            // out of input: scripts, -c and pipes end here
+            break;
         }
-        else {
-            // remove extraneous newline char read by fgets
-            userInput[strlen(userInput) - 1] = '\0';
-
-            // expand $$ to pid
-            expandInput(userInput, getpid());
-
-            // tokenize input, locate each argument & io files
-            numArgs = tokenize(userInput, userArgs, ioFiles);
-
-            // process the user arguments
-            if (strcmp(userArgs[0], "exit") == 0) {
-                // kill background processes and exit shell
-                struct process *temp = backgroundProcsList;
-                while (temp) {
-                    kill(temp->processId, 1);
-                    temp = temp->next;
-                }
-                exitShell = 1;
-            }
-            else if (strcmp(userArgs[0], "status") == 0) {
-                // print last foreground status
-                printStatus(foregroundStatus);
-            }
-            else if (strcmp(userArgs[0], "cd") == 0) {
-                int result = -1;
-                if (!userArgs[1]) {
-                    // cd is the only command, go to HOME
-                    result = chdir(getenv("HOME"));
-                }
-                else {
-                    result = chdir(userArgs[1]);
-                }
-
-                if (result == -1){
-                    perror("cd error");
-                    fflush(stdout);
-                }
-            }
-            else {
-                // check if process should be run in background (last arg is &)
-                runInBackground = backgroundCheck(userArgs, &numArgs);
-
-                // background processes are not allowed in foreground only mode
-                if (foregroundOnly) { runInBackground = 0; }
-
-                if (runInBackground) {
-                    // if input is not redirected, direct to /dev/null
-                    if (!ioFiles[0]) {
-                        ioFiles[0] = "/dev/null";
-                    }
-                    // if output is not redirected, direct to /dev/null
-                    if (!ioFiles[1]) {
-                        ioFiles[1] = "/dev/null";
-                    }
-                }
-
-                // fork and pass command to exec
-                // source: Benjamin Breswter OSU CS344 lectures: 3.1 Processes
-                pid_t spawnPid = fork();
-
-                switch (spawnPid) {
-                    case -1:
-                        perror("fork()\n");
-                        exit(1);
-                        break;
-                    case 0:
-                        // open files for input & output redirection
-                        // source: OSU CS344 course materials: 5_4_sortViaFiles.c
-
-                        // input redirection. input name is in ioFiles[0]
-                        if (ioFiles[0]) {
-                            // open file as read only
-                            int inputFd = open(ioFiles[0], O_RDONLY);
-                            if (inputFd == -1) {
-                                printf("cannot open %s for input\n", ioFiles[0]);
-                                fflush(stdout);
-                                exit(1);
-                            }
-
-                            // copy file descriptor to stdin. input is 0
-                            int result = dup2(inputFd, 0);
-                            if (result == -1) {
-                                printf("error redirecting stdin to %s\n", ioFiles[0]);
-                                fflush(stdout);
-                                exit(2);
-                            }
-                        }
-                        // output redirection. output name is in ioFiles[1]
-                        if (ioFiles[1]) {
-                            // open file as write only, truncate, create if not exist
-                            int outputFd = open(ioFiles[1], O_WRONLY | O_CREAT | O_TRUNC, 0644);
-                            if (outputFd == -1) {
-                                printf("cannot open %s for output\n", ioFiles[1]);
-                                fflush(stdout);
-                                exit(1);
-                            }
-
-                            // copy file descriptor to stdout. output is 1
-                            int result = dup2(outputFd, 1);
-                            if (result == -1) {
-                                printf("error redirecting stdout to %s\n", ioFiles[1]);
-                                fflush(stdout);
-                                exit(2);
-                            }
-                        }
-
-                        // foreground children do not ignore SIGINT
-                        if (!runInBackground) {
-                            SIGINT_action.sa_handler = SIG_DFL;
-                            sigaction(SIGINT, &SIGINT_action, NULL);
-                        }
-
-                        // all children ignore SIGTSTP
-                        SIGTSTP_action.sa_handler = SIG_IGN;
-                        sigaction(SIGTSTP, &SIGTSTP_action, NULL);
-
-                        // pass the command and args to exec()
-                        execvp(userArgs[0], userArgs);
-
-                        // exec will only make it here on error
-                        printf("%s: no such file or directory\n", userArgs[0]);
-                        fflush(stdout);
-                        exit(1);
-                        break;
-                    default:
-                        if (runInBackground) {
-                            // add child process to list of background processes
-                            addProcess(&backgroundProcsList, spawnPid);
-
-                            printf("background pid is %d\n", spawnPid);
-                            fflush(stdout);
-                        }
-                        else {
-                            // foreground, blocking wait, set foreground status
-                            spawnPid = waitpid(spawnPid, &foregroundStatus, 0);
-
-                            // if foreground child is terminated by signal, print status immediately
-                            if (WIFSIGNALED(foregroundStatus)) {
-                                printStatus(foregroundStatus);
-                            }
-                        }
-                        break;
-                } 
-            } 
-        } 
-
-        // reap all zombie children that have finished with nonblocking wait call
-        // waitpid(-1,.. ) does not work properly with the grading script 
-        // so I've switched to iterating through the backgroundProcsList
-        // source: Michael Kerrisk - The Linux Programming Interface pg. 557-558
-        struct process *temp = backgroundProcsList;
-        while (temp) {
-            if (waitpid(temp->processId, &backgroundStatus, WNOHANG) > 0) {
-                printf("background pid %d is done: ", temp->processId);
-                fflush(stdout);
-                printStatus(backgroundStatus);
 
-                // remove process and move to next while preventing invalid reads
-                int deletePid = temp->processId;
-                temp = temp->next;
-                removeProcess(&backgroundProcsList, deletePid);
-            }
-            else {
-                temp = temp->next;
-            }
+        // nothing to run after a syntax error, spaces or a comment
+        if (result == -1) {
+            shell.foregroundStatus = W_EXITCODE(2, 0);
         }
+        else if (root) {
+            execLine(root, &commandArena, &shell);
+        }
+
+        // the command is done with its memory
+        arenaReset(&commandArena);
+
+        // pick up anything that happened while the command ran
+        handleEvents(eventsWait(0, 0));
     } 
 
-    // free memory associated with background process linked list
-    freeMemory(&backgroundProcsList);
+    // KELL_SHSTATS asks for the phase statistics on the way out
+    char *statsDestination = getenv("KELL_SHSTATS");
+    if (statsDestination && statsDestination[0]) {
+        statsDump(statsDestination);
+    }
 
-    return 0;
+    // free memory associated with the background job table
+    jobsFree();
+    eventsFree();
+    hashFree();
+    scriptFree();
+    historyClose();
+    if (useEditor) {
+        editorFree(&editor);
+    }
+    arenaFree(&commandArena);
+    inputClose(&reader);
+    varsFree();
+
+    if (shell.exitShell) {
+        return shell.exitStatus;
+    }
+    // ran out of input: exit with the status of the last foreground command
+    return exitValue(shell.foregroundStatus);
 }
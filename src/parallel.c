@@ -0,0 +1,326 @@
+/*******************************************************************************
+*
+* File:     parallel.c
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   The `parallel` built-in for kell-shell:
+*
+*       parallel [-j N] [-k] command [arg...] ::: input...
+*
+*   runs command once per input with at most N copies alive at a time (N
+*   defaults to the number of online CPUs). Every `{}` in the command is
+*   replaced by the input; without one the input is appended as the last
+*   argument.
+*
+*   The pool is driven by the shell's event loop: the built-in sleeps in
+*   eventsWait() and, as soon as the SIGCHLD for a finished job has been
+*   reaped, starts the next input in its slot. Output goes straight to the
+*   terminal, or with -k to a memfd per job that is copied out in input
+*   order once every earlier job has been printed.
+*
+*   The exit value is the number of jobs that failed, at most 253, so it
+*   shows up in `status` and $? like any other command.
+*
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+#include "builtins.h"
+#include "events.h"     // eventsWait()
+#include "hash.h"       // hashSpawn()
+#include "jobs.h"
+#include "parallel.h"
+#include "spawn.h"
+#include "vars.h"
+
+#define PARALLEL_MAX_FAILED 253
+
+struct parallelSlot {
+    struct job *job;    // NULL while the slot is free
+    int input;          // index of the input the job is running
+};
+
+struct parallelOutput {
+    int fd;             // memfd holding the output, -1 once printed
+    _Bool done;
+};
+
+/**
+*
+* static char *parallelSubstitute(const char *word, const char *input)
+*
+* Summary:
+*       Replaces every `{}` in a word with the input
+*
+* Parameters:   char* for the template word
+*               char* for the input
+*
+* Returns:      newly allocated word, or NULL if it holds no `{}`
+*
+**/
+static char *parallelSubstitute(const char *word, const char *input)
+{
+    const char *mark = strstr(word, "{}");
+    if (!mark) {
+        return NULL;
+    }
+
+    size_t inputLength = strlen(input);
+    size_t length = strlen(word);
+    for (const char *p = mark; p; p = strstr(p + 2, "{}")) {
+        length += inputLength;
+    }
+
+    char *result = malloc(length + 1);
+    char *out = result;
+    const char *p = word;
+    while (mark) {
+        memcpy(out, p, mark - p);
+        out += mark - p;
+        memcpy(out, input, inputLength);
+        out += inputLength;
+        p = mark + 2;
+        mark = strstr(p, "{}");
+    }
+    strcpy(out, p);
+    return result;
+}
+
+/**
+*
+* static void parallelFlush(struct parallelOutput *outputs, int numInputs,
+*                           int *nextToPrint)
+*
+* Summary:
+*       Copies finished job output to stdout, in input order
+*
+* Parameters:   array of per-input output buffers
+*               int for the number of inputs
+*               pointer to int for the first input not yet printed
+*
+* Returns:      nothing.
+*
+**/
+static void parallelFlush(struct parallelOutput *outputs, int numInputs,
+        int *nextToPrint)
+{
+    char buffer[65536];
+
+    fflush(stdout);
+    while (*nextToPrint < numInputs && outputs[*nextToPrint].done) {
+        struct parallelOutput *output = &outputs[*nextToPrint];
+        if (output->fd != -1) {
+            off_t offset = 0;
+            ssize_t n;
+            while ((n = pread(output->fd, buffer, sizeof(buffer), offset)) > 0) {
+                if (write(STDOUT_FILENO, buffer, n) != n) {
+                    break;
+                }
+                offset += n;
+            }
+            close(output->fd);
+            output->fd = -1;
+        }
+        (*nextToPrint)++;
+    }
+}
+
+/**
+*
+* static struct job *parallelStart(char *argv[], int argc, const char *input,
+*                                  int outputFd)
+*
+* Summary:
+*       Starts the command for one input
+*
+* Parameters:   array of char* for the command template
+*               int for the number of template arguments
+*               char* for the input
+*               int for the descriptor to use as stdout, or -1
+*
+* Returns:      the job tracking the child, or NULL if it could not start
+*
+**/
+static struct job *parallelStart(char *argv[], int argc, const char *input,
+        int outputFd)
+{
+    char *words[argc + 2];
+    char *substituted[argc];
+    _Bool found = 0;
+
+    for (int i = 0; i < argc; i++) {
+        substituted[i] = parallelSubstitute(argv[i], input);
+        words[i] = substituted[i] ? substituted[i] : argv[i];
+        found = found || substituted[i];
+    }
+    words[argc] = found ? NULL : (char *)input;
+    words[argc + 1] = NULL;
+
+    struct spawnRequest request = {
+        .argv = words,
+        .envp = varsEnviron(),
+        .inputFd = -1,
+        .outputFd = outputFd,
+        .defaultSIGINT = 1
+    };
+    enum spawnFailure failure;
+    struct job *job = jobCreate(0);
+    pid_t pid = hashSpawn(&request, NULL, &failure);
+    if (pid == -1) {
+        spawnPrintError(&request, failure);
+        jobDelete(job);
+        job = NULL;
+    }
+    else {
+        jobSetCommand(job, words);
+        jobAddProcess(job, pid, 1);
+    }
+
+    // the child has its own copy of the arguments now
+    for (int i = 0; i < argc; i++) {
+        free(substituted[i]);
+    }
+    return job;
+}
+
+/**
+*
+* int parallelRun(char *argv[], int argc, struct shellState *shell)
+*
+* Summary:
+*       The `parallel` built-in, see the description at the top of the file
+*
+* Parameters:   array of char* for the arguments
+*               int for the number of arguments
+*               pointer to the shell state
+*
+* Returns:      the number of failed jobs, at most 253, or 2 on usage errors
+*
+**/
+int parallelRun(char *argv[], int argc, struct shellState *shell)
+{
+    long maxJobs = sysconf(_SC_NPROCESSORS_ONLN);
+    _Bool keepOrder = 0;
+    int i = 1;
+
+    for (; i < argc && argv[i][0] == '-'; i++) {
+        if (strcmp(argv[i], "-k") == 0) {
+            keepOrder = 1;
+        }
+        else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            maxJobs = atol(argv[++i]);
+        }
+        else if (strncmp(argv[i], "-j", 2) == 0 && argv[i][2]) {
+            maxJobs = atol(argv[i] + 2);
+        }
+        else {
+            break;
+        }
+    }
+
+    int commandStart = i;
+    while (i < argc && strcmp(argv[i], ":::") != 0) {
+        i++;
+    }
+    int commandArgc = i - commandStart;
+    if (commandArgc == 0 || i == argc || maxJobs < 1) {
+        printf("parallel: usage: parallel [-j N] [-k] command [arg...] ::: input...\n");
+        return 2;
+    }
+
+    char **inputs = argv + i + 1;
+    int numInputs = argc - i - 1;
+    if (maxJobs > numInputs) {
+        maxJobs = numInputs;
+    }
+
+    struct parallelSlot *slots = calloc(maxJobs, sizeof(struct parallelSlot));
+    struct parallelOutput *outputs = NULL;
+    if (keepOrder) {
+        outputs = calloc(numInputs, sizeof(struct parallelOutput));
+        for (int n = 0; n < numInputs; n++) {
+            outputs[n].fd = -1;
+        }
+    }
+
+    int nextInput = 0;
+    int nextToPrint = 0;
+    int running = 0;
+    int failed = 0;
+
+    fflush(stdout);
+    while (nextInput < numInputs || running > 0) {
+        // fill every free slot
+        for (int s = 0; s < maxJobs && nextInput < numInputs; s++) {
+            if (slots[s].job) {
+                continue;
+            }
+            int input = nextInput++;
+            int outputFd = -1;
+            if (keepOrder) {
+                outputFd = memfd_create("parallel", MFD_CLOEXEC);
+                outputs[input].fd = outputFd;
+            }
+
+            slots[s].job = parallelStart(argv + commandStart, commandArgc,
+                    inputs[input], outputFd);
+            slots[s].input = input;
+            if (slots[s].job) {
+                running++;
+            }
+            else {
+                failed++;
+                if (keepOrder) {
+                    outputs[input].done = 1;
+                }
+            }
+        }
+        if (keepOrder) {
+            parallelFlush(outputs, numInputs, &nextToPrint);
+        }
+        if (running == 0) {
+            continue;
+        }
+
+        // sleep until a child exits, then free its slot
+        shell->handleEvents(eventsWait(-1, 0));
+        for (int s = 0; s < maxJobs; s++) {
+            struct job *job = slots[s].job;
+            if (!job || !job->done) {
+                continue;
+            }
+            if (!WIFEXITED(job->status) || WEXITSTATUS(job->status) != 0) {
+                failed++;
+            }
+            if (WIFSIGNALED(job->status) && WTERMSIG(job->status) == SIGINT) {
+                // CTRL+C: let running jobs finish but start no more
+                nextInput = numInputs;
+            }
+            if (keepOrder) {
+                outputs[slots[s].input].done = 1;
+            }
+            jobDelete(job);
+            slots[s].job = NULL;
+            running--;
+        }
+    }
+
+    if (keepOrder) {
+        // inputs skipped after CTRL+C have nothing to print
+        for (int n = nextToPrint; n < numInputs; n++) {
+            outputs[n].done = 1;
+        }
+        parallelFlush(outputs, numInputs, &nextToPrint);
+        free(outputs);
+    }
+    free(slots);
+    return (failed > PARALLEL_MAX_FAILED) ? PARALLEL_MAX_FAILED : failed;
+}
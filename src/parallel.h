@@ -0,0 +1,20 @@
+/*******************************************************************************
+*
+* File:     parallel.h
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Interface for the kell-shell `parallel` built-in, which fans a command
+*   out over a list of inputs with a bounded number of jobs at a time.
+*
+******************************************************************************/
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+struct shellState;
+
+int parallelRun(char *argv[], int argc, struct shellState *shell);
+
+#endif
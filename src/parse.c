@@ -0,0 +1,1167 @@
+/*******************************************************************************
+*
+* File:     parse.c
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Command line parser for kell-shell. Turns the tokens of a line into a
+*   tree of pipelines, each a list of commands with their own argument
+*   lists and io redirection. A recursive descent over the grammar
+*       list     := andOr ((';' | '&' | NL) andOr)* [';' | '&'] NL*
+*       andOr    := pipeline (('&&' | '||') NL* pipeline)*
+*       pipeline := ['time'] command ('|' NL* command)*
+*       command  := simple | compound redirects | function
+*       compound := '(' list ')' | '{' list '}'
+*                 | 'if' list 'then' list ('elif' list 'then' list)*
+*                       ['else' list] 'fi'
+*                 | ('while' | 'until') list 'do' list 'done'
+*                 | 'for' name [NL* 'in' word*] (';' | NL)* 'do' list 'done'
+*       function := name '(' ')' NL* compound
+*                 | 'function' name ['(' ')'] NL* compound
+*   where the reserved words are only keywords as unquoted words where a
+*   command could start. An and-or list other than a single pipeline that
+*   is sent to the background becomes a subshell, so every background job
+*   is a pipeline.
+*
+*   NL is the end of a line when a command goes on past it. A line that
+*   ends inside a command is not an error: parseLine() returns
+*   PARSE_INCOMPLETE and the caller parses it again with the next line.
+*
+******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+
+#include "arena.h"
+#include "lex.h"
+#include "parse.h"
+#include "redirect.h"
+
+/**
+*
+* static int syntaxError(const struct token *near)
+*
+* Summary:
+*       Reports a token the parser did not expect
+*
+* Parameters:   pointer to the token, or NULL for the end of the line
+*
+* Returns:      -1, for the caller to return
+*
+**/
+static int syntaxError(const struct token *near)
+{
+    printf("syntax error near unexpected token `%s'\n",
+            (near && near->type != TOKEN_NEWLINE) ? near->text : "newline");
+    fflush(stdout);
+    return -1;
+}
+
+/**
+*
+* static int parseDescriptor(const char *text)
+*
+* Summary:
+*       Reads the descriptor named after `>&` or `<&`
+*
+* Parameters:   char* for the word
+*
+* Returns:      the descriptor, or -1 if the word is not a small number
+*
+**/
+static int parseDescriptor(const char *text)
+{
+    int fd = 0;
+    if (!text[0] || strlen(text) > 4) {
+        return -1;
+    }
+    for (const char *p = text; *p; p++) {
+        if (*p < '0' || *p > '9') {
+            return -1;
+        }
+        fd = fd * 10 + (*p - '0');
+    }
+    return fd;
+}
+
+/**
+*
+* static int parseRedirect(struct token *token, struct token *next,
+*                          struct arena *arena, struct redirect *steps)
+*
+* Summary:
+*       Turns one redirection operator and its word into plan steps
+*
+* Parameters:   pointer to the operator token
+*               pointer to the word after it
+*               pointer to the arena, for here-string contents
+*               pointer to room for two steps
+*
+* Returns:      the number of steps written, or -1 after printing an error
+*
+* Description:
+*       `&>` and `>&file` send stdout to the file and then make stderr a
+*       copy of it, as two steps. The word after `<<` holds the contents
+*       of the here-document, which the shell reads in place of the
+*       delimiter before the line is parsed.
+*
+**/
+static int parseRedirect(struct token *token, struct token *next,
+        struct arena *arena, struct redirect *steps)
+{
+    memset(steps, 0, 2 * sizeof(struct redirect));
+    steps[0].fd = token->fd;
+    steps[0].text = next->text;
+    steps[0].action = REDIRECT_OPEN;
+
+    switch (token->type) {
+        case TOKEN_REDIRECT_IN:
+            steps[0].flags = O_RDONLY;
+            return 1;
+        case TOKEN_REDIRECT_OUT:
+            steps[0].flags = O_WRONLY | O_CREAT | O_TRUNC;
+            return 1;
+        case TOKEN_APPEND:
+            steps[0].flags = O_WRONLY | O_CREAT | O_APPEND;
+            return 1;
+        case TOKEN_HEREDOC:
+            steps[0].action = REDIRECT_DOCUMENT;
+            steps[0].length = next->length;
+            return 1;
+        case TOKEN_HERESTRING: {
+            // the word and a newline
+            char *text = arenaAlloc(arena, next->length + 2);
+            memcpy(text, next->text, next->length);
+            text[next->length] = '\n';
+            text[next->length + 1] = '\0';
+            steps[0].action = REDIRECT_DOCUMENT;
+            steps[0].text = text;
+            steps[0].length = next->length + 1;
+            return 1;
+        }
+        case TOKEN_DUP:
+            if (strcmp(next->text, "-") == 0) {
+                steps[0].action = REDIRECT_CLOSE;
+                return 1;
+            }
+            steps[0].source = parseDescriptor(next->text);
+            if (steps[0].source != -1) {
+                steps[0].action = REDIRECT_DUP;
+                return 1;
+            }
+            if (token->fd != 1 || token->text[0] != '>') {
+                printf("%s: bad file descriptor\n", next->text);
+                fflush(stdout);
+                return -1;
+            }
+            // >&file is &>file
+            steps[0].flags = O_WRONLY | O_CREAT | O_TRUNC;
+            break;
+        default:
+            // &> or &>>
+            steps[0].flags = O_WRONLY | O_CREAT
+                    | (token->length == 3 ? O_APPEND : O_TRUNC);
+            break;
+    }
+    steps[1].action = REDIRECT_DUP;
+    steps[1].fd = 2;
+    steps[1].source = 1;
+    return 2;
+}
+
+struct parser {
+    struct token *tokens;
+    int numTokens;
+    int pos;                // next token to read
+    struct arena *arena;
+    _Bool incomplete;       // ran out of tokens inside a command
+};
+
+static int parseList(struct parser *parser, struct node **list);
+static int parseStage(struct parser *parser, struct command *cmd);
+
+/**
+*
+* static struct token *parsePeek(struct parser *parser)
+*
+* Summary:
+*       Returns the next token without consuming it, or NULL at the end
+*
+**/
+static struct token *parsePeek(struct parser *parser)
+{
+    return (parser->pos < parser->numTokens) ? &parser->tokens[parser->pos] : NULL;
+}
+
+/**
+*
+* static _Bool parseIsKeyword(const struct token *token, const char *word)
+*
+* Summary:
+*       Checks if a token is the given keyword: an unquoted word written
+*       exactly as it, not the result of an expansion
+*
+**/
+static _Bool parseIsKeyword(const struct token *token, const char *word)
+{
+    return token && token->type == TOKEN_WORD && token->text[0] == word[0]
+            && !token->quoted && !token->source && strcmp(token->text, word) == 0;
+}
+
+/**
+*
+* static _Bool parseIsRedirect(const struct token *token)
+*
+* Summary:
+*       Checks if a token is a redirection operator
+*
+**/
+static _Bool parseIsRedirect(const struct token *token)
+{
+    switch (token->type) {
+        case TOKEN_REDIRECT_IN:
+        case TOKEN_REDIRECT_OUT:
+        case TOKEN_APPEND:
+        case TOKEN_DUP:
+        case TOKEN_HEREDOC:
+        case TOKEN_HERESTRING:
+        case TOKEN_OUTPUT_ALL:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/**
+*
+* static _Bool parseListEnd(struct parser *parser)
+*
+* Summary:
+*       Checks if the next token ends a list: the end of the line, `)`,
+*       or a reserved word that closes or continues a compound command
+*       where a command could start
+*
+**/
+static _Bool parseListEnd(struct parser *parser)
+{
+    struct token *token = parsePeek(parser);
+    if (!token || token->type == TOKEN_CLOSE) {
+        return 1;
+    }
+    if (token->type != TOKEN_WORD || token->quoted || token->source) {
+        return 0;
+    }
+    switch (token->text[0]) {
+        case '}':
+            return token->text[1] == '\0';
+        case 't':
+            return strcmp(token->text, "then") == 0;
+        case 'e':
+            return strcmp(token->text, "elif") == 0 || strcmp(token->text, "else") == 0;
+        case 'f':
+            return strcmp(token->text, "fi") == 0;
+        case 'd':
+            return strcmp(token->text, "do") == 0 || strcmp(token->text, "done") == 0;
+        default:
+            return 0;
+    }
+}
+
+/**
+*
+* static void parseNewlines(struct parser *parser)
+*
+* Summary:
+*       Moves past line ends, which may come before any command
+*
+**/
+static void parseNewlines(struct parser *parser)
+{
+    while (parser->pos < parser->numTokens
+            && parser->tokens[parser->pos].type == TOKEN_NEWLINE) {
+        parser->pos++;
+    }
+}
+
+/**
+*
+* static int parseUnexpected(struct parser *parser, const struct token *token)
+*
+* Summary:
+*       Reports a token where something else was needed
+*
+* Parameters:   pointer to the parser
+*               pointer to the token, NULL at the end of the tokens
+*
+* Returns:      -1, for the caller to return
+*
+* Description:
+*       Running out of tokens is not an error: the command goes on in
+*       the next line, so the parser is only marked incomplete.
+*
+**/
+static int parseUnexpected(struct parser *parser, const struct token *token)
+{
+    if (!token) {
+        parser->incomplete = 1;
+        return -1;
+    }
+    return syntaxError(token);
+}
+
+/**
+*
+* static int parseExpect(struct parser *parser, const char *keyword)
+*
+* Summary:
+*       Consumes a reserved word that must come next
+*
+* Returns:      0 on success, -1 after printing an error
+*
+**/
+static int parseExpect(struct parser *parser, const char *keyword)
+{
+    struct token *token = parsePeek(parser);
+    if (!parseIsKeyword(token, keyword)) {
+        return parseUnexpected(parser, token);
+    }
+    parser->pos++;
+    return 0;
+}
+
+/**
+*
+* static struct node *parseNode(struct parser *parser, enum nodeType type,
+*                               struct node *left, struct node *right)
+*
+* Summary:
+*       Allocates a tree node from the command arena
+*
+**/
+static struct node *parseNode(struct parser *parser, enum nodeType type,
+        struct node *left, struct node *right)
+{
+    struct node *node = arenaAlloc(parser->arena, sizeof(struct node));
+    memset(node, 0, sizeof(struct node));
+    node->type = type;
+    node->left = left;
+    node->right = right;
+    return node;
+}
+
+/**
+*
+* static struct node *parseWrap(struct parser *parser, struct command **cmd)
+*
+* Summary:
+*       Makes a pipeline node of a single command
+*
+* Parameters:   pointer to the parser
+*               pointer that receives the cleared command to fill in
+*
+* Returns:      the new node
+*
+**/
+static struct node *parseWrap(struct parser *parser, struct command **cmd)
+{
+    struct node *node = parseNode(parser, NODE_PIPELINE, NULL, NULL);
+    node->pipeline.commands = arenaAlloc(parser->arena, sizeof(struct command));
+    node->pipeline.numCommands = 1;
+    memset(node->pipeline.commands, 0, sizeof(struct command));
+    *cmd = node->pipeline.commands;
+    return node;
+}
+
+/**
+*
+* static char **parseText(struct parser *parser, int start)
+*
+* Summary:
+*       Makes a NULL terminated list of the token texts from start up to
+*       the next token, shown by `jobs` for commands that have no argv
+*
+**/
+static char **parseText(struct parser *parser, int start)
+{
+    int count = parser->pos - start;
+    char **text = arenaAlloc(parser->arena, (count + 1) * sizeof(char *));
+    for (int i = 0; i < count; i++) {
+        text[i] = parser->tokens[start + i].text;
+    }
+    text[count] = NULL;
+    return text;
+}
+
+/**
+*
+* static int parseSkip(struct parser *parser, _Bool words, struct command *cmd)
+*
+* Summary:
+*       Moves past the words and redirections of one command
+*
+* Parameters:   pointer to the parser
+*               bool for whether words belong to the command, false after
+*                   the `)` or `}` of a compound command
+*               pointer to the command, whose expands, substitutes,
+*                   fields and globs are set if a word has a $ expansion,
+*                   a command substitution, a $@ or a wildcard
+*
+* Returns:      the number of tokens skipped, or -1 after printing an error
+*
+**/
+static int parseSkip(struct parser *parser, _Bool words, struct command *cmd)
+{
+    struct token *tokens = parser->tokens;
+    int start = parser->pos;
+    int i = start;
+    while (i < parser->numTokens) {
+        if (tokens[i].type == TOKEN_WORD && words) {
+            cmd->expands |= (tokens[i].source != NULL);
+            cmd->substitutes |= tokens[i].substitutes;
+            cmd->fields |= tokens[i].fields;
+            cmd->globs |= tokens[i].glob;
+            i++;
+        }
+        else if (parseIsRedirect(&tokens[i])) {
+            if (i + 1 == parser->numTokens || tokens[i + 1].type != TOKEN_WORD) {
+                return syntaxError((i + 1 < parser->numTokens) ? &tokens[i + 1] : NULL);
+            }
+            cmd->expands |= (tokens[i + 1].source != NULL);
+            cmd->substitutes |= tokens[i + 1].substitutes;
+            cmd->fields |= tokens[i + 1].fields;
+            cmd->globs |= (tokens[i + 1].glob && tokens[i].type != TOKEN_HEREDOC);
+            i += 2;
+        }
+        else {
+            break;
+        }
+    }
+    parser->pos = i;
+    return i - start;
+}
+
+/**
+*
+* int parseCommand(struct command *cmd, struct arena *arena)
+*
+* Summary:
+*       Builds the argument list and redirection plan of a simple command
+*       from its tokens. The argument list is marked at its end with a
+*       NULL arg.
+*
+* Parameters:   pointer to the command, with its tokens set
+*               pointer to the arena the argument and step arrays are
+*                   allocated from
+*
+* Returns:      an int for the number of arguments found, or -1 if the
+*               command is not valid
+*
+* Description:
+*       Arguments point at the word text owned by the tokens; nothing is
+*       copied, and there is no limit on the number of arguments. The
+*       executor calls this again when it has expanded the words anew.
+*
+*       NAME=value words in front of the first argument are assignments,
+*       kept apart from the argument list.
+*
+* ---
+*
+* Elements of the following code have been adapted from:
+*
+* - Title: OSU CS344 course materials including studentsc & sample repl
+*   Author: Unknown
+*   Date: Unknown
+*   Availability: canvas.oregonstate.edu
+*   Additional Info: first accessed 9/24/2020
+*
+* - Kelley Neubauer CS344 Assignment1 & Assignment2
+*
+**/
+int parseCommand(struct command *cmd, struct arena *arena)
+{
+    struct redirect *steps = NULL;
+
+    cmd->argv = arenaAlloc(arena, (cmd->numTokens + 1) * sizeof(char *));
+    cmd->argc = 0;
+    cmd->assigns = NULL;
+    cmd->numAssigns = 0;
+    cmd->redirects = NULL;
+    cmd->numRedirects = 0;
+
+    for (int i = 0; i < cmd->numTokens; i++) {
+        struct token *token = &cmd->tokens[i];
+        struct token *next = (i + 1 < cmd->numTokens) ? &cmd->tokens[i + 1] : NULL;
+
+        if (token->type == TOKEN_WORD && token->assignment && cmd->argc == 0) {
+            if (!cmd->assigns) {
+                cmd->assigns = arenaAlloc(arena, cmd->numTokens * sizeof(char *));
+            }
+            cmd->assigns[cmd->numAssigns++] = token->text;
+            continue;
+        }
+        if (token->type == TOKEN_WORD) {
+            // save token to arg list
+            cmd->argv[cmd->argc++] = token->text;
+            continue;
+        }
+
+        // add the steps to the plan, neither token to the arg list
+        if (!next || next->type != TOKEN_WORD) {
+            return syntaxError(next);
+        }
+        if (!steps) {
+            // an operator and its word make at most two steps
+            steps = arenaAlloc(arena, cmd->numTokens * sizeof(struct redirect));
+            cmd->redirects = steps;
+        }
+        int added = parseRedirect(token, next, arena, steps);
+        if (added == -1) {
+            return -1;
+        }
+        steps += added;
+        cmd->numRedirects += added;
+        i++;
+    }
+    // add NULL terminator so we can find end of list
+    cmd->argv[cmd->argc] = NULL;
+    return cmd->argc;
+}
+
+/**
+*
+* int parseRedirects(struct command *cmd, struct arena *arena)
+*
+* Summary:
+*       Builds the redirection plan of a compound command from its tokens
+*
+* Parameters:   pointer to the command, with its redirection tokens set
+*               pointer to the arena the plan is allocated from
+*
+* Returns:      0 on success, -1 after printing an error
+*
+* Description:
+*       The text `jobs` shows for the command is left alone.
+*
+**/
+int parseRedirects(struct command *cmd, struct arena *arena)
+{
+    cmd->redirects = NULL;
+    cmd->numRedirects = 0;
+    if (cmd->numTokens == 0) {
+        return 0;
+    }
+    struct command redirects = { .tokens = cmd->tokens, .numTokens = cmd->numTokens };
+    if (parseCommand(&redirects, arena) == -1) {
+        return -1;
+    }
+    cmd->redirects = redirects.redirects;
+    cmd->numRedirects = redirects.numRedirects;
+    return 0;
+}
+
+/**
+*
+* static _Bool parseIsName(const char *text)
+*
+* Summary:
+*       Checks if a word is a valid variable name: [A-Za-z_][A-Za-z0-9_]*
+*
+**/
+static _Bool parseIsName(const char *text)
+{
+    for (const char *p = text; *p; p++) {
+        _Bool letter = (*p >= 'a' && *p <= 'z') || (*p >= 'A' && *p <= 'Z') || *p == '_';
+        if (!letter && (p == text || *p < '0' || *p > '9')) {
+            return 0;
+        }
+    }
+    return text[0] != '\0';
+}
+
+/**
+*
+* static int parseBody(struct parser *parser, struct node **list)
+*
+* Summary:
+*       Parses the list inside a compound command, which may not be empty
+*
+* Returns:      0 on success, -1 after printing an error
+*
+**/
+static int parseBody(struct parser *parser, struct node **list)
+{
+    if (parseList(parser, list) == -1) {
+        return -1;
+    }
+    return *list ? 0 : parseUnexpected(parser, parsePeek(parser));
+}
+
+/**
+*
+* static int parseDoGroup(struct parser *parser, struct command *cmd)
+*
+* Summary:
+*       Parses the `do list done` of a loop into its body
+*
+**/
+static int parseDoGroup(struct parser *parser, struct command *cmd)
+{
+    if (parseExpect(parser, "do") == -1 || parseBody(parser, &cmd->body) == -1) {
+        return -1;
+    }
+    return parseExpect(parser, "done");
+}
+
+/**
+*
+* static int parseIf(struct parser *parser, struct command *cmd)
+*
+* Summary:
+*       Parses an `if` or `elif` up to and including its `fi`
+*
+* Description:
+*       An `elif` becomes an `if` of its own in the else part, and takes
+*       the `fi` with it.
+*
+**/
+static int parseIf(struct parser *parser, struct command *cmd)
+{
+    parser->pos++;
+    cmd->type = COMMAND_IF;
+    if (parseBody(parser, &cmd->condition) == -1 || parseExpect(parser, "then") == -1
+            || parseBody(parser, &cmd->body) == -1) {
+        return -1;
+    }
+
+    struct token *token = parsePeek(parser);
+    if (parseIsKeyword(token, "elif")) {
+        int start = parser->pos;
+        struct command *elif;
+        cmd->orElse = parseWrap(parser, &elif);
+        if (parseIf(parser, elif) == -1) {
+            return -1;
+        }
+        elif->argv = parseText(parser, start);
+        return 0;
+    }
+    if (parseIsKeyword(token, "else")) {
+        parser->pos++;
+        if (parseBody(parser, &cmd->orElse) == -1) {
+            return -1;
+        }
+    }
+    return parseExpect(parser, "fi");
+}
+
+/**
+*
+* static int parseFor(struct parser *parser, struct command *cmd)
+*
+* Summary:
+*       Parses a `for` loop, keeping the words after `in` to expand each
+*       time the loop runs
+*
+**/
+static int parseFor(struct parser *parser, struct command *cmd)
+{
+    parser->pos++;
+    cmd->type = COMMAND_FOR;
+
+    struct token *name = parsePeek(parser);
+    if (!name || name->type != TOKEN_WORD || name->quoted || name->source
+            || !parseIsName(name->text)) {
+        return parseUnexpected(parser, name);
+    }
+    cmd->name = name->text;
+    parser->pos++;
+    parseNewlines(parser);
+
+    struct token *token = parsePeek(parser);
+    if (parseIsKeyword(token, "in")) {
+        parser->pos++;
+        cmd->words = &parser->tokens[parser->pos];
+        while (parser->pos < parser->numTokens
+                && parser->tokens[parser->pos].type == TOKEN_WORD) {
+            cmd->numWords++;
+            parser->pos++;
+        }
+        token = parsePeek(parser);
+        if (!token || (token->type != TOKEN_SEMICOLON && token->type != TOKEN_NEWLINE)) {
+            return parseUnexpected(parser, token);
+        }
+        parser->pos++;
+    }
+    else if (token && token->type == TOKEN_SEMICOLON) {
+        parser->pos++;
+    }
+    parseNewlines(parser);
+    return parseDoGroup(parser, cmd);
+}
+
+/**
+*
+* static _Bool parseIsCompound(struct parser *parser)
+*
+* Summary:
+*       Checks if the next token starts a compound command other than a
+*       function definition
+*
+**/
+static _Bool parseIsCompound(struct parser *parser)
+{
+    struct token *token = parsePeek(parser);
+    return token && (token->type == TOKEN_OPEN || parseIsKeyword(token, "{")
+            || parseIsKeyword(token, "if") || parseIsKeyword(token, "while")
+            || parseIsKeyword(token, "until") || parseIsKeyword(token, "for"));
+}
+
+/**
+*
+* static int parseFunction(struct parser *parser, struct command *cmd)
+*
+* Summary:
+*       Parses a function definition, `name() compound` or
+*       `function name [()] compound`
+*
+* Description:
+*       Redirections after the body belong to the body, and apply each
+*       time the function is called.
+*
+**/
+static int parseFunction(struct parser *parser, struct command *cmd)
+{
+    int start = parser->pos;
+    if (parseIsKeyword(parsePeek(parser), "function")) {
+        parser->pos++;
+    }
+    struct token *name = parsePeek(parser);
+    if (!name || name->type != TOKEN_WORD) {
+        return parseUnexpected(parser, name);
+    }
+    parser->pos++;
+    if (parser->pos + 1 < parser->numTokens
+            && parser->tokens[parser->pos].type == TOKEN_OPEN
+            && parser->tokens[parser->pos + 1].type == TOKEN_CLOSE) {
+        parser->pos += 2;
+    }
+    parseNewlines(parser);
+    if (!parseIsCompound(parser)) {
+        return parseUnexpected(parser, parsePeek(parser));
+    }
+
+    struct command *body;
+    cmd->type = COMMAND_FUNCTION;
+    cmd->name = name->text;
+    cmd->body = parseWrap(parser, &body);
+    if (parseStage(parser, body) == -1) {
+        return -1;
+    }
+    cmd->argv = parseText(parser, start);
+    return 0;
+}
+
+/**
+*
+* static int parseCompound(struct parser *parser, struct command *cmd)
+*
+* Summary:
+*       Parses a compound command or function definition, if one starts
+*       at the next token
+*
+* Parameters:   pointer to the parser
+*               pointer to the cleared command to fill in
+*
+* Returns:      0 on success, -1 after printing an error, 1 if the next
+*               token does not start one
+*
+* Description:
+*       A compound command keeps its tokens as the text `jobs` shows.
+*       Redirections after it apply to the whole command.
+*
+**/
+static int parseCompound(struct parser *parser, struct command *cmd)
+{
+    struct token *token = parsePeek(parser);
+    int start = parser->pos;
+    int result = 0;
+
+    if (!token || (token->type == TOKEN_WORD && (token->quoted || token->source))) {
+        return 1;
+    }
+    if (token->type == TOKEN_OPEN || parseIsKeyword(token, "{")) {
+        _Bool group = (token->type != TOKEN_OPEN);
+        cmd->type = group ? COMMAND_GROUP : COMMAND_SUBSHELL;
+        parser->pos++;
+        if (parseBody(parser, &cmd->body) == -1) {
+            return -1;
+        }
+        struct token *close = parsePeek(parser);
+        if (group ? !parseIsKeyword(close, "}") : (!close || close->type != TOKEN_CLOSE)) {
+            return parseUnexpected(parser, close);
+        }
+        parser->pos++;
+    }
+    else if (parseIsKeyword(token, "if")) {
+        result = parseIf(parser, cmd);
+    }
+    else if (parseIsKeyword(token, "while") || parseIsKeyword(token, "until")) {
+        parser->pos++;
+        cmd->type = (token->text[0] == 'w') ? COMMAND_WHILE : COMMAND_UNTIL;
+        result = parseBody(parser, &cmd->condition);
+        if (result == 0) {
+            result = parseDoGroup(parser, cmd);
+        }
+    }
+    else if (parseIsKeyword(token, "for")) {
+        result = parseFor(parser, cmd);
+    }
+    else if (parseIsKeyword(token, "function") || (token->type == TOKEN_WORD
+            && start + 2 < parser->numTokens
+            && parser->tokens[start + 1].type == TOKEN_OPEN
+            && parser->tokens[start + 2].type == TOKEN_CLOSE)) {
+        return parseFunction(parser, cmd);
+    }
+    else {
+        return 1;
+    }
+    if (result == -1) {
+        return -1;
+    }
+
+    cmd->argv = parseText(parser, start);
+
+    // the redirections are parsed like those of a simple command
+    cmd->tokens = parsePeek(parser);
+    cmd->numTokens = parseSkip(parser, 0, cmd);
+    if (cmd->numTokens == -1) {
+        return -1;
+    }
+    return parseRedirects(cmd, parser->arena);
+}
+
+/**
+*
+* static int parseStage(struct parser *parser, struct command *cmd)
+*
+* Summary:
+*       Parses one command of a pipeline
+*
+* Parameters:   pointer to the parser
+*               pointer to the command to fill in
+*
+* Returns:      0 on success, -1 after printing an error
+*
+**/
+static int parseStage(struct parser *parser, struct command *cmd)
+{
+    memset(cmd, 0, sizeof(struct command));
+    int result = parseCompound(parser, cmd);
+    if (result != 1) {
+        return result;
+    }
+
+    struct token *token = parsePeek(parser);
+    cmd->type = COMMAND_SIMPLE;
+    cmd->tokens = token;
+    cmd->numTokens = parseSkip(parser, 1, cmd);
+    if (cmd->numTokens == -1) {
+        return -1;
+    }
+    if (cmd->numTokens == 0) {
+        // an operator where a command should be
+        return parseUnexpected(parser, token);
+    }
+    return (parseCommand(cmd, parser->arena) == -1) ? -1 : 0;
+}
+
+/**
+*
+* static int parsePipeline(struct parser *parser, struct node **pipeline)
+*
+* Summary:
+*       Parses a pipeline of commands separated by `|`
+*
+* Parameters:   pointer to the parser
+*               pointer to the node pointer to set
+*
+* Returns:      0 on success, -1 after printing an error
+*
+* Description:
+*       A lone command may have no words, only redirections (> file); every
+*       stage of a longer pipeline needs a command.
+*
+**/
+static int parsePipeline(struct parser *parser, struct node **pipeline)
+{
+    struct node *node = parseNode(parser, NODE_PIPELINE, NULL, NULL);
+    struct pipeline *stages = &node->pipeline;
+
+    // `time` in front of a pipeline reports what it used
+    if (parseIsKeyword(parsePeek(parser), "time") && parser->pos + 1 < parser->numTokens) {
+        stages->timed = 1;
+        parser->pos++;
+    }
+
+    int capacity = 4;
+    stages->commands = arenaAlloc(parser->arena, capacity * sizeof(struct command));
+    while (1) {
+        if (stages->numCommands == capacity) {
+            stages->commands = arenaGrow(parser->arena, stages->commands,
+                    capacity * sizeof(struct command),
+                    capacity * 2 * sizeof(struct command));
+            capacity *= 2;
+        }
+        struct command *cmd = &stages->commands[stages->numCommands++];
+        if (parseStage(parser, cmd) == -1) {
+            return -1;
+        }
+
+        struct token *token = parsePeek(parser);
+        if (cmd->type == COMMAND_SIMPLE && cmd->argc == 0 && cmd->numAssigns == 0
+                && (stages->numCommands > 1 || (token && token->type == TOKEN_PIPE))) {
+            return syntaxError(token);
+        }
+        if (!token || token->type != TOKEN_PIPE) {
+            break;
+        }
+        // start the next stage after the |
+        parser->pos++;
+        parseNewlines(parser);
+    }
+
+    *pipeline = node;
+    return 0;
+}
+
+/**
+*
+* static int parseAndOr(struct parser *parser, struct node **list)
+*
+* Summary:
+*       Parses pipelines joined by `&&` and `||`, which bind left to right
+*       with equal precedence
+*
+**/
+static int parseAndOr(struct parser *parser, struct node **list)
+{
+    if (parsePipeline(parser, list) == -1) {
+        return -1;
+    }
+    struct token *token;
+    while ((token = parsePeek(parser))
+            && (token->type == TOKEN_AND || token->type == TOKEN_OR)) {
+        parser->pos++;
+        parseNewlines(parser);
+        struct node *right;
+        if (parsePipeline(parser, &right) == -1) {
+            return -1;
+        }
+        *list = parseNode(parser, (token->type == TOKEN_AND) ? NODE_AND : NODE_OR,
+                *list, right);
+    }
+    return 0;
+}
+
+/**
+*
+* static int parseList(struct parser *parser, struct node **list)
+*
+* Summary:
+*       Parses and-or lists separated by `;`, `&` or line ends until the
+*       end of the tokens, a `)` or a reserved word such as `}` or `fi`
+*
+* Parameters:   pointer to the parser
+*               pointer to the node pointer to set, NULL for an empty list
+*
+* Returns:      0 on success, -1 after printing an error
+*
+**/
+static int parseList(struct parser *parser, struct node **list)
+{
+    *list = NULL;
+    parseNewlines(parser);
+    while (!parseListEnd(parser)) {
+        int start = parser->pos;
+        struct node *item;
+        if (parseAndOr(parser, &item) == -1) {
+            return -1;
+        }
+
+        struct token *token = parsePeek(parser);
+        if (token && token->type == TOKEN_BACKGROUND) {
+            if (item->type != NODE_PIPELINE) {
+                // a && b & runs the whole and-or list in a subshell job
+                struct command *job;
+                struct node *wrapped = parseWrap(parser, &job);
+                job->type = COMMAND_SUBSHELL;
+                job->argv = parseText(parser, start);
+                job->body = item;
+                item = wrapped;
+            }
+            item->pipeline.background = 1;
+            parser->pos++;
+        }
+        else if (token && (token->type == TOKEN_SEMICOLON || token->type == TOKEN_NEWLINE)) {
+            parser->pos++;
+        }
+        else if (!parseListEnd(parser)) {
+            return syntaxError(token);
+        }
+
+        *list = *list ? parseNode(parser, NODE_SEQUENCE, *list, item) : item;
+        parseNewlines(parser);
+    }
+    return 0;
+}
+
+/**
+*
+* int parseLine(struct token *tokens, int numTokens, struct arena *arena,
+*               struct node **root)
+*
+* Summary:
+*       Parses the tokens of a whole command into a tree
+*
+* Parameters:   array of tokens from lexLine(), with a TOKEN_NEWLINE
+*                   between lines when the command spans several
+*               int for the number of tokens
+*               pointer to the arena the tree is allocated from
+*               pointer to the root to set, NULL if there is nothing to run
+*                   or the tokens do not parse
+*
+* Returns:      0 on success, -1 after printing a syntax error, or
+*               PARSE_INCOMPLETE when the tokens end inside a command
+*
+* Description:
+*       The list is built as it is parsed, so an error part way leaves
+*       the commands before it; none of them may run.
+*
+**/
+int parseLine(struct token *tokens, int numTokens, struct arena *arena,
+        struct node **root)
+{
+    struct parser parser = {
+        .tokens = tokens,
+        .numTokens = numTokens,
+        .arena = arena
+    };
+    if (parseList(&parser, root) == -1) {
+        *root = NULL;
+        return parser.incomplete ? PARSE_INCOMPLETE : -1;
+    }
+    if (parser.pos < numTokens) {
+        // a ) or reserved word with nothing open
+        *root = NULL;
+        return syntaxError(&tokens[parser.pos]);
+    }
+    return 0;
+}
+
+/**
+*
+* static struct token *parseCopyTokens(const struct token *tokens,
+*                                      int count, struct arena *arena)
+*
+* Summary:
+*       Copies tokens along with their text
+*
+**/
+static struct token *parseCopyTokens(const struct token *tokens, int count,
+        struct arena *arena)
+{
+    struct token *copy = arenaAlloc(arena, (count + 1) * sizeof(struct token));
+    for (int i = 0; i < count; i++) {
+        copy[i] = tokens[i];
+        copy[i].text = arenaStrndup(arena, tokens[i].text, tokens[i].length);
+        if (tokens[i].source) {
+            copy[i].source = arenaStrndup(arena, tokens[i].source, tokens[i].sourceLength);
+        }
+    }
+    return copy;
+}
+
+/**
+*
+* static void parseCopyCommand(struct command *copy,
+*                              const struct command *cmd, struct arena *arena)
+*
+* Summary:
+*       Copies a command and everything it holds
+*
+* Description:
+*       The argument list and redirection plan are parsed again from the
+*       copied tokens rather than copied, so they point at the copies.
+*
+**/
+static void parseCopyCommand(struct command *copy, const struct command *cmd,
+        struct arena *arena)
+{
+    *copy = *cmd;
+    copy->tokens = parseCopyTokens(cmd->tokens, cmd->numTokens, arena);
+    if (cmd->type == COMMAND_SIMPLE) {
+        parseCommand(copy, arena);
+    }
+    else {
+        int count = 0;
+        while (cmd->argv[count]) {
+            count++;
+        }
+        copy->argv = arenaAlloc(arena, (count + 1) * sizeof(char *));
+        for (int i = 0; i < count; i++) {
+            copy->argv[i] = arenaStrndup(arena, cmd->argv[i], strlen(cmd->argv[i]));
+        }
+        copy->argv[count] = NULL;
+        parseRedirects(copy, arena);
+    }
+    copy->body = parseCopy(cmd->body, arena);
+    copy->condition = parseCopy(cmd->condition, arena);
+    copy->orElse = parseCopy(cmd->orElse, arena);
+    if (cmd->name) {
+        copy->name = arenaStrndup(arena, cmd->name, strlen(cmd->name));
+    }
+    if (cmd->words) {
+        copy->words = parseCopyTokens(cmd->words, cmd->numWords, arena);
+    }
+}
+
+/**
+*
+* struct node *parseCopy(const struct node *node, struct arena *arena)
+*
+* Summary:
+*       Copies a tree into another arena
+*
+* Parameters:   pointer to the tree, may be NULL
+*               pointer to the arena the copy is allocated from
+*
+* Returns:      the copy, NULL for NULL
+*
+* Description:
+*       Used to keep a function's body after the command arena its line
+*       was parsed into is reset. The copy shares nothing with the
+*       original.
+*
+**/
+struct node *parseCopy(const struct node *node, struct arena *arena)
+{
+    if (!node) {
+        return NULL;
+    }
+    struct node *copy = arenaAlloc(arena, sizeof(struct node));
+    *copy = *node;
+    if (node->type == NODE_PIPELINE) {
+        const struct pipeline *pipeline = &node->pipeline;
+        copy->pipeline.commands = arenaAlloc(arena,
+                pipeline->numCommands * sizeof(struct command));
+        for (int i = 0; i < pipeline->numCommands; i++) {
+            parseCopyCommand(&copy->pipeline.commands[i], &pipeline->commands[i], arena);
+        }
+    }
+    else {
+        copy->left = parseCopy(node->left, arena);
+        copy->right = parseCopy(node->right, arena);
+    }
+    return copy;
+}
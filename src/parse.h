@@ -0,0 +1,94 @@
+/*******************************************************************************
+*
+* File:     parse.h
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Interface for the kell-shell command line parser. The tokens of a line
+*   are parsed into a tree: lists joined by `;`, `&`, `&&` and `||`, whose
+*   leaves are pipelines of commands separated by `|`. A command is either
+*   simple, with its arguments and redirection plan, or a compound command
+*   holding lists of its own: a `( ... )` subshell, a `{ ...; }` group,
+*   `if`, `while`, `until` or `for`, or a function definition.
+*
+*   A tree is never changed once it is built: it can run any number of
+*   times, as a loop body, a function or a cached script, with its words
+*   expanded anew into the command arena each time.
+*
+******************************************************************************/
+#ifndef PARSE_H
+#define PARSE_H
+
+struct arena;
+struct token;
+struct redirect;
+struct node;
+
+enum commandType {
+    COMMAND_SIMPLE,     // words and redirections
+    COMMAND_SUBSHELL,   // ( list ), runs apart from the shell
+    COMMAND_GROUP,      // { list; }, runs in the shell
+    COMMAND_IF,         // if list; then list; [elif ...] [else list;] fi
+    COMMAND_WHILE,      // while list; do list; done
+    COMMAND_UNTIL,      // until list; do list; done
+    COMMAND_FOR,        // for name [in word...]; do list; done
+    COMMAND_FUNCTION    // name() compound, defines a function
+};
+
+// parseLine() result for a line that ends inside a command
+#define PARSE_INCOMPLETE 1
+
+struct command {
+    enum commandType type;
+    char **argv;        // NULL terminated, points into the tokenized args;
+                        // for compound commands only the text `jobs` shows
+    int argc;           // 0 for compound commands
+    char **assigns;     // NAME=value words in front of argv[0], may be
+    int numAssigns;     // NULL; they point into the tokens too
+    struct redirect *redirects; // redirection plan, in the order written
+    int numRedirects;
+    struct token *tokens;   // its words and redirections, or just the
+    int numTokens;          // redirections of a compound command, to
+                            // parse again after expanding them anew
+    _Bool expands;          // some word has a $ expansion
+    _Bool substitutes;      // some word has a command substitution
+    _Bool fields;           // some word has a $@ or $* to split
+    _Bool globs;            // some word is a pattern to match file names
+    struct node *body;      // ( ), { }, then, do, or the function body
+    struct node *condition; // if, while, until
+    struct node *orElse;    // if: the elif or else part, may be NULL
+    const char *name;       // for: the variable, function: its name
+    struct token *words;    // for: the words after `in`, NULL without
+    int numWords;           // `in` to loop over the positional parameters
+};
+
+struct pipeline {
+    struct command *commands;   // allocated from the command arena
+    int numCommands;
+    _Bool background;           // ended with `&`
+    _Bool timed;                // started with the `time` keyword
+};
+
+enum nodeType {
+    NODE_PIPELINE,      // a pipeline, possibly of a single command
+    NODE_SEQUENCE,      // left ; right, or left & right
+    NODE_AND,           // left && right, right runs if left succeeds
+    NODE_OR             // left || right, right runs if left fails
+};
+
+struct node {
+    enum nodeType type;
+    struct pipeline pipeline;   // NODE_PIPELINE
+    struct node *left;          // the other types
+    struct node *right;
+};
+
+int parseLine(struct token *tokens, int numTokens, struct arena *arena,
+        struct node **root);
+int parseCommand(struct command *cmd, struct arena *arena);
+int parseRedirects(struct command *cmd, struct arena *arena);
+struct node *parseCopy(const struct node *node, struct arena *arena);
+
+#endif
@@ -0,0 +1,311 @@
+/*******************************************************************************
+*
+* File:     redirect.c
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Redirection for kell-shell. The parser turns the redirections of a
+*   command into a plan, one step per operator in the order written:
+*       < > >> &> &>>   open a file on a descriptor
+*       << <<- <<<      read a here-document or here-string
+*       n>&m n<&m       copy descriptor m onto n
+*       n>&- n<&-       close descriptor n
+*
+*   Before a command is launched, redirectPrepare() carries the plan out
+*   as far as the shell can: files are opened and here-documents are
+*   written into memfd_create() buffers, all close-on-exec and numbered
+*   from REDIRECT_FD_BASE up. What is left is a list of dup2() and close()
+*   steps, which posix_spawn file actions, a forked child or a built-in
+*   running inside the shell all replay the same way. Every error is
+*   found and reported here, in the shell, before anything is launched.
+*
+******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>   // memfd_create()
+
+#include "redirect.h"
+
+/**
+*
+* static int redirectMoveUp(int fd)
+*
+* Summary:
+*       Moves a descriptor the shell opened to REDIRECT_FD_BASE or above
+*
+* Parameters:   int for a close-on-exec descriptor
+*
+* Returns:      the descriptor to use, still close-on-exec
+*
+* Description:
+*       A low number could be the target of a later step: in
+*       `cmd 3>&1 > file`, the file must not already be sitting on 3.
+*
+**/
+static int redirectMoveUp(int fd)
+{
+    if (fd >= REDIRECT_FD_BASE) {
+        return fd;
+    }
+    int moved = fcntl(fd, F_DUPFD_CLOEXEC, REDIRECT_FD_BASE);
+    if (moved == -1) {
+        return fd;
+    }
+    close(fd);
+    return moved;
+}
+
+/**
+*
+* static int redirectDocument(const char *text, size_t length)
+*
+* Summary:
+*       Puts a here-document in an anonymous memory file
+*
+* Parameters:   char* for the contents
+*               size_t for their length
+*
+* Returns:      a close-on-exec descriptor positioned at the start, or -1
+*
+* Description:
+*       A memfd needs no temporary file and, unlike a pipe, holds any
+*       amount without a writer process to feed it.
+*
+**/
+static int redirectDocument(const char *text, size_t length)
+{
+    int fd = memfd_create("kell-heredoc", MFD_CLOEXEC);
+    if (fd == -1) {
+        return -1;
+    }
+    while (length > 0) {
+        ssize_t n = write(fd, text, length);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            close(fd);
+            return -1;
+        }
+        text += n;
+        length -= n;
+    }
+    lseek(fd, 0, SEEK_SET);
+    return fd;
+}
+
+/**
+*
+* static _Bool redirectIsOpen(const struct redirect *prepared, int numSteps,
+*                             int fd)
+*
+* Summary:
+*       Checks if a descriptor will be open in the command after the given
+*       steps
+*
+* Description:
+*       The newest step that targets fd decides. Otherwise the command
+*       inherits it from the shell only if it is not close-on-exec.
+*
+**/
+static _Bool redirectIsOpen(const struct redirect *prepared, int numSteps, int fd)
+{
+    for (int i = numSteps - 1; i >= 0; i--) {
+        if (prepared[i].fd == fd) {
+            return prepared[i].action != REDIRECT_CLOSE;
+        }
+    }
+    int flags = fcntl(fd, F_GETFD);
+    return flags != -1 && !(flags & FD_CLOEXEC);
+}
+
+/**
+*
+* _Bool redirectTargets(const struct redirect *steps, int numSteps, int fd)
+*
+* Summary:
+*       Checks if any step of a plan redirects a descriptor
+*
+* Parameters:   array of steps
+*               int for the number of steps
+*               int for the descriptor
+*
+* Returns:      true if a step targets fd
+*
+**/
+_Bool redirectTargets(const struct redirect *steps, int numSteps, int fd)
+{
+    for (int i = 0; i < numSteps; i++) {
+        if (steps[i].fd == fd) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+*
+* int redirectPrepare(const struct redirect *plan, int numSteps,
+*                     struct redirect *prepared)
+*
+* Summary:
+*       Opens the files and here-documents of a plan
+*
+* Parameters:   array of steps from the parser, not modified
+*               int for the number of steps
+*               array of as many steps that receives the prepared plan
+*
+* Returns:      0 on success, -1 after printing an error
+*
+* Description:
+*       The prepared plan has only REDIRECT_DUP and REDIRECT_CLOSE steps.
+*       Descriptors opened here are marked owned and must be closed with
+*       redirectRelease() once the command has them. On error nothing is
+*       left open.
+*
+**/
+int redirectPrepare(const struct redirect *plan, int numSteps,
+        struct redirect *prepared)
+{
+    for (int i = 0; i < numSteps; i++) {
+        const struct redirect *step = &plan[i];
+        prepared[i] = *step;
+        prepared[i].owned = 0;
+
+        switch (step->action) {
+            case REDIRECT_OPEN: {
+                int fd = open(step->text, step->flags | O_CLOEXEC, 0644);
+                if (fd == -1) {
+                    printf("cannot open %s for %s\n", step->text,
+                            ((step->flags & O_ACCMODE) == O_RDONLY) ? "input" : "output");
+                    fflush(stdout);
+                    redirectRelease(prepared, i);
+                    return -1;
+                }
+                prepared[i].action = REDIRECT_DUP;
+                prepared[i].source = redirectMoveUp(fd);
+                prepared[i].owned = 1;
+                break;
+            }
+            case REDIRECT_DOCUMENT: {
+                int fd = redirectDocument(step->text, step->length);
+                if (fd == -1) {
+                    perror("here-document");
+                    fflush(stdout);
+                    redirectRelease(prepared, i);
+                    return -1;
+                }
+                prepared[i].action = REDIRECT_DUP;
+                prepared[i].source = redirectMoveUp(fd);
+                prepared[i].owned = 1;
+                break;
+            }
+            case REDIRECT_DUP:
+                if (!redirectIsOpen(prepared, i, step->source)) {
+                    printf("%d: bad file descriptor\n", step->source);
+                    fflush(stdout);
+                    redirectRelease(prepared, i);
+                    return -1;
+                }
+                break;
+            case REDIRECT_CLOSE:
+                break;
+        }
+    }
+    return 0;
+}
+
+/**
+*
+* void redirectRelease(struct redirect *prepared, int numSteps)
+*
+* Summary:
+*       Closes the descriptors redirectPrepare() opened
+*
+* Parameters:   array of prepared steps
+*               int for the number of steps
+*
+* Returns:      nothing.
+*
+**/
+void redirectRelease(struct redirect *prepared, int numSteps)
+{
+    for (int i = 0; i < numSteps; i++) {
+        if (prepared[i].owned) {
+            close(prepared[i].source);
+            prepared[i].owned = 0;
+        }
+    }
+}
+
+/**
+*
+* void redirectApply(const struct redirect *prepared, int numSteps,
+*                    struct redirectSaved *saved)
+*
+* Summary:
+*       Applies a prepared plan to the shell itself, for a built-in
+*
+* Parameters:   array of prepared steps
+*               int for the number of steps
+*               array of as many saved descriptors to fill in
+*
+* Returns:      nothing.
+*
+* Description:
+*       Each target is copied before it is replaced so redirectRestore()
+*       can put it back, even when it is one of the shell's own
+*       descriptors.
+*
+**/
+void redirectApply(const struct redirect *prepared, int numSteps,
+        struct redirectSaved *saved)
+{
+    for (int i = 0; i < numSteps; i++) {
+        int fd = prepared[i].fd;
+        saved[i].flags = fcntl(fd, F_GETFD);
+        saved[i].copy = (saved[i].flags == -1) ? -1
+                : fcntl(fd, F_DUPFD_CLOEXEC, REDIRECT_FD_BASE);
+
+        if (prepared[i].action == REDIRECT_CLOSE) {
+            close(fd);
+        }
+        else if (prepared[i].source != fd) {
+            dup2(prepared[i].source, fd);
+        }
+    }
+}
+
+/**
+*
+* void redirectRestore(const struct redirect *prepared, int numSteps,
+*                      const struct redirectSaved *saved)
+*
+* Summary:
+*       Undoes redirectApply(), last step first
+*
+* Parameters:   array of prepared steps
+*               int for the number of steps
+*               array of saved descriptors from redirectApply()
+*
+* Returns:      nothing.
+*
+**/
+void redirectRestore(const struct redirect *prepared, int numSteps,
+        const struct redirectSaved *saved)
+{
+    for (int i = numSteps - 1; i >= 0; i--) {
+        int fd = prepared[i].fd;
+        if (saved[i].copy == -1) {
+            close(fd);
+            continue;
+        }
+        dup3(saved[i].copy, fd, (saved[i].flags & FD_CLOEXEC) ? O_CLOEXEC : 0);
+        close(saved[i].copy);
+    }
+}
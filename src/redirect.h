@@ -0,0 +1,55 @@
+/*******************************************************************************
+*
+* File:     redirect.h
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Interface for kell-shell io redirection. The redirections of a command
+*   form a plan of steps applied in order; the shell opens every file and
+*   here-document itself, so launching a command only copies and closes
+*   descriptors.
+*
+******************************************************************************/
+#ifndef REDIRECT_H
+#define REDIRECT_H
+
+#include <stddef.h>
+
+enum redirectAction {
+    REDIRECT_OPEN,      // open text as a file on fd
+    REDIRECT_DOCUMENT,  // text is the contents to read from fd
+    REDIRECT_DUP,       // make fd a copy of source
+    REDIRECT_CLOSE      // close fd
+};
+
+struct redirect {
+    enum redirectAction action;
+    int fd;             // descriptor in the command
+    int source;         // REDIRECT_DUP: descriptor copied onto fd
+    const char *text;   // file name or here-document contents
+    size_t length;      // length of a here-document
+    int flags;          // REDIRECT_OPEN: open() flags
+    _Bool owned;        // source was opened by redirectPrepare()
+};
+
+struct redirectSaved {
+    int copy;           // copy of the original descriptor, -1 if it was closed
+    int flags;          // descriptor flags of the original
+};
+
+// descriptors the shell opens for redirection start here, out of the
+// way of the small numbers a command line names
+#define REDIRECT_FD_BASE 10
+
+_Bool redirectTargets(const struct redirect *steps, int numSteps, int fd);
+int redirectPrepare(const struct redirect *plan, int numSteps,
+        struct redirect *prepared);
+void redirectRelease(struct redirect *prepared, int numSteps);
+void redirectApply(const struct redirect *prepared, int numSteps,
+        struct redirectSaved *saved);
+void redirectRestore(const struct redirect *prepared, int numSteps,
+        const struct redirectSaved *saved);
+
+#endif
@@ -0,0 +1,603 @@
+/*******************************************************************************
+*
+* File:     script.c
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Command reading and script files for kell-shell. scriptParse() reads
+*   one command from any source of lines: it lexes a line, reads the
+*   here-documents it names, and parses it. A line that ends inside quotes
+*   or with a backslash is joined with the next before it is lexed. A
+*   command such as `if` or `while` that is not complete at the end of the
+*   line takes the next line too, joined by a TOKEN_NEWLINE, until it
+*   parses.
+*
+*   `source file` runs a script in the shell. The trees its commands parse
+*   into are kept, keyed by the path and checked against the file's
+*   modification and change times, size and inode, so sourcing it again
+*   runs the trees without reading, lexing or parsing anything. Their words were
+*   expanded when they were read, and are always expanded again when they
+*   run (see execTree()). Here-documents keep their text as written for
+*   the same reason.
+*
+*   A file changed within the last second is not cached: a second change
+*   in the same clock tick would leave its times and perhaps its size as
+*   they were. KELL_SCRIPT_CACHE=0 turns the cache off, so every `source`
+*   parses the file again.
+*
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/stat.h>
+
+#include "arena.h"
+#include "builtins.h"   // struct shellState, exitValue()
+#include "exec.h"       // execTree(), execVars()
+#include "expand.h"     // expandLine()
+#include "input.h"
+#include "lex.h"
+#include "parse.h"
+#include "script.h"
+#include "stats.h"
+
+#define SCRIPT_CACHE_MAX 32     // scripts kept before the oldest is dropped
+#define SCRIPT_DEPTH_MAX 100    // nested `source`s before giving up
+
+struct script {
+    char *path;
+    dev_t device;           // the file the trees were parsed from
+    ino_t inode;
+    off_t size;
+    struct timespec modified;
+    struct timespec changed;    // which touch cannot set back
+    struct arena arena;     // the trees and everything they point to
+    struct node **trees;    // one per command, in order
+    int numTrees;
+    int capacity;
+    int running;            // nested `source`s of it in progress
+    _Bool cached;           // in the list
+    struct script *next;    // in the list, most recently used first
+};
+
+static struct script *scripts = NULL;
+static int numScripts = 0;
+static int cacheEnabled = -1;   // KELL_SCRIPT_CACHE, read on first use
+static int depth = 0;           // `source`s running
+static struct arena scratch;    // what the commands of sourced scripts need
+
+/**
+*
+* static void scriptHereDocuments(struct token *tokens, int numTokens,
+*                                 struct arena *arena,
+*                                 const struct expandVars *vars,
+*                                 struct scriptInput *input)
+*
+* Summary:
+*       Reads the body of every `<<` here-document on a command line
+*
+* Parameters:   array of tokens from lexLine()
+*               int for the number of tokens
+*               pointer to the arena that holds the bodies
+*               pointer to the values for $ expansions
+*               pointer to the input the command line came from
+*
+* Returns:      nothing. the word after each `<<` is replaced by the body
+*
+* Description:
+*       Bodies are the lines after the command, in order, each ending at a
+*       line that is exactly its delimiter. `<<-` strips leading tabs. $
+*       references in a body are expanded unless the delimiter was quoted;
+*       such a body also keeps its text as written, to expand again each
+*       time it is used. End of input also ends a body, with a warning as
+*       bash gives.
+*
+**/
+static void scriptHereDocuments(struct token *tokens, int numTokens,
+        struct arena *arena, const struct expandVars *vars, struct scriptInput *input)
+{
+    for (int i = 0; i + 1 < numTokens; i++) {
+        if (tokens[i].type != TOKEN_HEREDOC || tokens[i + 1].type != TOKEN_WORD) {
+            continue;
+        }
+        struct token *delimiter = &tokens[i + 1];
+        _Bool stripTabs = (tokens[i].text[2] == '-');
+        size_t capacity = 256;
+        size_t bodyLength = 0;
+        char *body = arenaAlloc(arena, capacity);
+
+        while (1) {
+            size_t length;
+            const char *line = input->readLine(input, SCRIPT_DOCUMENT, &length);
+            if (!line) {
+                printf("warning: here-document delimited by end-of-file (wanted `%s')\n",
+                        delimiter->text);
+                fflush(stdout);
+                break;
+            }
+
+            while (stripTabs && length > 0 && line[0] == '\t') {
+                line++;
+                length--;
+            }
+            if (length == delimiter->length
+                    && memcmp(line, delimiter->text, length) == 0) {
+                break;
+            }
+
+            if (bodyLength + length + 2 > capacity) {
+                size_t newCapacity = capacity * 2;
+                while (bodyLength + length + 2 > newCapacity) {
+                    newCapacity *= 2;
+                }
+                body = arenaGrow(arena, body, bodyLength, newCapacity);
+                capacity = newCapacity;
+            }
+            memcpy(body + bodyLength, line, length);
+            bodyLength += length;
+            body[bodyLength++] = '\n';
+        }
+        body[bodyLength] = '\0';
+
+        delimiter->source = NULL;
+        if (!delimiter->quoted && memchr(body, '$', bodyLength)) {
+            delimiter->source = body;
+            delimiter->sourceLength = bodyLength;
+            delimiter->substitutes = (strstr(body, "$(") != NULL);
+            body = expandLine(arena, body, &bodyLength, vars);
+        }
+        delimiter->text = body;
+        delimiter->length = bodyLength;
+        delimiter->glob = 0;
+        i++;
+    }
+}
+
+/**
+*
+* int scriptParse(struct scriptInput *input, struct arena *arena,
+*                 const struct expandVars *vars, struct node **root)
+*
+* Summary:
+*       Reads and parses one command, which may span several lines
+*
+* Parameters:   pointer to the input to read lines from
+*               pointer to the arena the tokens and tree are allocated from
+*               pointer to the values for $ expansions
+*               pointer to the root to set, NULL if there is nothing to run
+*                   or the command did not parse
+*
+* Returns:      1 when a line was read, 0 if there was no line to read, or
+*               -1 after a syntax error or when input ran out inside a
+*               command
+*
+* Description:
+*       The tokens of each further line are added after those already
+*       read and the whole command is parsed again; parsing is cheap next
+*       to reading the lines, and commands are rarely long.
+*
+**/
+int scriptParse(struct scriptInput *input, struct arena *arena,
+        const struct expandVars *vars, struct node **root)
+{
+    struct token *tokens = NULL;
+    int numTokens = 0;
+    STATS_TIMER(phaseStart);
+
+    *root = NULL;
+    for (enum scriptLine kind = SCRIPT_COMMAND; ; kind = SCRIPT_CONTINUED) {
+        size_t length;
+        const char *line = input->readLine(input, kind, &length);
+        if (!line) {
+            if (kind == SCRIPT_COMMAND) {
+                return 0;
+            }
+            if (input->eof) {
+                printf("syntax error: unexpected end of file\n");
+                fflush(stdout);
+            }
+            return -1;
+        }
+
+        // split into tokens, expanding $ words outside single quotes as
+        // they are read
+        struct token *lineTokens;
+        char *text = arenaStrndup(arena, line, length);
+        STATS_START(phaseStart);
+        int count = lexLine(text, length, arena, vars, &lineTokens);
+        STATS_STOP(STATS_LEX, phaseStart);
+
+        // a quote or backslash left open goes on on the next line; the
+        // lexer wrote into text, so the lines are joined from copies
+        char *whole = (count == LEX_INCOMPLETE) ? arenaStrndup(arena, line, length) : NULL;
+        while (count == LEX_INCOMPLETE) {
+            size_t nextLength;
+            const char *next = input->readLine(input, SCRIPT_CONTINUED, &nextLength);
+            if (!next) {
+                if (input->eof) {
+                    printf("syntax error: unexpected end of file\n");
+                    fflush(stdout);
+                }
+                return -1;
+            }
+            char *joined = arenaAlloc(arena, length + 1 + nextLength + 1);
+            memcpy(joined, whole, length);
+            joined[length] = '\n';
+            memcpy(joined + length + 1, next, nextLength);
+            length += 1 + nextLength;
+            joined[length] = '\0';
+            whole = joined;
+            text = arenaStrndup(arena, whole, length);
+            STATS_START(phaseStart);
+            count = lexLine(text, length, arena, vars, &lineTokens);
+            STATS_STOP(STATS_LEX, phaseStart);
+        }
+        if (count == -1) {
+            return -1;
+        }
+        scriptHereDocuments(lineTokens, count, arena, vars, input);
+
+        if (kind == SCRIPT_COMMAND) {
+            tokens = lineTokens;
+            numTokens = count;
+        }
+        else {
+            struct token *joined = arenaAlloc(arena,
+                    (numTokens + 1 + count) * sizeof(struct token));
+            memcpy(joined, tokens, numTokens * sizeof(struct token));
+            joined[numTokens] = (struct token) {
+                .type = TOKEN_NEWLINE, .fd = -1, .text = ";", .length = 1
+            };
+            if (count > 0) {
+                memcpy(joined + numTokens + 1, lineTokens, count * sizeof(struct token));
+            }
+            tokens = joined;
+            numTokens += 1 + count;
+        }
+        if (numTokens == 0) {
+            // spaces or a comment
+            return 1;
+        }
+
+        // build the tree of the command: lists, pipelines and commands
+        STATS_START(phaseStart);
+        int result = parseLine(tokens, numTokens, arena, root);
+        STATS_STOP(STATS_PARSE, phaseStart);
+        if (result != PARSE_INCOMPLETE) {
+            return (result == -1) ? -1 : 1;
+        }
+    }
+}
+
+/**
+*
+* static const char *scriptReadLine(struct scriptInput *input,
+*                                   enum scriptLine kind, size_t *length)
+*
+* Summary:
+*       Reads the next line of a sourced file
+*
+**/
+static const char *scriptReadLine(struct scriptInput *input, enum scriptLine kind,
+        size_t *length)
+{
+    struct inputReader *reader = input->context;
+    const char *line;
+    do {
+        line = inputReadLine(reader, length);
+    } while (!line && !reader->eof);
+    input->eof = reader->eof;
+    return line;
+}
+
+/**
+*
+* static void scriptRelease(struct script *script)
+*
+* Summary:
+*       Frees a script and its trees
+*
+**/
+static void scriptRelease(struct script *script)
+{
+    arenaFree(&script->arena);
+    free(script->trees);
+    free(script->path);
+    free(script);
+}
+
+/**
+*
+* static void scriptUncache(struct script *script)
+*
+* Summary:
+*       Takes a script out of the list, freeing it unless it is running
+*
+**/
+static void scriptUncache(struct script *script)
+{
+    struct script **link = &scripts;
+    while (*link != script) {
+        link = &(*link)->next;
+    }
+    *link = script->next;
+    script->cached = 0;
+    numScripts--;
+    if (script->running == 0) {
+        scriptRelease(script);
+    }
+}
+
+/**
+*
+* static struct script *scriptFind(const char *path, const struct stat *info)
+*
+* Summary:
+*       Looks up the cached trees of a file
+*
+* Parameters:   char* for the path as given to `source`
+*               pointer to the file's current status
+*
+* Returns:      the script, moved to the front of the list, or NULL if it
+*               is not cached or the file has changed since
+*
+**/
+static struct script *scriptFind(const char *path, const struct stat *info)
+{
+    for (struct script *script = scripts; script; script = script->next) {
+        if (strcmp(script->path, path) != 0) {
+            continue;
+        }
+        if (script->device != info->st_dev || script->inode != info->st_ino
+                || script->size != info->st_size
+                || script->modified.tv_sec != info->st_mtim.tv_sec
+                || script->modified.tv_nsec != info->st_mtim.tv_nsec
+                || script->changed.tv_sec != info->st_ctim.tv_sec
+                || script->changed.tv_nsec != info->st_ctim.tv_nsec) {
+            scriptUncache(script);
+            return NULL;
+        }
+        if (script != scripts) {
+            struct script **link = &scripts;
+            while (*link != script) {
+                link = &(*link)->next;
+            }
+            *link = script->next;
+            script->next = scripts;
+            scripts = script;
+        }
+        return script;
+    }
+    return NULL;
+}
+
+/**
+*
+* static void scriptCache(struct script *script)
+*
+* Summary:
+*       Adds a completely parsed script to the front of the list
+*
+* Description:
+*       The least recently used script that is not running makes room
+*       when the list is full.
+*
+**/
+static void scriptCache(struct script *script)
+{
+    if (numScripts >= SCRIPT_CACHE_MAX) {
+        struct script *oldest = NULL;
+        for (struct script *other = scripts; other; other = other->next) {
+            if (other->running == 0) {
+                oldest = other;
+            }
+        }
+        if (!oldest) {
+            return;
+        }
+        scriptUncache(oldest);
+    }
+    script->cached = 1;
+    script->next = scripts;
+    scripts = script;
+    numScripts++;
+}
+
+/**
+*
+* static void scriptAdd(struct script *script, struct node *root)
+*
+* Summary:
+*       Appends the tree of a command to a script
+*
+**/
+static void scriptAdd(struct script *script, struct node *root)
+{
+    if (script->numTrees == script->capacity) {
+        script->capacity = script->capacity ? script->capacity * 2 : 16;
+        script->trees = realloc(script->trees, script->capacity * sizeof(struct node *));
+    }
+    script->trees[script->numTrees++] = root;
+}
+
+/**
+*
+* static int scriptLoad(struct script *script, const char *path,
+*                       struct shellState *shell)
+*
+* Summary:
+*       Reads, parses and runs a script one command at a time, keeping
+*       the trees
+*
+* Parameters:   pointer to the new, empty script
+*               char* for the path of the file
+*               pointer to the shell state
+*
+* Returns:      1 if every command was read and parsed, 0 if the script
+*               stopped early, -1 after a syntax error
+*
+* Description:
+*       Each command runs as soon as it is parsed, as from any other
+*       input, so a command can define what a later one needs.
+*
+**/
+static int scriptLoad(struct script *script, const char *path, struct shellState *shell)
+{
+    struct inputReader reader;
+    if (inputOpenFile(&reader, path) == -1) {
+        printf("source: %s: %s\n", path, strerror(errno));
+        fflush(stdout);
+        return -1;
+    }
+    struct scriptInput input = { .readLine = scriptReadLine, .context = &reader };
+    struct arenaMark mark = arenaMark(&scratch);
+    int result = 1;
+
+    while (1) {
+        struct expandVars vars;
+        struct node *root;
+        execVars(shell, &vars);
+        int parsed = scriptParse(&input, &script->arena, &vars, &root);
+        if (parsed == 0) {
+            break;
+        }
+        if (parsed == -1) {
+            result = -1;
+            break;
+        }
+        if (!root) {
+            continue;
+        }
+        scriptAdd(script, root);
+        _Bool stopped = execTree(root, &scratch, shell);
+        arenaRewind(&scratch, mark);
+        if (stopped) {
+            result = 0;
+            break;
+        }
+    }
+    inputClose(&reader);
+    return result;
+}
+
+/**
+*
+* int scriptSource(const char *path, char **args, int numArgs,
+*                  struct shellState *shell)
+*
+* Summary:
+*       Runs the commands of a file in the shell, for `source` and `.`
+*
+* Parameters:   char* for the path of the file
+*               array of char* for the positional parameters while it
+*                   runs, or NULL to keep those of the caller
+*               int for their number
+*               pointer to the shell state
+*
+* Returns:      the exit value of the last command it ran, 1 if the file
+*               cannot be read, 2 after a syntax error
+*
+* Description:
+*       `return` ends the script early. A file seen before, and unchanged
+*       since, runs from its cached trees.
+*
+**/
+int scriptSource(const char *path, char **args, int numArgs, struct shellState *shell)
+{
+    if (cacheEnabled == -1) {
+        char *value = getenv("KELL_SCRIPT_CACHE");
+        cacheEnabled = !(value && strcmp(value, "0") == 0);
+    }
+
+    struct stat info;
+    if (stat(path, &info) == -1) {
+        printf("source: %s: %s\n", path, strerror(errno));
+        fflush(stdout);
+        return 1;
+    }
+    if (depth >= SCRIPT_DEPTH_MAX) {
+        printf("source: %s: maximum nesting level exceeded (%d)\n", path, SCRIPT_DEPTH_MAX);
+        fflush(stdout);
+        return 1;
+    }
+    depth++;
+
+    char **savedArgs = shell->args;
+    int savedNumArgs = shell->numArgs;
+    if (args) {
+        shell->args = args;
+        shell->numArgs = numArgs;
+    }
+    shell->functionDepth++;
+
+    int result = 1;
+    struct script *script = cacheEnabled ? scriptFind(path, &info) : NULL;
+    if (script) {
+        // parsed before: run the trees
+        struct arenaMark mark = arenaMark(&scratch);
+        script->running++;
+        for (int i = 0; i < script->numTrees; i++) {
+            _Bool stopped = execTree(script->trees[i], &scratch, shell);
+            arenaRewind(&scratch, mark);
+            if (stopped) {
+                break;
+            }
+        }
+        script->running--;
+        if (!script->cached && script->running == 0) {
+            scriptRelease(script);
+        }
+    }
+    else {
+        script = calloc(1, sizeof(struct script));
+        script->path = strdup(path);
+        script->device = info.st_dev;
+        script->inode = info.st_ino;
+        script->size = info.st_size;
+        script->modified = info.st_mtim;
+        script->changed = info.st_ctim;
+        script->running = 1;
+        result = scriptLoad(script, path, shell);
+        script->running = 0;
+
+        // only a whole, settled regular file can be run from its trees
+        if (result == 1 && cacheEnabled && S_ISREG(info.st_mode)
+                && info.st_mtim.tv_sec < time(NULL) - 1) {
+            scriptCache(script);
+        }
+        if (!script->cached) {
+            scriptRelease(script);
+        }
+    }
+
+    depth--;
+    shell->functionDepth--;
+    shell->returning = 0;
+    shell->args = savedArgs;
+    shell->numArgs = savedNumArgs;
+    return (result == -1) ? 2 : exitValue(shell->foregroundStatus);
+}
+
+/**
+*
+* void scriptFree(void)
+*
+* Summary:
+*       Frees every cached script
+*
+* Parameters:   none
+*
+* Returns:      nothing.
+*
+**/
+void scriptFree(void)
+{
+    while (scripts) {
+        scriptUncache(scripts);
+    }
+    arenaFree(&scratch);
+}
@@ -0,0 +1,45 @@
+/*******************************************************************************
+*
+* File:     script.h
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Interface for reading kell-shell commands that may span several lines,
+*   and for running script files with `source`, whose parsed trees are
+*   cached.
+*
+******************************************************************************/
+#ifndef SCRIPT_H
+#define SCRIPT_H
+
+#include <stddef.h>
+
+struct arena;
+struct expandVars;
+struct node;
+struct shellState;
+
+enum scriptLine {
+    SCRIPT_COMMAND,     // the first line of a command
+    SCRIPT_CONTINUED,   // a further line of a command not yet complete
+    SCRIPT_DOCUMENT     // a line of a here-document
+};
+
+struct scriptInput {
+    // returns the next line without its newline, or NULL when there is
+    // none; sets eof once no more input will come
+    const char *(*readLine)(struct scriptInput *input, enum scriptLine kind,
+            size_t *length);
+    void *context;
+    _Bool eof;
+};
+
+int scriptParse(struct scriptInput *input, struct arena *arena,
+        const struct expandVars *vars, struct node **root);
+int scriptSource(const char *path, char **args, int numArgs,
+        struct shellState *shell);
+void scriptFree(void);
+
+#endif
@@ -0,0 +1,1101 @@
+/*******************************************************************************
+*
+* File:     serve.c
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Server mode for kell-shell:
+*
+*       kell-shell --serve /path/to/socket
+*
+*   listens on a Unix domain socket and runs the commands its clients send
+*   (see serve.h for the frames they are sent in), and
+*
+*       kell-shell --connect /path/to/socket [-c commands]
+*
+*   is a client that runs one command there, as -c would run it here.
+*
+*   Every connection is a session with a shell of its own, forked from
+*   the server when the client connects. The server has already read the
+*   environment and set up its signals, so a session starts without
+*   either, and its commands go through the same parse, redirect and
+*   exec path as any other. Its working directory, variables and
+*   functions are its own and last until the client goes, and sessions
+*   run their commands at the same time.
+*
+*   A session shell writes its output to two pipes, and after each
+*   command its exit value to a socketpair. The server watches all of
+*   them with one epoll instance, and passes output on to the client in
+*   frames as it arrives. When a command's exit value comes, its output
+*   is already in the pipes: the server reads what is left, sends the
+*   status frame and only then lets the session go on with its next
+*   command, so output never shows up after the status of a later one.
+*   Output a client is slow to take is kept, up to SERVE_PENDING_MAX
+*   bytes, after which the session's pipes are left unread until it has
+*   been sent and the session waits on them.
+*
+*   A client hanging up hangs up its session's process group, background
+*   jobs too, as closing a terminal would.
+*
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <arpa/inet.h>      // htonl()
+#include <sys/epoll.h>
+#include <sys/mman.h>       // memfd_create()
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>       // umask()
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include "arena.h"
+#include "builtins.h"       // struct shellState, exitValue()
+#include "events.h"         // eventsInit()
+#include "exec.h"           // execLine()
+#include "expand.h"         // expandInit()
+#include "input.h"
+#include "redirect.h"       // REDIRECT_FD_BASE
+#include "script.h"         // scriptParse()
+#include "serve.h"
+
+#define SERVE_CHUNK 65536               // most read from a pipe at a time
+#define SERVE_PENDING_MAX (1 << 20)     // output held for a slow client
+#define SERVE_FRAME_MAX (64 << 20)      // longest frame a session takes
+#define SERVE_BACKLOG 128
+#define SERVE_EVENTS 64
+
+// what an epoll event is about: the low two bits of its data, with the
+// session's slot above them
+enum serveWatch {
+    WATCH_STDOUT,       // the session's standard output
+    WATCH_STDERR,       // its standard error
+    WATCH_CONTROL,      // exit values from it, acknowledgements to it
+    WATCH_CLIENT        // room to write to the client, or its hang up
+};
+#define WATCH_LISTEN  UINT64_MAX
+#define WATCH_SIGNALS (UINT64_MAX - 1)
+
+struct serveSession {
+    pid_t pid;          // the session's shell, leader of its process group
+    int client;         // the connection, -1 once the client is gone
+    int fds[3];         // read ends of its stdout and stderr and the
+                        // control socket, indexed by enum serveWatch;
+                        // -1 once closed
+    char *pending;      // frames not yet written to the client
+    size_t start;       // first byte not yet written
+    size_t end;
+    size_t capacity;
+    _Bool writing;      // waiting for room to write to the client
+    _Bool throttled;    // stdout and stderr are left unread for now
+};
+
+static int epollFd = -1;
+static int listenFd = -1;
+static int signalFd = -1;
+static struct serveSession **sessions = NULL;
+static int numSlots = 0;
+
+/**
+*
+* static int serveReadAll(int fd, void *data, size_t length)
+*
+* Summary:
+*       Reads exactly length bytes
+*
+* Returns:      1 on success, 0 at end of file before the first byte, or
+*               -1 on an error or end of file part way
+*
+**/
+static int serveReadAll(int fd, void *data, size_t length)
+{
+    size_t done = 0;
+    while (done < length) {
+        ssize_t n = read(fd, (char *)data + done, length - done);
+        if (n == 0) {
+            return (done == 0) ? 0 : -1;
+        }
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        done += n;
+    }
+    return 1;
+}
+
+/**
+*
+* static int serveWriteAll(int fd, const void *data, size_t length)
+*
+* Summary:
+*       Writes exactly length bytes
+*
+* Returns:      0 on success, -1 on an error
+*
+**/
+static int serveWriteAll(int fd, const void *data, size_t length)
+{
+    size_t done = 0;
+    while (done < length) {
+        ssize_t n = write(fd, (const char *)data + done, length - done);
+        if (n == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        done += n;
+    }
+    return 0;
+}
+
+/**
+*
+* static void serveHeader(char *header, char type, size_t length)
+*
+* Summary:
+*       Fills in the SERVE_HEADER_SIZE bytes that start a frame
+*
+**/
+static void serveHeader(char *header, char type, size_t length)
+{
+    uint32_t networkLength = htonl(length);
+    header[0] = type;
+    memcpy(header + 1, &networkLength, sizeof(networkLength));
+}
+
+/**
+*
+* static int serveReadHeader(int fd, char *type, size_t *length)
+*
+* Summary:
+*       Reads the header of the next frame
+*
+* Returns:      1 on success, 0 at end of file, -1 on an error
+*
+**/
+static int serveReadHeader(int fd, char *type, size_t *length)
+{
+    char header[SERVE_HEADER_SIZE];
+    uint32_t networkLength;
+    int result = serveReadAll(fd, header, sizeof(header));
+    if (result == 1) {
+        *type = header[0];
+        memcpy(&networkLength, header + 1, sizeof(networkLength));
+        *length = ntohl(networkLength);
+    }
+    return result;
+}
+
+/**
+*
+* static int serveSend(int fd, char type, const char *data, size_t length)
+*
+* Summary:
+*       Writes a frame
+*
+* Returns:      0 on success, -1 on an error
+*
+**/
+static int serveSend(int fd, char type, const char *data, size_t length)
+{
+    char header[SERVE_HEADER_SIZE];
+    serveHeader(header, type, length);
+    if (serveWriteAll(fd, header, sizeof(header)) == -1) {
+        return -1;
+    }
+    return serveWriteAll(fd, data, length);
+}
+
+/**
+*
+* static const char *serveReadLine(struct scriptInput *input,
+*                                  enum scriptLine kind, size_t *length)
+*
+* Summary:
+*       Gives scriptParse() the next line of a command a client sent
+*
+**/
+static const char *serveReadLine(struct scriptInput *input, enum scriptLine kind,
+        size_t *length)
+{
+    struct inputReader *reader = input->context;
+    const char *line = inputReadLine(reader, length);
+    input->eof = reader->eof;
+    return line;
+}
+
+/**
+*
+* static int serveCommand(const char *text, struct arena *arena,
+*                         struct shellState *shell)
+*
+* Summary:
+*       Runs the lines of one client command in the session shell
+*
+* Parameters:   char* for the lines
+*               pointer to the arena for each command
+*               pointer to the shell state
+*
+* Returns:      the exit value to report: the value given to `exit`, or
+*               that of the last foreground command
+*
+* Description:
+*       The same loop the shell runs for -c, reading from the text.
+*
+**/
+static int serveCommand(const char *text, struct arena *arena,
+        struct shellState *shell)
+{
+    struct inputReader reader;
+    inputOpenString(&reader, text);
+    struct scriptInput input = { .readLine = serveReadLine, .context = &reader };
+
+    while (!shell->exitShell) {
+        struct expandVars vars;
+        execVars(shell, &vars);
+
+        struct node *root;
+        int result = scriptParse(&input, arena, &vars, &root);
+        if (result == 0 && reader.eof) {
+            break;
+        }
+        if (result == -1) {
+            // a syntax error: nothing of the command runs
+            shell->foregroundStatus = W_EXITCODE(2, 0);
+        }
+        else if (root) {
+            execLine(root, arena, shell);
+        }
+        arenaReset(arena);
+        shell->handleEvents(eventsWait(0, 0));
+    }
+    arenaReset(arena);
+    inputClose(&reader);
+
+    fflush(stdout);
+    fflush(stderr);
+    return shell->exitShell ? shell->exitStatus : exitValue(shell->foregroundStatus);
+}
+
+/**
+*
+* static void serveSession(int client, const int ends[3],
+*                          struct shellState *shell)
+*
+* Summary:
+*       Runs a session shell in the child forked for a client, and exits
+*
+* Parameters:   int for the connection to the client
+*               array of the write ends of the stdout and stderr pipes
+*                   and the session's end of the control socket
+*               pointer to the shell state
+*
+* Returns:      does not return
+*
+* Description:
+*       Standard input of every command is a memfd that holds what the
+*       client sent for it, empty if nothing, so a command never waits on
+*       the client. The connection and the control socket are moved out
+*       of the way of the descriptors a command line names. After each
+*       command the exit value goes to the server, and the session waits
+*       for the byte that says the server has passed the command's output
+*       on. It ends at `exit`, when the client stops sending, or when the
+*       server goes.
+*
+**/
+static void serveSession(int client, const int ends[3], struct shellState *shell)
+{
+    int connection = fcntl(client, F_DUPFD_CLOEXEC, REDIRECT_FD_BASE);
+    int control = fcntl(ends[WATCH_CONTROL], F_DUPFD_CLOEXEC, REDIRECT_FD_BASE);
+    int input = memfd_create("kell-stdin", 0);
+    if (connection == -1 || control == -1 || input == -1
+            || dup2(input, STDIN_FILENO) == -1
+            || dup2(ends[WATCH_STDOUT], STDOUT_FILENO) == -1
+            || dup2(ends[WATCH_STDERR], STDERR_FILENO) == -1) {
+        perror("kell-shell: session");
+        _exit(1);
+    }
+    close(client);
+    close(input);
+    for (int i = 0; i < 3; i++) {
+        close(ends[i]);
+    }
+
+    // a process group of its own, for the server to hang up, and a shell
+    // of its own: $$, and SIGCHLD and SIGTSTP read in its event loop
+    setpgid(0, 0);
+    expandInit(getpid());
+    struct sigaction ignore = {{0}};
+    ignore.sa_handler = SIG_IGN;
+    sigaction(SIGINT, &ignore, NULL);
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigprocmask(SIG_SETMASK, &mask, NULL);
+    if (eventsInit() == -1) {
+        perror("kell-shell: session");
+        _exit(1);
+    }
+
+    struct arena arena = { 0 };
+    char buffer[SERVE_CHUNK];
+    int value = 0;
+    char type;
+    size_t length;
+
+    while (!shell->exitShell && serveReadHeader(connection, &type, &length) == 1
+            && length <= SERVE_FRAME_MAX) {
+        if (type == SERVE_STDIN) {
+            // appended to the input of the next command
+            while (length > 0) {
+                size_t part = (length < sizeof(buffer)) ? length : sizeof(buffer);
+                if (serveReadAll(connection, buffer, part) != 1
+                        || serveWriteAll(STDIN_FILENO, buffer, part) == -1) {
+                    break;
+                }
+                length -= part;
+            }
+            if (length > 0) {
+                break;
+            }
+            continue;
+        }
+        if (type != SERVE_COMMAND) {
+            break;
+        }
+
+        char *text = malloc(length + 1);
+        if (serveReadAll(connection, text, length) != 1) {
+            free(text);
+            break;
+        }
+        text[length] = '\0';
+        lseek(STDIN_FILENO, 0, SEEK_SET);
+        value = serveCommand(text, &arena, shell);
+        free(text);
+        if (ftruncate(STDIN_FILENO, 0) == -1 || lseek(STDIN_FILENO, 0, SEEK_SET) == -1) {
+            perror("kell-shell: session");
+        }
+
+        char acknowledged;
+        if (serveWriteAll(control, &value, sizeof(value)) == -1
+                || serveReadAll(control, &acknowledged, 1) != 1) {
+            break;
+        }
+    }
+
+    arenaFree(&arena);
+    fflush(stdout);
+    _exit(value);
+}
+
+/**
+*
+* static void serveWatch(int fd, int op, uint32_t events, uint64_t data)
+*
+* Summary:
+*       Adds a descriptor to the epoll set, or changes what it waits for
+*
+**/
+static void serveWatch(int fd, int op, uint32_t events, uint64_t data)
+{
+    struct epoll_event event = { 0 };
+    event.events = events;
+    event.data.u64 = data;
+    epoll_ctl(epollFd, op, fd, &event);
+}
+
+/**
+*
+* static void serveClose(int *fd)
+*
+* Summary:
+*       Stops watching a descriptor, closes it and sets it to -1
+*
+* Description:
+*       The client connection is shared with the session shell, and epoll
+*       only drops a descriptor by itself once every copy is closed.
+*
+**/
+static void serveClose(int *fd)
+{
+    if (*fd != -1) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, *fd, NULL);
+        close(*fd);
+        *fd = -1;
+    }
+}
+
+/**
+*
+* static void serveReserve(struct serveSession *session, size_t length)
+*
+* Summary:
+*       Makes room for length more bytes of pending output
+*
+**/
+static void serveReserve(struct serveSession *session, size_t length)
+{
+    if (session->start > 0 && session->end + length > session->capacity) {
+        memmove(session->pending, session->pending + session->start,
+                session->end - session->start);
+        session->end -= session->start;
+        session->start = 0;
+    }
+    if (session->end + length > session->capacity) {
+        size_t capacity = session->capacity ? session->capacity : SERVE_CHUNK;
+        while (capacity < session->end + length) {
+            capacity *= 2;
+        }
+        session->pending = realloc(session->pending, capacity);
+        session->capacity = capacity;
+    }
+}
+
+/**
+*
+* static ssize_t serveRead(struct serveSession *session, int kind)
+*
+* Summary:
+*       Reads from a session's stdout or stderr pipe into a frame for its
+*       client
+*
+* Parameters:   pointer to the session
+*               int for WATCH_STDOUT or WATCH_STDERR
+*
+* Returns:      the number of bytes read, 0 at end of file, when the pipe
+*               is closed, or -1 if there is nothing to read
+*
+* Description:
+*       Output is read straight into place behind its frame header. It is
+*       thrown away once the client is gone.
+*
+**/
+static ssize_t serveRead(struct serveSession *session, int kind)
+{
+    serveReserve(session, SERVE_HEADER_SIZE + SERVE_CHUNK);
+    char *frame = session->pending + session->end;
+    ssize_t n = read(session->fds[kind], frame + SERVE_HEADER_SIZE, SERVE_CHUNK);
+    if (n > 0 && session->client != -1) {
+        serveHeader(frame, (kind == WATCH_STDOUT) ? SERVE_STDOUT : SERVE_STDERR, n);
+        session->end += SERVE_HEADER_SIZE + n;
+    }
+    else if (n == 0 || (n == -1 && errno != EAGAIN && errno != EINTR)) {
+        serveClose(&session->fds[kind]);
+        return 0;
+    }
+    return n;
+}
+
+/**
+*
+* static void serveDrain(struct serveSession *session)
+*
+* Summary:
+*       Reads everything that is waiting in a session's output pipes
+*
+**/
+static void serveDrain(struct serveSession *session)
+{
+    for (int kind = WATCH_STDOUT; kind <= WATCH_STDERR; kind++) {
+        while (session->fds[kind] != -1 && serveRead(session, kind) > 0) {
+        }
+    }
+}
+
+/**
+*
+* static void serveThrottle(int slot, _Bool throttled)
+*
+* Summary:
+*       Stops or starts reading a session's output pipes
+*
+**/
+static void serveThrottle(int slot, _Bool throttled)
+{
+    struct serveSession *session = sessions[slot];
+    for (int kind = WATCH_STDOUT; kind <= WATCH_STDERR; kind++) {
+        if (session->fds[kind] != -1) {
+            serveWatch(session->fds[kind], EPOLL_CTL_MOD, throttled ? 0 : EPOLLIN,
+                    (uint64_t)slot << 2 | kind);
+        }
+    }
+    session->throttled = throttled;
+}
+
+/**
+*
+* static void serveHangUp(struct serveSession *session)
+*
+* Summary:
+*       Drops a client that is gone, and hangs up its session
+*
+**/
+static void serveHangUp(struct serveSession *session)
+{
+    kill(-session->pid, SIGHUP);
+    serveClose(&session->client);
+    session->start = session->end = 0;
+}
+
+/**
+*
+* static void serveFinish(int slot)
+*
+* Summary:
+*       Frees a session once its shell has ended and its client has all
+*       of its output, or is gone
+*
+**/
+static void serveFinish(int slot)
+{
+    struct serveSession *session = sessions[slot];
+    if (session->fds[WATCH_CONTROL] != -1 || (session->client != -1
+            && session->start < session->end)) {
+        return;
+    }
+    for (int kind = WATCH_STDOUT; kind <= WATCH_STDERR; kind++) {
+        serveClose(&session->fds[kind]);
+    }
+    serveClose(&session->client);
+    free(session->pending);
+    free(session);
+    sessions[slot] = NULL;
+}
+
+/**
+*
+* static void serveFlush(int slot)
+*
+* Summary:
+*       Writes as much pending output to a session's client as it takes
+*
+* Parameters:   int for the session's slot
+*
+* Returns:      nothing.
+*
+* Description:
+*       The connection is shared with the session shell, which reads it
+*       blocking, so it is written with MSG_DONTWAIT rather than made
+*       non-blocking. What does not fit waits for EPOLLOUT.
+*
+**/
+static void serveFlush(int slot)
+{
+    struct serveSession *session = sessions[slot];
+    while (session->client != -1 && session->start < session->end) {
+        ssize_t n = send(session->client, session->pending + session->start,
+                session->end - session->start, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (n == -1 && errno == EINTR) {
+            continue;
+        }
+        if (n == -1 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if (!session->writing) {
+                serveWatch(session->client, EPOLL_CTL_MOD, EPOLLOUT,
+                        (uint64_t)slot << 2 | WATCH_CLIENT);
+                session->writing = 1;
+            }
+            if (!session->throttled && session->end - session->start > SERVE_PENDING_MAX) {
+                serveThrottle(slot, 1);
+            }
+            return;
+        }
+        if (n == -1) {
+            serveHangUp(session);
+            break;
+        }
+        session->start += n;
+    }
+
+    session->start = session->end = 0;
+    if (session->writing && session->client != -1) {
+        serveWatch(session->client, EPOLL_CTL_MOD, 0, (uint64_t)slot << 2 | WATCH_CLIENT);
+    }
+    session->writing = 0;
+    if (session->throttled) {
+        serveThrottle(slot, 0);
+    }
+    serveFinish(slot);
+}
+
+/**
+*
+* static void serveControl(int slot)
+*
+* Summary:
+*       Acts on an exit value from a session shell, or on its end
+*
+* Parameters:   int for the session's slot
+*
+* Returns:      nothing.
+*
+* Description:
+*       The command's output is in the pipes by the time its exit value
+*       is, and is sent ahead of it. Once the shell has ended, so has the
+*       session: whatever is left of its process group is hung up, as
+*       `exit` hangs up background jobs, and its client is let go once it
+*       has all of the output.
+*
+**/
+static void serveControl(int slot)
+{
+    struct serveSession *session = sessions[slot];
+    int value;
+    ssize_t n = read(session->fds[WATCH_CONTROL], &value, sizeof(value));
+    if (n == -1 && (errno == EAGAIN || errno == EINTR)) {
+        return;
+    }
+
+    serveDrain(session);
+    if (n == sizeof(value)) {
+        if (session->client != -1) {
+            uint32_t networkValue = htonl(value);
+            serveReserve(session, SERVE_HEADER_SIZE + sizeof(networkValue));
+            serveHeader(session->pending + session->end, SERVE_STATUS, sizeof(networkValue));
+            memcpy(session->pending + session->end + SERVE_HEADER_SIZE, &networkValue,
+                    sizeof(networkValue));
+            session->end += SERVE_HEADER_SIZE + sizeof(networkValue);
+        }
+        char acknowledged = 1;
+        if (send(session->fds[WATCH_CONTROL], &acknowledged, 1, MSG_NOSIGNAL) == 1) {
+            serveFlush(slot);
+            return;
+        }
+    }
+
+    kill(-session->pid, SIGHUP);
+    for (int kind = WATCH_STDOUT; kind <= WATCH_CONTROL; kind++) {
+        serveClose(&session->fds[kind]);
+    }
+    serveFlush(slot);
+}
+
+/**
+*
+* static int serveSlot(void)
+*
+* Summary:
+*       Finds a free slot in the session table, growing it if needed
+*
+**/
+static int serveSlot(void)
+{
+    for (int slot = 0; slot < numSlots; slot++) {
+        if (!sessions[slot]) {
+            return slot;
+        }
+    }
+    int slot = numSlots;
+    numSlots = numSlots ? numSlots * 2 : 16;
+    sessions = realloc(sessions, numSlots * sizeof(struct serveSession *));
+    memset(sessions + slot, 0, (numSlots - slot) * sizeof(struct serveSession *));
+    return slot;
+}
+
+/**
+*
+* static void serveStart(int client, struct shellState *shell)
+*
+* Summary:
+*       Forks the session shell for a new client and starts watching it
+*
+* Parameters:   int for the accepted connection
+*               pointer to the shell state
+*
+* Returns:      nothing.
+*
+* Description:
+*       The child closes what the server holds: the listening socket, the
+*       epoll and signal descriptors, and the connections and pipes of
+*       every other session, which it must not keep open.
+*
+**/
+static void serveStart(int client, struct shellState *shell)
+{
+    int out[2], err[2], control[2];
+    if (pipe2(out, O_CLOEXEC) == -1) {
+        perror("kell-shell: session");
+        close(client);
+        return;
+    }
+    if (pipe2(err, O_CLOEXEC) == -1) {
+        perror("kell-shell: session");
+        close(out[0]);
+        close(out[1]);
+        close(client);
+        return;
+    }
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, control) == -1) {
+        perror("kell-shell: session");
+        close(out[0]);
+        close(out[1]);
+        close(err[0]);
+        close(err[1]);
+        close(client);
+        return;
+    }
+
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(listenFd);
+        close(epollFd);
+        close(signalFd);
+        for (int slot = 0; slot < numSlots; slot++) {
+            struct serveSession *other = sessions[slot];
+            for (int kind = WATCH_STDOUT; other && kind <= WATCH_CONTROL; kind++) {
+                if (other->fds[kind] != -1) {
+                    close(other->fds[kind]);
+                }
+            }
+            if (other && other->client != -1) {
+                close(other->client);
+            }
+        }
+        close(out[0]);
+        close(err[0]);
+        close(control[0]);
+        int ends[3] = { out[1], err[1], control[1] };
+        serveSession(client, ends, shell);
+    }
+    close(out[1]);
+    close(err[1]);
+    close(control[1]);
+    if (pid == -1) {
+        perror("kell-shell: session");
+        close(out[0]);
+        close(err[0]);
+        close(control[0]);
+        close(client);
+        return;
+    }
+    // as the child does, so a hang up right away reaches it
+    setpgid(pid, pid);
+
+    int slot = serveSlot();
+    struct serveSession *session = calloc(1, sizeof(struct serveSession));
+    session->pid = pid;
+    session->client = client;
+    session->fds[WATCH_STDOUT] = out[0];
+    session->fds[WATCH_STDERR] = err[0];
+    session->fds[WATCH_CONTROL] = control[0];
+    sessions[slot] = session;
+
+    for (int kind = WATCH_STDOUT; kind <= WATCH_CONTROL; kind++) {
+        fcntl(session->fds[kind], F_SETFL, O_NONBLOCK);
+        serveWatch(session->fds[kind], EPOLL_CTL_ADD, EPOLLIN, (uint64_t)slot << 2 | kind);
+    }
+    // no events asked for: only a hang up or an error is reported
+    serveWatch(client, EPOLL_CTL_ADD, 0, (uint64_t)slot << 2 | WATCH_CLIENT);
+}
+
+/**
+*
+* static int serveListen(const char *path)
+*
+* Summary:
+*       Creates the listening socket at path
+*
+* Returns:      the socket, or -1 with errno set
+*
+* Description:
+*       A socket file left behind by a server that is gone is replaced;
+*       one a server still answers on is not. The socket file is made
+*       under a umask of 077, so no other user can connect to it.
+*
+**/
+static int serveListen(const char *path)
+{
+    struct sockaddr_un address = { .sun_family = AF_UNIX };
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    strcpy(address.sun_path, path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        return -1;
+    }
+    mode_t oldMask = umask(077);
+    int bound = bind(fd, (struct sockaddr *)&address, sizeof(address));
+    if (bound == -1 && errno == EADDRINUSE) {
+        int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        _Bool stale = (probe != -1
+                && connect(probe, (struct sockaddr *)&address, sizeof(address)) == -1
+                && errno == ECONNREFUSED);
+        if (probe != -1) {
+            close(probe);
+        }
+        if (stale && unlink(path) == 0) {
+            bound = bind(fd, (struct sockaddr *)&address, sizeof(address));
+        }
+        else {
+            errno = EADDRINUSE;
+        }
+    }
+    umask(oldMask);
+    if (bound == -1 || listen(fd, SERVE_BACKLOG) == -1) {
+        int saved = errno;
+        close(fd);
+        errno = saved;
+        return -1;
+    }
+    return fd;
+}
+
+/**
+*
+* int serveRun(const char *path, struct shellState *shell)
+*
+* Summary:
+*       Serves clients on a Unix domain socket until SIGINT, SIGTERM or
+*       SIGHUP
+*
+* Parameters:   char* for the path of the socket
+*               pointer to the shell state every session starts with
+*
+* Returns:      0 when stopped, 1 if the socket cannot be set up
+*
+* Description:
+*       The signals are read from a signalfd in the same epoll set as the
+*       sessions, SIGCHLD to reap session shells. New connections are
+*       taken after the other events of a wait, so a slot freed by one of
+*       them is not reused while an event for it may still be pending.
+*       A connection from a process of another user is closed unanswered.
+*       Stopping hangs up every session and removes the socket file.
+*
+**/
+int serveRun(const char *path, struct shellState *shell)
+{
+    // a closed standard descriptor would be handed out as a session pipe
+    int fd;
+    while ((fd = open("/dev/null", O_RDWR)) != -1 && fd <= STDERR_FILENO) {
+    }
+    if (fd != -1) {
+        close(fd);
+    }
+
+    listenFd = serveListen(path);
+    if (listenFd == -1) {
+        fprintf(stderr, "kell-shell: %s: %s\n", path, strerror(errno));
+        return 1;
+    }
+
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGCHLD);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    sigaddset(&mask, SIGHUP);
+    struct sigaction standard = {{0}};
+    standard.sa_handler = SIG_DFL;
+    sigaction(SIGINT, &standard, NULL);     // ignored signals never arrive
+    sigprocmask(SIG_BLOCK, &mask, NULL);
+    signalFd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (signalFd == -1 || epollFd == -1) {
+        perror("kell-shell: serve");
+        close(listenFd);
+        unlink(path);
+        return 1;
+    }
+    serveWatch(listenFd, EPOLL_CTL_ADD, EPOLLIN, WATCH_LISTEN);
+    serveWatch(signalFd, EPOLL_CTL_ADD, EPOLLIN, WATCH_SIGNALS);
+
+    _Bool stopping = 0;
+    while (!stopping) {
+        struct epoll_event ready[SERVE_EVENTS];
+        int n = epoll_wait(epollFd, ready, SERVE_EVENTS, -1);
+        _Bool connecting = 0;
+
+        for (int i = 0; i < n; i++) {
+            uint64_t data = ready[i].data.u64;
+            if (data == WATCH_LISTEN) {
+                connecting = 1;
+                continue;
+            }
+            if (data == WATCH_SIGNALS) {
+                struct signalfd_siginfo info;
+                while (read(signalFd, &info, sizeof(info)) == sizeof(info)) {
+                    stopping |= (info.ssi_signo != SIGCHLD);
+                }
+                while (waitpid(-1, NULL, WNOHANG) > 0) {
+                }
+                continue;
+            }
+
+            int slot = data >> 2;
+            int kind = data & 3;
+            struct serveSession *session = sessions[slot];
+            if (!session) {
+                // freed by an earlier event of this wait
+                continue;
+            }
+            if (kind == WATCH_STDOUT || kind == WATCH_STDERR) {
+                if (session->fds[kind] != -1) {
+                    serveRead(session, kind);
+                    serveFlush(slot);
+                }
+            }
+            else if (kind == WATCH_CONTROL) {
+                serveControl(slot);
+            }
+            else if (ready[i].events & (EPOLLHUP | EPOLLERR)) {
+                serveHangUp(session);
+                serveFinish(slot);
+            }
+            else {
+                serveFlush(slot);
+            }
+        }
+
+        while (connecting && !stopping) {
+            int client = accept4(listenFd, NULL, NULL, SOCK_CLOEXEC);
+            if (client == -1) {
+                break;
+            }
+            struct ucred peer;
+            socklen_t length = sizeof(peer);
+            if (getsockopt(client, SOL_SOCKET, SO_PEERCRED, &peer, &length) == -1
+                    || peer.uid != geteuid()) {
+                close(client);
+                continue;
+            }
+            serveStart(client, shell);
+        }
+    }
+
+    for (int slot = 0; slot < numSlots; slot++) {
+        struct serveSession *session = sessions[slot];
+        if (session) {
+            kill(-session->pid, SIGHUP);
+            for (int kind = WATCH_STDOUT; kind <= WATCH_CONTROL; kind++) {
+                serveClose(&session->fds[kind]);
+            }
+            serveClose(&session->client);
+            free(session->pending);
+            free(session);
+        }
+    }
+    free(sessions);
+    close(listenFd);
+    close(signalFd);
+    close(epollFd);
+    unlink(path);
+    return 0;
+}
+
+/**
+*
+* int serveConnect(const char *path, const char *command)
+*
+* Summary:
+*       Runs a command in a new session of the server at path
+*
+* Parameters:   char* for the path of the socket
+*               char* for the command lines, or NULL to send the lines
+*                   read from stdin
+*
+* Returns:      the exit value of the command, or 1 if the server cannot
+*               be reached or goes away before it ends
+*
+* Description:
+*       With a command, stdin is its input unless it is a terminal. The
+*       output is copied to stdout and stderr as it comes.
+*
+**/
+int serveConnect(const char *path, const char *command)
+{
+    struct sockaddr_un address = { .sun_family = AF_UNIX };
+    int fd = -1;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        errno = ENAMETOOLONG;
+    }
+    else {
+        strcpy(address.sun_path, path);
+        fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    }
+    if (fd == -1 || connect(fd, (struct sockaddr *)&address, sizeof(address)) == -1) {
+        fprintf(stderr, "kell-shell: %s: %s\n", path, strerror(errno));
+        if (fd != -1) {
+            close(fd);
+        }
+        return 1;
+    }
+    signal(SIGPIPE, SIG_IGN);
+
+    char buffer[SERVE_CHUNK];
+    ssize_t n;
+    int sent = 0;
+    if (command) {
+        if (!isatty(STDIN_FILENO)) {
+            while (sent == 0 && (n = read(STDIN_FILENO, buffer, sizeof(buffer))) > 0) {
+                sent = serveSend(fd, SERVE_STDIN, buffer, n);
+            }
+        }
+        if (sent == 0) {
+            sent = serveSend(fd, SERVE_COMMAND, command, strlen(command));
+        }
+    }
+    else {
+        char *text = NULL;
+        size_t length = 0;
+        size_t capacity = 0;
+        do {
+            if (length + sizeof(buffer) > capacity) {
+                capacity = capacity ? capacity * 2 : sizeof(buffer);
+                text = realloc(text, capacity);
+            }
+            n = read(STDIN_FILENO, text + length, capacity - length);
+            length += (n > 0) ? n : 0;
+        } while (n > 0 || (n == -1 && errno == EINTR));
+        sent = serveSend(fd, SERVE_COMMAND, text, length);
+        free(text);
+    }
+    // the session ends after this command
+    shutdown(fd, SHUT_WR);
+
+    int status = -1;
+    char type;
+    size_t length;
+    while (sent == 0 && status == -1 && serveReadHeader(fd, &type, &length) == 1) {
+        if (type == SERVE_STATUS && length == sizeof(uint32_t)) {
+            uint32_t networkValue;
+            if (serveReadAll(fd, &networkValue, sizeof(networkValue)) == 1) {
+                status = ntohl(networkValue);
+            }
+            break;
+        }
+        int out = (type == SERVE_STDERR) ? STDERR_FILENO : STDOUT_FILENO;
+        while (length > 0) {
+            size_t part = (length < sizeof(buffer)) ? length : sizeof(buffer);
+            if (serveReadAll(fd, buffer, part) != 1) {
+                break;
+            }
+            serveWriteAll(out, buffer, part);
+            length -= part;
+        }
+        if (length > 0) {
+            break;
+        }
+    }
+    close(fd);
+
+    if (status == -1) {
+        fprintf(stderr, "kell-shell: %s: connection closed\n", path);
+        return 1;
+    }
+    return status;
+}
@@ -0,0 +1,37 @@
+/*******************************************************************************
+*
+* File:     serve.h
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Interface for the kell-shell server, which runs the commands of many
+*   clients over a Unix domain socket (--serve), and for the client that
+*   sends it one (--connect).
+*
+*   Both directions are a stream of frames: a type byte, a length of 4
+*   bytes in network order and that many bytes. A client sends any number
+*   of SERVE_STDIN frames, the input of its next command, and then the
+*   SERVE_COMMAND frame with its lines. The server answers with the
+*   command's output as it is written and ends with a SERVE_STATUS frame.
+*
+******************************************************************************/
+#ifndef SERVE_H
+#define SERVE_H
+
+struct shellState;
+
+#define SERVE_HEADER_SIZE 5
+
+#define SERVE_STDIN   'I'   // to the server: input for the next command
+#define SERVE_COMMAND 'C'   // to the server: command lines to run
+#define SERVE_STDOUT  'O'   // to the client: standard output of the command
+#define SERVE_STDERR  'E'   // to the client: standard error of the command
+#define SERVE_STATUS  'X'   // to the client: exit value, 4 bytes in network
+                            // order, after all of the command's output
+
+int serveRun(const char *path, struct shellState *shell);
+int serveConnect(const char *path, const char *command);
+
+#endif
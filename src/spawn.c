@@ -0,0 +1,499 @@
+/*******************************************************************************
+*
+* File:     spawn.c
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Spawn engine for kell-shell. Every non-built-in command is launched
+*   through spawnCommand(), which either uses posix_spawn (file actions for
+*   redirection, spawn attributes for signal dispositions) or falls back to
+*   the original fork() + execvp path. The mode can be selected at startup
+*   with the KELL_SPAWN environment variable (`spawn` or `fork`).
+*
+*   Both modes report failures back to the parent, so the shell can print
+*   the same messages regardless of how the child was created. An
+*   executable file the kernel cannot run, a script without `#!`, is run
+*   with /bin/sh instead, as execvp() does.
+*
+*   Redirections arrive as a plan prepared by redirectPrepare(): the files
+*   are already open in the shell, so either mode only copies and closes
+*   descriptors, in the same order, and cannot fail part way through a
+*   redirection.
+*
+*   A request can also run a function of the shell in the child instead
+*   of a program, for subshells. That always takes the fork() path.
+*
+******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <spawn.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <paths.h>      // _PATH_BSHELL
+#include <sys/wait.h>
+
+#include "redirect.h"
+#include "spawn.h"
+
+enum spawnMode spawnMode = SPAWN_POSIX;
+
+// error record written by a forked child when it fails before exec
+struct spawnReport {
+    int failure;
+    int error;
+};
+
+/**
+*
+* int spawnSetMode(const char *name)
+*
+* Summary:
+*       Selects the spawn mode by name
+*
+* Parameters:   char* for the mode name, `spawn` or `fork`
+*
+* Returns:      0 on success, -1 if the name is not recognized
+*
+**/
+int spawnSetMode(const char *name)
+{
+    if (strcmp(name, "spawn") == 0) {
+        spawnMode = SPAWN_POSIX;
+    }
+    else if (strcmp(name, "fork") == 0) {
+        spawnMode = SPAWN_FORK;
+    }
+    else {
+        return -1;
+    }
+    return 0;
+}
+
+/**
+*
+* const char *spawnModeName(enum spawnMode mode)
+*
+* Summary:
+*       Returns the printable name of a spawn mode
+*
+* Parameters:   enum spawnMode for the mode
+*
+* Returns:      a static string
+*
+**/
+const char *spawnModeName(enum spawnMode mode)
+{
+    return (mode == SPAWN_FORK) ? "fork" : "spawn";
+}
+
+/**
+*
+* static void spawnFailChild(int fd, enum spawnFailure failure)
+*
+* Summary:
+*       Reports a pre-exec failure to the parent and exits the child
+*
+* Parameters:   int for the write end of the report pipe
+*               enum spawnFailure for the step that failed
+*
+* Returns:      does not return
+*
+* Description:
+*       Only async-signal-safe calls are made here since the child is a copy
+*       of the shell that has not yet exec'd.
+*
+**/
+static void spawnFailChild(int fd, enum spawnFailure failure)
+{
+    struct spawnReport report = { failure, errno };
+    write(fd, &report, sizeof(report));
+    _exit(1);
+}
+
+/**
+*
+* static void spawnShellArgv(char **argv, const char *path,
+*                            char **shellArgv)
+*
+* Summary:
+*       Fills in the argument list that runs a script without `#!` with
+*       /bin/sh: the shell, the script's path and the command's arguments
+*
+* Parameters:   array of the command's arguments
+*               char* for the path of the script
+*               array with room for the arguments and two more
+*
+* Returns:      nothing.
+*
+**/
+static void spawnShellArgv(char **argv, const char *path, char **shellArgv)
+{
+    shellArgv[0] = _PATH_BSHELL;
+    shellArgv[1] = (char *)path;
+    for (int i = 1; argv[i - 1]; i++) {
+        shellArgv[i + 1] = argv[i];
+    }
+}
+
+/**
+*
+* static int spawnArgc(char **argv)
+*
+* Summary:
+*       Counts the arguments of a command
+*
+**/
+static int spawnArgc(char **argv)
+{
+    int argc = 0;
+    while (argv[argc]) {
+        argc++;
+    }
+    return argc;
+}
+
+/**
+*
+* static void spawnCloseOnExec(void)
+*
+* Summary:
+*       Closes every close-on-exec descriptor, as exec would
+*
+* Description:
+*       A subshell child does not exec, so the shell's own descriptors stay
+*       open in it. They include the read ends of pipeline pipes, which
+*       would keep a writer in the subshell from ever seeing EPIPE.
+*
+**/
+static void spawnCloseOnExec(void)
+{
+    DIR *dir = opendir("/proc/self/fd");
+    if (!dir) {
+        return;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir))) {
+        int fd = atoi(entry->d_name);
+        int flags;
+        if (fd > STDERR_FILENO && fd != dirfd(dir)
+                && (flags = fcntl(fd, F_GETFD)) != -1 && (flags & FD_CLOEXEC)) {
+            close(fd);
+        }
+    }
+    closedir(dir);
+}
+
+/**
+*
+* static pid_t spawnFork(const struct spawnRequest *req,
+*                        enum spawnFailure *failure)
+*
+* Summary:
+*       Launches a command with fork() and execve(), or execvpe() when the
+*       request has no resolved path
+*
+* Parameters:   pointer to the spawn request
+*               pointer to enum spawnFailure set on error
+*
+* Returns:      child pid, or -1 on failure
+*
+* Description:
+*       A close-on-exec pipe is shared with the child. If exec succeeds the
+*       pipe closes with nothing written; otherwise the child writes which
+*       step failed along with errno, and the parent reaps it. A subshell
+*       child closes its end itself before it runs.
+*
+**/
+static pid_t spawnFork(const struct spawnRequest *req, enum spawnFailure *failure)
+{
+    int reportPipe[2];
+    if (pipe2(reportPipe, O_CLOEXEC) == -1) {
+        *failure = SPAWN_FAIL_SYSTEM;
+        return -1;
+    }
+
+    pid_t spawnPid = fork();
+    if (spawnPid == -1) {
+        int error = errno;
+        close(reportPipe[0]);
+        close(reportPipe[1]);
+        errno = error;
+        *failure = SPAWN_FAIL_SYSTEM;
+        return -1;
+    }
+
+    if (spawnPid == 0) {
+        close(reportPipe[0]);
+
+        // children start with nothing blocked, whatever the shell blocks
+        sigset_t emptyMask;
+        sigemptyset(&emptyMask);
+        sigprocmask(SIG_SETMASK, &emptyMask, NULL);
+
+        // a job of its own, before exec so the shell can count on it
+        if (req->jobControl && setpgid(0, req->processGroup) == -1) {
+            spawnFailChild(reportPipe[1], SPAWN_FAIL_SYSTEM);
+        }
+
+        // foreground children do not ignore SIGINT; SIGTSTP stops jobs
+        // under job control and is ignored otherwise; the shell's ignored
+        // SIGTTIN and SIGTTOU are not passed on
+        struct sigaction action = {{0}};
+        action.sa_handler = SIG_DFL;
+        if (req->defaultSIGINT) {
+            sigaction(SIGINT, &action, NULL);
+        }
+        sigaction(SIGTTIN, &action, NULL);
+        sigaction(SIGTTOU, &action, NULL);
+        action.sa_handler = (req->jobControl || req->defaultSIGTSTP) ? SIG_DFL : SIG_IGN;
+        sigaction(SIGTSTP, &action, NULL);
+
+        // pipe ends are close-on-exec, dup2 gives the child inheritable copies
+        if (req->inputFd != -1 && dup2(req->inputFd, STDIN_FILENO) == -1) {
+            spawnFailChild(reportPipe[1], SPAWN_FAIL_SYSTEM);
+        }
+        if (req->outputFd != -1 && dup2(req->outputFd, STDOUT_FILENO) == -1) {
+            spawnFailChild(reportPipe[1], SPAWN_FAIL_SYSTEM);
+        }
+
+        // then the redirections, the shell's close-on-exec copies vanish at exec
+        for (int i = 0; i < req->numRedirects; i++) {
+            const struct redirect *step = &req->redirects[i];
+            if (step->action == REDIRECT_CLOSE) {
+                close(step->fd);
+            }
+            else if (step->source == step->fd) {
+                // dup2 onto itself would leave close-on-exec set
+                fcntl(step->fd, F_SETFD, 0);
+            }
+            else if (dup2(step->source, step->fd) == -1) {
+                spawnFailChild(reportPipe[1], SPAWN_FAIL_SYSTEM);
+            }
+        }
+
+        if (req->run) {
+            spawnCloseOnExec();
+            req->run(req->runArg);
+            _exit(1);
+        }
+        if (req->path) {
+            execve(req->path, req->argv, req->envp);
+            if (errno == ENOEXEC) {
+                char *shellArgv[spawnArgc(req->argv) + 2];
+                spawnShellArgv(req->argv, req->path, shellArgv);
+                execve(_PATH_BSHELL, shellArgv, req->envp);
+            }
+        }
+        else {
+            // searches PATH and falls back to /bin/sh itself
+            execvpe(req->argv[0], req->argv, req->envp);
+        }
+        spawnFailChild(reportPipe[1], SPAWN_FAIL_EXEC);
+    }
+
+    // parent: also set the group, whichever of the two runs first wins
+    if (req->jobControl) {
+        setpgid(spawnPid, req->processGroup ? req->processGroup : spawnPid);
+    }
+
+    // an empty read means the exec succeeded
+    close(reportPipe[1]);
+    struct spawnReport report;
+    ssize_t n;
+    do {
+        n = read(reportPipe[0], &report, sizeof(report));
+    } while (n == -1 && errno == EINTR);
+    close(reportPipe[0]);
+
+    if (n == sizeof(report)) {
+        waitpid(spawnPid, NULL, 0);
+        *failure = report.failure;
+        errno = report.error;
+        return -1;
+    }
+    return spawnPid;
+}
+
+/**
+*
+* static pid_t spawnPosix(const struct spawnRequest *req,
+*                         enum spawnFailure *failure)
+*
+* Summary:
+*       Launches a command with posix_spawn(), or posix_spawnp() when the
+*       request has no resolved path
+*
+* Parameters:   pointer to the spawn request
+*               pointer to enum spawnFailure set on error
+*
+* Returns:      child pid, or -1 on failure
+*
+* Description:
+*       A file that is not a program the kernel can run, ENOEXEC, is run
+*       again as a script of /bin/sh.
+*
+*       Pipe ends and redirections become file actions and SIGINT is reset
+*       through the spawn attributes, as are SIGTTIN and SIGTTOU, which
+*       the shell ignores under job control. Job control children get
+*       their process group and a default SIGTSTP the same way, as do
+*       children asking for defaultSIGTSTP. There is
+*       no attribute for ignoring a signal, so for other children SIGTSTP
+*       is blocked and set to SIG_IGN in the parent for the duration of
+*       the call; ignored dispositions survive exec. A SIGTSTP arriving in
+*       that short window is discarded.
+*
+**/
+static pid_t spawnPosix(const struct spawnRequest *req, enum spawnFailure *failure)
+{
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    if (req->inputFd != -1) {
+        posix_spawn_file_actions_adddup2(&actions, req->inputFd, STDIN_FILENO);
+    }
+    if (req->outputFd != -1) {
+        posix_spawn_file_actions_adddup2(&actions, req->outputFd, STDOUT_FILENO);
+    }
+    for (int i = 0; i < req->numRedirects; i++) {
+        const struct redirect *step = &req->redirects[i];
+        if (step->action == REDIRECT_CLOSE) {
+            posix_spawn_file_actions_addclose(&actions, step->fd);
+        }
+        else {
+            // glibc clears close-on-exec when source and fd are the same
+            posix_spawn_file_actions_adddup2(&actions, step->source, step->fd);
+        }
+    }
+
+    sigset_t tstpSet, oldMask, defaults, emptyMask;
+    sigemptyset(&emptyMask);
+    sigemptyset(&tstpSet);
+    sigaddset(&tstpSet, SIGTSTP);
+    sigprocmask(SIG_BLOCK, &tstpSet, &oldMask);
+
+    sigemptyset(&defaults);
+    if (req->defaultSIGINT) {
+        sigaddset(&defaults, SIGINT);
+    }
+    sigaddset(&defaults, SIGTTIN);
+    sigaddset(&defaults, SIGTTOU);
+
+    posix_spawnattr_t attr;
+    short flags = POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK;
+    posix_spawnattr_init(&attr);
+    posix_spawnattr_setsigmask(&attr, &emptyMask);
+
+    struct sigaction ignore = {{0}};
+    struct sigaction saved;
+    ignore.sa_handler = SIG_IGN;
+    _Bool stoppable = (req->jobControl || req->defaultSIGTSTP);
+    if (req->jobControl) {
+        posix_spawnattr_setpgroup(&attr, req->processGroup);
+        flags |= POSIX_SPAWN_SETPGROUP;
+    }
+    if (stoppable) {
+        sigaddset(&defaults, SIGTSTP);
+    }
+    else {
+        sigaction(SIGTSTP, &ignore, &saved);
+    }
+    posix_spawnattr_setsigdefault(&attr, &defaults);
+    posix_spawnattr_setflags(&attr, flags);
+
+    pid_t spawnPid;
+    int error;
+    if (req->path) {
+        error = posix_spawn(&spawnPid, req->path, &actions, &attr,
+                req->argv, req->envp);
+    }
+    else {
+        error = posix_spawnp(&spawnPid, req->argv[0], &actions, &attr,
+                req->argv, req->envp);
+    }
+    if (error == ENOEXEC) {
+        // posix_spawn() leaves the /bin/sh fallback of execvp() out
+        const char *script = req->path ? req->path : req->argv[0];
+        char *shellArgv[spawnArgc(req->argv) + 2];
+        spawnShellArgv(req->argv, script, shellArgv);
+        error = posix_spawn(&spawnPid, _PATH_BSHELL, &actions, &attr,
+                shellArgv, req->envp);
+    }
+
+    if (!stoppable) {
+        sigaction(SIGTSTP, &saved, NULL);
+    }
+    sigprocmask(SIG_SETMASK, &oldMask, NULL);
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+
+    if (error == 0) {
+        return spawnPid;
+    }
+
+    if (error == EAGAIN || error == ENOMEM || error == EBADF) {
+        *failure = SPAWN_FAIL_SYSTEM;
+    }
+    else {
+        *failure = SPAWN_FAIL_EXEC;
+    }
+    errno = error;
+    return -1;
+}
+
+/**
+*
+* pid_t spawnCommand(const struct spawnRequest *req,
+*                    enum spawnFailure *failure)
+*
+* Summary:
+*       Launches a command using the current spawn mode
+*
+* Parameters:   pointer to the spawn request
+*               pointer to enum spawnFailure set on error
+*
+* Returns:      child pid, or -1 on failure with errno set
+*
+**/
+pid_t spawnCommand(const struct spawnRequest *req, enum spawnFailure *failure)
+{
+    *failure = SPAWN_FAIL_NONE;
+    if (spawnMode == SPAWN_FORK || req->run) {
+        return spawnFork(req, failure);
+    }
+    return spawnPosix(req, failure);
+}
+
+/**
+*
+* void spawnPrintError(const struct spawnRequest *req,
+*                      enum spawnFailure failure)
+*
+* Summary:
+*       Prints the message for a failed spawn
+*
+* Parameters:   pointer to the spawn request that failed
+*               enum spawnFailure returned by spawnCommand
+*
+* Returns:      nothing. prints error
+*
+* Description:
+*       The reason is errno as the failed spawn left it.
+*
+**/
+void spawnPrintError(const struct spawnRequest *req, enum spawnFailure failure)
+{
+    switch (failure) {
+        case SPAWN_FAIL_EXEC:
+            printf("%s: %s\n", req->argv[0], strerror(errno));
+            break;
+        default:
+            perror("spawn");
+            break;
+    }
+    fflush(stdout);
+}
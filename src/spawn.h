@@ -0,0 +1,55 @@
+/*******************************************************************************
+*
+* File:     spawn.h
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Interface for the kell-shell spawn engine. Commands are launched either
+*   with posix_spawn (the default, which avoids copying the shell's page
+*   tables) or with the classic fork() + exec path.
+*
+******************************************************************************/
+#ifndef SPAWN_H
+#define SPAWN_H
+
+#include <sys/types.h>
+
+struct redirect;
+
+enum spawnMode {
+    SPAWN_POSIX,    // posix_spawn, vfork-style clone in glibc
+    SPAWN_FORK      // fork() followed by exec in the child
+};
+
+enum spawnFailure {
+    SPAWN_FAIL_NONE,
+    SPAWN_FAIL_EXEC,    // command could not be executed
+    SPAWN_FAIL_SYSTEM   // fork/posix_spawn itself failed
+};
+
+struct spawnRequest {
+    char **argv;            // NULL terminated argument list
+    const char *path;       // resolved executable, NULL to search PATH
+    char **envp;            // environment of the command
+    int inputFd;            // pipe end for stdin, -1 to inherit
+    int outputFd;           // pipe end for stdout, -1 to inherit
+    const struct redirect *redirects;   // prepared plan, applied after
+    int numRedirects;                   // the pipe ends
+    _Bool defaultSIGINT;    // child gets default SIGINT (foreground jobs)
+    _Bool jobControl;       // child joins processGroup and may be stopped
+    pid_t processGroup;     // with jobControl: group to join, 0 to lead one
+    _Bool defaultSIGTSTP;   // child may be stopped without job control
+    void (*run)(void *arg); // subshell: called in a forked child in place
+    void *runArg;           // of exec, must not return; argv is not run
+};
+
+extern enum spawnMode spawnMode;
+
+int spawnSetMode(const char *name);
+const char *spawnModeName(enum spawnMode mode);
+pid_t spawnCommand(const struct spawnRequest *req, enum spawnFailure *failure);
+void spawnPrintError(const struct spawnRequest *req, enum spawnFailure failure);
+
+#endif
@@ -0,0 +1,255 @@
+/*******************************************************************************
+*
+* File:     stats.c
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Per-phase latency histograms for kell-shell.
+*
+*   The histograms are HDR-style: every power of two is split into 8
+*   linear buckets, so any recorded latency is kept to within 12.5% using a
+*   fixed table of 304 counters per phase that covers 1ns to about 18
+*   minutes. Recording is a clock_gettime() call, a count-leading-zeros and
+*   a few adds, with no allocation. Percentiles are read back from the
+*   buckets and reported as the top of the bucket they fall in, clamped to
+*   the largest value seen.
+*
+*   `shstats` prints the table and `shstats -r` clears it. With
+*   KELL_SHSTATS set, the table is also printed when the shell exits: to
+*   stderr for `1` or `-`, otherwise appended to the named file.
+*
+******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "stats.h"
+
+#ifdef KELL_STATS
+
+static const char *phaseNames[STATS_PHASES] = {
+    "read", "lex", "parse", "builtin", "redirect", "spawn", "wait", "reap"
+};
+
+#define STATS_SUB_BITS 3                            // 8 buckets per power of 2
+#define STATS_SUB_COUNT (1 << STATS_SUB_BITS)
+#define STATS_MAGNITUDES 40                         // up to 2^40 ns
+#define STATS_BUCKETS ((STATS_MAGNITUDES - 2) * STATS_SUB_COUNT)
+
+struct histogram {
+    uint64_t count;
+    uint64_t total;     // sum of all values, for the mean
+    uint64_t min;
+    uint64_t max;
+    uint32_t buckets[STATS_BUCKETS];
+};
+
+static struct histogram histograms[STATS_PHASES];
+
+/**
+*
+* static int bucketIndex(uint64_t ns)
+*
+* Summary:
+*       Histogram bucket of a latency
+*
+* Parameters:   uint64_t for the latency in nanoseconds
+*
+* Returns:      index into the bucket array
+*
+* Description:
+*       Values below 8 get a bucket each. Above that, the position of the
+*       highest set bit picks the power of two and the next 3 bits pick
+*       one of its 8 sub-buckets.
+*
+**/
+static int bucketIndex(uint64_t ns)
+{
+    if (ns < STATS_SUB_COUNT) {
+        return ns;
+    }
+    int magnitude = 63 - __builtin_clzll(ns);
+    if (magnitude >= STATS_MAGNITUDES) {
+        return STATS_BUCKETS - 1;
+    }
+    int sub = (ns >> (magnitude - STATS_SUB_BITS)) & (STATS_SUB_COUNT - 1);
+    return (magnitude - STATS_SUB_BITS + 1) * STATS_SUB_COUNT + sub;
+}
+
+/**
+*
+* static uint64_t bucketTop(int index)
+*
+* Summary:
+*       Largest latency that falls in a bucket
+*
+* Parameters:   int for the bucket index
+*
+* Returns:      the latency in nanoseconds
+*
+**/
+static uint64_t bucketTop(int index)
+{
+    if (index < STATS_SUB_COUNT) {
+        return index;
+    }
+    int magnitude = index / STATS_SUB_COUNT + STATS_SUB_BITS - 1;
+    int sub = index % STATS_SUB_COUNT;
+    uint64_t width = (uint64_t)1 << (magnitude - STATS_SUB_BITS);
+    return (STATS_SUB_COUNT + sub) * width + width - 1;
+}
+
+/**
+*
+* void statsRecord(enum statsPhase phase, const struct timespec *start)
+*
+* Summary:
+*       Records the time since start in the histogram of a phase
+*
+* Parameters:   enum statsPhase for the phase that just finished
+*               pointer to the CLOCK_MONOTONIC time the phase started
+*
+* Returns:      nothing.
+*
+**/
+void statsRecord(enum statsPhase phase, const struct timespec *start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t elapsed = (int64_t)(now.tv_sec - start->tv_sec) * 1000000000
+            + (now.tv_nsec - start->tv_nsec);
+    uint64_t ns = elapsed > 0 ? elapsed : 0;
+
+    struct histogram *h = &histograms[phase];
+    if (h->count == 0 || ns < h->min) {
+        h->min = ns;
+    }
+    if (ns > h->max) {
+        h->max = ns;
+    }
+    h->count++;
+    h->total += ns;
+    h->buckets[bucketIndex(ns)]++;
+}
+
+/**
+*
+* static uint64_t percentile(const struct histogram *h, double fraction)
+*
+* Summary:
+*       Reads a percentile back from a histogram
+*
+* Parameters:   pointer to the histogram, which holds at least one value
+*               double for the percentile as a fraction, such as 0.99
+*
+* Returns:      the latency in nanoseconds
+*
+**/
+static uint64_t percentile(const struct histogram *h, double fraction)
+{
+    uint64_t rank = fraction * h->count + 0.5;
+    uint64_t seen = 0;
+    if (rank < 1) {
+        rank = 1;
+    }
+    for (int i = 0; i < STATS_BUCKETS; i++) {
+        seen += h->buckets[i];
+        if (seen >= rank) {
+            uint64_t top = bucketTop(i);
+            return top < h->max ? top : h->max;
+        }
+    }
+    return h->max;
+}
+
+/**
+*
+* int statsPrint(FILE *out)
+*
+* Summary:
+*       Prints count, min, mean, p50, p90, p99 and max of every phase
+*
+* Parameters:   FILE* to print to
+*
+* Returns:      0, or 1 if the statistics were compiled out
+*
+* Description:
+*       Times are in microseconds. Phases that never ran are left out.
+*
+**/
+int statsPrint(FILE *out)
+{
+    fprintf(out, "%-9s %9s %10s %10s %10s %10s %10s %10s\n", "phase(us)",
+            "count", "min", "mean", "p50", "p90", "p99", "max");
+    for (int phase = 0; phase < STATS_PHASES; phase++) {
+        const struct histogram *h = &histograms[phase];
+        if (h->count == 0) {
+            continue;
+        }
+        fprintf(out, "%-9s %9llu %10.2f %10.2f %10.2f %10.2f %10.2f %10.2f\n",
+                phaseNames[phase], (unsigned long long)h->count,
+                h->min / 1e3, (double)h->total / h->count / 1e3,
+                percentile(h, 0.50) / 1e3, percentile(h, 0.90) / 1e3,
+                percentile(h, 0.99) / 1e3, h->max / 1e3);
+    }
+    fflush(out);
+    return 0;
+}
+
+/**
+*
+* void statsReset(void)
+*
+* Summary:
+*       Clears every histogram
+*
+**/
+void statsReset(void)
+{
+    memset(histograms, 0, sizeof(histograms));
+}
+
+#else
+
+int statsPrint(FILE *out)
+{
+    fprintf(out, "shstats: statistics not compiled in, rebuild with make STATS=1\n");
+    fflush(out);
+    return 1;
+}
+
+void statsReset(void)
+{
+}
+
+#endif
+
+/**
+*
+* void statsDump(const char *where)
+*
+* Summary:
+*       Prints the statistics when the shell exits
+*
+* Parameters:   char* for the value of KELL_SHSTATS: `1` or `-` for stderr,
+*               otherwise a file to append to
+*
+* Returns:      nothing.
+*
+**/
+void statsDump(const char *where)
+{
+    if (strcmp(where, "1") == 0 || strcmp(where, "-") == 0) {
+        statsPrint(stderr);
+        return;
+    }
+    FILE *file = fopen(where, "a");
+    if (!file) {
+        perror(where);
+        return;
+    }
+    statsPrint(file);
+    fclose(file);
+}
@@ -0,0 +1,51 @@
+/*******************************************************************************
+*
+* File:     stats.h
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Interface for kell-shell self-profiling. Each phase of running a
+*   command is timed with CLOCK_MONOTONIC into a fixed-bucket latency
+*   histogram, shown by the `shstats` built-in.
+*
+*   The timers are only compiled in with `make STATS=1`, which defines
+*   KELL_STATS. Otherwise the timing macros expand to nothing and cost
+*   nothing.
+*
+******************************************************************************/
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+#include <time.h>
+
+enum statsPhase {
+    STATS_READ,         // reading one line of input
+    STATS_LEX,          // lexing the line, with its $ expansions
+    STATS_PARSE,        // grouping tokens into a pipeline
+    STATS_BUILTIN,      // running a built-in, redirections included
+    STATS_REDIRECT,     // opening and dup2()ing a built-in's redirections
+    STATS_SPAWN,        // launching one pipeline stage
+    STATS_WAIT,         // waiting for a foreground job
+    STATS_REAP,         // one pass of the reaping loop
+    STATS_PHASES
+};
+
+#ifdef KELL_STATS
+#define STATS_TIMER(t)          struct timespec t
+#define STATS_START(t)          clock_gettime(CLOCK_MONOTONIC, &(t))
+#define STATS_STOP(phase, t)    statsRecord((phase), &(t))
+void statsRecord(enum statsPhase phase, const struct timespec *start);
+#else
+#define STATS_TIMER(t)
+#define STATS_START(t)          ((void)0)
+#define STATS_STOP(phase, t)    ((void)0)
+#endif
+
+int statsPrint(FILE *out);
+void statsReset(void);
+void statsDump(const char *where);
+
+#endif
@@ -0,0 +1,135 @@
+#!/bin/sh
+################################################################################
+#	File: 	check.sh
+#	Author:	Kelley Neubauer
+#	Date:	10/16/2026
+#
+#	Description: regression checks for kell-shell. Each check feeds a script
+#	to the shell on stdin and compares everything it prints with what is
+#	expected. Run by make check; the shell to test is the first argument.
+#
+################################################################################
+
+SHELL_BIN=${1:-./kell-shell}
+case $SHELL_BIN in
+	/*) ;;
+	*) SHELL_BIN=$(pwd)/$SHELL_BIN ;;
+esac
+WORK=$(mktemp -d) || exit 1
+trap 'rm -rf "$WORK"' EXIT
+failed=0
+total=0
+
+# check NAME SCRIPT EXPECTED: runs SCRIPT in $WORK, stdout and stderr together
+check() {
+	total=$((total + 1))
+	actual=$(cd "$WORK" && printf '%s\n' "$2" | "$SHELL_BIN" 2>&1)
+	if [ "$actual" != "$3" ]; then
+		failed=$((failed + 1))
+		printf 'FAIL: %s\n--- expected\n%s\n--- got\n%s\n' "$1" "$3" "$actual"
+	fi
+}
+
+# a syntax error anywhere on a line runs nothing of it
+check "syntax error after a list" \
+'echo a; ; echo b
+echo $?
+touch ran; ;
+ls ran 2>/dev/null || echo none' \
+"syntax error near unexpected token \`;'
+2
+syntax error near unexpected token \`;'
+none"
+
+check "syntax error after an and-or" \
+'echo a && )
+echo $?' \
+"syntax error near unexpected token \`)'
+2"
+
+# test and [ take the whole POSIX grammar, not just three operands
+check "test with -a -o ! and parentheses" \
+'touch f; mkdir d
+[ -f f -a -d d ]; echo $?
+[ -f f -a -d f ]; echo $?
+test "" -o x; echo $?
+[ ! \( -f f -a -d d \) ]; echo $?
+[ \( 1 -eq 1 \) -a \( x = y -o 2 -gt 1 \) ]; echo $?
+[ ! = ! ]; echo $?
+test a b c d; echo $?' \
+"0
+1
+0
+1
+0
+0
+test: too many arguments
+2"
+
+check "echo options and escapes" \
+"echo -e 'a\\tb|'
+echo -ne 'x\\0101'; echo
+echo -E 'a\\tb'
+echo -x y
+echo -e 'stop\\cnever'
+echo after" \
+"a	b|
+xA
+a\\tb
+-x y
+stopafter"
+
+check "printf floating point, %b and unknown conversions" \
+"printf '%.2f|%e|%g|%5b|\\n' 3.14159 12345 0.0001 x
+printf '%b|\\n' 'a\\tb\\0101'
+printf '%z\\n' 1; echo \$?" \
+"3.14|1.234500e+04|0.0001|    x|
+a	bA|
+printf: %z: invalid conversion
+1"
+
+check "time leaves out a built-in's own memory" \
+"{ time echo hi; } 2>&1 | grep maxrss" \
+"maxrss	0 KB"
+
+check "a PATH assignment in front of a command is searched" \
+"mkdir bin; echo 'echo mine' > bin/ls; chmod +x bin/ls
+ls bin
+PATH=\$PWD/bin ls
+PATH=\$PWD/none ls; echo \$?
+ls bin" \
+"ls
+mine
+ls: No such file or directory
+1
+ls"
+
+check "ARG_MAX only limits external commands" \
+"big=\$(head -c 3000000 /dev/zero | tr '\\0' x)
+echo \"\$big\" | wc -c
+/bin/echo \"\$big\"; echo \$?" \
+"3000001
+/bin/echo: argument list too long
+1"
+
+check "quotes and backslashes go on to the next line" \
+'echo "a
+b"
+echo '"'"'c
+d'"'"' e
+echo one \
+two
+echo "x\
+y" pre\
+fix
+echo '"'"'open' \
+"a
+b
+c
+d e
+one two
+xy prefix
+syntax error: unexpected end of file"
+
+printf '%d of %d checks failed\n' "$failed" "$total"
+[ "$failed" -eq 0 ]
@@ -0,0 +1,522 @@
+/*******************************************************************************
+*
+* File:     vars.c
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Variable store for kell-shell. Every variable lives in one
+*   open-addressing hash table (linear probing, power of two capacity)
+*   keyed by its name. Names are interned: each is copied once into an
+*   arena, and its slot stays in the table when the variable is unset, so
+*   setting it again finds the same slot and allocates only the value.
+*
+*   A variable's value is kept as a whole "NAME=value" string, the form
+*   the environment takes. The environment array handed to commands is
+*   made of those same strings: it is kept up to date as exported
+*   variables change (a new value takes over its slot, an unset variable
+*   gives its slot to the last entry), so launching a command passes the
+*   array as it is, without building anything. `environ` always points at
+*   it too, so getenv() and PATH searches see what commands get.
+*
+*   The strings are never changed in place. A command given assignments of
+*   its own (NAME=value cmd) gets a copy of the array, made in the
+*   command arena, with those entries replaced; the shared array and its
+*   strings are untouched.
+*
+******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "fnv.h"
+#include "vars.h"
+
+#define VARS_MIN_CAPACITY 64
+#define ENVIRON_MIN_CAPACITY 64
+
+extern char **environ;
+
+struct var {
+    const char *name;   // interned, NULL for an empty slot
+    size_t nameLength;
+    unsigned hash;
+    int flags;          // VAR_EXPORT
+    char *entry;        // "NAME=value", NULL while unset
+    int envIndex;       // position in the environment array, -1 if absent
+};
+
+// a varsPush() to undo: the value and flags from before it
+struct varSaved {
+    const char *name;
+    size_t nameLength;
+    char *entry;
+    int flags;
+};
+
+static struct var *table = NULL;
+static size_t capacity = 0;
+static size_t count = 0;
+static struct arena names;          // the interned names
+
+static char **envp = NULL;          // exported entries, NULL terminated
+static int envCount = 0;
+static int envCapacity = 0;
+
+static struct varSaved *saved = NULL;
+static int numSaved = 0;
+static int savedCapacity = 0;
+
+/**
+*
+* static struct var *varsFind(const char *name, size_t length, unsigned hash)
+*
+* Summary:
+*       Locates the slot of a name
+*
+* Parameters:   char* for the name, not NUL terminated
+*               size_t for its length
+*               unsigned for its hash
+*
+* Returns:      pointer to the slot, or NULL if the name was never used
+*
+**/
+static struct var *varsFind(const char *name, size_t length, unsigned hash)
+{
+    if (!table) {
+        return NULL;
+    }
+    size_t mask = capacity - 1;
+    for (size_t i = hash & mask; table[i].name; i = (i + 1) & mask) {
+        if (table[i].hash == hash && table[i].nameLength == length
+                && memcmp(table[i].name, name, length) == 0) {
+            return &table[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+*
+* static void varsGrow(void)
+*
+* Summary:
+*       Doubles the table and rehashes every slot
+*
+**/
+static void varsGrow(void)
+{
+    size_t newCapacity = capacity ? capacity * 2 : VARS_MIN_CAPACITY;
+    struct var *newTable = calloc(newCapacity, sizeof(struct var));
+    size_t mask = newCapacity - 1;
+
+    for (size_t i = 0; i < capacity; i++) {
+        if (table[i].name) {
+            size_t j = table[i].hash & mask;
+            while (newTable[j].name) {
+                j = (j + 1) & mask;
+            }
+            newTable[j] = table[i];
+        }
+    }
+
+    free(table);
+    table = newTable;
+    capacity = newCapacity;
+}
+
+/**
+*
+* static struct var *varsIntern(const char *name, size_t length)
+*
+* Summary:
+*       Finds the slot of a name, adding the name if it is new
+*
+* Parameters:   char* for the name, not NUL terminated
+*               size_t for its length
+*
+* Returns:      pointer to the slot, valid until the next name is added
+*
+**/
+static struct var *varsIntern(const char *name, size_t length)
+{
+    unsigned hash = fnvHash(name, length);
+    struct var *var = varsFind(name, length, hash);
+    if (var) {
+        return var;
+    }
+
+    // keep load under 70%
+    if ((count + 1) * 10 > capacity * 7) {
+        varsGrow();
+    }
+    size_t mask = capacity - 1;
+    size_t i = hash & mask;
+    while (table[i].name) {
+        i = (i + 1) & mask;
+    }
+    var = &table[i];
+    var->name = arenaStrndup(&names, name, length);
+    var->nameLength = length;
+    var->hash = hash;
+    var->flags = 0;
+    var->entry = NULL;
+    var->envIndex = -1;
+    count++;
+    return var;
+}
+
+/**
+*
+* static void varsGrowEnviron(void)
+*
+* Summary:
+*       Makes room in the environment array for one more entry
+*
+**/
+static void varsGrowEnviron(void)
+{
+    envCapacity = envCapacity ? envCapacity * 2 : ENVIRON_MIN_CAPACITY;
+    envp = realloc(envp, envCapacity * sizeof(char *));
+    envp[envCount] = NULL;
+    environ = envp;
+}
+
+/**
+*
+* static char *varsReplace(struct var *var, char *entry, int flags)
+*
+* Summary:
+*       Gives a variable a new value and flags, keeping the environment
+*       array in step
+*
+* Parameters:   pointer to the variable
+*               char* for the new "NAME=value" string, NULL to unset it
+*               int for the new flags
+*
+* Returns:      the old string, for the caller to free or keep
+*
+* Description:
+*       Each change costs the same whatever the size of the environment:
+*       an exported value replaces its slot, a new one is appended, and a
+*       removed one has the last entry moved into its place.
+*
+**/
+static char *varsReplace(struct var *var, char *entry, int flags)
+{
+    _Bool listed = (var->envIndex >= 0);
+    _Bool exported = (entry && (flags & VAR_EXPORT));
+
+    if (listed && exported) {
+        envp[var->envIndex] = entry;
+    }
+    else if (listed) {
+        int last = --envCount;
+        if (var->envIndex != last) {
+            char *moved = envp[last];
+            size_t length = strchr(moved, '=') - moved;
+            struct var *other = varsFind(moved, length, fnvHash(moved, length));
+            other->envIndex = var->envIndex;
+            envp[var->envIndex] = moved;
+        }
+        envp[last] = NULL;
+        var->envIndex = -1;
+    }
+    else if (exported) {
+        if (envCount + 1 >= envCapacity) {
+            varsGrowEnviron();
+        }
+        var->envIndex = envCount;
+        envp[envCount++] = entry;
+        envp[envCount] = NULL;
+    }
+
+    char *old = var->entry;
+    var->entry = entry;
+    var->flags = flags;
+    return old;
+}
+
+/**
+*
+* void varsInit(char **env)
+*
+* Summary:
+*       Fills the store with the environment the shell was started with
+*
+* Parameters:   NULL terminated array of "NAME=value" strings
+*
+* Returns:      nothing.
+*
+**/
+void varsInit(char **env)
+{
+    if (!envp) {
+        varsGrowEnviron();
+    }
+    for (; env && *env; env++) {
+        const char *equals = strchr(*env, '=');
+        if (!equals || equals == *env) {
+            continue;
+        }
+        struct var *var = varsIntern(*env, equals - *env);
+        free(varsReplace(var, strdup(*env), VAR_EXPORT));
+    }
+}
+
+/**
+*
+* const char *varsLookup(const char *name, size_t length)
+*
+* Summary:
+*       Looks up the value of a variable
+*
+* Parameters:   char* for the name, not NUL terminated
+*               size_t for its length
+*
+* Returns:      the value, valid until the variable changes, or NULL if it
+*               is not set
+*
+**/
+const char *varsLookup(const char *name, size_t length)
+{
+    struct var *var = varsFind(name, length, fnvHash(name, length));
+    if (!var || !var->entry) {
+        return NULL;
+    }
+    return var->entry + length + 1;
+}
+
+/**
+*
+* const char *varsGet(const char *name)
+*
+* Summary:
+*       Looks up the value of a variable by its NUL terminated name
+*
+**/
+const char *varsGet(const char *name)
+{
+    return varsLookup(name, strlen(name));
+}
+
+/**
+*
+* void varsSet(const char *name, const char *value, int flags)
+*
+* Summary:
+*       Sets a variable
+*
+* Parameters:   char* for a valid name
+*               char* for the value
+*               int for flags to add: VAR_EXPORT exports it, 0 keeps it
+*                   exported if it was
+*
+* Returns:      nothing.
+*
+**/
+void varsSet(const char *name, const char *value, int flags)
+{
+    size_t nameLength = strlen(name);
+    size_t valueLength = strlen(value);
+    char *entry = malloc(nameLength + valueLength + 2);
+    memcpy(entry, name, nameLength);
+    entry[nameLength] = '=';
+    memcpy(entry + nameLength + 1, value, valueLength + 1);
+
+    struct var *var = varsIntern(name, nameLength);
+    free(varsReplace(var, entry, var->flags | flags));
+}
+
+/**
+*
+* void varsAssign(const char *assignment, int flags)
+*
+* Summary:
+*       Sets a variable from a "NAME=value" string, as in an assignment
+*
+* Parameters:   char* for the assignment, with a valid name
+*               int for flags to add, as for varsSet()
+*
+* Returns:      nothing.
+*
+**/
+void varsAssign(const char *assignment, int flags)
+{
+    struct var *var = varsIntern(assignment, strchr(assignment, '=') - assignment);
+    free(varsReplace(var, strdup(assignment), var->flags | flags));
+}
+
+/**
+*
+* void varsExport(const char *name)
+*
+* Summary:
+*       Marks a variable for the environment of commands
+*
+* Description:
+*       An unset variable is exported once it is given a value.
+*
+**/
+void varsExport(const char *name)
+{
+    struct var *var = varsIntern(name, strlen(name));
+    varsReplace(var, var->entry, var->flags | VAR_EXPORT);
+}
+
+/**
+*
+* void varsUnset(const char *name)
+*
+* Summary:
+*       Removes a variable and its export flag
+*
+**/
+void varsUnset(const char *name)
+{
+    size_t length = strlen(name);
+    struct var *var = varsFind(name, length, fnvHash(name, length));
+    if (var) {
+        free(varsReplace(var, NULL, 0));
+    }
+}
+
+/**
+*
+* char **varsEnviron(void)
+*
+* Summary:
+*       Gets the environment for a command
+*
+* Parameters:   none
+*
+* Returns:      the NULL terminated array of exported "NAME=value"
+*               strings, valid until a variable changes
+*
+**/
+char **varsEnviron(void)
+{
+    if (!envp) {
+        varsGrowEnviron();
+    }
+    return envp;
+}
+
+/**
+*
+* char **varsEnvironWith(char **assignments, int count, struct arena *arena)
+*
+* Summary:
+*       Gets the environment for a command with assignments of its own
+*
+* Parameters:   array of "NAME=value" strings, with valid names
+*               int for their number
+*               pointer to the arena the copy is allocated from
+*
+* Returns:      a copy of the environment array with the assignments in
+*               place of the variables they name, or added
+*
+**/
+char **varsEnvironWith(char **assignments, int count, struct arena *arena)
+{
+    char **shared = varsEnviron();
+    char **copy = arenaAlloc(arena, (envCount + count + 1) * sizeof(char *));
+    memcpy(copy, shared, envCount * sizeof(char *));
+    int numEntries = envCount;
+
+    for (int i = 0; i < count; i++) {
+        size_t length = strchr(assignments[i], '=') - assignments[i];
+        struct var *var = varsFind(assignments[i], length, fnvHash(assignments[i], length));
+        if (var && var->envIndex >= 0) {
+            copy[var->envIndex] = assignments[i];
+            continue;
+        }
+        // not exported: added, once however often it is assigned
+        int j = envCount;
+        while (j < numEntries && strncmp(copy[j], assignments[i], length + 1) != 0) {
+            j++;
+        }
+        copy[j] = assignments[i];
+        if (j == numEntries) {
+            numEntries++;
+        }
+    }
+    copy[numEntries] = NULL;
+    return copy;
+}
+
+/**
+*
+* void varsPush(const char *assignment)
+*
+* Summary:
+*       Exports an assignment until the matching varsPop()
+*
+* Parameters:   char* for the "NAME=value" string, with a valid name
+*
+* Returns:      nothing.
+*
+* Description:
+*       For assignments in front of a built-in or a function, which run
+*       in the shell.
+*
+**/
+void varsPush(const char *assignment)
+{
+    if (numSaved == savedCapacity) {
+        savedCapacity = savedCapacity ? savedCapacity * 2 : 16;
+        saved = realloc(saved, savedCapacity * sizeof(struct varSaved));
+    }
+    struct var *var = varsIntern(assignment, strchr(assignment, '=') - assignment);
+    struct varSaved *save = &saved[numSaved++];
+    save->name = var->name;
+    save->nameLength = var->nameLength;
+    save->flags = var->flags;
+    save->entry = varsReplace(var, strdup(assignment), var->flags | VAR_EXPORT);
+}
+
+/**
+*
+* void varsPop(int count)
+*
+* Summary:
+*       Undoes the last count varsPush() calls
+*
+**/
+void varsPop(int count)
+{
+    while (count-- > 0 && numSaved > 0) {
+        struct varSaved *save = &saved[--numSaved];
+        struct var *var = varsFind(save->name, save->nameLength,
+                fnvHash(save->name, save->nameLength));
+        free(varsReplace(var, save->entry, save->flags));
+    }
+}
+
+/**
+*
+* void varsFree(void)
+*
+* Summary:
+*       Frees every variable, on the way out of the shell
+*
+**/
+void varsFree(void)
+{
+    varsPop(numSaved);
+    environ = NULL;
+    for (size_t i = 0; i < capacity; i++) {
+        free(table[i].entry);
+    }
+    free(table);
+    free(envp);
+    free(saved);
+    arenaFree(&names);
+    table = NULL;
+    envp = NULL;
+    saved = NULL;
+    capacity = count = 0;
+    envCount = envCapacity = 0;
+    numSaved = savedCapacity = 0;
+}
@@ -0,0 +1,36 @@
+/*******************************************************************************
+*
+* File:     vars.h
+* Author:   Kelley Neubauer
+* Date:     10/16/2026
+*
+* Description:
+*
+*   Interface for the kell-shell variable store, which holds the shell's
+*   variables and the environment array exported ones are passed to
+*   commands in.
+*
+******************************************************************************/
+#ifndef VARS_H
+#define VARS_H
+
+#include <stddef.h>
+
+struct arena;
+
+#define VAR_EXPORT 1    // in the environment of commands
+
+void varsInit(char **envp);
+const char *varsGet(const char *name);
+const char *varsLookup(const char *name, size_t length);
+void varsSet(const char *name, const char *value, int flags);
+void varsAssign(const char *assignment, int flags);
+void varsExport(const char *name);
+void varsUnset(const char *name);
+char **varsEnviron(void);
+char **varsEnvironWith(char **assignments, int count, struct arena *arena);
+void varsPush(const char *assignment);
+void varsPop(int count);
+void varsFree(void);
+
+#endif